@@ -1,5 +1,11 @@
+#include "audio_processor_api.h"
+#include "resampler.h"
+#include "fm_discriminator.h"
+#include "pipeline_profiler.h"
 #include <android/log.h>
 #include <cmath>
+#include <cstdint>
+#include <string>
 #include <vector>
 #include <algorithm>
 
@@ -15,7 +21,12 @@ constexpr float PI = 3.14159265359f;
 constexpr float TWO_PI = 2.0f * PI;
 constexpr int AUDIO_SAMPLE_RATE = 44100;
 constexpr int SDR_SAMPLE_RATE = 2048000;
-constexpr float DECIMATION_RATIO = static_cast<float>(SDR_SAMPLE_RATE) / AUDIO_SAMPLE_RATE;
+
+// Modo fundido: amostras por bloco. Entrada u8, I, Q e áudio do bloco somam
+// cerca de 14 KB e ficam na L1 durante toda a cadeia.
+constexpr size_t TILE_SIZE = 1024;
+
+namespace audio {
 
 // Filtros simples para demodulação
 class AudioProcessor {
@@ -36,7 +47,9 @@ private:
     
     // Demodulador FM
     float fm_demod_gain_;
-    float fm_prev_sample_;
+    float fm_prev_i_;
+    float fm_prev_q_;
+    DiscriminatorAccuracy fm_accuracy_;
     
     // AGC (Automatic Gain Control)
     float agc_gain_;
@@ -48,6 +61,24 @@ private:
     float noise_gate_threshold_;
     float noise_gate_ratio_;
     
+    // Reamostragem exata da taxa do SDR para a taxa do AudioManager
+    Resampler resampler_;
+    int sdr_sample_rate_;
+    int audio_sample_rate_;
+    
+    // Modo fundido (padrão): todos os estágios por bloco de TILE_SIZE, sem
+    // alocações por chamada. Os dois FIRs viram um só (chain_coeffs_), e
+    // tile_audio_ guarda à frente as últimas amostras do bloco anterior.
+    bool fused_;
+    std::vector<float> chain_coeffs_;
+    std::vector<float> tile_i_;
+    std::vector<float> tile_q_;
+    std::vector<float> tile_audio_;
+    std::vector<float> fused_output_;
+    
+    // Tempo de cada estágio no PipelineProfiler do núcleo; nullptr desliga
+    PipelineProfiler* profiler_;
+    
 public:
     AudioProcessor() 
         : lpf_buffer_index_(0)
@@ -55,15 +86,22 @@ public:
         , am_demod_gain_(1.0f)
         , am_demod_dc_block_(0.0f)
         , fm_demod_gain_(1.0f)
-        , fm_prev_sample_(0.0f)
+        , fm_prev_i_(0.0f)
+        , fm_prev_q_(0.0f)
+        , fm_accuracy_(DiscriminatorAccuracy::POLYNOMIAL)
         , agc_gain_(1.0f)
         , agc_target_(0.3f)
         , agc_attack_(0.01f)
         , agc_decay_(0.001f)
         , noise_gate_threshold_(0.01f)
-        , noise_gate_ratio_(0.1f) {
+        , noise_gate_ratio_(0.1f)
+        , sdr_sample_rate_(SDR_SAMPLE_RATE)
+        , audio_sample_rate_(AUDIO_SAMPLE_RATE)
+        , fused_(true)
+        , profiler_(nullptr) {
         
         initializeFilters();
+        resampler_.configure(sdr_sample_rate_, audio_sample_rate_);
         LOGI("AudioProcessor initialized");
     }
     
@@ -79,6 +117,9 @@ public:
             return audio_data;
         }
         
+        StageTimer timer(profiler_);
+        const size_t num_samples = iq_data.size() / 2;
+        
         // Converter dados I/Q de 8-bit para float
         std::vector<float> i_samples, q_samples;
         for (size_t i = 0; i < iq_data.size(); i += 2) {
@@ -89,6 +130,7 @@ public:
                 q_samples.push_back(q_val);
             }
         }
+        timer.lap(PipelineStage::INGEST, num_samples);
         
         // Aplicar demodulação
         if (demod_type == "AM") {
@@ -99,27 +141,131 @@ public:
             // Demodulação AM padrão
             audio_data = demodulateAM(i_samples, q_samples);
         }
+        timer.lap(PipelineStage::DEMOD, num_samples);
         
         // Aplicar filtros e processamento
         audio_data = applyFilters(audio_data);
+        timer.lap(PipelineStage::CHANNEL_FILTER, num_samples);
         audio_data = applyAGC(audio_data);
+        timer.lap(PipelineStage::AGC, num_samples);
         audio_data = applyNoiseGate(audio_data);
+        timer.lap(PipelineStage::SQUELCH, num_samples);
         
-        // Decimar para taxa de áudio
-        audio_data = decimate(audio_data);
+        // Reamostrar para a taxa de áudio
+        audio_data = resample(audio_data);
+        timer.lap(PipelineStage::RESAMPLE, num_samples);
         
         return audio_data;
     }
     
+    // Mesma cadeia de processIQData, fundida por blocos; o resultado fica em
+    // um buffer interno, válido até a próxima chamada
+    const std::vector<float>& processIQDataFused(const uint8_t* iq_data, size_t iq_length,
+                                                 const std::string& demod_type = "AM") {
+        fused_output_.clear();
+        const bool fm = demod_type == "FM";
+        const size_t history = chain_coeffs_.size() - 1;
+        const size_t num_samples = iq_length / 2;
+        
+        // Uma volta do relógio por estágio e por bloco de TILE_SIZE
+        StageTimer timer(profiler_);
+        for (size_t start = 0; start < num_samples; start += TILE_SIZE) {
+            const size_t count = std::min(TILE_SIZE, num_samples - start);
+            const uint8_t* iq = iq_data + 2 * start;
+            float* audio = tile_audio_.data() + history;
+            
+            // Converter u8 -> I/Q
+            for (size_t k = 0; k < count; ++k) {
+                tile_i_[k] = (iq[2 * k] - 128.0f) / 128.0f;
+                tile_q_[k] = (iq[2 * k + 1] - 128.0f) / 128.0f;
+            }
+            timer.lap(PipelineStage::INGEST, count);
+            
+            if (fm) {
+                discriminateFM(tile_i_.data(), tile_q_.data(), count,
+                               fm_prev_i_, fm_prev_q_, audio, fm_accuracy_);
+                for (size_t k = 0; k < count; ++k) {
+                    audio[k] *= fm_demod_gain_;
+                }
+            } else {
+                for (size_t k = 0; k < count; ++k) {
+                    float magnitude = std::sqrt(tile_i_[k] * tile_i_[k] + tile_q_[k] * tile_q_[k]);
+                    magnitude -= am_demod_dc_block_;
+                    am_demod_dc_block_ = am_demod_dc_block_ * 0.999f + magnitude * 0.001f;
+                    audio[k] = magnitude * am_demod_gain_;
+                }
+            }
+            timer.lap(PipelineStage::DEMOD, count);
+            
+            // Passa-baixa e passa-alta como um FIR só, no lugar: a saída k
+            // entra em tile_i_, que já foi consumido
+            float* filtered = tile_i_.data();
+            const float* taps = chain_coeffs_.data();
+            for (size_t k = 0; k < count; ++k) {
+                const float* window = tile_audio_.data() + k;   // audio[k - history .. k]
+                float output = 0.0f;
+                for (size_t t = 0; t <= history; ++t) {
+                    output += taps[t] * window[history - t];
+                }
+                filtered[k] = output;
+            }
+            
+            // Guardar as últimas amostras demoduladas para o próximo bloco
+            std::copy(audio + count - history, audio + count, tile_audio_.data());
+            timer.lap(PipelineStage::CHANNEL_FILTER, count);
+            
+            // AGC: recursivo, amostra a amostra
+            for (size_t k = 0; k < count; ++k) {
+                float sample = filtered[k];
+                float error = agc_target_ - std::abs(sample);
+                float rate = (error > 0) ? agc_attack_ : agc_decay_;
+                agc_gain_ = std::max(0.1f, std::min(10.0f, agc_gain_ + error * rate));
+                filtered[k] = sample * agc_gain_;
+            }
+            timer.lap(PipelineStage::AGC, count);
+            
+            // Noise gate: sem estado, vetoriza
+            for (size_t k = 0; k < count; ++k) {
+                const float sample = filtered[k];
+                filtered[k] = std::abs(sample) < noise_gate_threshold_ ? sample * noise_gate_ratio_ : sample;
+            }
+            timer.lap(PipelineStage::SQUELCH, count);
+            
+            resampler_.process(filtered, count, fused_output_);
+            timer.lap(PipelineStage::RESAMPLE, count);
+        }
+        
+        return fused_output_;
+    }
+    
     // Configurar parâmetros
+    void setFusedProcessing(bool fused) { fused_ = fused; }
+    bool isFusedProcessing() const { return fused_; }
+    void setProfiler(PipelineProfiler* profiler) { profiler_ = profiler; }
     void setAMDemodGain(float gain) { am_demod_gain_ = gain; }
     void setFMDemodGain(float gain) { fm_demod_gain_ = gain; }
+    void setFMAccuracy(DiscriminatorAccuracy accuracy) { fm_accuracy_ = accuracy; }
     void setAGCTarget(float target) { agc_target_ = target; }
     void setAGCAttack(float attack) { agc_attack_ = attack; }
     void setAGCDecay(float decay) { agc_decay_ = decay; }
     void setNoiseGateThreshold(float threshold) { noise_gate_threshold_ = threshold; }
     void setNoiseGateRatio(float ratio) { noise_gate_ratio_ = ratio; }
     
+    // Taxa do SDR na entrada e taxa com que o AudioManager foi aberto
+    bool setSampleRates(int sdr_rate, int audio_rate) {
+        if (!resampler_.configure(sdr_rate, audio_rate)) {
+            LOGE("Unsupported resampling %d Hz -> %d Hz", sdr_rate, audio_rate);
+            resampler_.configure(sdr_sample_rate_, audio_sample_rate_);
+            return false;
+        }
+        
+        sdr_sample_rate_ = sdr_rate;
+        audio_sample_rate_ = audio_rate;
+        LOGI("Resampling %d Hz -> %d Hz (D=%d, L/M=%d/%d)", sdr_rate, audio_rate,
+             resampler_.getPreDecimation(), resampler_.getInterpolation(), resampler_.getDecimation());
+        return true;
+    }
+    
 private:
     void initializeFilters() {
         // Filtro de baixa passagem simples (FIR)
@@ -129,6 +275,31 @@ private:
         // Filtro de alta passagem simples (FIR)
         hpf_coeffs_ = {0.1f, -0.2f, 0.4f, -0.2f, 0.1f};
         hpf_buffer_.resize(hpf_coeffs_.size(), 0.0f);
+        
+        // Modo fundido: resposta ao impulso de cada filtro (o buffer circular
+        // aplica coeffs[0] à amostra nova e coeffs[1..] da mais antiga para a
+        // mais recente) e a convolução das duas, aplicada de uma vez
+        std::vector<float> lpf_response = impulseResponse(lpf_coeffs_);
+        std::vector<float> hpf_response = impulseResponse(hpf_coeffs_);
+        chain_coeffs_.assign(lpf_response.size() + hpf_response.size() - 1, 0.0f);
+        for (size_t a = 0; a < lpf_response.size(); ++a) {
+            for (size_t b = 0; b < hpf_response.size(); ++b) {
+                chain_coeffs_[a + b] += lpf_response[a] * hpf_response[b];
+            }
+        }
+        
+        tile_i_.resize(TILE_SIZE);
+        tile_q_.resize(TILE_SIZE);
+        tile_audio_.assign(chain_coeffs_.size() - 1 + TILE_SIZE, 0.0f);
+    }
+    
+    static std::vector<float> impulseResponse(const std::vector<float>& coeffs) {
+        std::vector<float> response(coeffs.size());
+        response[0] = coeffs[0];
+        for (size_t t = 1; t < coeffs.size(); ++t) {
+            response[t] = coeffs[coeffs.size() - t];
+        }
+        return response;
     }
     
     std::vector<float> demodulateAM(const std::vector<float>& i_samples, const std::vector<float>& q_samples) {
@@ -153,25 +324,14 @@ private:
     }
     
     std::vector<float> demodulateFM(const std::vector<float>& i_samples, const std::vector<float>& q_samples) {
-        std::vector<float> audio_data;
-        audio_data.reserve(i_samples.size());
+        // Demodulação FM: derivada da fase, em um passe vetorizado por bloco
+        std::vector<float> audio_data(i_samples.size());
+        discriminateFM(i_samples.data(), q_samples.data(), i_samples.size(),
+                       fm_prev_i_, fm_prev_q_, audio_data.data(), fm_accuracy_);
         
-        for (size_t i = 0; i < i_samples.size(); ++i) {
-            // Demodulação FM: derivada da fase
-            float phase = std::atan2(q_samples[i], i_samples[i]);
-            
-            // Calcular diferença de fase
-            float phase_diff = phase - fm_prev_sample_;
-            
-            // Normalizar diferença de fase
-            if (phase_diff > PI) phase_diff -= TWO_PI;
-            if (phase_diff < -PI) phase_diff += TWO_PI;
-            
-            // Aplicar ganho
-            float audio_sample = phase_diff * fm_demod_gain_;
-            
-            audio_data.push_back(audio_sample);
-            fm_prev_sample_ = phase;
+        // Aplicar ganho
+        for (float& audio_sample : audio_data) {
+            audio_sample *= fm_demod_gain_;
         }
         
         return audio_data;
@@ -264,34 +424,32 @@ private:
         return gated_data;
     }
     
-    std::vector<float> decimate(const std::vector<float>& audio_data) {
-        std::vector<float> decimated_data;
+    std::vector<float> resample(const std::vector<float>& audio_data) {
+        std::vector<float> resampled_data;
         
-        // Decimar para taxa de áudio
-        for (size_t i = 0; i < audio_data.size(); i += static_cast<int>(DECIMATION_RATIO)) {
-            if (i < audio_data.size()) {
-                decimated_data.push_back(audio_data[i]);
-            }
-        }
+        // Filtro anti-aliasing + reamostragem racional exata
+        resampler_.process(audio_data.data(), audio_data.size(), resampled_data);
         
-        return decimated_data;
+        return resampled_data;
     }
 };
 
+} // namespace audio
+
 // Funções de interface C para uso externo
 extern "C" {
 
-AudioProcessor* audio_processor_create() {
-    return new AudioProcessor();
+audio::AudioProcessor* audio_processor_create() {
+    return new audio::AudioProcessor();
 }
 
-void audio_processor_destroy(AudioProcessor* processor) {
+void audio_processor_destroy(audio::AudioProcessor* processor) {
     if (processor) {
         delete processor;
     }
 }
 
-void audio_processor_process_iq(AudioProcessor* processor, 
+void audio_processor_process_iq(audio::AudioProcessor* processor, 
                               const uint8_t* iq_data, int iq_length,
                               float* audio_data, int* audio_length,
                               const char* demod_type) {
@@ -299,9 +457,18 @@ void audio_processor_process_iq(AudioProcessor* processor,
         return;
     }
     
-    std::vector<uint8_t> iq_vector(iq_data, iq_data + iq_length);
     std::string demod_str = demod_type ? demod_type : "AM";
     
+    if (processor->isFusedProcessing()) {
+        const std::vector<float>& result =
+            processor->processIQDataFused(iq_data, static_cast<size_t>(std::max(iq_length, 0)), demod_str);
+        int copy_length = std::min(static_cast<int>(result.size()), *audio_length);
+        std::copy(result.begin(), result.begin() + copy_length, audio_data);
+        *audio_length = copy_length;
+        return;
+    }
+    
+    std::vector<uint8_t> iq_vector(iq_data, iq_data + iq_length);
     std::vector<float> result = processor->processIQData(iq_vector, demod_str);
     
     // Copiar resultado para buffer de saída
@@ -310,25 +477,50 @@ void audio_processor_process_iq(AudioProcessor* processor,
     *audio_length = copy_length;
 }
 
-void audio_processor_set_am_gain(AudioProcessor* processor, float gain) {
+bool audio_processor_set_sample_rates(audio::AudioProcessor* processor, int sdr_rate, int audio_rate) {
+    if (processor) {
+        return processor->setSampleRates(sdr_rate, audio_rate);
+    }
+    return false;
+}
+
+void audio_processor_set_profiler(audio::AudioProcessor* processor, PipelineProfiler* profiler) {
+    if (processor) {
+        processor->setProfiler(profiler);
+    }
+}
+
+void audio_processor_set_fused(audio::AudioProcessor* processor, bool fused) {
+    if (processor) {
+        processor->setFusedProcessing(fused);
+    }
+}
+
+void audio_processor_set_am_gain(audio::AudioProcessor* processor, float gain) {
     if (processor) {
         processor->setAMDemodGain(gain);
     }
 }
 
-void audio_processor_set_fm_gain(AudioProcessor* processor, float gain) {
+void audio_processor_set_fm_gain(audio::AudioProcessor* processor, float gain) {
     if (processor) {
         processor->setFMDemodGain(gain);
     }
 }
 
-void audio_processor_set_agc_target(AudioProcessor* processor, float target) {
+void audio_processor_set_fm_accuracy(audio::AudioProcessor* processor, int accuracy) {
+    if (processor && accuracy >= 0 && accuracy <= 2) {
+        processor->setFMAccuracy(static_cast<audio::DiscriminatorAccuracy>(accuracy));
+    }
+}
+
+void audio_processor_set_agc_target(audio::AudioProcessor* processor, float target) {
     if (processor) {
         processor->setAGCTarget(target);
     }
 }
 
-void audio_processor_set_noise_gate_threshold(AudioProcessor* processor, float threshold) {
+void audio_processor_set_noise_gate_threshold(audio::AudioProcessor* processor, float threshold) {
     if (processor) {
         processor->setNoiseGateThreshold(threshold);
     }
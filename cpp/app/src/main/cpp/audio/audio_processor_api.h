@@ -0,0 +1,46 @@
+#ifndef AUDIO_PROCESSOR_API_H
+#define AUDIO_PROCESSOR_API_H
+
+#include <cstdint>
+
+// Interface C do processador de áudio (audio_processor.cpp).
+// A classe fica no namespace audio para não colidir com o AudioProcessor
+// do núcleo DSP (java/) quando os dois são ligados no runner headless.
+namespace audio {
+class AudioProcessor;
+}
+
+class PipelineProfiler;
+
+extern "C" {
+
+audio::AudioProcessor* audio_processor_create();
+void audio_processor_destroy(audio::AudioProcessor* processor);
+
+// audio_length: capacidade de audio_data na entrada, amostras escritas na saída
+void audio_processor_process_iq(audio::AudioProcessor* processor,
+                              const uint8_t* iq_data, int iq_length,
+                              float* audio_data, int* audio_length,
+                              const char* demod_type);
+
+// Taxa do SDR na entrada e taxa exata de saída (a do AudioManager::startAudio)
+bool audio_processor_set_sample_rates(audio::AudioProcessor* processor, int sdr_rate, int audio_rate);
+
+// Tempo de cada estágio (conversão, demodulação, filtro, AGC, noise gate,
+// reamostragem) no profiler do núcleo (java/.../pipeline_profiler.h);
+// nullptr desliga
+void audio_processor_set_profiler(audio::AudioProcessor* processor, PipelineProfiler* profiler);
+
+// Cadeia fundida por blocos (padrão) ou um passe completo por estágio
+void audio_processor_set_fused(audio::AudioProcessor* processor, bool fused);
+
+void audio_processor_set_am_gain(audio::AudioProcessor* processor, float gain);
+void audio_processor_set_fm_gain(audio::AudioProcessor* processor, float gain);
+// 0 = atan2 exato, 1 = polinomial (padrão), 2 = quadratura sem atan (fm_discriminator.h)
+void audio_processor_set_fm_accuracy(audio::AudioProcessor* processor, int accuracy);
+void audio_processor_set_agc_target(audio::AudioProcessor* processor, float target);
+void audio_processor_set_noise_gate_threshold(audio::AudioProcessor* processor, float threshold);
+
+} // extern "C"
+
+#endif // AUDIO_PROCESSOR_API_H
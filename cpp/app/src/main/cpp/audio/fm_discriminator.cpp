@@ -0,0 +1,75 @@
+#include "fm_discriminator.h"
+#include <algorithm>
+#include <cmath>
+
+namespace audio {
+
+namespace {
+
+constexpr float PI = 3.14159265358979f;
+constexpr float HALF_PI = 1.57079632679490f;
+
+// atan(a) minimax em [0, 1], polinômio ímpar de grau 11 (A&S 4.4.49)
+inline float atanUnit(float a) {
+    float s = a * a;
+    return a * (0.99997726f + s * (-0.33262347f + s * (0.19354346f +
+           s * (-0.11643287f + s * (0.05265332f + s * -0.01172120f)))));
+}
+
+// Redução ao primeiro octante só com seleções: todas as lanes seguem o mesmo caminho
+inline float atan2Polynomial(float y, float x) {
+    float ax = std::fabs(x);
+    float ay = std::fabs(y);
+    float hi = std::max(ax, ay);
+    float lo = std::min(ax, ay);
+    float angle = atanUnit(lo / std::max(hi, 1e-30f));
+    angle = ay > ax ? HALF_PI - angle : angle;
+    angle = x < 0.0f ? PI - angle : angle;
+    return std::copysign(angle, y);
+}
+
+inline float step(float i, float q, float pi, float pq, DiscriminatorAccuracy accuracy) {
+    float im = q * pi - i * pq;
+    if (accuracy == DiscriminatorAccuracy::QUADRATURE) {
+        return im / std::max(i * i + q * q, 1e-30f);
+    }
+    float re = i * pi + q * pq;
+    return accuracy == DiscriminatorAccuracy::EXACT ? std::atan2(im, re) : atan2Polynomial(im, re);
+}
+
+} // namespace
+
+void discriminateFM(const float* i, const float* q, size_t count,
+                    float& prevI, float& prevQ, float* out, DiscriminatorAccuracy accuracy) {
+    if (count == 0) {
+        return;
+    }
+    
+    out[0] = step(i[0], q[0], prevI, prevQ, accuracy);
+    
+    // Um laço por nível, para o vetorizador ver um corpo sem desvios
+    switch (accuracy) {
+        case DiscriminatorAccuracy::EXACT:
+            for (size_t k = 1; k < count; ++k) {
+                out[k] = step(i[k], q[k], i[k - 1], q[k - 1], DiscriminatorAccuracy::EXACT);
+            }
+            break;
+        
+        case DiscriminatorAccuracy::POLYNOMIAL:
+            for (size_t k = 1; k < count; ++k) {
+                out[k] = step(i[k], q[k], i[k - 1], q[k - 1], DiscriminatorAccuracy::POLYNOMIAL);
+            }
+            break;
+        
+        case DiscriminatorAccuracy::QUADRATURE:
+            for (size_t k = 1; k < count; ++k) {
+                out[k] = step(i[k], q[k], i[k - 1], q[k - 1], DiscriminatorAccuracy::QUADRATURE);
+            }
+            break;
+    }
+    
+    prevI = i[count - 1];
+    prevQ = q[count - 1];
+}
+
+} // namespace audio
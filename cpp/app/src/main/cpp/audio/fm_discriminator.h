@@ -0,0 +1,28 @@
+#ifndef AUDIO_FM_DISCRIMINATOR_H
+#define AUDIO_FM_DISCRIMINATOR_H
+
+#include <cstddef>
+
+namespace audio {
+
+// Níveis de precisão do discriminador de fase FM, do mais ao menos exato
+enum class DiscriminatorAccuracy {
+    EXACT = 0,      // std::atan2 por amostra; referência
+    POLYNOMIAL = 1, // atan2 minimax sem desvios, erro abaixo de 2e-6 rad
+    QUADRATURE = 2  // atraso em quadratura sem atan: seno do passo de fase
+};
+
+// Passo de fase entre amostras consecutivas, em radianos (-pi, pi]:
+//   out[k] = arg(x[k] * conj(x[k-1])), x = i + jq
+// x[-1] vem de prevI/prevQ, que saem com a última amostra do bloco.
+// Trabalha sobre o produto conjugado, então não há diferença de fases a
+// desembrulhar. POLYNOMIAL e QUADRATURE não têm desvios nem chamadas à libm
+// no laço e compilam para 4 (NEON/SSE) ou 8 (AVX) amostras por iteração.
+// QUADRATURE fica 1% abaixo em 0,25 rad; na taxa cheia do SDR
+// (2048000 Hz) o desvio de 75 kHz do FM comercial dá 0,23 rad.
+void discriminateFM(const float* i, const float* q, size_t count,
+                    float& prevI, float& prevQ, float* out, DiscriminatorAccuracy accuracy);
+
+} // namespace audio
+
+#endif // AUDIO_FM_DISCRIMINATOR_H
@@ -0,0 +1,101 @@
+#include "resampler.h"
+#include <algorithm>
+#include <cmath>
+
+namespace audio {
+
+Resampler::Resampler()
+    : preDecimation_(1)
+    , prePos_(0)
+    , prePhase_(0)
+    , configured_(false) {
+}
+
+bool Resampler::configure(int inputRate, int outputRate) {
+    configured_ = false;
+    if (inputRate <= 0 || outputRate <= 0) {
+        return false;
+    }
+    
+    // Escolher D: a taxa intermediária deve ficar >= 2x a saída, e o resto
+    // da razão precisa caber num banco polifásico do núcleo
+    const int d = RationalResampler::choosePreDecimation(inputRate, outputRate, MIN_OVERSAMPLING);
+    if (!polyphase_.configure(inputRate, outputRate * d)) {
+        return false;
+    }
+    
+    // Estágio 1: passa até 0.45 * saída e rejeita tudo que dobraria sobre
+    // essa faixa na taxa intermediária
+    preDecimation_ = d;
+    if (d > 1) {
+        double intermediate = static_cast<double>(inputRate) / d;
+        double passband = 0.45 * outputRate;
+        double transition = (intermediate - 2.0 * passband) / inputRate;
+        int length = static_cast<int>(std::ceil(4.32 / transition)) | 1;
+        double cutoff = 0.5 * intermediate / inputRate;
+        std::vector<float> taps = RationalResampler::designLowPass(length, cutoff, 1.0);
+        preTaps_.assign(taps.rbegin(), taps.rend());
+        preDelay_.assign(2 * preTaps_.size(), 0.0f);
+    } else {
+        preTaps_.clear();
+        preDelay_.clear();
+    }
+    
+    configured_ = true;
+    reset();
+    return true;
+}
+
+void Resampler::reset() {
+    std::fill(preDelay_.begin(), preDelay_.end(), 0.0f);
+    prePos_ = 0;
+    prePhase_ = 0;
+    polyphase_.reset();
+}
+
+void Resampler::process(const float* input, size_t count, std::vector<float>& output) {
+    if (!configured_) {
+        return;
+    }
+    
+    if (preDecimation_ == 1) {
+        processPolyphase(input, count, output);
+        return;
+    }
+    
+    // Estágio 1: só calcula as saídas mantidas
+    const size_t taps = preTaps_.size();
+    float* delay = preDelay_.data();
+    stage1Output_.clear();
+    stage1Output_.reserve(count / preDecimation_ + 1);
+    
+    for (size_t i = 0; i < count; ++i) {
+        delay[prePos_] = delay[prePos_ + taps] = input[i];
+        if (++prePos_ == taps) {
+            prePos_ = 0;
+        }
+        
+        if (++prePhase_ < preDecimation_) {
+            continue;
+        }
+        prePhase_ = 0;
+        
+        const float* window = delay + prePos_;
+        float acc = 0.0f;
+        for (size_t k = 0; k < taps; ++k) {
+            acc += preTaps_[k] * window[k];
+        }
+        stage1Output_.push_back(acc);
+    }
+    
+    processPolyphase(stage1Output_.data(), stage1Output_.size(), output);
+}
+
+void Resampler::processPolyphase(const float* input, size_t count, std::vector<float>& output) {
+    const size_t start = output.size();
+    output.resize(start + polyphase_.maxOutput(count));
+    size_t produced = polyphase_.process(input, count, output.data() + start);
+    output.resize(start + produced);
+}
+
+} // namespace audio
@@ -0,0 +1,56 @@
+#ifndef AUDIO_RESAMPLER_H
+#define AUDIO_RESAMPLER_H
+
+#include <cstddef>
+#include <vector>
+
+#include "rational_resampler.h"
+
+namespace audio {
+
+// Reamostrador racional exato para áudio real: taxa de saída = entrada * L / M
+// sem arredondamento, então o AudioManager recebe exatamente a taxa com que
+// foi aberto. Funciona em dois estágios:
+//   1. FIR decimador inteiro (fator D), que leva a taxa do SDR para perto
+//      do dobro da taxa de áudio;
+//   2. banco polifásico L/M, pré-calculado para a razão restante.
+// D é o maior fator que ainda deixa um banco L/M viável no núcleo
+// (2048000 -> 44100 usa D = 20 e L/M = 441/1024); o projeto dos filtros e o
+// estágio 2 são os do RationalResampler do núcleo.
+class Resampler {
+public:
+    Resampler();
+    
+    // Projeta os dois estágios para inputRate -> outputRate e zera o estado
+    bool configure(int inputRate, int outputRate);
+    void reset();
+    
+    // Acrescenta em output todas as amostras produzidas por count entradas
+    void process(const float* input, size_t count, std::vector<float>& output);
+    
+    int getPreDecimation() const { return preDecimation_; }
+    int getInterpolation() const { return polyphase_.getInterpolation(); }
+    int getDecimation() const { return polyphase_.getDecimation(); }
+
+private:
+    void processPolyphase(const float* input, size_t count, std::vector<float>& output);
+    
+    // Estágio 1: FIR decimador com linha de atraso circular de comprimento duplo
+    int preDecimation_;
+    std::vector<float> preTaps_;        // invertidos, mais antigo primeiro
+    std::vector<float> preDelay_;
+    size_t prePos_;
+    int prePhase_;
+    std::vector<float> stage1Output_;
+    
+    // Estágio 2: banco polifásico L/M da taxa intermediária para a saída
+    RationalResampler polyphase_;
+    bool configured_;
+    
+    // Taxa intermediária mínima, em múltiplos da saída
+    static constexpr int MIN_OVERSAMPLING = 2;
+};
+
+} // namespace audio
+
+#endif // AUDIO_RESAMPLER_H
@@ -23,7 +23,13 @@ AudioManager::AudioManager()
     , running_(false)
     , sampleRate_(44100)
     , channels_(1)
-    , volume_(1.0f) {
+    , volume_(1.0f)
+    , bufferCount_(DEFAULT_BUFFER_COUNT)
+    , framesPerBuffer_(DEFAULT_FRAMES_PER_BUFFER)
+    , maxQueuedMs_(DEFAULT_MAX_QUEUED_MS)
+    , samplesPerBuffer_(0)
+    , nextBuffer_(0)
+    , underruns_(0) {
     
     LOGI("AudioManager constructor called");
 }
@@ -49,9 +55,6 @@ bool AudioManager::initialize() {
     initialized_ = true;
     running_ = true;
     
-    // Iniciar thread de processamento
-    processThread_ = std::thread(&AudioManager::processAudioQueue, this);
-    
     LOGI("AudioManager initialized successfully");
     return true;
 }
@@ -62,13 +65,7 @@ void AudioManager::shutdown() {
     running_ = false;
     playing_ = false;
     
-    if (processThread_.joinable()) {
-        processCondition_.notify_all();
-        processThread_.join();
-    }
-    
     destroyOpenSL();
-    clearAudioQueue();
     
     initialized_ = false;
     LOGI("AudioManager shutdown complete");
@@ -90,37 +87,68 @@ bool AudioManager::startAudio(int sampleRate, int channels) {
     sampleRate_ = sampleRate;
     channels_ = channels;
     
+    // Toda a memória do caminho de áudio é reservada aqui: o conjunto de
+    // buffers do OpenSL e a fila limitada a maxQueuedMs_ de áudio
+    samplesPerBuffer_ = static_cast<size_t>(framesPerBuffer_) * channels_;
+    bufferPool_.assign(samplesPerBuffer_ * bufferCount_, 0);
+    nextBuffer_ = 0;
+    
+    size_t queuedSamples = static_cast<size_t>(sampleRate_) * channels_ * maxQueuedMs_ / 1000;
+    audioRing_.allocate(std::max(queuedSamples, samplesPerBuffer_));
+    underruns_.store(0);
+    
+    // O player segue a taxa e os canais pedidos agora
+    if (!createPlayer()) {
+        destroyPlayer();
+        return false;
+    }
+    
     // Configurar volume
     if (playerVolume_) {
         SLmillibel volume = static_cast<SLmillibel>(volume_ * 1000);
         (*playerVolume_)->SetVolumeLevel(playerVolume_, volume);
     }
     
-    // Iniciar reprodução
-    if (playerPlay_) {
-        SLresult result = (*playerPlay_)->SetPlayState(playerPlay_, SL_PLAYSTATE_PLAYING);
-        if (result != SL_RESULT_SUCCESS) {
-            LOGE("Failed to start audio playback: %d", result);
-            return false;
-        }
+    // Todos os buffers entram na fila antes do PLAYING; depois disso cada
+    // um volta pelo bufferQueueCallback e é reenchido ali mesmo
+    for (int i = 0; i < bufferCount_; ++i) {
+        enqueueNextBuffer();
     }
     
+    // Iniciar reprodução; playing_ vem antes para que nenhum callback
+    // devolvido saia do rodízio
     playing_ = true;
-    LOGI("Audio started successfully");
+    SLresult result = (*playerPlay_)->SetPlayState(playerPlay_, SL_PLAYSTATE_PLAYING);
+    if (result != SL_RESULT_SUCCESS) {
+        LOGE("Failed to start audio playback: %d", result);
+        playing_ = false;
+        destroyPlayer();
+        return false;
+    }
+    
+    LOGI("Audio started successfully: %d x %d frames, queue %zu samples",
+         bufferCount_, framesPerBuffer_, audioRing_.limit());
     return true;
 }
 
 void AudioManager::stopAudio() {
     LOGI("Stopping audio");
     
+    playing_ = false;
+    
+    // Parar e limpar a fila do player antes de soltar os buffers
     if (playerPlay_) {
         (*playerPlay_)->SetPlayState(playerPlay_, SL_PLAYSTATE_STOPPED);
     }
+    if (playerBufferQueue_) {
+        (*playerBufferQueue_)->Clear(playerBufferQueue_);
+    }
+    destroyPlayer();
+    audioRing_.discard();
     
-    playing_ = false;
-    clearAudioQueue();
-    
-    LOGI("Audio stopped");
+    LOGI("Audio stopped: %llu underruns, %llu samples dropped",
+         static_cast<unsigned long long>(getUnderrunCount()),
+         static_cast<unsigned long long>(getDroppedSamples()));
 }
 
 bool AudioManager::isAudioPlaying() const {
@@ -128,40 +156,20 @@ bool AudioManager::isAudioPlaying() const {
 }
 
 bool AudioManager::writeAudioData(const std::vector<float>& audioData) {
-    if (!playing_) {
-        return false;
-    }
-    
-    // Converter float para int16_t
-    std::vector<int16_t> int16Data;
-    int16Data.reserve(audioData.size());
-    
-    for (float sample : audioData) {
-        // Clamp entre -1.0 e 1.0
-        sample = std::max(-1.0f, std::min(1.0f, sample));
-        
-        // Converter para int16_t
-        int16_t intSample = static_cast<int16_t>(sample * 32767.0f);
-        int16Data.push_back(intSample);
-    }
-    
-    return writeAudioData(int16Data);
+    return writeAudioData(audioData.data(), audioData.size());
 }
 
 bool AudioManager::writeAudioData(const std::vector<int16_t>& audioData) {
+    return writeAudioData(audioData.data(), audioData.size());
+}
+
+bool AudioManager::writeAudioData(const int16_t* audioData, size_t length) {
     if (!playing_) {
         return false;
     }
     
-    std::lock_guard<std::mutex> lock(audioQueueMutex_);
-    
-    // Adicionar dados à fila
-    audioQueue_.push(audioData);
-    
-    // Notificar thread de processamento
-    processCondition_.notify_one();
-    
-    return true;
+    // Nunca bloqueia: o que não cabe na fila é descartado e contado
+    return audioRing_.write(audioData, length) == length;
 }
 
 void AudioManager::setVolume(float volume) {
@@ -181,6 +189,18 @@ void AudioManager::setChannels(int channels) {
     channels_ = channels;
 }
 
+void AudioManager::setBufferCount(int bufferCount) {
+    bufferCount_ = std::max(2, bufferCount);
+}
+
+void AudioManager::setFramesPerBuffer(int framesPerBuffer) {
+    framesPerBuffer_ = std::max(64, framesPerBuffer);
+}
+
+void AudioManager::setMaxQueuedMs(int maxQueuedMs) {
+    maxQueuedMs_ = std::max(1, maxQueuedMs);
+}
+
 void AudioManager::setAudioFinishedCallback(AudioFinishedCallback callback) {
     audioFinishedCallback_ = callback;
 }
@@ -239,9 +259,14 @@ bool AudioManager::initializeOpenSL() {
         return false;
     }
     
-    // Configurar player de áudio
+    LOGI("OpenSL ES initialized successfully");
+    return true;
+}
+
+bool AudioManager::createPlayer() {
+    // Configurar player de áudio com uma posição na fila por buffer do conjunto
     SLDataLocator_AndroidSimpleBufferQueue loc_bufq = {
-        SL_DATALOCATOR_ANDROIDSIMPLEBUFFERQUEUE, 2
+        SL_DATALOCATOR_ANDROIDSIMPLEBUFFERQUEUE, static_cast<SLuint32>(bufferCount_)
     };
     
     SLDataFormat_PCM format_pcm = {
@@ -270,7 +295,7 @@ bool AudioManager::initializeOpenSL() {
     const SLboolean req[3] = {SL_BOOLEAN_TRUE, SL_BOOLEAN_TRUE, SL_BOOLEAN_TRUE};
     
     // Criar player
-    result = (*engineEngine_)->CreateAudioPlayer(engineEngine_, &playerObject_, &audioSrc, &audioSnk, 3, ids, req);
+    SLresult result = (*engineEngine_)->CreateAudioPlayer(engineEngine_, &playerObject_, &audioSrc, &audioSnk, 3, ids, req);
     if (result != SL_RESULT_SUCCESS) {
         LOGE("Failed to create audio player: %d", result);
         return false;
@@ -318,13 +343,10 @@ bool AudioManager::initializeOpenSL() {
         return false;
     }
     
-    LOGI("OpenSL ES initialized successfully");
     return true;
 }
 
-void AudioManager::destroyOpenSL() {
-    LOGI("Destroying OpenSL ES");
-    
+void AudioManager::destroyPlayer() {
     if (playerObject_) {
         (*playerObject_)->Destroy(playerObject_);
         playerObject_ = nullptr;
@@ -332,6 +354,12 @@ void AudioManager::destroyOpenSL() {
         playerBufferQueue_ = nullptr;
         playerVolume_ = nullptr;
     }
+}
+
+void AudioManager::destroyOpenSL() {
+    LOGI("Destroying OpenSL ES");
+    
+    destroyPlayer();
     
     if (outputMixObject_) {
         (*outputMixObject_)->Destroy(outputMixObject_);
@@ -347,55 +375,33 @@ void AudioManager::destroyOpenSL() {
     LOGI("OpenSL ES destroyed");
 }
 
-void AudioManager::processAudioQueue() {
-    LOGI("Audio processing thread started");
-    
-    while (running_) {
-        std::unique_lock<std::mutex> lock(processMutex_);
-        processCondition_.wait(lock, [this] { return !running_ || !audioQueue_.empty(); });
-        
-        if (!running_) {
-            break;
-        }
-        
-        // Processar dados de áudio da fila
-        std::lock_guard<std::mutex> queueLock(audioQueueMutex_);
-        
-        while (!audioQueue_.empty() && playing_) {
-            currentBuffer_ = audioQueue_.front();
-            audioQueue_.pop();
-            
-            // Enviar buffer para OpenSL ES
-            if (playerBufferQueue_ && !currentBuffer_.empty()) {
-                SLresult result = (*playerBufferQueue_)->Enqueue(playerBufferQueue_, 
-                                                               currentBuffer_.data(), 
-                                                               currentBuffer_.size() * sizeof(int16_t));
-                if (result != SL_RESULT_SUCCESS) {
-                    LOGE("Failed to enqueue audio buffer: %d", result);
-                    if (errorCallback_) {
-                        errorCallback_("Failed to enqueue audio buffer");
-                    }
-                }
-            }
+void AudioManager::enqueueNextBuffer() {
+    // O OpenSL devolve os buffers na ordem em que foram enfileirados, então
+    // o próximo do rodízio é sempre o que acabou de tocar
+    int16_t* buffer = bufferPool_.data() + static_cast<size_t>(nextBuffer_) * samplesPerBuffer_;
+    nextBuffer_ = (nextBuffer_ + 1) % bufferCount_;
+    
+    size_t filled = audioRing_.read(buffer, samplesPerBuffer_);
+    if (filled < samplesPerBuffer_) {
+        // Completar com silêncio; só conta como underrun durante a reprodução
+        std::fill(buffer + filled, buffer + samplesPerBuffer_, 0);
+        if (playing_) {
+            underruns_.fetch_add(1, std::memory_order_relaxed);
         }
     }
     
-    LOGI("Audio processing thread ended");
-}
-
-void AudioManager::clearAudioQueue() {
-    std::lock_guard<std::mutex> lock(audioQueueMutex_);
-    while (!audioQueue_.empty()) {
-        audioQueue_.pop();
+    SLresult result = (*playerBufferQueue_)->Enqueue(playerBufferQueue_, buffer,
+                                                     samplesPerBuffer_ * sizeof(int16_t));
+    if (result != SL_RESULT_SUCCESS) {
+        LOGE("Failed to enqueue audio buffer: %d", result);
     }
-    currentBuffer_.clear();
 }
 
 void AudioManager::bufferQueueCallback(SLAndroidSimpleBufferQueueItf caller, void* context) {
     auto* manager = static_cast<AudioManager*>(context);
-    if (manager) {
-        // Buffer foi processado, podemos enviar mais dados
-        manager->processCondition_.notify_one();
+    if (manager && manager->playing_) {
+        // Buffer foi tocado: reencher e devolver sem sair do callback
+        manager->enqueueNextBuffer();
     }
 }
 
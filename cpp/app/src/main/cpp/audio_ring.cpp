@@ -0,0 +1,68 @@
+#include "audio_ring.h"
+#include <algorithm>
+
+AudioRing::AudioRing()
+    : capacity_(0)
+    , limit_(0)
+    , mask_(0)
+    , writeIndex_(0)
+    , readIndex_(0)
+    , dropped_(0) {
+}
+
+void AudioRing::allocate(size_t limit) {
+    size_t capacity = 1;
+    while (capacity < limit) {
+        capacity <<= 1;
+    }
+    
+    buffer_.assign(capacity, 0);
+    capacity_ = capacity;
+    limit_ = limit;
+    mask_ = capacity - 1;
+    writeIndex_.store(0);
+    readIndex_.store(0);
+    dropped_.store(0);
+}
+
+size_t AudioRing::write(const int16_t* data, size_t length) {
+    const size_t write = writeIndex_.load(std::memory_order_relaxed);
+    const size_t read = readIndex_.load(std::memory_order_acquire);
+    
+    // O limite, não a capacidade: é ele que segura a latência
+    size_t count = std::min(length, limit_ - std::min(limit_, write - read));
+    if (count < length) {
+        dropped_.fetch_add(length - count, std::memory_order_relaxed);
+    }
+    
+    // No máximo dois trechos contíguos
+    size_t offset = write & mask_;
+    size_t first = std::min(count, capacity_ - offset);
+    std::copy(data, data + first, buffer_.begin() + offset);
+    std::copy(data + first, data + count, buffer_.begin());
+    
+    writeIndex_.store(write + count, std::memory_order_release);
+    return count;
+}
+
+size_t AudioRing::read(int16_t* data, size_t length) {
+    const size_t read = readIndex_.load(std::memory_order_relaxed);
+    const size_t write = writeIndex_.load(std::memory_order_acquire);
+    
+    size_t count = std::min(length, write - read);
+    size_t offset = read & mask_;
+    size_t first = std::min(count, capacity_ - offset);
+    std::copy(buffer_.begin() + offset, buffer_.begin() + offset + first, data);
+    std::copy(buffer_.begin(), buffer_.begin() + (count - first), data + first);
+    
+    readIndex_.store(read + count, std::memory_order_release);
+    return count;
+}
+
+void AudioRing::discard() {
+    readIndex_.store(writeIndex_.load(std::memory_order_acquire), std::memory_order_release);
+}
+
+size_t AudioRing::available() const {
+    return writeIndex_.load(std::memory_order_acquire) - readIndex_.load(std::memory_order_acquire);
+}
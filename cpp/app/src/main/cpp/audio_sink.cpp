@@ -0,0 +1,30 @@
+#include "audio_sink.h"
+#include <algorithm>
+
+namespace {
+
+// Amostras convertidas por vez na pilha
+const size_t CONVERT_CHUNK = 1024;
+
+} // namespace
+
+bool AudioSink::writeAudioData(const float* audioData, size_t length) {
+    int16_t chunk[CONVERT_CHUNK];
+    bool complete = true;
+    
+    for (size_t offset = 0; offset < length; offset += CONVERT_CHUNK) {
+        size_t count = std::min(CONVERT_CHUNK, length - offset);
+        
+        for (size_t i = 0; i < count; ++i) {
+            // Clamp entre -1.0 e 1.0
+            float sample = std::max(-1.0f, std::min(1.0f, audioData[offset + i]));
+            
+            // Converter para int16_t
+            chunk[i] = static_cast<int16_t>(sample * 32767.0f);
+        }
+        
+        complete = writeAudioData(chunk, count) && complete;
+    }
+    
+    return complete;
+}
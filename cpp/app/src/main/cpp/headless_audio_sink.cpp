@@ -0,0 +1,259 @@
+#include "headless_audio_sink.h"
+#include <algorithm>
+
+// NullAudioSink
+
+NullAudioSink::NullAudioSink()
+    : playing_(false)
+    , sampleRate_(0)
+    , channels_(1) {
+}
+
+bool NullAudioSink::startAudio(int sampleRate, int channels) {
+    sampleRate_ = sampleRate;
+    channels_ = channels;
+    playing_ = true;
+    return true;
+}
+
+void NullAudioSink::stopAudio() {
+    playing_ = false;
+}
+
+bool NullAudioSink::writeAudioData(const int16_t*, size_t) {
+    return playing_;
+}
+
+// WavAudioSink
+
+WavAudioSink::WavAudioSink(const std::string& path)
+    : path_(path)
+    , file_(nullptr)
+    , sampleRate_(0)
+    , channels_(1)
+    , dataBytes_(0) {
+}
+
+WavAudioSink::~WavAudioSink() {
+    stopAudio();
+}
+
+bool WavAudioSink::startAudio(int sampleRate, int channels) {
+    stopAudio();
+    
+    file_ = std::fopen(path_.c_str(), "wb");
+    if (!file_) {
+        return false;
+    }
+    
+    sampleRate_ = sampleRate;
+    channels_ = channels;
+    dataBytes_ = 0;
+    writeHeader(0);
+    return true;
+}
+
+void WavAudioSink::stopAudio() {
+    if (file_) {
+        std::fseek(file_, 0, SEEK_SET);
+        writeHeader(dataBytes_);
+        std::fclose(file_);
+        file_ = nullptr;
+    }
+}
+
+bool WavAudioSink::writeAudioData(const int16_t* audioData, size_t length) {
+    if (!file_) {
+        return false;
+    }
+    
+    size_t written = std::fwrite(audioData, sizeof(int16_t), length, file_);
+    dataBytes_ += static_cast<uint32_t>(written * sizeof(int16_t));
+    return written == length;
+}
+
+void WavAudioSink::writeHeader(uint32_t dataBytes) {
+    const uint16_t channels = static_cast<uint16_t>(channels_);
+    const uint16_t bitsPerSample = 16;
+    const uint16_t blockAlign = channels * bitsPerSample / 8;
+    const uint32_t byteRate = static_cast<uint32_t>(sampleRate_) * blockAlign;
+    const uint32_t sampleRate = static_cast<uint32_t>(sampleRate_);
+    const uint32_t riffSize = 36 + dataBytes;
+    const uint32_t fmtSize = 16;
+    const uint16_t pcmFormat = 1;
+    
+    std::fwrite("RIFF", 1, 4, file_);
+    std::fwrite(&riffSize, 4, 1, file_);
+    std::fwrite("WAVEfmt ", 1, 8, file_);
+    std::fwrite(&fmtSize, 4, 1, file_);
+    std::fwrite(&pcmFormat, 2, 1, file_);
+    std::fwrite(&channels, 2, 1, file_);
+    std::fwrite(&sampleRate, 4, 1, file_);
+    std::fwrite(&byteRate, 4, 1, file_);
+    std::fwrite(&blockAlign, 2, 1, file_);
+    std::fwrite(&bitsPerSample, 2, 1, file_);
+    std::fwrite("data", 1, 4, file_);
+    std::fwrite(&dataBytes, 4, 1, file_);
+}
+
+// ClockedAudioSink
+
+ClockedAudioSink::ClockedAudioSink(int bufferCount, int framesPerBuffer, int maxQueuedMs)
+    : bufferCount_(std::max(2, bufferCount))
+    , framesPerBuffer_(std::max(64, framesPerBuffer))
+    , maxQueuedMs_(std::max(1, maxQueuedMs))
+    , sampleRate_(0)
+    , channels_(1)
+    , playing_(false)
+    , marks_(MARK_CAPACITY)
+    , markWrite_(0)
+    , markRead_(0)
+    , samplesWritten_(0)
+    , underruns_(0)
+    , buffersPlayed_(0)
+    , maxQueuedSamples_(0)
+    , delayHistogram_(HISTOGRAM_MS, 0)
+    , delayCount_(0)
+    , maxDelayMs_(0.0) {
+}
+
+ClockedAudioSink::~ClockedAudioSink() {
+    stopAudio();
+}
+
+bool ClockedAudioSink::startAudio(int sampleRate, int channels) {
+    stopAudio();
+    
+    sampleRate_ = sampleRate;
+    channels_ = channels;
+    
+    // Mesmo dimensionamento do AudioManager::startAudio()
+    size_t samplesPerBuffer = static_cast<size_t>(framesPerBuffer_) * channels_;
+    size_t queuedSamples = static_cast<size_t>(sampleRate_) * channels_ * maxQueuedMs_ / 1000;
+    playoutBuffer_.assign(samplesPerBuffer, 0);
+    audioRing_.allocate(std::max(queuedSamples, samplesPerBuffer));
+    
+    markWrite_.store(0);
+    markRead_.store(0);
+    samplesWritten_ = 0;
+    underruns_.store(0);
+    buffersPlayed_ = 0;
+    maxQueuedSamples_ = 0;
+    std::fill(delayHistogram_.begin(), delayHistogram_.end(), 0);
+    delayCount_ = 0;
+    maxDelayMs_ = 0.0;
+    
+    playing_ = true;
+    playoutThread_ = std::thread(&ClockedAudioSink::playoutLoop, this);
+    return true;
+}
+
+void ClockedAudioSink::stopAudio() {
+    playing_ = false;
+    if (playoutThread_.joinable()) {
+        playoutThread_.join();
+    }
+}
+
+bool ClockedAudioSink::writeAudioData(const int16_t* audioData, size_t length) {
+    if (!playing_ || length == 0) {
+        return false;
+    }
+    
+    // A marca vai antes das amostras, assim o consumidor nunca toca uma
+    // amostra cuja marca ainda não viu. Com a fila cheia nada entra e não
+    // há marca.
+    if (audioRing_.available() < audioRing_.limit()) {
+        size_t write = markWrite_.load(std::memory_order_relaxed);
+        if (write - markRead_.load(std::memory_order_acquire) < MARK_CAPACITY) {
+            marks_[write % MARK_CAPACITY] = WriteMark{samplesWritten_, Clock::now()};
+            markWrite_.store(write + 1, std::memory_order_release);
+        }
+    }
+    
+    size_t written = audioRing_.write(audioData, length);
+    samplesWritten_ += written;
+    return written == length;
+}
+
+double ClockedAudioSink::getDelayPercentileMs(double percentile) const {
+    if (delayCount_ == 0) {
+        return 0.0;
+    }
+    
+    // Interpola dentro do balde de 1 ms que alcança o percentil, supondo os
+    // atrasos espalhados por igual nele; o limite superior do balde podia
+    // passar do máximo medido
+    const double target = percentile / 100.0 * delayCount_;
+    uint64_t seen = 0;
+    for (size_t ms = 0; ms < delayHistogram_.size(); ++ms) {
+        const uint64_t bucket = delayHistogram_[ms];
+        if (bucket > 0 && (seen + bucket > target || seen + bucket == delayCount_)) {
+            double fraction = std::min(1.0, (target - seen) / bucket);
+            return std::min(maxDelayMs_, ms + fraction);
+        }
+        seen += bucket;
+    }
+    return maxDelayMs_;
+}
+
+void ClockedAudioSink::playoutLoop() {
+    const size_t samplesPerBuffer = playoutBuffer_.size();
+    const Clock::duration period = std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(static_cast<double>(framesPerBuffer_) / sampleRate_));
+    const double secondsPerFrame = 1.0 / sampleRate_;
+    
+    // Como no AudioManager, a fila do dispositivo começa com bufferCount_
+    // buffers de silêncio e o primeiro volta depois de um período
+    const Clock::time_point start = Clock::now();
+    uint64_t samplesRead = 0;
+    
+    for (uint64_t tick = 1; playing_; ++tick) {
+        // Relógio do "dispositivo": horários fixos, sem acumular atraso
+        const Clock::time_point callbackTime = start + period * tick;
+        std::this_thread::sleep_until(callbackTime);
+        
+        maxQueuedSamples_ = std::max(maxQueuedSamples_, audioRing_.available());
+        size_t filled = audioRing_.read(playoutBuffer_.data(), samplesPerBuffer);
+        if (filled < samplesPerBuffer) {
+            underruns_.fetch_add(1, std::memory_order_relaxed);
+        }
+        
+        // O buffer reenchido entra atrás dos outros bufferCount_ - 1
+        const Clock::time_point playoutStart = callbackTime + period * (bufferCount_ - 1);
+        
+        // Blocos cuja primeira amostra saiu neste buffer
+        for (;;) {
+            size_t read = markRead_.load(std::memory_order_relaxed);
+            if (read == markWrite_.load(std::memory_order_acquire)) {
+                break;
+            }
+            
+            const WriteMark& mark = marks_[read % MARK_CAPACITY];
+            if (mark.firstSample >= samplesRead + filled) {
+                break;
+            }
+            
+            if (mark.firstSample >= samplesRead) {
+                const double offset = static_cast<double>((mark.firstSample - samplesRead) / channels_) * secondsPerFrame;
+                recordDelay(playoutStart + std::chrono::duration_cast<Clock::duration>(
+                    std::chrono::duration<double>(offset)) - mark.time);
+            }
+            markRead_.store(read + 1, std::memory_order_release);
+        }
+        
+        samplesRead += filled;
+        ++buffersPlayed_;
+    }
+    
+    audioRing_.discard();
+}
+
+void ClockedAudioSink::recordDelay(Clock::duration delay) {
+    double ms = std::max(0.0, std::chrono::duration<double, std::milli>(delay).count());
+    size_t bin = std::min(static_cast<size_t>(ms), delayHistogram_.size() - 1);
+    
+    ++delayHistogram_[bin];
+    ++delayCount_;
+    maxDelayMs_ = std::max(maxDelayMs_, ms);
+}
@@ -6,58 +6,83 @@
 #include <vector>
 #include <memory>
 #include <atomic>
-#include <mutex>
-#include <queue>
 #include <functional>
+#include <string>
 
-class AudioManager {
+#include "audio_ring.h"
+#include "audio_sink.h"
+
+// Saída OpenSL ES em modelo pull: um conjunto fixo de buffers
+// pré-alocados circula pela fila do player, e o bufferQueueCallback enche
+// cada buffer devolvido a partir de um AudioRing alimentado por
+// writeAudioData(). Sem thread intermediária, sem mutex e sem alocação
+// depois do startAudio().
+class AudioManager : public AudioSink {
 public:
     // Callback para quando o áudio termina de tocar
     using AudioFinishedCallback = std::function<void()>;
     
     AudioManager();
-    ~AudioManager();
-
+    ~AudioManager() override;
+    
     // Inicialização e finalização
     bool initialize();
     void shutdown();
-
+    
     // Controle de áudio
-    bool startAudio(int sampleRate = 44100, int channels = 1);
-    void stopAudio();
-    bool isAudioPlaying() const;
-
-    // Envio de dados de áudio
+    bool startAudio(int sampleRate = 44100, int channels = 1) override;
+    void stopAudio() override;
+    bool isAudioPlaying() const override;
+    
+    // Envio de dados de áudio (thread produtora única). Retorna false se
+    // parte do bloco foi descartada por falta de espaço na fila.
+    using AudioSink::writeAudioData;
     bool writeAudioData(const std::vector<float>& audioData);
     bool writeAudioData(const std::vector<int16_t>& audioData);
-
+    bool writeAudioData(const int16_t* audioData, size_t length) override;
+    
     // Configurações de áudio
     void setVolume(float volume); // 0.0 a 1.0
     void setSampleRate(int sampleRate);
     void setChannels(int channels);
-
+    
+    // Fila do player: buffers em circulação, frames por buffer e o máximo
+    // de áudio esperando no AudioRing. Valem a partir do próximo startAudio().
+    void setBufferCount(int bufferCount);
+    void setFramesPerBuffer(int framesPerBuffer);
+    void setMaxQueuedMs(int maxQueuedMs);
+    
     // Callbacks
     void setAudioFinishedCallback(AudioFinishedCallback callback);
     void setErrorCallback(std::function<void(const std::string&)> callback);
-
+    
     // Informações
-    int getSampleRate() const;
-    int getChannels() const;
+    int getSampleRate() const override;
+    int getChannels() const override;
+    const char* getName() const override { return "opensl"; }
     float getVolume() const;
+    
+    // Buffers entregues ao OpenSL sem áudio suficiente, amostras
+    // descartadas com a fila cheia e amostras esperando agora
+    uint64_t getUnderrunCount() const override { return underruns_.load(std::memory_order_relaxed); }
+    uint64_t getDroppedSamples() const override { return audioRing_.droppedSamples(); }
+    size_t getQueuedSamples() const override { return audioRing_.available(); }
 
 private:
     // Callbacks do OpenSL ES
     static void bufferQueueCallback(SLAndroidSimpleBufferQueueItf caller, void* context);
     static void playCallback(SLPlayItf caller, void* context, SLuint32 event);
-
-    // Inicialização do OpenSL ES
+    
+    // Inicialização do OpenSL ES: engine e mix ficam, o player é criado
+    // no startAudio() com a taxa, os canais e a fila pedidos
     bool initializeOpenSL();
     void destroyOpenSL();
-
-    // Gerenciamento de buffers
-    void processAudioQueue();
-    void clearAudioQueue();
-
+    bool createPlayer();
+    void destroyPlayer();
+    
+    // Enche o próximo buffer do conjunto a partir do AudioRing e o enfileira
+    void enqueueNextBuffer();
+    
     // Engine e objetos OpenSL ES
     SLObjectItf engineObject_;
     SLEngineItf engineEngine_;
@@ -66,7 +91,7 @@ private:
     SLPlayItf playerPlay_;
     SLAndroidSimpleBufferQueueItf playerBufferQueue_;
     SLVolumeItf playerVolume_;
-
+    
     // Estado
     std::atomic<bool> initialized_;
     std::atomic<bool> playing_;
@@ -76,20 +101,27 @@ private:
     int sampleRate_;
     int channels_;
     float volume_;
+    int bufferCount_;
+    int framesPerBuffer_;
+    int maxQueuedMs_;
     
-    // Buffers de áudio
-    std::queue<std::vector<int16_t>> audioQueue_;
-    std::mutex audioQueueMutex_;
-    std::vector<int16_t> currentBuffer_;
+    // Conjunto de buffers do OpenSL, bufferCount_ x samplesPerBuffer_,
+    // reutilizados na mesma ordem em que o player os devolve
+    std::vector<int16_t> bufferPool_;
+    size_t samplesPerBuffer_;
+    int nextBuffer_;
+    
+    // Thread do SDR -> callback do OpenSL
+    AudioRing audioRing_;
+    std::atomic<uint64_t> underruns_;
+    
+    static const int DEFAULT_BUFFER_COUNT = 3;
+    static const int DEFAULT_FRAMES_PER_BUFFER = 512;
+    static const int DEFAULT_MAX_QUEUED_MS = 200;
     
     // Callbacks
     AudioFinishedCallback audioFinishedCallback_;
     std::function<void(const std::string&)> errorCallback_;
-    
-    // Thread de processamento
-    std::thread processThread_;
-    std::mutex processMutex_;
-    std::condition_variable processCondition_;
 };
 
 #endif // AUDIO_MANAGER_H 
\ No newline at end of file
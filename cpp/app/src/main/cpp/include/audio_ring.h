@@ -0,0 +1,50 @@
+#ifndef AUDIO_RING_H
+#define AUDIO_RING_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Fila circular lock-free de um produtor e um consumidor para PCM int16.
+// O produtor (thread do SDR) nunca espera: o que passa do limite é
+// descartado e contado. O consumidor é o callback do OpenSL, que também
+// nunca espera.
+class AudioRing {
+public:
+    AudioRing();
+    
+    // A fila nunca passa de limit amostras; o armazenamento é arredondado
+    // para potência de dois (para mascarar os índices), mas a sobra não
+    // entra na latência. Só com os dois lados parados.
+    void allocate(size_t limit);
+    
+    size_t capacity() const { return capacity_; }
+    size_t limit() const { return limit_; }
+    
+    // Produtor: copia até length amostras, retorna quantas couberam no limite
+    size_t write(const int16_t* data, size_t length);
+    
+    // Consumidor: copia até length amostras, retorna quantas havia
+    size_t read(int16_t* data, size_t length);
+    
+    // Consumidor: descarta tudo o que está na fila
+    void discard();
+    
+    size_t available() const;
+    uint64_t droppedSamples() const { return dropped_.load(std::memory_order_relaxed); }
+
+private:
+    std::vector<int16_t> buffer_;
+    size_t capacity_;
+    size_t limit_;
+    size_t mask_;
+    
+    // Índices crescem sempre e são mascarados no uso; cada um na sua linha
+    // de cache
+    alignas(64) std::atomic<size_t> writeIndex_;
+    alignas(64) std::atomic<size_t> readIndex_;
+    std::atomic<uint64_t> dropped_;
+};
+
+#endif // AUDIO_RING_H
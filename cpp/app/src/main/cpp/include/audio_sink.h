@@ -0,0 +1,39 @@
+#ifndef AUDIO_SINK_H
+#define AUDIO_SINK_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Destino do PCM produzido pela cadeia de áudio. O AudioManager (OpenSL ES)
+// é a implementação do aparelho; os sinks de headless_audio_sink.h rodam
+// em Linux para medir latência e vazão sem o telefone.
+//
+// writeAudioData() é chamado por uma única thread produtora e nunca deve
+// bloquear: o que não couber é descartado e contado.
+class AudioSink {
+public:
+    virtual ~AudioSink() = default;
+    
+    // Controle de áudio
+    virtual bool startAudio(int sampleRate, int channels) = 0;
+    virtual void stopAudio() = 0;
+    virtual bool isAudioPlaying() const = 0;
+    
+    // PCM intercalado; retorna false se parte do bloco foi descartada
+    virtual bool writeAudioData(const int16_t* audioData, size_t length) = 0;
+    
+    // Converte float [-1, 1] para int16 em pedaços na pilha, sem alocar
+    bool writeAudioData(const float* audioData, size_t length);
+    
+    // Informações
+    virtual int getSampleRate() const = 0;
+    virtual int getChannels() const = 0;
+    virtual const char* getName() const = 0;
+    
+    // Métricas da fila; zero nos sinks que não têm fila
+    virtual uint64_t getUnderrunCount() const { return 0; }
+    virtual uint64_t getDroppedSamples() const { return 0; }
+    virtual size_t getQueuedSamples() const { return 0; }
+};
+
+#endif // AUDIO_SINK_H
@@ -0,0 +1,149 @@
+#ifndef HEADLESS_AUDIO_SINK_H
+#define HEADLESS_AUDIO_SINK_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "audio_ring.h"
+#include "audio_sink.h"
+
+// Sinks sem placa de som, para rodar a cadeia de áudio fora do aparelho
+
+// Descarta tudo; mede só a cadeia DSP
+class NullAudioSink : public AudioSink {
+public:
+    NullAudioSink();
+    
+    bool startAudio(int sampleRate, int channels) override;
+    void stopAudio() override;
+    bool isAudioPlaying() const override { return playing_; }
+    
+    using AudioSink::writeAudioData;
+    bool writeAudioData(const int16_t* audioData, size_t length) override;
+    
+    int getSampleRate() const override { return sampleRate_; }
+    int getChannels() const override { return channels_; }
+    const char* getName() const override { return "null"; }
+
+private:
+    bool playing_;
+    int sampleRate_;
+    int channels_;
+};
+
+// WAV PCM 16 bits; o cabeçalho recebe o tamanho final no stopAudio()
+class WavAudioSink : public AudioSink {
+public:
+    explicit WavAudioSink(const std::string& path);
+    ~WavAudioSink() override;
+    
+    bool startAudio(int sampleRate, int channels) override;
+    void stopAudio() override;
+    bool isAudioPlaying() const override { return file_ != nullptr; }
+    
+    using AudioSink::writeAudioData;
+    bool writeAudioData(const int16_t* audioData, size_t length) override;
+    
+    int getSampleRate() const override { return sampleRate_; }
+    int getChannels() const override { return channels_; }
+    const char* getName() const override { return path_.c_str(); }
+
+private:
+    void writeHeader(uint32_t dataBytes);
+    
+    std::string path_;
+    FILE* file_;
+    int sampleRate_;
+    int channels_;
+    uint32_t dataBytes_;
+};
+
+// Imita o AudioManager em tempo de parede: bufferCount buffers de
+// framesPerBuffer frames na fila do "dispositivo", uma thread que a cada
+// período puxa o próximo buffer do AudioRing como o bufferQueueCallback
+// faria, e o mesmo limite de fila em milissegundos. Mede a profundidade
+// da fila, os underruns e o atraso entre a escrita de cada bloco e a
+// reprodução da sua primeira amostra.
+class ClockedAudioSink : public AudioSink {
+public:
+    ClockedAudioSink(int bufferCount, int framesPerBuffer, int maxQueuedMs);
+    ~ClockedAudioSink() override;
+    
+    bool startAudio(int sampleRate, int channels) override;
+    void stopAudio() override;
+    bool isAudioPlaying() const override { return playing_; }
+    
+    using AudioSink::writeAudioData;
+    bool writeAudioData(const int16_t* audioData, size_t length) override;
+    
+    int getSampleRate() const override { return sampleRate_; }
+    int getChannels() const override { return channels_; }
+    const char* getName() const override { return "clocked"; }
+    
+    uint64_t getUnderrunCount() const override { return underruns_.load(std::memory_order_relaxed); }
+    uint64_t getDroppedSamples() const override { return audioRing_.droppedSamples(); }
+    size_t getQueuedSamples() const override { return audioRing_.available(); }
+    
+    int getBufferCount() const { return bufferCount_; }
+    int getFramesPerBuffer() const { return framesPerBuffer_; }
+    size_t getQueueCapacity() const { return audioRing_.limit(); }
+    
+    // Válidos depois do stopAudio()
+    uint64_t getBuffersPlayed() const { return buffersPlayed_; }
+    size_t getMaxQueuedSamples() const { return maxQueuedSamples_; }
+    uint64_t getDelayCount() const { return delayCount_; }
+    // Interpolado no balde de 1 ms, nunca acima de getMaxDelayMs()
+    double getDelayPercentileMs(double percentile) const;
+    double getMaxDelayMs() const { return maxDelayMs_; }
+    
+    // Histograma do atraso, uma posição por milissegundo; a última junta
+    // tudo acima dela
+    const std::vector<uint64_t>& getDelayHistogram() const { return delayHistogram_; }
+    
+    static const int HISTOGRAM_MS = 1000;
+
+private:
+    using Clock = std::chrono::steady_clock;
+    
+    // Início de um bloco escrito: índice da primeira amostra e instante
+    struct WriteMark {
+        uint64_t firstSample;
+        Clock::time_point time;
+    };
+    
+    void playoutLoop();
+    void recordDelay(Clock::duration delay);
+    
+    int bufferCount_;
+    int framesPerBuffer_;
+    int maxQueuedMs_;
+    int sampleRate_;
+    int channels_;
+    std::atomic<bool> playing_;
+    
+    AudioRing audioRing_;
+    std::vector<int16_t> playoutBuffer_;
+    std::thread playoutThread_;
+    
+    // Marcas do produtor para o consumidor, SPSC de tamanho fixo; sem
+    // espaço a marca é pulada e o bloco fica fora do histograma
+    std::vector<WriteMark> marks_;
+    std::atomic<size_t> markWrite_;
+    std::atomic<size_t> markRead_;
+    uint64_t samplesWritten_;
+    
+    std::atomic<uint64_t> underruns_;
+    uint64_t buffersPlayed_;
+    size_t maxQueuedSamples_;
+    std::vector<uint64_t> delayHistogram_;
+    uint64_t delayCount_;
+    double maxDelayMs_;
+    
+    static const size_t MARK_CAPACITY = 4096;
+};
+
+#endif // HEADLESS_AUDIO_SINK_H
@@ -8,56 +8,62 @@
 #include <thread>
 #include <mutex>
 
+#include "wakeup_meter.h"
+
 // Forward declaration para RTL-SDR
 struct rtlsdr_dev;
 
 class SDRManager {
 public:
     // Callback para dados recebidos
-    using DataCallback = std::function<void(const std::vector<uint8_t>&)>;
+    // Recebe o buffer do driver sem cópia; válido só durante a chamada
+    using DataCallback = std::function<void(const uint8_t* data, size_t length)>;
     
     SDRManager();
     ~SDRManager();
-
+    
     // Inicialização e finalização
     bool initialize();
     void shutdown();
-
+    
     // Controle do dispositivo
     bool openDevice(int deviceIndex = 0);
     void closeDevice();
     bool isDeviceOpen() const;
-
+    
     // Configurações do dispositivo
     bool setFrequency(double frequency);
     bool setSampleRate(int sampleRate);
     bool setGain(float gain);
     bool setAutoGain(bool enabled);
     bool setBandwidth(int bandwidth);
-
+    
     // Controle de streaming
     bool startStreaming();
     void stopStreaming();
     bool isStreaming() const;
-
+    
     // Callbacks
     void setDataCallback(DataCallback callback);
     void setErrorCallback(std::function<void(const std::string&)> callback);
-
+    
     // Informações do dispositivo
     int getDeviceCount() const;
     std::string getDeviceName(int deviceIndex = 0) const;
     double getCurrentFrequency() const;
     int getCurrentSampleRate() const;
     float getCurrentGain() const;
-
+    
     // Thread de processamento
     void processLoop();
+    
+    // Um despertar por bloco lido enquanto há streaming
+    WakeupMeter& readWakeups() { return readWakeups_; }
 
 private:
     // Callback estático para RTL-SDR
     static void rtlsdrCallback(unsigned char* buf, uint32_t len, void* ctx);
-
+    
     rtlsdr_dev* device_;
     std::atomic<bool> deviceOpen_;
     std::atomic<bool> streaming_;
@@ -65,6 +71,7 @@ private:
     
     std::thread processThread_;
     std::mutex mutex_;
+    WakeupMeter readWakeups_;
     
     // Callbacks
     DataCallback dataCallback_;
@@ -8,6 +8,12 @@
 #include <atomic>
 #include <mutex>
 #include <condition_variable>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "pipeline_profiler.h"
+#include "wakeup_meter.h"
 
 // Definições de log
 #define LOG_TAG "SDRRadio"
@@ -16,11 +22,22 @@
 #define LOGW(...) __android_log_print(ANDROID_LOG_WARN, LOG_TAG, __VA_ARGS__)
 #define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
 
+// Despertares por segundo das threads do rádio; 0 quando ocioso
+struct RadioWakeupRates {
+    double sdrRead;       // SDRManager::processLoop, um por bloco
+    double status;        // SDRRadio::processLoop, atualização de status
+    double usbMonitor;    // USBManager::monitorLoop, eventos do libusb
+};
+
 // Forward declarations
 class SDRManager;
 class AudioManager;
 class USBManager;
 
+namespace audio {
+class AudioProcessor;
+}
+
 // Callback interface para notificações do Java
 class SDRCallback {
 public:
@@ -38,34 +55,49 @@ class SDRRadio {
 public:
     SDRRadio();
     ~SDRRadio();
-
+    
     // Inicialização e finalização
     bool initialize();
     void shutdown();
-
+    
     // Controle do dispositivo
     bool connectDevice();
     void disconnectDevice();
     bool isDeviceConnected() const;
-
+    
     // Controle do rádio
     bool startRadio(double frequency, int sampleRate, float gain, bool autoGain);
     void stopRadio();
     bool isRadioRunning() const;
-
+    
     // Configurações
     void setFrequency(double frequency);
     void setSampleRate(int sampleRate);
     void setGain(float gain);
     void setAutoGain(bool autoGain);
-
+    
     // Callbacks
     void setCallback(SDRCallback* callback);
-
+    
+    // Custo de cada estágio desde o startRadio() contra o tempo real
+    PipelineStats getPipelineStats() const { return profiler_.snapshot(); }
+    
+    // Despertares por segundo de cada thread desde a chamada anterior
+    RadioWakeupRates getWakeupRates();
+    
     // Thread de processamento
     void processLoop();
 
 private:
+    // Demodula e reamostra um bloco I/Q para a taxa do AudioManager em
+    // audioScratch_; retorna o número de amostras
+    size_t convertIQToAudio(const uint8_t* iqData, size_t length);
+    void updateAudioRates();
+    float calculateSignalStrength();
+    
+    // Acorda processLoop() depois de mudar running_ ou radioRunning_
+    void wakeProcessLoop();
+    
     std::unique_ptr<SDRManager> sdrManager_;
     std::unique_ptr<AudioManager> audioManager_;
     std::unique_ptr<USBManager> usbManager_;
@@ -79,6 +111,15 @@ private:
     
     std::mutex mutex_;
     std::condition_variable condition_;
+    WakeupMeter statusWakeups_;
+    
+    // Cadeia de áudio (audio/audio_processor.cpp)
+    audio::AudioProcessor* audioProcessor_;
+    std::mutex audioMutex_;
+    std::vector<float> audioScratch_;
+    
+    // Tempos por estágio e por bloco, sempre ligados
+    PipelineProfiler profiler_;
     
     // Configurações atuais
     double currentFrequency_;
@@ -97,6 +138,8 @@ extern "C" {
     JNIEXPORT void JNICALL Java_com_example_sdrradio_SDRRadio_nativeStopRadio(JNIEnv* env, jobject thiz, jlong nativePtr);
     JNIEXPORT jboolean JNICALL Java_com_example_sdrradio_SDRRadio_nativeIsDeviceConnected(JNIEnv* env, jobject thiz, jlong nativePtr);
     JNIEXPORT jboolean JNICALL Java_com_example_sdrradio_SDRRadio_nativeIsRadioRunning(JNIEnv* env, jobject thiz, jlong nativePtr);
+    JNIEXPORT jfloatArray JNICALL Java_com_example_sdrradio_SDRRadio_nativeGetPipelineStats(JNIEnv* env, jobject thiz, jlong nativePtr);
+    JNIEXPORT jfloatArray JNICALL Java_com_example_sdrradio_SDRRadio_nativeGetWakeupRates(JNIEnv* env, jobject thiz, jlong nativePtr);
 }
 
 #endif // SDR_RADIO_H 
\ No newline at end of file
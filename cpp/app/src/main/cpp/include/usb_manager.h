@@ -8,6 +8,8 @@
 #include <mutex>
 #include <thread>
 
+#include "wakeup_meter.h"
+
 // Forward declarations para libusb
 struct libusb_context;
 struct libusb_device;
@@ -23,29 +25,29 @@ public:
         std::string serialNumber;
         int deviceIndex;
     };
-
+    
     // Callbacks
     using DeviceConnectedCallback = std::function<void(const DeviceInfo&)>;
     using DeviceDisconnectedCallback = std::function<void(const DeviceInfo&)>;
     using ErrorCallback = std::function<void(const std::string&)>;
-
+    
     USBManager();
     ~USBManager();
-
+    
     // Inicialização e finalização
     bool initialize();
     void shutdown();
-
+    
     // Controle de dispositivos
     bool openDevice(int deviceIndex = 0);
     bool openDeviceByVendorProduct(uint16_t vendorId, uint16_t productId);
     void closeDevice();
     bool isDeviceOpen() const;
-
+    
     // Enumeração de dispositivos
     std::vector<DeviceInfo> enumerateDevices();
     int getDeviceCount() const;
-
+    
     // Operações USB
     bool claimInterface(int interfaceNumber = 0);
     bool releaseInterface(int interfaceNumber = 0);
@@ -53,17 +55,20 @@ public:
     // Transferências
     int bulkTransfer(unsigned char endpoint, unsigned char* data, int length, unsigned int timeout = 1000);
     int controlTransfer(uint8_t requestType, uint8_t request, uint16_t value, uint16_t index, unsigned char* data, uint16_t length, unsigned int timeout = 1000);
-
+    
     // Callbacks
     void setDeviceConnectedCallback(DeviceConnectedCallback callback);
     void setDeviceDisconnectedCallback(DeviceDisconnectedCallback callback);
     void setErrorCallback(ErrorCallback callback);
-
+    
     // Thread de monitoramento
     void startMonitoring();
     void stopMonitoring();
     void monitorLoop();
-
+    
+    // Um despertar por evento do libusb tratado
+    WakeupMeter& monitorWakeups() { return monitorWakeups_; }
+    
     // Informações do dispositivo atual
     DeviceInfo getCurrentDeviceInfo() const;
     libusb_device_handle* getCurrentDeviceHandle() const;
@@ -71,11 +76,11 @@ public:
 private:
     // Callback estático para libusb
     static int hotplugCallback(libusb_context* ctx, libusb_device* dev, libusb_hotplug_event event, void* user_data);
-
+    
     // Inicialização do libusb
     bool initializeLibUSB();
     void destroyLibUSB();
-
+    
     // Contexto libusb
     libusb_context* context_;
     libusb_device_handle* deviceHandle_;
@@ -89,6 +94,7 @@ private:
     // Thread de monitoramento
     std::thread monitorThread_;
     std::mutex mutex_;
+    WakeupMeter monitorWakeups_;
     
     // Callbacks
     DeviceConnectedCallback deviceConnectedCallback_;
@@ -0,0 +1,29 @@
+#ifndef WAKEUP_METER_H
+#define WAKEUP_METER_H
+
+#include <atomic>
+#include <cstdint>
+
+// Conta quantas vezes uma thread de trabalho acorda, para confirmar que o
+// aparelho fica ocioso sem dados. A própria thread marca cada despertar;
+// um leitor por vez amostra a taxa.
+class WakeupMeter {
+public:
+    WakeupMeter();
+    
+    void tick() { count_.fetch_add(1, std::memory_order_relaxed); }
+    
+    uint64_t total() const { return count_.load(std::memory_order_relaxed); }
+    
+    // Despertares por segundo desde a chamada anterior (ou reset())
+    double ratePerSecond();
+    
+    void reset();
+
+private:
+    std::atomic<uint64_t> count_;
+    uint64_t lastCount_;
+    int64_t lastTimeNs_;
+};
+
+#endif // WAKEUP_METER_H
@@ -1,14 +1,16 @@
+#include "rtlsdr_simulated.h"
 #include <android/log.h>
+#include "async_logger.h"
 #include <cstring>
 #include <cmath>
 #include <cstdlib>
 
 // Definições de log
 #define LOG_TAG "RTL-SDR-Sim"
-#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
-#define LOGD(...) __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, __VA_ARGS__)
-#define LOGW(...) __android_log_print(ANDROID_LOG_WARN, LOG_TAG, __VA_ARGS__)
-#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+#define LOGI(...) ASYNC_LOG(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+#define LOGD(...) ASYNC_LOG(ANDROID_LOG_DEBUG, LOG_TAG, __VA_ARGS__)
+#define LOGW(...) ASYNC_LOG(ANDROID_LOG_WARN, LOG_TAG, __VA_ARGS__)
+#define LOGE(...) ASYNC_LOG(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
 
 // Estrutura simulada do dispositivo RTL-SDR
 struct rtlsdr_dev {
@@ -92,7 +94,7 @@ int rtlsdr_set_center_freq(rtlsdr_dev* dev, uint32_t freq) {
     }
     
     dev->frequency = freq;
-    LOGI("Frequency set to %u Hz (%.1f MHz)", freq, freq / 1e6);
+    LOGD("Frequency set to %u Hz (%.1f MHz)", freq, freq / 1e6);
     return 0;
 }
 
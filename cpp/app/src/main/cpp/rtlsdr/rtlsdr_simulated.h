@@ -0,0 +1,26 @@
+#ifndef RTLSDR_SIMULATED_H
+#define RTLSDR_SIMULATED_H
+
+#include <cstdint>
+
+// Interface da biblioteca RTL-SDR simulada (rtlsdr_simulated.cpp)
+struct rtlsdr_dev;
+
+extern "C" {
+
+int rtlsdr_open(rtlsdr_dev** dev, int index);
+void rtlsdr_close(rtlsdr_dev* dev);
+int rtlsdr_get_device_count();
+
+int rtlsdr_set_center_freq(rtlsdr_dev* dev, uint32_t freq);
+uint32_t rtlsdr_get_center_freq(rtlsdr_dev* dev);
+int rtlsdr_set_sample_rate(rtlsdr_dev* dev, uint32_t rate);
+uint32_t rtlsdr_get_sample_rate(rtlsdr_dev* dev);
+
+int rtlsdr_read_sync(rtlsdr_dev* dev, void* buf, int len, int* n_read);
+int rtlsdr_read_async(rtlsdr_dev* dev, void (*cb)(unsigned char*, uint32_t, void*), void* ctx, uint32_t buf_num, uint32_t buf_len);
+int rtlsdr_cancel_async(rtlsdr_dev* dev);
+
+} // extern "C"
+
+#endif // RTLSDR_SIMULATED_H
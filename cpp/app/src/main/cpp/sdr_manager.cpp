@@ -1,14 +1,16 @@
 #include "sdr_manager.h"
 #include <android/log.h>
+#include "async_logger.h"
 #include <cmath>
 #include <algorithm>
+#include <chrono>
 
 // Definições de log
 #define LOG_TAG "SDRManager"
-#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
-#define LOGD(...) __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, __VA_ARGS__)
-#define LOGW(...) __android_log_print(ANDROID_LOG_WARN, LOG_TAG, __VA_ARGS__)
-#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+#define LOGI(...) ASYNC_LOG(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+#define LOGD(...) ASYNC_LOG(ANDROID_LOG_DEBUG, LOG_TAG, __VA_ARGS__)
+#define LOGW(...) ASYNC_LOG(ANDROID_LOG_WARN, LOG_TAG, __VA_ARGS__)
+#define LOGE(...) ASYNC_LOG(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
 
 // Simulação da estrutura rtlsdr_dev para desenvolvimento
 struct rtlsdr_dev {
@@ -19,6 +21,7 @@ struct rtlsdr_dev {
     bool auto_gain;
     int bandwidth;
     bool streaming;
+    std::chrono::steady_clock::time_point nextRead;
 };
 
 // Simulação das funções RTL-SDR
@@ -48,7 +51,7 @@ extern "C" {
     int rtlsdr_set_center_freq(rtlsdr_dev* dev, uint32_t freq) {
         if (dev && dev->is_open) {
             dev->frequency = freq;
-            LOGI("Frequency set to %u Hz", freq);
+            LOGD("Frequency set to %u Hz", freq);
             return 0;
         }
         return -1;
@@ -108,6 +111,16 @@ extern "C" {
                 buffer[i + 1] = static_cast<uint8_t>((noise_q + signal) * 128.0f + 128.0f);
             }
             *n_read = len;
+            
+            // Como a transferência bulk do dongle, só volta quando o bloco
+            // teria chegado na taxa de amostragem; depois de uma pausa
+            // recomeça do agora
+            const auto now = std::chrono::steady_clock::now();
+            if (dev->nextRead < now) {
+                dev->nextRead = now;
+            }
+            dev->nextRead += std::chrono::nanoseconds(static_cast<int64_t>(len / 2) * 1000000000LL / dev->sample_rate);
+            std::this_thread::sleep_until(dev->nextRead);
             return 0;
         }
         return -1;
@@ -240,7 +253,7 @@ bool SDRManager::setFrequency(double frequency) {
         return false;
     }
     
-    LOGI("Frequency set to %.1f MHz", frequency / 1e6);
+    LOGD("Frequency set to %.1f MHz", frequency / 1e6);
     return true;
 }
 
@@ -336,6 +349,7 @@ bool SDRManager::startStreaming() {
     // Iniciar thread de processamento
     running_ = true;
     streaming_ = true;
+    readWakeups_.reset();
     processThread_ = std::thread(&SDRManager::processLoop, this);
     
     LOGI("SDR streaming started");
@@ -401,21 +415,20 @@ void SDRManager::processLoop() {
     std::vector<uint8_t> buffer(bufferSize);
     
     while (running_ && streaming_) {
+        // closeDevice() para o streaming antes de fechar
         if (!device_ || !deviceOpen_) {
-            std::this_thread::sleep_for(std::chrono::milliseconds(100));
-            continue;
+            break;
         }
         
+        // Bloqueia até o dongle entregar o bloco: um despertar por bloco
         int n_read = 0;
         int result = rtlsdr_read_sync(device_, buffer.data(), bufferSize, &n_read);
+        readWakeups_.tick();
         
         if (result == 0 && n_read > 0) {
-            // Copiar dados para um novo buffer
-            std::vector<uint8_t> data(buffer.begin(), buffer.begin() + n_read);
-            
-            // Chamar callback com os dados
+            // Chamar callback direto sobre o buffer de leitura
             if (dataCallback_) {
-                dataCallback_(data);
+                dataCallback_(buffer.data(), static_cast<size_t>(n_read));
             }
         } else if (result != 0) {
             LOGE("Error reading from RTL-SDR: %d", result);
@@ -424,9 +437,6 @@ void SDRManager::processLoop() {
             }
             break;
         }
-        
-        // Pequena pausa para não sobrecarregar o sistema
-        std::this_thread::sleep_for(std::chrono::microseconds(100));
     }
     
     LOGI("SDRManager process loop ended");
@@ -435,7 +445,6 @@ void SDRManager::processLoop() {
 void SDRManager::rtlsdrCallback(unsigned char* buf, uint32_t len, void* ctx) {
     auto* manager = static_cast<SDRManager*>(ctx);
     if (manager && manager->dataCallback_) {
-        std::vector<uint8_t> data(buf, buf + len);
-        manager->dataCallback_(data);
+        manager->dataCallback_(buf, len);
     }
 } 
\ No newline at end of file
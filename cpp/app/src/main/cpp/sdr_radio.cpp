@@ -2,6 +2,7 @@
 #include "sdr_manager.h"
 #include "audio_manager.h"
 #include "usb_manager.h"
+#include "audio_processor_api.h"
 #include <jni.h>
 #include <android/log.h>
 
@@ -14,7 +15,8 @@ SDRRadio::SDRRadio()
     , currentFrequency_(100.0)
     , currentSampleRate_(2048000)
     , currentGain_(20.0)
-    , currentAutoGain_(true) {
+    , currentAutoGain_(true)
+    , audioProcessor_(nullptr) {
     
     LOGI("SDRRadio constructor called");
 }
@@ -32,6 +34,8 @@ bool SDRRadio::initialize() {
         sdrManager_ = std::make_unique<SDRManager>();
         audioManager_ = std::make_unique<AudioManager>();
         usbManager_ = std::make_unique<USBManager>();
+        audioProcessor_ = audio_processor_create();
+        audio_processor_set_profiler(audioProcessor_, &profiler_);
         
         if (!sdrManager_->initialize()) {
             LOGE("Failed to initialize SDRManager");
@@ -49,12 +53,18 @@ bool SDRRadio::initialize() {
         }
         
         // Configurar callbacks
-        sdrManager_->setDataCallback([this](const std::vector<uint8_t>& data) {
+        sdrManager_->setDataCallback([this](const uint8_t* data, size_t length) {
             // Processar dados do SDR e enviar para áudio
             if (radioRunning_) {
-                // Converter dados I/Q para áudio
-                std::vector<float> audioData = convertIQToAudio(data);
-                audioManager_->writeAudioData(audioData);
+                // Converter dados I/Q para áudio, sem alocar por bloco; o
+                // AudioProcessor registra cada estágio no profiler_
+                const int64_t start = PipelineProfiler::now();
+                size_t audioLength = convertIQToAudio(data, length);
+                StageTimer timer(&profiler_);
+                audioManager_->writeAudioData(audioScratch_.data(), audioLength);
+                timer.lap(PipelineStage::AUDIO_CONVERSION, audioLength);
+                
+                profiler_.recordBlock(length / 2, currentSampleRate_, PipelineProfiler::now() - start);
             }
         });
         
@@ -80,6 +90,7 @@ bool SDRRadio::initialize() {
         usbManager_->setDeviceDisconnectedCallback([this](const USBManager::DeviceInfo& device) {
             deviceConnected_ = false;
             radioRunning_ = false;
+            wakeProcessLoop();
             if (callback_) {
                 callback_->onDeviceDisconnected();
             }
@@ -109,6 +120,7 @@ void SDRRadio::shutdown() {
     
     running_ = false;
     radioRunning_ = false;
+    wakeProcessLoop();
     
     if (processThread_.joinable()) {
         processThread_.join();
@@ -126,6 +138,12 @@ void SDRRadio::shutdown() {
         usbManager_->shutdown();
     }
     
+    {
+        std::lock_guard<std::mutex> lock(audioMutex_);
+        audio_processor_destroy(audioProcessor_);
+        audioProcessor_ = nullptr;
+    }
+    
     LOGI("SDRRadio shutdown complete");
 }
 
@@ -228,7 +246,12 @@ bool SDRRadio::startRadio(double frequency, int sampleRate, float gain, bool aut
         currentGain_ = gain;
         currentAutoGain_ = autoGain;
         
+        // Áudio sai exatamente na taxa com que o AudioManager foi aberto
+        updateAudioRates();
+        
+        profiler_.reset();
         radioRunning_ = true;
+        wakeProcessLoop();
         
         if (callback_) {
             callback_->onRadioStarted();
@@ -247,6 +270,7 @@ void SDRRadio::stopRadio() {
     LOGI("Stopping radio");
     
     radioRunning_ = false;
+    wakeProcessLoop();
     
     if (sdrManager_) {
         sdrManager_->stopStreaming();
@@ -278,6 +302,15 @@ void SDRRadio::setSampleRate(int sampleRate) {
     currentSampleRate_ = sampleRate;
     if (radioRunning_ && sdrManager_) {
         sdrManager_->setSampleRate(sampleRate);
+        updateAudioRates();
+    }
+}
+
+void SDRRadio::updateAudioRates() {
+    std::lock_guard<std::mutex> lock(audioMutex_);
+    if (audioProcessor_ && audioManager_) {
+        audio_processor_set_sample_rates(audioProcessor_, currentSampleRate_,
+                                         audioManager_->getSampleRate());
     }
 }
 
@@ -299,44 +332,67 @@ void SDRRadio::setCallback(SDRCallback* callback) {
     callback_ = callback;
 }
 
+void SDRRadio::wakeProcessLoop() {
+    // Sob o mutex, para o aviso não cair entre o teste e a espera
+    std::lock_guard<std::mutex> lock(mutex_);
+    condition_.notify_all();
+}
+
+RadioWakeupRates SDRRadio::getWakeupRates() {
+    RadioWakeupRates rates = {};
+    rates.sdrRead = sdrManager_ ? sdrManager_->readWakeups().ratePerSecond() : 0.0;
+    rates.status = statusWakeups_.ratePerSecond();
+    rates.usbMonitor = usbManager_ ? usbManager_->monitorWakeups().ratePerSecond() : 0.0;
+    return rates;
+}
+
 void SDRRadio::processLoop() {
     LOGI("SDRRadio process loop started");
     
+    // Intervalo da força do sinal com o rádio ligado
+    const auto statusInterval = std::chrono::milliseconds(100);
+    
+    std::unique_lock<std::mutex> lock(mutex_);
     while (running_) {
-        // Processar eventos e atualizar status
-        if (radioRunning_) {
-            // Calcular força do sinal (simulado por enquanto)
-            float signalStrength = calculateSignalStrength();
-            if (callback_) {
-                callback_->onSignalStrengthChanged(signalStrength);
-            }
+        if (!radioRunning_) {
+            // Rádio parado: dorme até startRadio(), stopRadio() ou shutdown()
+            condition_.wait(lock, [this] { return !running_ || radioRunning_; });
+            continue;
+        }
+        
+        lock.unlock();
+        statusWakeups_.tick();
+        
+        // Calcular força do sinal (simulado por enquanto)
+        float signalStrength = calculateSignalStrength();
+        if (callback_) {
+            callback_->onSignalStrengthChanged(signalStrength);
         }
         
-        // Aguardar um pouco antes da próxima iteração
-        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        lock.lock();
+        condition_.wait_for(lock, statusInterval, [this] { return !running_ || !radioRunning_; });
     }
     
     LOGI("SDRRadio process loop ended");
 }
 
 // Função auxiliar para converter dados I/Q para áudio
-std::vector<float> SDRRadio::convertIQToAudio(const std::vector<uint8_t>& iqData) {
-    std::vector<float> audioData;
-    
-    // Converter dados I/Q (8-bit) para float
-    for (size_t i = 0; i < iqData.size(); i += 2) {
-        if (i + 1 < iqData.size()) {
-            // Converter I e Q para float (-1.0 a 1.0)
-            float i_val = (iqData[i] - 128.0f) / 128.0f;
-            float q_val = (iqData[i + 1] - 128.0f) / 128.0f;
-            
-            // Aplicar demodulação AM simples (magnitude)
-            float magnitude = std::sqrt(i_val * i_val + q_val * q_val);
-            audioData.push_back(magnitude);
-        }
+size_t SDRRadio::convertIQToAudio(const uint8_t* iqData, size_t length) {
+    std::lock_guard<std::mutex> lock(audioMutex_);
+    if (!audioProcessor_) {
+        return 0;
+    }
+    
+    // Demodulação AM + reamostragem para a taxa do AudioManager; o bloco
+    // de saída nunca passa de uma amostra por par I/Q. O scratch só cresce.
+    if (audioScratch_.size() < length / 2) {
+        audioScratch_.resize(length / 2);
     }
+    int audioLength = static_cast<int>(length / 2);
+    audio_processor_process_iq(audioProcessor_, iqData, static_cast<int>(length),
+                               audioScratch_.data(), &audioLength, "AM");
     
-    return audioData;
+    return static_cast<size_t>(audioLength);
 }
 
 // Função auxiliar para calcular força do sinal
@@ -406,4 +462,48 @@ JNIEXPORT jboolean JNICALL Java_com_example_sdrradio_SDRRadio_nativeIsRadioRunni
     return sdrRadio->isRadioRunning() ? JNI_TRUE : JNI_FALSE;
 }
 
+// Blocos, blocos atrasados, % ocupado do orçamento e pior bloco %; depois,
+// para cada PipelineStage, chamadas, amostras, ns por amostra e % do orçamento
+JNIEXPORT jfloatArray JNICALL Java_com_example_sdrradio_SDRRadio_nativeGetPipelineStats(JNIEnv* env, jobject thiz, jlong nativePtr) {
+    auto* sdrRadio = reinterpret_cast<SDRRadio*>(nativePtr);
+    if (!sdrRadio) return nullptr;
+    
+    const int stages = static_cast<int>(PipelineStage::COUNT);
+    const int size = 4 + stages * 4;
+    jfloat values[size];
+    
+    PipelineStats stats = sdrRadio->getPipelineStats();
+    values[0] = static_cast<jfloat>(stats.blocks);
+    values[1] = static_cast<jfloat>(stats.deadline_misses);
+    values[2] = static_cast<jfloat>(stats.busy_percent);
+    values[3] = static_cast<jfloat>(stats.worst_block_percent);
+    for (int i = 0; i < stages; ++i) {
+        const StageStats& stage = stats.stages[i];
+        values[4 + i * 4 + 0] = static_cast<jfloat>(stage.calls);
+        values[4 + i * 4 + 1] = static_cast<jfloat>(stage.samples);
+        values[4 + i * 4 + 2] = static_cast<jfloat>(stage.ns_per_sample);
+        values[4 + i * 4 + 3] = static_cast<jfloat>(stage.budget_percent);
+    }
+    
+    jfloatArray result = env->NewFloatArray(size);
+    env->SetFloatArrayRegion(result, 0, size, values);
+    return result;
+}
+
+JNIEXPORT jfloatArray JNICALL Java_com_example_sdrradio_SDRRadio_nativeGetWakeupRates(JNIEnv* env, jobject thiz, jlong nativePtr) {
+    auto* sdrRadio = reinterpret_cast<SDRRadio*>(nativePtr);
+    if (!sdrRadio) return nullptr;
+    
+    RadioWakeupRates rates = sdrRadio->getWakeupRates();
+    jfloat values[3] = {
+        static_cast<jfloat>(rates.sdrRead),
+        static_cast<jfloat>(rates.status),
+        static_cast<jfloat>(rates.usbMonitor)
+    };
+    
+    jfloatArray result = env->NewFloatArray(3);
+    env->SetFloatArrayRegion(result, 0, 3, values);
+    return result;
+}
+
 } // extern "C" 
\ No newline at end of file
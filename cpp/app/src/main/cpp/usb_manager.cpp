@@ -1,6 +1,8 @@
 #include "usb_manager.h"
 #include <android/log.h>
 #include <cstring>
+#include <condition_variable>
+#include <mutex>
 
 // Definições de log
 #define LOG_TAG "USBManager"
@@ -12,6 +14,11 @@
 // Simulação das estruturas libusb para desenvolvimento
 struct libusb_context {
     bool initialized;
+    
+    // libusb_handle_events() dorme aqui até um evento ou interrupção
+    std::mutex eventMutex;
+    std::condition_variable eventCondition;
+    bool interrupted = false;
 };
 
 struct libusb_device {
@@ -156,9 +163,20 @@ extern "C" {
     
     int libusb_handle_events(libusb_context* ctx) {
         if (!ctx) return -1;
-        // Simular processamento de eventos
+        // Como no libusb, bloqueia até haver evento; a simulação não gera
+        // hotplug, então só libusb_interrupt_event_handler() acorda
+        std::unique_lock<std::mutex> lock(ctx->eventMutex);
+        ctx->eventCondition.wait(lock, [ctx] { return ctx->interrupted; });
+        ctx->interrupted = false;
         return 0;
     }
+    
+    void libusb_interrupt_event_handler(libusb_context* ctx) {
+        if (!ctx) return;
+        std::lock_guard<std::mutex> lock(ctx->eventMutex);
+        ctx->interrupted = true;
+        ctx->eventCondition.notify_all();
+    }
 }
 
 USBManager::USBManager()
@@ -452,6 +470,7 @@ void USBManager::startMonitoring() {
     
     monitoring_ = true;
     running_ = true;
+    monitorWakeups_.reset();
     monitorThread_ = std::thread(&USBManager::monitorLoop, this);
     
     LOGI("USB device monitoring started");
@@ -463,6 +482,11 @@ void USBManager::stopMonitoring() {
     monitoring_ = false;
     running_ = false;
     
+    // Tira a thread de dentro de libusb_handle_events()
+    if (context_) {
+        libusb_interrupt_event_handler(context_);
+    }
+    
     if (monitorThread_.joinable()) {
         monitorThread_.join();
     }
@@ -473,13 +497,11 @@ void USBManager::stopMonitoring() {
 void USBManager::monitorLoop() {
     LOGI("USB monitoring thread started");
     
-    while (running_ && monitoring_) {
-        if (context_) {
-            libusb_handle_events(context_);
-        }
-        
-        // Pequena pausa para não sobrecarregar o sistema
-        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    // libusb_handle_events() bloqueia até um evento de hotplug ou até
+    // stopMonitoring() interromper: sem sondagem periódica
+    while (running_ && monitoring_ && context_) {
+        libusb_handle_events(context_);
+        monitorWakeups_.tick();
     }
     
     LOGI("USB monitoring thread ended");
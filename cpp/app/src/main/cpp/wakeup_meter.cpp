@@ -0,0 +1,34 @@
+#include "wakeup_meter.h"
+#include <chrono>
+
+namespace {
+
+int64_t nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+} // namespace
+
+WakeupMeter::WakeupMeter()
+    : count_(0)
+    , lastCount_(0)
+    , lastTimeNs_(nowNs()) {
+}
+
+double WakeupMeter::ratePerSecond() {
+    const uint64_t count = total();
+    const int64_t now = nowNs();
+    const int64_t elapsed = now - lastTimeNs_;
+    const double rate = elapsed > 0 ? (count - lastCount_) * 1e9 / elapsed : 0.0;
+    
+    lastCount_ = count;
+    lastTimeNs_ = now;
+    return rate;
+}
+
+void WakeupMeter::reset() {
+    count_.store(0, std::memory_order_relaxed);
+    lastCount_ = 0;
+    lastTimeNs_ = nowNs();
+}
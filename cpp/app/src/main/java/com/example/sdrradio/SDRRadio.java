@@ -156,6 +156,32 @@ public class SDRRadio {
         return isRadioRunning;
     }
     
+    /**
+     * Custo do caminho quente desde o startRadio(): blocos, blocos
+     * atrasados, % ocupado do orçamento de tempo real e pior bloco %,
+     * depois chamadas, amostras, ns por amostra e % do orçamento de cada
+     * estágio na ordem de PipelineStage (conversão I/Q, filtro de áudio,
+     * demodulação, AGC, noise gate, reamostragem, FFT sem uso aqui, saída de áudio)
+     */
+    public float[] getPipelineStats() {
+        if (nativePtr == 0) {
+            return new float[0];
+        }
+        return nativeGetPipelineStats(nativePtr);
+    }
+    
+    /**
+     * Despertares por segundo desde a chamada anterior: leitura do SDR,
+     * atualização de status e monitor USB. Todos ficam em 0 com o rádio
+     * parado.
+     */
+    public float[] getWakeupRates() {
+        if (nativePtr == 0) {
+            return new float[0];
+        }
+        return nativeGetWakeupRates(nativePtr);
+    }
+    
     /**
      * Obter status do dispositivo
      */
@@ -179,6 +205,8 @@ public class SDRRadio {
     private native void nativeStopRadio(long nativePtr);
     private native boolean nativeIsDeviceConnected(long nativePtr);
     private native boolean nativeIsRadioRunning(long nativePtr);
+    private native float[] nativeGetPipelineStats(long nativePtr);
+    private native float[] nativeGetWakeupRates(long nativePtr);
     
     // Carregar biblioteca nativa
     static {
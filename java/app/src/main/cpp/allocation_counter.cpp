@@ -0,0 +1,61 @@
+#include "allocation_counter.h"
+
+#ifdef SDR_COUNT_ALLOCATIONS
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+std::atomic<uint64_t> allocation_count{0};
+
+// Plain integer, no constructor or destructor: safe to touch from inside
+// operator new on any thread, including during thread start and exit
+thread_local uint64_t thread_allocation_count = 0;
+
+void* countedAllocate(size_t size) {
+    allocation_count.fetch_add(1, std::memory_order_relaxed);
+    ++thread_allocation_count;
+    if (void* p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+} // namespace
+
+void* operator new(size_t size) { return countedAllocate(size); }
+void* operator new[](size_t size) { return countedAllocate(size); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+void operator delete[](void* p, size_t) noexcept { std::free(p); }
+
+bool allocationCountingEnabled() {
+    return true;
+}
+
+uint64_t allocationCount() {
+    return allocation_count.load(std::memory_order_relaxed);
+}
+
+uint64_t threadAllocationCount() {
+    return thread_allocation_count;
+}
+
+#else
+
+bool allocationCountingEnabled() {
+    return false;
+}
+
+uint64_t allocationCount() {
+    return 0;
+}
+
+uint64_t threadAllocationCount() {
+    return 0;
+}
+
+#endif // SDR_COUNT_ALLOCATIONS
@@ -0,0 +1,37 @@
+#ifndef ALLOCATION_COUNTER_H
+#define ALLOCATION_COUNTER_H
+
+#include <cassert>
+#include <cstdint>
+
+// Heap allocation counter for checking the zero-allocation steady state of
+// the streaming loop. Built with SDR_COUNT_ALLOCATIONS (debug builds), the
+// global operator new is replaced by a counting one; otherwise counting is
+// compiled out and the count stays 0.
+
+bool allocationCountingEnabled();
+
+// operator new calls so far, all threads
+uint64_t allocationCount();
+
+// operator new calls so far on the calling thread
+uint64_t threadAllocationCount();
+
+// Asserts on destruction that nothing in the scope allocated on the
+// scope's own thread; the UI, spectrum readers, workers and the logger
+// may allocate meanwhile without tripping it.
+class NoAllocationScope {
+public:
+    NoAllocationScope() : start_(threadAllocationCount()) {}
+    ~NoAllocationScope() { assert(allocations() == 0 && "heap allocation in steady state"); }
+    
+    NoAllocationScope(const NoAllocationScope&) = delete;
+    NoAllocationScope& operator=(const NoAllocationScope&) = delete;
+    
+    uint64_t allocations() const { return threadAllocationCount() - start_; }
+
+private:
+    uint64_t start_;
+};
+
+#endif // ALLOCATION_COUNTER_H
@@ -10,10 +10,26 @@
 
 AudioProcessor::AudioProcessor()
     : volume_(0.5f)
+    , drift_compensation_(true)
+    , compensating_(false)
+    , consumer_active_(false)
+    , last_samples_read_(0)
+    , samples_since_read_(CONSUMER_IDLE_SAMPLES)
+    , samples_read_(0)
+    , resyncs_(0)
+    , target_fill_(AUDIO_BUFFER_SIZE / 4)
+    , drift_ppm_(0.0f)
+    , correction_ppm_(0.0f)
+    , average_fill_(0.0f)
     , audio_read_pos_(0)
-    , audio_write_pos_(0) {
+    , audio_write_pos_(0)
+    , write_total_(0)
+    , read_total_(0)
+    , tracer_(nullptr)
+    , profiler_(nullptr) {
     
     audio_buffer_.resize(AUDIO_BUFFER_SIZE, 0);
+    drift_compensator_.setTargetFill(target_fill_.load());
     
     LOGI("Audio processor initialized");
 }
@@ -22,40 +38,153 @@ AudioProcessor::~AudioProcessor() {
     LOGI("Audio processor destroyed");
 }
 
-void AudioProcessor::processAudio(const std::vector<float>& audio_samples) {
-    if (audio_samples.empty()) {
+void AudioProcessor::processAudio(const float* audio_samples, size_t count) {
+    StageTimer timer(profiler_);
+    const size_t input_count = count;
+    const bool compensate = drift_compensation_.load();
+    if (compensate != compensating_) {
+        // Each switch starts the loop over from a clean resampler
+        drift_compensator_.reset();
+        consumer_active_ = false;
+        samples_since_read_ = CONSUMER_IDLE_SAMPLES;
+        compensating_ = compensate;
+    }
+    
+    // Fixed-size chunks through a member scratch, so no block size allocates
+    if (!compensating_) {
+        while (count > 0) {
+            size_t chunk = std::min(count, CONVERT_CHUNK);
+            processChunk(audio_samples, chunk);
+            audio_samples += chunk;
+            count -= chunk;
+        }
+        timer.lap(PipelineStage::AUDIO_CONVERSION, input_count);
         return;
     }
     
+    size_t written = 0;
+    while (count > 0) {
+        size_t chunk = std::min(count, RESAMPLE_CHUNK);
+        size_t produced = drift_compensator_.process(audio_samples, chunk, resampled_);
+        processChunk(resampled_, produced);
+        written += produced;
+        audio_samples += chunk;
+        count -= chunk;
+    }
+    
+    steerClock(written);
+    timer.lap(PipelineStage::AUDIO_CONVERSION, input_count);
+}
+
+void AudioProcessor::steerClock(size_t written) {
+    // The consumer reads in bursts; it is only idle after a second or so
+    // without any read
+    const uint64_t samples_read = samples_read_.load();
+    if (samples_read != last_samples_read_) {
+        last_samples_read_ = samples_read;
+        samples_since_read_ = 0;
+    } else if (samples_since_read_ < CONSUMER_IDLE_SAMPLES) {
+        samples_since_read_ += written;
+    }
+    
+    if (samples_since_read_ >= CONSUMER_IDLE_SAMPLES) {
+        // Nobody drains the buffer, so its fill says nothing about clocks
+        consumer_active_ = false;
+        return;
+    }
+    
+    const size_t target = target_fill_.load();
+    if (target != drift_compensator_.getTargetFill()) {
+        drift_compensator_.setTargetFill(target);
+    }
+    
+    // Acquisition, or an error the loop would take minutes to absorb: jump
+    // once to the target and let the loop hold it from there
+    size_t fill = bufferedSamples();
+    if (!consumer_active_ || fill > 2 * target) {
+        if (fill > target) {
+            skipTo(target);
+            if (consumer_active_) {
+                resyncs_.fetch_add(1);
+            }
+        }
+        drift_compensator_.restart();
+        consumer_active_ = true;
+    } else {
+        drift_compensator_.update(fill, written);
+    }
+    
+    drift_ppm_.store(static_cast<float>(drift_compensator_.getDriftPpm()));
+    correction_ppm_.store(static_cast<float>(drift_compensator_.getCorrectionPpm()));
+    average_fill_.store(static_cast<float>(drift_compensator_.getAverageFill()));
+}
+
+size_t AudioProcessor::bufferedSamples() const {
+    size_t read_pos = audio_read_pos_.load();
+    size_t write_pos = audio_write_pos_.load();
+    return (write_pos >= read_pos) ? (write_pos - read_pos) : (AUDIO_BUFFER_SIZE - read_pos + write_pos);
+}
+
+void AudioProcessor::skipTo(size_t fill) {
+    std::lock_guard<std::mutex> lock(buffer_mutex_);
+    
+    size_t write_pos = audio_write_pos_.load();
+    audio_read_pos_.store((write_pos + AUDIO_BUFFER_SIZE - fill) % AUDIO_BUFFER_SIZE);
+    read_total_ = write_total_ - fill;
+}
+
+void AudioProcessor::stampNextBlock(int64_t ingest_ns) {
+    if (tracer_) {
+        BlockStamp stamp = {write_total_, ingest_ns, LatencyTracer::now()};
+        audio_stamps_.push(stamp);
+    }
+}
+
+void AudioProcessor::setTargetFill(size_t samples) {
+    // Room above the target for the resync threshold and the overflow jump
+    target_fill_.store(std::max<size_t>(CONVERT_CHUNK, std::min(samples, AUDIO_BUFFER_SIZE / 3)));
+}
+
+ClockDriftStats AudioProcessor::getClockDriftStats() const {
+    ClockDriftStats stats;
+    stats.drift_ppm = drift_ppm_.load();
+    stats.correction_ppm = correction_ppm_.load();
+    stats.average_fill = average_fill_.load();
+    stats.target_fill = target_fill_.load();
+    stats.resyncs = resyncs_.load();
+    stats.locked = drift_compensation_.load() && consumer_active_.load();
+    return stats;
+}
+
+void AudioProcessor::processChunk(const float* audio_samples, size_t count) {
     // Convert float samples to int16_t
-    std::vector<int16_t> int_samples;
-    int_samples.reserve(audio_samples.size());
+    int16_t* int_samples = int_samples_;
     
-    for (float sample : audio_samples) {
+    for (size_t i = 0; i < count; ++i) {
         // Clamp to [-1.0, 1.0] range
-        sample = std::max(-1.0f, std::min(1.0f, sample));
+        float sample = std::max(-1.0f, std::min(1.0f, audio_samples[i]));
         
         // Convert to int16_t
-        int16_t int_sample = static_cast<int16_t>(sample * MAX_AMPLITUDE);
-        int_samples.push_back(int_sample);
+        int_samples[i] = static_cast<int16_t>(sample * MAX_AMPLITUDE);
     }
     
     // Apply volume
-    applyVolume(int_samples);
+    applyVolume(int_samples, count);
     
     // Apply limiter to prevent clipping
-    applyLimiter(int_samples);
+    applyLimiter(int_samples, count);
     
     // Add to audio buffer
     {
         std::lock_guard<std::mutex> lock(buffer_mutex_);
         
         size_t write_pos = audio_write_pos_.load();
-        for (int16_t sample : int_samples) {
-            audio_buffer_[write_pos] = sample;
+        for (size_t i = 0; i < count; ++i) {
+            audio_buffer_[write_pos] = int_samples[i];
             write_pos = (write_pos + 1) % AUDIO_BUFFER_SIZE;
         }
         audio_write_pos_.store(write_pos);
+        write_total_ += count;
         
         // If buffer is getting full, advance read position
         size_t read_pos = audio_read_pos_.load();
@@ -65,11 +194,15 @@ void AudioProcessor::processAudio(const std::vector<float>& audio_samples) {
         if (available > AUDIO_BUFFER_SIZE * 3 / 4) {
             read_pos = (write_pos + AUDIO_BUFFER_SIZE / 4) % AUDIO_BUFFER_SIZE;
             audio_read_pos_.store(read_pos);
+            read_total_ = write_total_ - (AUDIO_BUFFER_SIZE - AUDIO_BUFFER_SIZE / 4);
+            if (consumer_active_) {
+                resyncs_.fetch_add(1);
+            }
         }
     }
 }
 
-std::vector<int16_t> AudioProcessor::getAudioBuffer() {
+size_t AudioProcessor::readAudio(int16_t* output, size_t max_count) {
     std::lock_guard<std::mutex> lock(buffer_mutex_);
     
     size_t read_pos = audio_read_pos_.load();
@@ -77,23 +210,39 @@ std::vector<int16_t> AudioProcessor::getAudioBuffer() {
     
     size_t available = (write_pos >= read_pos) ? 
         (write_pos - read_pos) : (AUDIO_BUFFER_SIZE - read_pos + write_pos);
-    
-    if (available == 0) {
-        return {};
-    }
-    
-    // Return up to 1024 samples at a time to avoid large allocations
-    size_t to_read = std::min(available, static_cast<size_t>(1024));
-    
-    std::vector<int16_t> result;
-    result.reserve(to_read);
+    size_t to_read = std::min(available, max_count);
     
     for (size_t i = 0; i < to_read; ++i) {
-        result.push_back(audio_buffer_[read_pos]);
+        output[i] = audio_buffer_[read_pos];
         read_pos = (read_pos + 1) % AUDIO_BUFFER_SIZE;
     }
     
     audio_read_pos_.store(read_pos);
+    samples_read_.fetch_add(to_read);
+    
+    // Blocks whose first sample just went out; stamps a jump skipped over
+    // are dropped untraced
+    const uint64_t first = read_total_;
+    read_total_ += to_read;
+    if (tracer_) {
+        BlockStamp stamp;
+        int64_t now = 0;
+        while (audio_stamps_.popBefore(read_total_, stamp)) {
+            if (stamp.index >= first) {
+                now = now ? now : LatencyTracer::now();
+                tracer_->record(LatencyStage::AUDIO_QUEUE, now - stamp.stage_ns);
+                tracer_->record(LatencyStage::TOTAL, now - stamp.ingest_ns);
+            }
+        }
+    }
+    
+    return to_read;
+}
+
+std::vector<int16_t> AudioProcessor::getAudioBuffer() {
+    // Return up to 1024 samples at a time to avoid large allocations
+    std::vector<int16_t> result(1024);
+    result.resize(readAudio(result.data(), result.size()));
     return result;
 }
 
@@ -102,25 +251,25 @@ void AudioProcessor::setVolume(float volume) {
     LOGD("Volume set to %.2f", volume_.load());
 }
 
-void AudioProcessor::applyVolume(std::vector<int16_t>& samples) {
+void AudioProcessor::applyVolume(int16_t* samples, size_t count) {
     float vol = volume_.load();
     
     if (vol != 1.0f) {
-        for (int16_t& sample : samples) {
-            float adjusted = static_cast<float>(sample) * vol;
-            sample = static_cast<int16_t>(std::max(-32768.0f, std::min(32767.0f, adjusted)));
+        for (size_t i = 0; i < count; ++i) {
+            float adjusted = static_cast<float>(samples[i]) * vol;
+            samples[i] = static_cast<int16_t>(std::max(-32768.0f, std::min(32767.0f, adjusted)));
         }
     }
 }
 
-void AudioProcessor::applyLimiter(std::vector<int16_t>& samples) {
+void AudioProcessor::applyLimiter(int16_t* samples, size_t count) {
     int16_t threshold = static_cast<int16_t>(MAX_AMPLITUDE * LIMITER_THRESHOLD);
     
-    for (int16_t& sample : samples) {
-        if (sample > threshold) {
-            sample = threshold;
-        } else if (sample < -threshold) {
-            sample = -threshold;
+    for (size_t i = 0; i < count; ++i) {
+        if (samples[i] > threshold) {
+            samples[i] = threshold;
+        } else if (samples[i] < -threshold) {
+            samples[i] = -threshold;
         }
     }
 }
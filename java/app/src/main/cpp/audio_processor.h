@@ -2,26 +2,97 @@
 #define AUDIO_PROCESSOR_H
 
 #include <vector>
+#include <cstdint>
 #include <atomic>
 #include <mutex>
 
+#include "drift_compensator.h"
+#include "latency_tracer.h"
+#include "pipeline_profiler.h"
+
+// State of the clock-drift loop, for display and logging
+struct ClockDriftStats {
+    float drift_ppm;        // audio output clock vs SDR clock, estimated
+    float correction_ppm;   // resampling ratio offset applied now
+    float average_fill;     // smoothed ring fill, samples
+    size_t target_fill;     // fill the loop steers to, samples
+    uint64_t resyncs;       // hard jumps of the read position
+    bool locked;            // a consumer is reading and the loop runs
+};
+
 class AudioProcessor {
 public:
     AudioProcessor();
     ~AudioProcessor();
     
-    void processAudio(const std::vector<float>& audio_samples);
+    void processAudio(const float* audio_samples, size_t count);
+    void processAudio(const std::vector<float>& audio_samples) {
+        processAudio(audio_samples.data(), audio_samples.size());
+    }
+    
+    // Copies up to max_count buffered samples to output; returns the number
+    // copied. getAudioBuffer() is the allocating form, 1024 at most.
+    size_t readAudio(int16_t* output, size_t max_count);
     std::vector<int16_t> getAudioBuffer();
     
     void setVolume(float volume);
     float getVolume() const { return volume_; }
     
+    // Steers a fine resampling ratio so the buffer stays at target_fill
+    // samples however far the SDR and audio clocks drift apart. On by
+    // default; off, the buffer only jumps when it is about to overflow.
+    void setDriftCompensation(bool enable) { drift_compensation_.store(enable); }
+    void setTargetFill(size_t samples);
+    ClockDriftStats getClockDriftStats() const;
+    
+    // Latency tracing: with a tracer set, stampNextBlock() marks where the
+    // next processAudio() call starts writing, and readAudio() records
+    // AUDIO_QUEUE and TOTAL when it hands that sample out. Set the tracer
+    // before either thread runs.
+    void setLatencyTracer(LatencyTracer* tracer) { tracer_ = tracer; }
+    void stampNextBlock(int64_t ingest_ns);
+    
+    // Times each processAudio() as AUDIO_CONVERSION; nullptr turns it off
+    void setProfiler(PipelineProfiler* profiler) { profiler_ = profiler; }
+    
 private:
-    void applyVolume(std::vector<int16_t>& samples);
-    void applyLimiter(std::vector<int16_t>& samples);
+    void processChunk(const float* audio_samples, size_t count);
+    void steerClock(size_t written);
+    size_t bufferedSamples() const;
+    void skipTo(size_t fill);
+    void applyVolume(int16_t* samples, size_t count);
+    void applyLimiter(int16_t* samples, size_t count);
     
     std::atomic<float> volume_;
     
+    // Conversion scratch for one chunk of a block
+    static const size_t CONVERT_CHUNK = 1024;
+    int16_t int_samples_[CONVERT_CHUNK];
+    
+    // Clock-drift loop. The compensator and the read count seen by the
+    // last block belong to the producer; the rest is published for
+    // getClockDriftStats().
+    DriftCompensator drift_compensator_;
+    std::atomic<bool> drift_compensation_;
+    bool compensating_;
+    std::atomic<bool> consumer_active_;
+    uint64_t last_samples_read_;
+    size_t samples_since_read_;
+    std::atomic<uint64_t> samples_read_;
+    std::atomic<uint64_t> resyncs_;
+    std::atomic<size_t> target_fill_;
+    std::atomic<float> drift_ppm_;
+    std::atomic<float> correction_ppm_;
+    std::atomic<float> average_fill_;
+    
+    // Resampler output for one input piece; pieces are half a chunk so the
+    // ratio never overruns it
+    static const size_t RESAMPLE_CHUNK = CONVERT_CHUNK / 2;
+    float resampled_[CONVERT_CHUNK];
+    
+    // Written samples with no read before the consumer counts as idle
+    static const size_t CONSUMER_IDLE_SAMPLES = 48000;
+    
     // Audio buffer for output
     std::vector<int16_t> audio_buffer_;
     std::atomic<size_t> audio_read_pos_;
@@ -29,6 +100,15 @@ private:
     std::mutex buffer_mutex_;
     static const size_t AUDIO_BUFFER_SIZE = 16384;
     
+    // Absolute sample indices for the stamps: every sample ever written,
+    // and the next one to read, moved by reads and by jumps alike
+    uint64_t write_total_;
+    uint64_t read_total_;
+    LatencyTracer* tracer_;
+    BlockStampQueue audio_stamps_;
+    
+    PipelineProfiler* profiler_;
+    
     // Audio processing parameters
     static const int16_t MAX_AMPLITUDE = 32000;
     static constexpr float LIMITER_THRESHOLD = 0.95f;
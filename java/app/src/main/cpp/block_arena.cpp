@@ -0,0 +1,57 @@
+#include "block_arena.h"
+#include <cstdint>
+
+namespace {
+
+size_t alignUp(size_t bytes) {
+    return (bytes + BlockArena::ALIGNMENT - 1) & ~(BlockArena::ALIGNMENT - 1);
+}
+
+} // namespace
+
+BlockArena::BlockArena(size_t initial_bytes)
+    : base_(nullptr)
+    , capacity_(0)
+    , used_(0)
+    , spill_bytes_(0) {
+    
+    if (initial_bytes > 0) {
+        capacity_ = alignUp(initial_bytes);
+        chunk_ = allocateChunk(capacity_, base_);
+    }
+}
+
+void BlockArena::reset() {
+    if (spill_bytes_ > 0) {
+        // Grow once to hold the whole block that just spilled, with headroom
+        size_t needed = used_ + spill_bytes_;
+        capacity_ = alignUp(needed + needed / 2);
+        spill_.clear();
+        chunk_ = allocateChunk(capacity_, base_);
+    }
+    
+    used_ = 0;
+    spill_bytes_ = 0;
+}
+
+void* BlockArena::allocateBytes(size_t bytes) {
+    bytes = alignUp(bytes);
+    
+    if (used_ + bytes <= capacity_) {
+        void* p = base_ + used_;
+        used_ += bytes;
+        return p;
+    }
+    
+    unsigned char* aligned = nullptr;
+    spill_.push_back(allocateChunk(bytes, aligned));
+    spill_bytes_ += bytes;
+    return aligned;
+}
+
+std::unique_ptr<unsigned char[]> BlockArena::allocateChunk(size_t bytes, unsigned char*& aligned) {
+    std::unique_ptr<unsigned char[]> chunk(new unsigned char[bytes + ALIGNMENT]);
+    uintptr_t address = reinterpret_cast<uintptr_t>(chunk.get());
+    aligned = chunk.get() + (alignUp(address) - address);
+    return chunk;
+}
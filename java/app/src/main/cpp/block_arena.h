@@ -0,0 +1,53 @@
+#ifndef BLOCK_ARENA_H
+#define BLOCK_ARENA_H
+
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+// Bump allocator for the per-block scratch of one pipeline. Every stage
+// buffer of a block is carved from one chunk and the whole arena is
+// released at once by reset() when the next block starts, so buffers cost
+// a pointer bump and no heap traffic.
+//
+// A block that outgrows the chunk spills into extra chunks, and the next
+// reset() replaces everything with one chunk big enough for it. After the
+// largest block has been seen once, the arena never touches the heap again.
+// Not thread-safe; one arena per processing thread.
+class BlockArena {
+public:
+    explicit BlockArena(size_t initial_bytes = 0);
+    
+    // Uninitialized storage for count Ts, ALIGNMENT-aligned, valid until
+    // the next reset()
+    template <typename T>
+    T* allocate(size_t count) {
+        static_assert(std::is_trivially_destructible<T>::value,
+                      "BlockArena never runs destructors");
+        return static_cast<T*>(allocateBytes(count * sizeof(T)));
+    }
+    
+    // Releases every allocation; coalesces spill chunks into one
+    void reset();
+    
+    size_t capacity() const { return capacity_; }
+    size_t used() const { return used_ + spill_bytes_; }
+    
+    static const size_t ALIGNMENT = 64;    // cache line, and any SIMD width
+
+private:
+    void* allocateBytes(size_t bytes);
+    static std::unique_ptr<unsigned char[]> allocateChunk(size_t bytes, unsigned char*& aligned);
+    
+    std::unique_ptr<unsigned char[]> chunk_;
+    unsigned char* base_;
+    size_t capacity_;
+    size_t used_;
+    
+    // Spill chunks of the current block, merged on reset()
+    std::vector<std::unique_ptr<unsigned char[]>> spill_;
+    size_t spill_bytes_;
+};
+
+#endif // BLOCK_ARENA_H
@@ -0,0 +1,100 @@
+#include "channel_bank.h"
+#include <android/log.h>
+#include "async_logger.h"
+#include <algorithm>
+
+#include "pipeline_profiler.h"
+
+#define LOG_TAG "Channel_Bank"
+#define LOGI(...) ASYNC_LOG(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+#define LOGE(...) ASYNC_LOG(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+#define LOGD(...) ASYNC_LOG(ANDROID_LOG_DEBUG, LOG_TAG, __VA_ARGS__)
+
+ChannelBank::ChannelBank()
+    : sample_rate_(0)
+    , profiler_(nullptr) {
+}
+
+ChannelBank::~ChannelBank() = default;
+
+bool ChannelBank::configure(int channels, bool oversampled, int sample_rate) {
+    if (sample_rate <= 0 || !channelizer_.configure(channels, oversampled)) {
+        LOGE("Invalid channel bank: %d channels at %d Hz", channels, sample_rate);
+        return false;
+    }
+    
+    sample_rate_ = sample_rate;
+    channels_.clear();
+    channels_.resize(channels);
+    LOGI("Channel bank: %d channels of %.0f Hz, %s, %zu-tap prototype", channels,
+         static_cast<double>(sample_rate) / channels, oversampled ? "oversampled" : "critically sampled",
+         channelizer_.getNumTaps());
+    return true;
+}
+
+bool ChannelBank::enableChannel(int channel, DemodulationType type, int audio_decimation) {
+    if (channel < 0 || channel >= static_cast<int>(channels_.size())) {
+        LOGE("No channel %d", channel);
+        return false;
+    }
+    
+    Channel& entry = channels_[channel];
+    if (!entry.demodulator) {
+        entry.demodulator = std::make_unique<Demodulator>();
+    }
+    entry.demodulator->setType(type);
+    if (!entry.demodulator->setDecimation(audio_decimation)) {
+        return false;
+    }
+    // Full scale at half the channel spacing, as SignalProcessor does with
+    // its bandwidth
+    const double channel_rate = getChannelRate();
+    const int spacing = sample_rate_ / static_cast<int>(channels_.size());
+    entry.demodulator->setFmDeviation(static_cast<int>(channel_rate), std::max(1, spacing / 2));
+    entry.audio_count = 0;
+    channelizer_.setActive(channel, true);
+    LOGD("Channel %d at %+.0f Hz enabled, mode %d", channel, channelOffset(channel), static_cast<int>(type));
+    return true;
+}
+
+void ChannelBank::disableChannel(int channel) {
+    if (channel < 0 || channel >= static_cast<int>(channels_.size())) {
+        return;
+    }
+    channelizer_.setActive(channel, false);
+    channels_[channel].demodulator.reset();
+    channels_[channel].audio_count = 0;
+}
+
+bool ChannelBank::isEnabled(int channel) const {
+    return channel >= 0 && channel < static_cast<int>(channels_.size()) && channels_[channel].demodulator;
+}
+
+double ChannelBank::getChannelRate() const {
+    return channelizer_.getDecimation() > 0
+        ? static_cast<double>(sample_rate_) / channelizer_.getDecimation()
+        : 0.0;
+}
+
+size_t ChannelBank::process(const std::complex<float>* samples, size_t count) {
+    StageTimer timer(profiler_);
+    const size_t frames = channelizer_.process(samples, count);
+    timer.lap(PipelineStage::CHANNEL_FILTER, count);
+    
+    size_t demodulated = 0;
+    for (size_t channel = 0; channel < channels_.size(); ++channel) {
+        Channel& entry = channels_[channel];
+        if (!entry.demodulator) {
+            continue;
+        }
+        const size_t needed = entry.demodulator->maxOutput(frames);
+        if (entry.audio.size() < needed) {
+            entry.audio.resize(needed);
+        }
+        entry.audio_count = entry.demodulator->demodulate(channelizer_.output(static_cast<int>(channel)),
+                                                          frames, entry.audio.data());
+        demodulated += frames;
+    }
+    timer.lap(PipelineStage::DEMOD, demodulated);
+    return frames;
+}
@@ -0,0 +1,61 @@
+#ifndef CHANNEL_BANK_H
+#define CHANNEL_BANK_H
+
+#include <vector>
+#include <complex>
+#include <memory>
+#include <cstddef>
+
+#include "demodulator.h"
+#include "polyphase_channelizer.h"
+
+class PipelineProfiler;
+
+// Many narrowband receivers on one capture: a PolyphaseChannelizer splits
+// it into uniform channels and each enabled channel runs its own
+// Demodulator on its channel's output. Disabled channels are masked off in
+// the channelizer, so they produce nothing and cost nothing downstream.
+class ChannelBank {
+public:
+    ChannelBank();
+    ~ChannelBank();
+    
+    // Drops every enabled channel
+    bool configure(int channels, bool oversampled, int sample_rate);
+    
+    // Audio comes out at getChannelRate() / audio_decimation. Enabling an
+    // enabled channel just changes its mode and decimation.
+    bool enableChannel(int channel, DemodulationType type, int audio_decimation = 1);
+    void disableChannel(int channel);
+    bool isEnabled(int channel) const;
+    int enabledCount() const { return channelizer_.activeCount(); }
+    
+    // Channelizes and demodulates count input samples; returns the
+    // channelizer frames produced. audio(channel) then holds
+    // audioCount(channel) samples, valid until the next call.
+    size_t process(const std::complex<float>* samples, size_t count);
+    const float* audio(int channel) const { return channels_[channel].audio.data(); }
+    size_t audioCount(int channel) const { return channels_[channel].audio_count; }
+    
+    double getChannelRate() const;
+    double channelOffset(int channel) const { return channelizer_.channelOffset(channel, sample_rate_); }
+    int channelForOffset(double offset_hz) const { return channelizer_.channelForOffset(offset_hz, sample_rate_); }
+    const PolyphaseChannelizer& getChannelizer() const { return channelizer_; }
+    
+    // Channelizer time goes to CHANNEL_FILTER, the demodulators' to DEMOD
+    void setProfiler(PipelineProfiler* profiler) { profiler_ = profiler; }
+
+private:
+    struct Channel {
+        std::unique_ptr<Demodulator> demodulator;   // null while disabled
+        std::vector<float> audio;                   // grown, never shrunk
+        size_t audio_count = 0;
+    };
+    
+    PolyphaseChannelizer channelizer_;
+    std::vector<Channel> channels_;
+    int sample_rate_;
+    PipelineProfiler* profiler_;
+};
+
+#endif // CHANNEL_BANK_H
@@ -0,0 +1,144 @@
+#include "decimating_fir.h"
+#include "fixed_point.h"
+#include <algorithm>
+
+DecimatingFIR::DecimatingFIR()
+    : write_pos_(0)
+    , decimation_(1)
+    , phase_(0) {
+}
+
+bool DecimatingFIR::configure(const std::vector<float>& taps, int decimation) {
+    if (taps.empty() || decimation < 1) {
+        return false;
+    }
+    
+    reversed_taps_.assign(taps.rbegin(), taps.rend());
+    decimation_ = decimation;
+    
+    delay_re_.assign(2 * taps.size(), 0.0f);
+    delay_im_.assign(2 * taps.size(), 0.0f);
+    reset();
+    return true;
+}
+
+void DecimatingFIR::reset() {
+    std::fill(delay_re_.begin(), delay_re_.end(), 0.0f);
+    std::fill(delay_im_.begin(), delay_im_.end(), 0.0f);
+    write_pos_ = 0;
+    phase_ = 0;
+}
+
+size_t DecimatingFIR::process(const std::complex<float>* input, size_t count, std::complex<float>* output) {
+    const size_t num_taps = reversed_taps_.size();
+    if (num_taps == 0) {
+        return 0;
+    }
+    
+    size_t produced = 0;
+    
+    const float* taps = reversed_taps_.data();
+    float* delay_re = delay_re_.data();
+    float* delay_im = delay_im_.data();
+    
+    for (size_t i = 0; i < count; ++i) {
+        // Write each sample to both halves so the window never wraps
+        delay_re[write_pos_] = delay_re[write_pos_ + num_taps] = input[i].real();
+        delay_im[write_pos_] = delay_im[write_pos_ + num_taps] = input[i].imag();
+        if (++write_pos_ == num_taps) {
+            write_pos_ = 0;
+        }
+        
+        if (++phase_ < decimation_) {
+            continue;
+        }
+        phase_ = 0;
+        
+        // write_pos_ now indexes the oldest sample of the window
+        const float* window_re = delay_re + write_pos_;
+        const float* window_im = delay_im + write_pos_;
+        float acc_re = 0.0f;
+        float acc_im = 0.0f;
+        for (size_t k = 0; k < num_taps; ++k) {
+            acc_re += taps[k] * window_re[k];
+            acc_im += taps[k] * window_im[k];
+        }
+        
+        output[produced++] = std::complex<float>(acc_re, acc_im);
+    }
+    
+    return produced;
+}
+
+DecimatingFIRQ15::DecimatingFIRQ15()
+    : write_pos_(0)
+    , decimation_(1)
+    , phase_(0) {
+}
+
+bool DecimatingFIRQ15::configure(const std::vector<float>& taps, int decimation) {
+    if (taps.empty() || decimation < 1) {
+        return false;
+    }
+    
+    reversed_taps_.resize(taps.size());
+    for (size_t i = 0; i < taps.size(); ++i) {
+        reversed_taps_[taps.size() - 1 - i] = floatToQ15(taps[i]);
+    }
+    decimation_ = decimation;
+    
+    delay_re_.assign(2 * taps.size(), 0);
+    delay_im_.assign(2 * taps.size(), 0);
+    reset();
+    return true;
+}
+
+void DecimatingFIRQ15::reset() {
+    std::fill(delay_re_.begin(), delay_re_.end(), 0);
+    std::fill(delay_im_.begin(), delay_im_.end(), 0);
+    write_pos_ = 0;
+    phase_ = 0;
+}
+
+size_t DecimatingFIRQ15::process(const std::complex<int16_t>* input, size_t count,
+                                 std::complex<int16_t>* output) {
+    const size_t num_taps = reversed_taps_.size();
+    if (num_taps == 0) {
+        return 0;
+    }
+    
+    size_t produced = 0;
+    
+    const int16_t* taps = reversed_taps_.data();
+    int16_t* delay_re = delay_re_.data();
+    int16_t* delay_im = delay_im_.data();
+    
+    for (size_t i = 0; i < count; ++i) {
+        delay_re[write_pos_] = delay_re[write_pos_ + num_taps] = input[i].real();
+        delay_im[write_pos_] = delay_im[write_pos_ + num_taps] = input[i].imag();
+        if (++write_pos_ == num_taps) {
+            write_pos_ = 0;
+        }
+        
+        if (++phase_ < decimation_) {
+            continue;
+        }
+        phase_ = 0;
+        
+        // Q15 x Q15 products summed in Q30; a low-pass with unity DC gain
+        // has sum |taps| well under 2, so the 32-bit sum cannot wrap
+        const int16_t* window_re = delay_re + write_pos_;
+        const int16_t* window_im = delay_im + write_pos_;
+        int32_t acc_re = 0;
+        int32_t acc_im = 0;
+        for (size_t k = 0; k < num_taps; ++k) {
+            acc_re += static_cast<int32_t>(taps[k]) * window_re[k];
+            acc_im += static_cast<int32_t>(taps[k]) * window_im[k];
+        }
+        
+        output[produced++] = std::complex<int16_t>(saturateQ15((acc_re + (1 << 14)) >> 15),
+                                                   saturateQ15((acc_im + (1 << 14)) >> 15));
+    }
+    
+    return produced;
+}
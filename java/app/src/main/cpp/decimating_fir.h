@@ -0,0 +1,75 @@
+#ifndef DECIMATING_FIR_H
+#define DECIMATING_FIR_H
+
+#include <vector>
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+
+// Complex-input, real-tap FIR filter followed by decimation, computed in
+// polyphase form: only every decimation-th output is evaluated, so the cost
+// per input sample is taps / decimation multiply-adds.
+//
+// The delay line is stored twice back to back (double-length circular
+// buffer), so the newest `taps` samples are always contiguous in memory and
+// each output is a single straight dot product with no shifting or wrap.
+class DecimatingFIR {
+public:
+    DecimatingFIR();
+    
+    // Replaces the taps and decimation factor and clears the filter state
+    bool configure(const std::vector<float>& taps, int decimation);
+    void reset();
+    
+    // Filters count input samples and writes one output per decimation
+    // inputs to output, which must hold maxOutput(count). Returns the
+    // number written. Phase is carried across calls.
+    size_t process(const std::complex<float>* input, size_t count, std::complex<float>* output);
+    size_t maxOutput(size_t count) const { return (phase_ + count) / decimation_; }
+    
+    int getDecimation() const { return decimation_; }
+    size_t getNumTaps() const { return reversed_taps_.size(); }
+
+private:
+    // Same delay line layout; picks up where this filter stopped
+    friend class TranslatingFIR;
+    
+    // Taps in reverse order, so oldest sample pairs with reversed_taps_[0]
+    std::vector<float> reversed_taps_;
+    
+    // Split re/im delay lines, each 2 * taps long
+    std::vector<float> delay_re_;
+    std::vector<float> delay_im_;
+    size_t write_pos_;
+    
+    int decimation_;
+    int phase_;
+};
+
+// Fixed-point twin of DecimatingFIR: Q15 taps and samples, 32-bit
+// accumulation, output saturated back to Q15. Same phase and output
+// timing, so its results line up sample for sample with the float filter.
+class DecimatingFIRQ15 {
+public:
+    DecimatingFIRQ15();
+    
+    // Quantizes the float taps to Q15
+    bool configure(const std::vector<float>& taps, int decimation);
+    void reset();
+    
+    size_t process(const std::complex<int16_t>* input, size_t count, std::complex<int16_t>* output);
+    size_t maxOutput(size_t count) const { return (phase_ + count) / decimation_; }
+    
+    int getDecimation() const { return decimation_; }
+    
+private:
+    std::vector<int16_t> reversed_taps_;
+    std::vector<int16_t> delay_re_;
+    std::vector<int16_t> delay_im_;
+    size_t write_pos_;
+    
+    int decimation_;
+    int phase_;
+};
+
+#endif // DECIMATING_FIR_H
@@ -1,4 +1,5 @@
 #include "demodulator.h"
+#include "fixed_point.h"
 #include <android/log.h>
 #include <cmath>
 #include <algorithm>
@@ -15,7 +16,12 @@
 Demodulator::Demodulator()
     : type_(DemodulationType::FM)
     , last_sample_(0, 0)
-    , decimation_counter_(0) {
+    , last_sample_q15_(0, 0)
+    , decimation_(DEFAULT_DECIMATION)
+    , decimation_counter_(0)
+    , discriminator_accuracy_(DiscriminatorAccuracy::POLYNOMIAL)
+    , fm_gain_(static_cast<float>(10.0 / (2.0 * M_PI)))
+    , fm_gain_q12_(5 << 12) {
     
     LOGI("Demodulator initialized");
 }
@@ -29,27 +35,52 @@ void Demodulator::setType(DemodulationType type) {
     LOGD("Demodulation type set to %d", static_cast<int>(type));
 }
 
-std::vector<float> Demodulator::demodulate(const std::vector<std::complex<float>>& samples) {
+bool Demodulator::setDecimation(int factor) {
+    if (factor < 1) {
+        LOGE("Invalid decimation factor %d", factor);
+        return false;
+    }
+    
+    decimation_ = factor;
+    decimation_counter_ = 0;
+    LOGD("Audio decimation set to %d", factor);
+    return true;
+}
+
+bool Demodulator::setFmDeviation(int sample_rate_hz, int deviation_hz) {
+    if (sample_rate_hz <= 0 || deviation_hz <= 0) {
+        LOGE("Invalid FM deviation %d Hz at %d Hz", deviation_hz, sample_rate_hz);
+        return false;
+    }
+    
+    // Full deviation turns the phase by 2 pi deviation / rate per sample
+    const double gain = static_cast<double>(sample_rate_hz) / (2.0 * M_PI * deviation_hz);
+    fm_gain_ = static_cast<float>(gain);
+    fm_gain_q12_ = static_cast<int32_t>(std::lround(gain * M_PI * 4096.0));
+    LOGD("FM full scale at %d Hz deviation, %d Hz input", deviation_hz, sample_rate_hz);
+    return true;
+}
+
+size_t Demodulator::demodulate(const std::complex<float>* samples, size_t count, float* audio) {
     switch (type_) {
         case DemodulationType::AM:
-            return demodulateAM(samples);
+            return demodulateAM(samples, count, audio);
         case DemodulationType::FM:
-            return demodulateFM(samples);
+            return demodulateFM(samples, count, audio);
         case DemodulationType::USB:
-            return demodulateSSB(samples, true);
+            return demodulateSSB(samples, count, true, audio);
         case DemodulationType::LSB:
-            return demodulateSSB(samples, false);
+            return demodulateSSB(samples, count, false, audio);
         default:
-            return demodulateFM(samples);
+            return demodulateFM(samples, count, audio);
     }
 }
 
-std::vector<float> Demodulator::demodulateAM(const std::vector<std::complex<float>>& samples) {
-    std::vector<float> audio;
-    audio.reserve(samples.size() / DECIMATION_FACTOR + 1);
+size_t Demodulator::demodulateAM(const std::complex<float>* samples, size_t count, float* audio) {
+    size_t produced = 0;
     
-    for (size_t i = 0; i < samples.size(); ++i) {
-        if (decimation_counter_++ >= DECIMATION_FACTOR) {
+    for (size_t i = 0; i < count; ++i) {
+        if (++decimation_counter_ >= decimation_) {
             decimation_counter_ = 0;
             
             // AM demodulation: envelope detection
@@ -61,54 +92,53 @@ std::vector<float> Demodulator::demodulateAM(const std::vector<std::complex<floa
             // Limit output
             audio_sample = std::max(-1.0f, std::min(1.0f, audio_sample));
             
-            audio.push_back(audio_sample);
+            audio[produced++] = audio_sample;
         }
     }
     
-    return audio;
+    return produced;
 }
 
-std::vector<float> Demodulator::demodulateFM(const std::vector<std::complex<float>>& samples) {
-    std::vector<float> audio;
-    audio.reserve(samples.size() / DECIMATION_FACTOR + 1);
+size_t Demodulator::demodulateFM(const std::complex<float>* samples, size_t count, float* audio) {
+    // Bound that does not depend on the decimation phase, so equal blocks
+    // never regrow the gather buffers
+    const size_t max_output = count / decimation_ + 1;
+    if (fm_current_.size() < max_output) {
+        fm_current_.resize(max_output);
+        fm_previous_.resize(max_output);
+    }
     
-    for (size_t i = 0; i < samples.size(); ++i) {
-        if (decimation_counter_++ >= DECIMATION_FACTOR) {
+    size_t produced = 0;
+    for (size_t i = 0; i < count; ++i) {
+        if (++decimation_counter_ >= decimation_) {
             decimation_counter_ = 0;
-            
-            // FM demodulation: phase difference
-            float audio_sample = 0.0f;
-            
-            if (i > 0) {
-                std::complex<float> current = samples[i];
-                std::complex<float> previous = (i > 0) ? samples[i-1] : last_sample_;
-                
-                // Calculate phase difference
-                std::complex<float> diff = current * std::conj(previous);
-                audio_sample = std::arg(diff) / (2.0f * M_PI);
-                
-                // Scale and limit
-                audio_sample *= 10.0f; // Adjust sensitivity
-                audio_sample = std::max(-1.0f, std::min(1.0f, audio_sample));
-            }
-            
-            audio.push_back(audio_sample);
+            fm_current_[produced] = samples[i];
+            fm_previous_[produced] = (i > 0) ? samples[i-1] : last_sample_;
+            ++produced;
         }
     }
     
-    if (!samples.empty()) {
-        last_sample_ = samples.back();
+    // FM demodulation: phase difference, one vector pass over the block
+    fmDiscriminate(fm_current_.data(), fm_previous_.data(), produced, audio, discriminator_accuracy_);
+    
+    // Scale and limit
+    const float gain = fm_gain_;
+    for (size_t i = 0; i < produced; ++i) {
+        audio[i] = std::max(-1.0f, std::min(1.0f, audio[i] * gain));
     }
     
-    return audio;
+    if (count > 0) {
+        last_sample_ = samples[count - 1];
+    }
+    
+    return produced;
 }
 
-std::vector<float> Demodulator::demodulateSSB(const std::vector<std::complex<float>>& samples, bool upper) {
-    std::vector<float> audio;
-    audio.reserve(samples.size() / DECIMATION_FACTOR + 1);
+size_t Demodulator::demodulateSSB(const std::complex<float>* samples, size_t count, bool upper, float* audio) {
+    size_t produced = 0;
     
-    for (size_t i = 0; i < samples.size(); ++i) {
-        if (decimation_counter_++ >= DECIMATION_FACTOR) {
+    for (size_t i = 0; i < count; ++i) {
+        if (++decimation_counter_ >= decimation_) {
             decimation_counter_ = 0;
             
             // SSB demodulation: take real part (USB) or imaginary part (LSB)
@@ -123,9 +153,85 @@ std::vector<float> Demodulator::demodulateSSB(const std::vector<std::complex<flo
             audio_sample *= 2.0f;
             audio_sample = std::max(-1.0f, std::min(1.0f, audio_sample));
             
-            audio.push_back(audio_sample);
+            audio[produced++] = audio_sample;
+        }
+    }
+    
+    return produced;
+}
+
+size_t Demodulator::demodulateQ15(const std::complex<int16_t>* samples, size_t count, int16_t* audio) {
+    switch (type_) {
+        case DemodulationType::AM:
+            return demodulateAMQ15(samples, count, audio);
+        case DemodulationType::USB:
+            return demodulateSSBQ15(samples, count, true, audio);
+        case DemodulationType::LSB:
+            return demodulateSSBQ15(samples, count, false, audio);
+        case DemodulationType::FM:
+        default:
+            return demodulateFMQ15(samples, count, audio);
+    }
+}
+
+size_t Demodulator::demodulateAMQ15(const std::complex<int16_t>* samples, size_t count, int16_t* audio) {
+    size_t produced = 0;
+    
+    for (size_t i = 0; i < count; ++i) {
+        if (++decimation_counter_ >= decimation_) {
+            decimation_counter_ = 0;
+            
+            // (magnitude - 0.5) * 2, saturated like the float limiter
+            int32_t magnitude = magnitudeQ15(samples[i].real(), samples[i].imag());
+            audio[produced++] = saturateQ15((magnitude - 16384) * 2);
+        }
+    }
+    
+    return produced;
+}
+
+size_t Demodulator::demodulateFMQ15(const std::complex<int16_t>* samples, size_t count, int16_t* audio) {
+    size_t produced = 0;
+    
+    for (size_t i = 0; i < count; ++i) {
+        if (++decimation_counter_ >= decimation_) {
+            decimation_counter_ = 0;
+            
+            std::complex<int16_t> current = samples[i];
+            std::complex<int16_t> previous = (i > 0) ? samples[i-1] : last_sample_q15_;
+            
+            // current * conj(previous); halve each product so the sums fit
+            int32_t re = ((current.real() * previous.real()) >> 1) + ((current.imag() * previous.imag()) >> 1);
+            int32_t im = ((current.imag() * previous.real()) >> 1) - ((current.real() * previous.imag()) >> 1);
+            
+            // arg * fm_gain_ in Q15 is angle * pi * fm_gain_ with pi == 32768;
+            // in 64 bits, as a narrow channel at a wide rate has a large gain
+            int32_t angle = atan2Q15(im, re);
+            int64_t scaled = (static_cast<int64_t>(angle) * fm_gain_q12_) >> 12;
+            scaled = std::max<int64_t>(-65536, std::min<int64_t>(65536, scaled));
+            audio[produced++] = saturateQ15(static_cast<int32_t>(scaled));
+        }
+    }
+    
+    if (count > 0) {
+        last_sample_q15_ = samples[count - 1];
+    }
+    
+    return produced;
+}
+
+size_t Demodulator::demodulateSSBQ15(const std::complex<int16_t>* samples, size_t count, bool upper,
+                                     int16_t* audio) {
+    size_t produced = 0;
+    
+    for (size_t i = 0; i < count; ++i) {
+        if (++decimation_counter_ >= decimation_) {
+            decimation_counter_ = 0;
+            
+            int32_t sample = upper ? samples[i].real() : samples[i].imag();
+            audio[produced++] = saturateQ15(sample * 2);
         }
     }
     
-    return audio;
+    return produced;
 }
@@ -3,6 +3,9 @@
 
 #include <vector>
 #include <complex>
+#include <cstdint>
+
+#include "fm_discriminator.h"
 
 enum class DemodulationType {
     FM,
@@ -17,19 +20,57 @@ public:
     ~Demodulator();
     
     void setType(DemodulationType type);
-    std::vector<float> demodulate(const std::vector<std::complex<float>>& samples);
+    
+    // Input samples per audio output sample; the channel filter in
+    // SignalProcessor takes the rest of the overall rate reduction
+    bool setDecimation(int factor);
+    int getDecimation() const { return decimation_; }
+    
+    // FM scaling: the deviation that reaches full scale at an input rate of
+    // sample_rate_hz, which is the rate the samples reach demodulate() at,
+    // not the capture's. Until set, full scale is a tenth of the input rate.
+    bool setFmDeviation(int sample_rate_hz, int deviation_hz);
+    
+    // FM discriminator tier; POLYNOMIAL by default
+    void setDiscriminatorAccuracy(DiscriminatorAccuracy accuracy) { discriminator_accuracy_ = accuracy; }
+    DiscriminatorAccuracy getDiscriminatorAccuracy() const { return discriminator_accuracy_; }
+    
+    // Writes one audio sample per decimation inputs to audio, which must
+    // hold maxOutput(count). Returns the number written.
+    size_t demodulate(const std::complex<float>* samples, size_t count, float* audio);
+    size_t maxOutput(size_t count) const { return (decimation_counter_ + count) / decimation_; }
+    
+    // Fixed-point variant: Q15 in, Q15 audio out. Same decimation state
+    // and scaling as demodulate(), with table lookups in place of std::arg
+    // and std::abs.
+    size_t demodulateQ15(const std::complex<int16_t>* samples, size_t count, int16_t* audio);
     
 private:
-    std::vector<float> demodulateAM(const std::vector<std::complex<float>>& samples);
-    std::vector<float> demodulateFM(const std::vector<std::complex<float>>& samples);
-    std::vector<float> demodulateSSB(const std::vector<std::complex<float>>& samples, bool upper);
+    size_t demodulateAM(const std::complex<float>* samples, size_t count, float* audio);
+    size_t demodulateFM(const std::complex<float>* samples, size_t count, float* audio);
+    size_t demodulateSSB(const std::complex<float>* samples, size_t count, bool upper, float* audio);
+    
+    size_t demodulateAMQ15(const std::complex<int16_t>* samples, size_t count, int16_t* audio);
+    size_t demodulateFMQ15(const std::complex<int16_t>* samples, size_t count, int16_t* audio);
+    size_t demodulateSSBQ15(const std::complex<int16_t>* samples, size_t count, bool upper,
+                            int16_t* audio);
     
     DemodulationType type_;
     std::complex<float> last_sample_;  // For FM phase difference calculation
+    std::complex<int16_t> last_sample_q15_;
     
     // Decimation for audio output
-    static const int DECIMATION_FACTOR = 42; // 2048000 / 42 ≈ 48000 Hz
+    static const int DEFAULT_DECIMATION = 42; // 2048000 / 42 ≈ 48000 Hz
+    int decimation_;
     int decimation_counter_;
+    
+    // FM: sample pairs gathered at the output positions, then discriminated
+    // as one block; grown to the largest block seen, never shrunk
+    DiscriminatorAccuracy discriminator_accuracy_;
+    float fm_gain_;             // radians per sample -> audio
+    int32_t fm_gain_q12_;       // Q15 angle (pi == 32768) -> Q15 audio, in Q12
+    std::vector<std::complex<float>> fm_current_;
+    std::vector<std::complex<float>> fm_previous_;
 };
 
 #endif // DEMODULATOR_H
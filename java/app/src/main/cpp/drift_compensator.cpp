@@ -0,0 +1,86 @@
+#include "drift_compensator.h"
+#include <algorithm>
+
+DriftCompensator::DriftCompensator()
+    : target_fill_(4096) {
+    
+    reset();
+}
+
+void DriftCompensator::reset() {
+    average_fill_ = static_cast<double>(target_fill_);
+    integral_ = 0.0;
+    correction_ = 0.0;
+    position_ = 1.0;
+    std::fill(history_, history_ + 3, 0.0f);
+}
+
+void DriftCompensator::setTargetFill(size_t samples) {
+    target_fill_ = std::max<size_t>(1, samples);
+    average_fill_ = static_cast<double>(target_fill_);
+}
+
+void DriftCompensator::restart() {
+    average_fill_ = static_cast<double>(target_fill_);
+    correction_ = integral_;
+}
+
+void DriftCompensator::update(size_t fill, size_t written) {
+    if (written == 0) {
+        return;
+    }
+    
+    // The raw fill saws up and down with every producer and consumer block;
+    // only its average says anything about the clocks
+    const double dt = static_cast<double>(written);
+    average_fill_ += (static_cast<double>(fill) - average_fill_) * dt / (dt + FILL_TIME_CONSTANT);
+    const double error = average_fill_ - static_cast<double>(target_fill_);
+    
+    // Fill error e obeys e' = drift - correction per output sample, so with
+    // correction = Kp e + Ki integral(e) the loop is critically damped for
+    // Kp = 2/T, Ki = 1/T^2. The integral settles on the drift itself.
+    const double kp = 2.0 / LOOP_TIME_CONSTANT;
+    const double ki = 1.0 / (LOOP_TIME_CONSTANT * LOOP_TIME_CONSTANT);
+    
+    integral_ = std::max(-MAX_CORRECTION, std::min(MAX_CORRECTION, integral_ - ki * error * dt));
+    correction_ = std::max(-MAX_CORRECTION, std::min(MAX_CORRECTION, integral_ - kp * error));
+}
+
+size_t DriftCompensator::maxOutput(size_t count) const {
+    return static_cast<size_t>(static_cast<double>(count) * (1.0 + MAX_CORRECTION)) + 2;
+}
+
+float DriftCompensator::sampleAt(const float* input, size_t index) const {
+    return index < 3 ? history_[index] : input[index - 3];
+}
+
+size_t DriftCompensator::process(const float* input, size_t count, float* output) {
+    // Input positions advance by 1 / ratio per output sample
+    const double step = 1.0 / (1.0 + correction_);
+    const double end = static_cast<double>(count) + 1.0;
+    size_t produced = 0;
+    
+    // Catmull-Rom between samples i and i + 1, with i - 1 and i + 2 as
+    // the outer points; the three history samples make every block seamless
+    while (position_ < end) {
+        const size_t i = static_cast<size_t>(position_);
+        const float frac = static_cast<float>(position_ - static_cast<double>(i));
+        
+        const float y0 = sampleAt(input, i - 1);
+        const float y1 = sampleAt(input, i);
+        const float y2 = sampleAt(input, i + 1);
+        const float y3 = sampleAt(input, i + 2);
+        
+        const float c1 = 0.5f * (y2 - y0);
+        const float c2 = y0 - 2.5f * y1 + 2.0f * y2 - 0.5f * y3;
+        const float c3 = 0.5f * (y3 - y0) + 1.5f * (y1 - y2);
+        output[produced++] = ((c3 * frac + c2) * frac + c1) * frac + y1;
+        
+        position_ += step;
+    }
+    
+    position_ -= static_cast<double>(count);
+    float last[3] = {sampleAt(input, count), sampleAt(input, count + 1), sampleAt(input, count + 2)};
+    std::copy(last, last + 3, history_);
+    return produced;
+}
@@ -0,0 +1,71 @@
+#ifndef DRIFT_COMPENSATOR_H
+#define DRIFT_COMPENSATOR_H
+
+#include <cstddef>
+
+// Keeps the audio ring at a constant fill level when the SDR crystal and
+// the audio output clock disagree by some ppm. A PI loop on the smoothed
+// fill level steers the ratio of a cubic interpolating resampler by at
+// most 1000 ppm (under 2 cents of pitch, inaudible) instead of letting the
+// ring overflow and jump.
+//
+// The loop runs in output samples, so it does not need the audio rate:
+// time constants are given for 48 kHz. Producer thread only.
+class DriftCompensator {
+public:
+    DriftCompensator();
+    
+    // Clears the resampler history and the loop, including the drift
+    // estimate
+    void reset();
+    
+    // Fill level the loop steers to, in samples
+    void setTargetFill(size_t samples);
+    size_t getTargetFill() const { return target_fill_; }
+    
+    // One fill measurement taken right after `written` output samples were
+    // queued; moves the ratio for the next process() calls
+    void update(size_t fill, size_t written);
+    
+    // After the ring was forced to the target: the smoothed fill restarts
+    // there, the drift estimate is kept
+    void restart();
+    
+    // Resamples count inputs at the current ratio; output must hold
+    // maxOutput(count). Returns the number written.
+    size_t process(const float* input, size_t count, float* output);
+    size_t maxOutput(size_t count) const;
+    
+    // Output/input ratio in use, as an offset from 1 in ppm
+    double getCorrectionPpm() const { return correction_ * 1e6; }
+    
+    // Long-term part of the correction: how much faster the audio output
+    // clock runs than the SDR clock
+    double getDriftPpm() const { return integral_ * 1e6; }
+    
+    double getAverageFill() const { return average_fill_; }
+    
+    // Largest correction ever applied, as a fraction (1000 ppm)
+    static constexpr double MAX_CORRECTION = 1e-3;
+
+private:
+    float sampleAt(const float* input, size_t index) const;
+    
+    size_t target_fill_;
+    double average_fill_;
+    double integral_;
+    double correction_;
+    
+    // Next output position in input samples, counted from the oldest
+    // history sample
+    double position_;
+    
+    // Last three inputs of the previous block
+    float history_[3];
+    
+    // Fill smoothing and PI loop time constants, in output samples
+    static constexpr double FILL_TIME_CONSTANT = 96000.0;      // 2 s
+    static constexpr double LOOP_TIME_CONSTANT = 960000.0;     // 20 s
+};
+
+#endif // DRIFT_COMPENSATOR_H
@@ -0,0 +1,232 @@
+#include "dsp_executor.h"
+#include <android/log.h>
+#include "async_logger.h"
+#include <chrono>
+
+#define LOG_TAG "DSP_Executor"
+#define LOGI(...) ASYNC_LOG(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+#define LOGE(...) ASYNC_LOG(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+#define LOGD(...) ASYNC_LOG(ANDROID_LOG_DEBUG, LOG_TAG, __VA_ARGS__)
+
+namespace {
+
+int64_t nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+} // namespace
+
+int TaskGraph::addTask(const char* name, TaskFunction function) {
+    if (tasks_.size() >= MAX_TASKS) {
+        LOGE("Task graph full, dropping task %s", name);
+        return -1;
+    }
+    
+    std::unique_ptr<Task> task = std::make_unique<Task>();
+    task->function = std::move(function);
+    task->name = name;
+    task->predecessors = 0;
+    task->pending.store(0, std::memory_order_relaxed);
+    task->runs.store(0, std::memory_order_relaxed);
+    task->total_ns.store(0, std::memory_order_relaxed);
+    tasks_.push_back(std::move(task));
+    return static_cast<int>(tasks_.size() - 1);
+}
+
+void TaskGraph::addEdge(int before, int after) {
+    if (before < 0 || after < 0 || before == after ||
+        before >= static_cast<int>(tasks_.size()) || after >= static_cast<int>(tasks_.size())) {
+        return;
+    }
+    tasks_[before]->successors.push_back(tasks_[after].get());
+    tasks_[after]->predecessors++;
+}
+
+void TaskGraph::clear() {
+    tasks_.clear();
+}
+
+void TaskGraph::resetCosts() {
+    for (auto& task : tasks_) {
+        task->runs.store(0, std::memory_order_relaxed);
+        task->total_ns.store(0, std::memory_order_relaxed);
+    }
+}
+
+DspExecutor::DspExecutor(int workers, const ThreadPlacement& placement)
+    : remaining_(0)
+    , queued_(0)
+    , sleepers_(0)
+    , stopping_(false)
+    , graphs_(0)
+    , tasks_run_(0)
+    , steals_(0)
+    , sleeps_(0) {
+    
+    if (workers < 0) {
+        const int cores = coreCount(placement.cores);
+        workers = cores > 1 ? cores - 1 : 0;
+    }
+    
+    for (int i = 0; i <= workers; ++i) {
+        deques_.push_back(std::make_unique<WorkDeque>());
+    }
+    for (int i = 1; i <= workers; ++i) {
+        workers_.emplace_back(&DspExecutor::workerLoop, this, i, placement);
+    }
+    LOGI("DSP executor with %d workers on %s cores", workers, coreClassName(placement.cores));
+}
+
+DspExecutor::~DspExecutor() {
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex_);
+        stopping_.store(true);
+        work_cv_.notify_all();
+    }
+    for (auto& worker : workers_) {
+        worker.join();
+    }
+}
+
+void DspExecutor::run(TaskGraph& graph) {
+    std::lock_guard<std::mutex> run_lock(run_mutex_);
+    if (graph.tasks_.empty()) {
+        return;
+    }
+    
+    graphs_.fetch_add(1, std::memory_order_relaxed);
+    for (auto& task : graph.tasks_) {
+        task->pending.store(task->predecessors, std::memory_order_relaxed);
+    }
+    remaining_.store(graph.tasks_.size(), std::memory_order_seq_cst);
+    
+    // Roots dealt round the deques so every worker starts at once
+    size_t next = 0;
+    for (auto& task : graph.tasks_) {
+        if (task->predecessors == 0) {
+            push(static_cast<int>(next++ % deques_.size()), task.get());
+        }
+    }
+    
+    // The caller works as deque 0 until the last task is done
+    for (;;) {
+        Task* task = take(0);
+        if (task) {
+            execute(0, task);
+            continue;
+        }
+        if (remaining_.load(std::memory_order_acquire) == 0) {
+            break;
+        }
+        
+        std::unique_lock<std::mutex> lock(sleep_mutex_);
+        sleepers_.fetch_add(1, std::memory_order_seq_cst);
+        work_cv_.wait(lock, [this]() {
+            return queued_.load(std::memory_order_seq_cst) > 0 ||
+                   remaining_.load(std::memory_order_acquire) == 0;
+        });
+        sleepers_.fetch_sub(1, std::memory_order_relaxed);
+    }
+}
+
+ExecutorStats DspExecutor::stats() const {
+    ExecutorStats stats;
+    stats.graphs = graphs_.load(std::memory_order_relaxed);
+    stats.tasks = tasks_run_.load(std::memory_order_relaxed);
+    stats.steals = steals_.load(std::memory_order_relaxed);
+    stats.sleeps = sleeps_.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void DspExecutor::workerLoop(int index, ThreadPlacement placement) {
+    applyThreadPlacement(placement);
+    
+    while (!stopping_.load()) {
+        Task* task = take(index);
+        if (task) {
+            execute(index, task);
+            continue;
+        }
+        
+        // Announce the sleep, then look again: either a pusher sees us and
+        // notifies, or we see its task
+        std::unique_lock<std::mutex> lock(sleep_mutex_);
+        sleepers_.fetch_add(1, std::memory_order_seq_cst);
+        if (queued_.load(std::memory_order_seq_cst) == 0 && !stopping_.load()) {
+            sleeps_.fetch_add(1, std::memory_order_relaxed);
+            work_cv_.wait(lock, [this]() {
+                return queued_.load(std::memory_order_seq_cst) > 0 || stopping_.load();
+            });
+        }
+        sleepers_.fetch_sub(1, std::memory_order_relaxed);
+    }
+}
+
+void DspExecutor::push(int index, Task* task) {
+    WorkDeque& deque = *deques_[index];
+    {
+        std::lock_guard<std::mutex> lock(deque.mutex);
+        deque.tasks[deque.tail % TaskGraph::MAX_TASKS] = task;
+        deque.tail++;
+    }
+    
+    queued_.fetch_add(1, std::memory_order_seq_cst);
+    if (sleepers_.load(std::memory_order_seq_cst) > 0) {
+        std::lock_guard<std::mutex> lock(sleep_mutex_);
+        work_cv_.notify_one();
+    }
+}
+
+DspExecutor::Task* DspExecutor::take(int index) {
+    if (queued_.load(std::memory_order_relaxed) == 0) {
+        return nullptr;
+    }
+    
+    // Own deque first, newest task: its inputs are the warmest
+    {
+        WorkDeque& own = *deques_[index];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (own.tail != own.head) {
+            own.tail--;
+            queued_.fetch_sub(1, std::memory_order_relaxed);
+            return own.tasks[own.tail % TaskGraph::MAX_TASKS];
+        }
+    }
+    
+    // Then the oldest task of the next deque round that has any
+    const size_t count = deques_.size();
+    for (size_t step = 1; step < count; ++step) {
+        WorkDeque& victim = *deques_[(index + step) % count];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (victim.tail != victim.head) {
+            Task* task = victim.tasks[victim.head % TaskGraph::MAX_TASKS];
+            victim.head++;
+            queued_.fetch_sub(1, std::memory_order_relaxed);
+            steals_.fetch_add(1, std::memory_order_relaxed);
+            return task;
+        }
+    }
+    return nullptr;
+}
+
+void DspExecutor::execute(int index, Task* task) {
+    const int64_t start = nowNs();
+    task->function();
+    task->total_ns.fetch_add(static_cast<uint64_t>(nowNs() - start), std::memory_order_relaxed);
+    task->runs.fetch_add(1, std::memory_order_relaxed);
+    tasks_run_.fetch_add(1, std::memory_order_relaxed);
+    
+    // Whoever finishes a task's last predecessor queues it, here
+    for (Task* successor : task->successors) {
+        if (successor->pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            push(index, successor);
+        }
+    }
+    
+    if (remaining_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        // The graph is done; the caller may be asleep
+        std::lock_guard<std::mutex> lock(sleep_mutex_);
+        work_cv_.notify_all();
+    }
+}
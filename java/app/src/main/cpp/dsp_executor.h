@@ -0,0 +1,126 @@
+#ifndef DSP_EXECUTOR_H
+#define DSP_EXECUTOR_H
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "thread_placement.h"
+
+// The per-block work of a multi-channel receiver as a dependency graph:
+// one task per channel filter+demod, FFT frame, decoder step, ... and an
+// edge wherever one needs another's output. Built once and run once per
+// block; running it allocates nothing.
+class TaskGraph {
+public:
+    using TaskFunction = std::function<void()>;
+    
+    static const size_t MAX_TASKS = 1024;
+    
+    // Returns the task's id, or -1 once MAX_TASKS are in the graph
+    int addTask(const char* name, TaskFunction function);
+    
+    // after starts only once before has finished
+    void addEdge(int before, int after);
+    
+    void clear();
+    size_t size() const { return tasks_.size(); }
+    
+    // Each task's own cost over every run so far, whichever worker ran it
+    const char* taskName(int task) const { return tasks_[task]->name; }
+    uint64_t taskRuns(int task) const { return tasks_[task]->runs.load(std::memory_order_relaxed); }
+    uint64_t taskNs(int task) const { return tasks_[task]->total_ns.load(std::memory_order_relaxed); }
+    void resetCosts();
+
+private:
+    friend class DspExecutor;
+    
+    struct Task {
+        TaskFunction function;
+        const char* name;
+        std::vector<Task*> successors;
+        int predecessors;
+        std::atomic<int> pending;   // predecessors still running this pass
+        std::atomic<uint64_t> runs;
+        std::atomic<uint64_t> total_ns;
+    };
+    
+    std::vector<std::unique_ptr<Task>> tasks_;
+};
+
+struct ExecutorStats {
+    uint64_t graphs;    // run() calls
+    uint64_t tasks;     // tasks executed
+    uint64_t steals;    // tasks taken from another worker's deque
+    uint64_t sleeps;    // times a worker found nothing and slept
+};
+
+// Work-stealing pool for TaskGraphs. Every worker, and the thread calling
+// run(), owns a deque: a task made ready by a finishing task goes on the
+// back of the finisher's deque and is taken LIFO there, so a channel's
+// chain tends to stay on one core with its data in cache; a worker with
+// an empty deque steals from the front of the others'. Deque operations
+// take a short per-deque lock, small next to a per-block DSP task.
+// Workers sleep when no deque holds work and cost nothing between blocks.
+class DspExecutor {
+public:
+    // workers: threads besides the caller; -1 for one per core beyond the
+    // caller's. 0 runs every graph on the calling thread.
+    explicit DspExecutor(int workers = -1, const ThreadPlacement& placement = ThreadPlacement());
+    ~DspExecutor();
+    
+    DspExecutor(const DspExecutor&) = delete;
+    DspExecutor& operator=(const DspExecutor&) = delete;
+    
+    // Runs every task of graph once, in an order its edges allow, and
+    // returns when all have finished. One run() at a time.
+    void run(TaskGraph& graph);
+    
+    int workerCount() const { return static_cast<int>(workers_.size()); }
+    ExecutorStats stats() const;
+
+private:
+    using Task = TaskGraph::Task;
+    
+    // Fixed ring: a deque never holds more than one graph's tasks
+    struct alignas(64) WorkDeque {
+        std::mutex mutex;
+        std::array<Task*, TaskGraph::MAX_TASKS> tasks;
+        size_t head = 0;    // steal end
+        size_t tail = 0;    // owner end
+    };
+    
+    void workerLoop(int index, ThreadPlacement placement);
+    void push(int index, Task* task);
+    Task* take(int index);
+    void execute(int index, Task* task);
+    
+    // Index 0 is the caller of run(), 1.. the workers
+    std::vector<std::unique_ptr<WorkDeque>> deques_;
+    std::vector<std::thread> workers_;
+    
+    std::mutex run_mutex_;
+    std::atomic<size_t> remaining_;     // tasks of the running graph not yet finished
+    std::atomic<size_t> queued_;        // tasks sitting in deques
+    
+    // Sleeping only: a pusher takes the mutex to notify only when someone
+    // sleeps, and the last task of a graph wakes everyone
+    std::mutex sleep_mutex_;
+    std::condition_variable work_cv_;
+    std::atomic<int> sleepers_;
+    std::atomic<bool> stopping_;
+    
+    std::atomic<uint64_t> graphs_;
+    std::atomic<uint64_t> tasks_run_;
+    std::atomic<uint64_t> steals_;
+    std::atomic<uint64_t> sleeps_;
+};
+
+#endif // DSP_EXECUTOR_H
@@ -0,0 +1,168 @@
+#include "fft.h"
+#include <cmath>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+FFTPlan::FFTPlan()
+    : size_(0)
+    , log2_size_(0) {
+}
+
+FFTPlan::FFTPlan(int size)
+    : FFTPlan() {
+    setSize(size);
+}
+
+bool FFTPlan::setSize(int size) {
+    if (!isPowerOfTwo(size)) {
+        return false;
+    }
+    
+    size_ = size;
+    log2_size_ = 0;
+    while ((1 << log2_size_) < size_) {
+        ++log2_size_;
+    }
+    
+    // Bit-reversal permutation, stored as the swaps it needs
+    swap_pairs_.clear();
+    for (uint32_t i = 0; i < static_cast<uint32_t>(size_); ++i) {
+        uint32_t j = 0;
+        for (int b = 0; b < log2_size_; ++b) {
+            j |= ((i >> b) & 1u) << (log2_size_ - 1 - b);
+        }
+        if (i < j) {
+            swap_pairs_.push_back(i);
+            swap_pairs_.push_back(j);
+        }
+    }
+    
+    // Twiddles for the radix-4 passes. A pass merging sub-transforms of
+    // length `quarter` into length 4 * quarter uses W^k, W^2k, W^3k with
+    // W = e^(-j 2 pi / (4 * quarter)), k = 0 .. quarter - 1.
+    twiddles_.clear();
+    stage_offsets_.clear();
+    
+    int quarter = (log2_size_ % 2) ? 2 : 1;
+    for (; quarter * 4 <= size_; quarter *= 4) {
+        stage_offsets_.push_back(twiddles_.size());
+        
+        const double step = -2.0 * M_PI / (4.0 * quarter);
+        for (int k = 0; k < quarter; ++k) {
+            for (int m = 1; m <= 3; ++m) {
+                twiddles_.push_back(static_cast<float>(std::cos(step * m * k)));
+                twiddles_.push_back(static_cast<float>(std::sin(step * m * k)));
+            }
+        }
+    }
+    
+    return true;
+}
+
+void FFTPlan::forward(std::complex<float>* data) const {
+    transform(data, false);
+}
+
+void FFTPlan::inverse(std::complex<float>* data) const {
+    transform(data, true);
+}
+
+void FFTPlan::transform(std::complex<float>* data, bool inverse) const {
+    if (size_ <= 1) {
+        return;
+    }
+    
+    bitReverse(data);
+    
+    // std::complex<float> is layout-compatible with float[2]
+    float* raw = reinterpret_cast<float*>(data);
+    
+    if (log2_size_ % 2) {
+        radix2Pass(raw);
+    }
+    
+    int quarter = (log2_size_ % 2) ? 2 : 1;
+    for (size_t stage = 0; stage < stage_offsets_.size(); ++stage, quarter *= 4) {
+        radix4Pass(raw, quarter, twiddles_.data() + stage_offsets_[stage], inverse);
+    }
+}
+
+void FFTPlan::bitReverse(std::complex<float>* data) const {
+    const uint32_t* pairs = swap_pairs_.data();
+    const size_t count = swap_pairs_.size();
+    
+    for (size_t p = 0; p < count; p += 2) {
+        std::swap(data[pairs[p]], data[pairs[p + 1]]);
+    }
+}
+
+void FFTPlan::radix2Pass(float* data) const {
+    // Length-2 butterflies, twiddle is always 1
+    for (int i = 0; i < size_; i += 2) {
+        float* a = data + 2 * i;
+        float ar = a[0], ai = a[1];
+        float br = a[2], bi = a[3];
+        a[0] = ar + br;
+        a[1] = ai + bi;
+        a[2] = ar - br;
+        a[3] = ai - bi;
+    }
+}
+
+void FFTPlan::radix4Pass(float* data, int quarter, const float* twiddles, bool inverse) const {
+    // Radix-4 DIT butterfly over bit-reversed input. With
+    //   A = x[k], B = w2 x[k+q], C = w1 x[k+2q], D = w3 x[k+3q]:
+    //   y[k]    = (A + B) + (C + D)
+    //   y[k+2q] = (A + B) - (C + D)
+    //   y[k+q]  = (A - B) - j (C - D)
+    //   y[k+3q] = (A - B) + j (C - D)
+    // The inverse uses conjugate twiddles and +j. Loops are kept flat on
+    // float arrays so the compiler vectorizes the k loop.
+    const float sign = inverse ? -1.0f : 1.0f;
+    const int span = quarter * 4;
+    
+    for (int base = 0; base < size_; base += span) {
+        float* x0 = data + 2 * base;
+        float* x1 = x0 + 2 * quarter;
+        float* x2 = x1 + 2 * quarter;
+        float* x3 = x2 + 2 * quarter;
+        
+        for (int k = 0; k < quarter; ++k) {
+            const float* w = twiddles + 6 * k;
+            const float w1r = w[0], w1i = sign * w[1];
+            const float w2r = w[2], w2i = sign * w[3];
+            const float w3r = w[4], w3i = sign * w[5];
+            
+            const float ar = x0[2*k], ai = x0[2*k + 1];
+            const float b0r = x1[2*k], b0i = x1[2*k + 1];
+            const float c0r = x2[2*k], c0i = x2[2*k + 1];
+            const float d0r = x3[2*k], d0i = x3[2*k + 1];
+            
+            const float br = b0r * w2r - b0i * w2i;
+            const float bi = b0r * w2i + b0i * w2r;
+            const float cr = c0r * w1r - c0i * w1i;
+            const float ci = c0r * w1i + c0i * w1r;
+            const float dr = d0r * w3r - d0i * w3i;
+            const float di = d0r * w3i + d0i * w3r;
+            
+            const float s0r = ar + br, s0i = ai + bi;
+            const float s1r = ar - br, s1i = ai - bi;
+            const float s2r = cr + dr, s2i = ci + di;
+            
+            // -j (C - D) for the forward transform, +j for the inverse
+            const float s3r = sign * (ci - di);
+            const float s3i = sign * (dr - cr);
+            
+            x0[2*k] = s0r + s2r;
+            x0[2*k + 1] = s0i + s2i;
+            x2[2*k] = s0r - s2r;
+            x2[2*k + 1] = s0i - s2i;
+            x1[2*k] = s1r + s3r;
+            x1[2*k + 1] = s1i + s3i;
+            x3[2*k] = s1r - s3r;
+            x3[2*k + 1] = s1i - s3i;
+        }
+    }
+}
@@ -0,0 +1,45 @@
+#ifndef FFT_H
+#define FFT_H
+
+#include <vector>
+#include <complex>
+#include <cstdint>
+
+// In-place iterative radix-4 FFT (with one radix-2 pass for odd log2 sizes).
+// All tables - bit-reversal permutation and per-stage twiddles - are built
+// once per size, so transforms do no allocation and no trig calls.
+class FFTPlan {
+public:
+    FFTPlan();
+    explicit FFTPlan(int size);
+    
+    // Rebuilds the tables; size must be a power of two
+    bool setSize(int size);
+    int getSize() const { return size_; }
+    
+    // Unnormalized forward transform (e^-j) and inverse transform (e^+j);
+    // inverse(forward(x)) == size * x
+    void forward(std::complex<float>* data) const;
+    void inverse(std::complex<float>* data) const;
+    
+    static bool isPowerOfTwo(int n) { return n > 0 && (n & (n - 1)) == 0; }
+    
+private:
+    void transform(std::complex<float>* data, bool inverse) const;
+    void bitReverse(std::complex<float>* data) const;
+    void radix2Pass(float* data) const;
+    void radix4Pass(float* data, int quarter, const float* twiddles, bool inverse) const;
+    
+    int size_;
+    int log2_size_;
+    
+    // Index pairs (i, j), i < j, to swap for the bit-reversal permutation
+    std::vector<uint32_t> swap_pairs_;
+    
+    // For each radix-4 pass, `quarter` entries of (w1, w2, w3) as
+    // interleaved re/im floats: 6 floats per butterfly index
+    std::vector<float> twiddles_;
+    std::vector<size_t> stage_offsets_;
+};
+
+#endif // FFT_H
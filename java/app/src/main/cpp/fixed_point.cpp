@@ -0,0 +1,86 @@
+#include "fixed_point.h"
+#include <cmath>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+namespace {
+
+const int ATAN_BITS = 10;
+const int ATAN_SIZE = (1 << ATAN_BITS) + 1;
+const int SQRT_SIZE = 257;
+
+struct Tables {
+    int16_t atan[ATAN_SIZE];    // atan(k / 1024) in Q15 angle units, 0 .. 8192
+    uint16_t sqrt[SQRT_SIZE];   // sqrt(k) with 8 fractional bits
+    
+    Tables() {
+        for (int k = 0; k < ATAN_SIZE; ++k) {
+            double angle = std::atan(static_cast<double>(k) / (ATAN_SIZE - 1));
+            atan[k] = static_cast<int16_t>(std::lround(angle * 32768.0 / M_PI));
+        }
+        for (int k = 0; k < SQRT_SIZE; ++k) {
+            sqrt[k] = static_cast<uint16_t>(std::lround(std::sqrt(static_cast<double>(k)) * 256.0));
+        }
+    }
+};
+
+const Tables tables;
+
+} // namespace
+
+int16_t atan2Q15(int32_t y, int32_t x) {
+    uint32_t ax = x < 0 ? -static_cast<uint32_t>(x) : static_cast<uint32_t>(x);
+    uint32_t ay = y < 0 ? -static_cast<uint32_t>(y) : static_cast<uint32_t>(y);
+    if (ax == 0 && ay == 0) {
+        return 0;
+    }
+    
+    // Reduce to the first octant: ratio in [0, 1] indexes the table
+    int32_t angle;
+    if (ax >= ay) {
+        uint32_t index = static_cast<uint32_t>(((static_cast<uint64_t>(ay) << ATAN_BITS) + ax / 2) / ax);
+        angle = tables.atan[index];
+    } else {
+        uint32_t index = static_cast<uint32_t>(((static_cast<uint64_t>(ax) << ATAN_BITS) + ay / 2) / ay);
+        angle = 16384 - tables.atan[index];
+    }
+    
+    if (x < 0) {
+        angle = 32768 - angle;
+    }
+    if (y < 0) {
+        angle = -angle;
+    }
+    
+    // +pi and -pi are the same angle; 32768 wraps to -32768
+    return static_cast<int16_t>(angle);
+}
+
+int16_t magnitudeQ15(int16_t i, int16_t q) {
+    uint32_t power = static_cast<uint32_t>(i * i) + static_cast<uint32_t>(q * q);
+    if (power == 0) {
+        return 0;
+    }
+    
+    // Keep 8 significant bits of the power (even shift, so the root's shift
+    // is whole), rounding to the nearest table entry
+    int bits = 32 - __builtin_clz(power);
+    int shift = bits > 8 ? bits - 8 : 0;
+    shift += shift & 1;
+    uint32_t index = shift > 0 ? (power + (1u << (shift - 1))) >> shift : power;
+    
+    uint32_t root = ((static_cast<uint32_t>(tables.sqrt[index]) << (shift / 2)) + 128) >> 8;
+    return static_cast<int16_t>(root > 32767 ? 32767 : root);
+}
+
+void convertToQ15(const std::complex<float>* in, size_t count, std::complex<int16_t>* out) {
+    const float* src = reinterpret_cast<const float*>(in);
+    int16_t* dst = reinterpret_cast<int16_t*>(out);
+    for (size_t k = 0; k < 2 * count; ++k) {
+        float scaled = src[k] * 32768.0f;
+        scaled = scaled > 32767.0f ? 32767.0f : (scaled < -32768.0f ? -32768.0f : scaled);
+        dst[k] = static_cast<int16_t>(std::lrintf(scaled));
+    }
+}
@@ -0,0 +1,31 @@
+#ifndef FIXED_POINT_H
+#define FIXED_POINT_H
+
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+
+// Q15 helpers for the fixed-point processing path. Samples are int16 with
+// 32768 == 1.0; angles are int16 with 32768 == pi.
+
+inline int16_t saturateQ15(int32_t value) {
+    return static_cast<int16_t>(value > 32767 ? 32767 : (value < -32768 ? -32768 : value));
+}
+
+inline int16_t floatToQ15(float value) {
+    float scaled = value * 32768.0f;
+    return saturateQ15(static_cast<int32_t>(scaled >= 0.0f ? scaled + 0.5f : scaled - 0.5f));
+}
+
+// atan2(y, x) from a 1025-entry arctangent table over one octant,
+// accurate to about 5 LSB (0.0005 rad)
+int16_t atan2Q15(int32_t y, int32_t x);
+
+// |i + jq| from a 256-entry square-root table after normalizing the
+// power to 8 significant bits; relative error under 0.5 %
+int16_t magnitudeQ15(int16_t i, int16_t q);
+
+// complex float in [-1, 1) -> Q15, saturating
+void convertToQ15(const std::complex<float>* in, size_t count, std::complex<int16_t>* out);
+
+#endif // FIXED_POINT_H
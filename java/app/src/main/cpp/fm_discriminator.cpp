@@ -0,0 +1,62 @@
+#include "fm_discriminator.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+constexpr float PI = 3.14159265358979f;
+constexpr float HALF_PI = 1.57079632679490f;
+
+// Minimax atan(a) on [0, 1], odd polynomial of degree 11 (A&S 4.4.49)
+inline float atanUnit(float a) {
+    float s = a * a;
+    return a * (0.99997726f + s * (-0.33262347f + s * (0.19354346f +
+           s * (-0.11643287f + s * (0.05265332f + s * -0.01172120f)))));
+}
+
+// Octant reduction done with selects only, so every lane runs the same path
+inline float atan2Polynomial(float y, float x) {
+    float ax = std::fabs(x);
+    float ay = std::fabs(y);
+    float hi = std::max(ax, ay);
+    float lo = std::min(ax, ay);
+    float angle = atanUnit(lo / std::max(hi, 1e-30f));
+    angle = ay > ax ? HALF_PI - angle : angle;
+    angle = x < 0.0f ? PI - angle : angle;
+    return std::copysign(angle, y);
+}
+
+} // namespace
+
+void fmDiscriminate(const std::complex<float>* current, const std::complex<float>* previous,
+                    size_t count, float* out, DiscriminatorAccuracy accuracy) {
+    // Flat float views: interleaved re/im, which the vectorizer de-interleaves
+    const float* cur = reinterpret_cast<const float*>(current);
+    const float* prev = reinterpret_cast<const float*>(previous);
+    
+    switch (accuracy) {
+        case DiscriminatorAccuracy::EXACT:
+            for (size_t k = 0; k < count; ++k) {
+                float re = cur[2 * k] * prev[2 * k] + cur[2 * k + 1] * prev[2 * k + 1];
+                float im = cur[2 * k + 1] * prev[2 * k] - cur[2 * k] * prev[2 * k + 1];
+                out[k] = std::atan2(im, re);
+            }
+            break;
+        
+        case DiscriminatorAccuracy::POLYNOMIAL:
+            for (size_t k = 0; k < count; ++k) {
+                float re = cur[2 * k] * prev[2 * k] + cur[2 * k + 1] * prev[2 * k + 1];
+                float im = cur[2 * k + 1] * prev[2 * k] - cur[2 * k] * prev[2 * k + 1];
+                out[k] = atan2Polynomial(im, re);
+            }
+            break;
+        
+        case DiscriminatorAccuracy::QUADRATURE:
+            for (size_t k = 0; k < count; ++k) {
+                float power = cur[2 * k] * cur[2 * k] + cur[2 * k + 1] * cur[2 * k + 1];
+                float im = cur[2 * k + 1] * prev[2 * k] - cur[2 * k] * prev[2 * k + 1];
+                out[k] = im / std::max(power, 1e-30f);
+            }
+            break;
+    }
+}
@@ -0,0 +1,24 @@
+#ifndef FM_DISCRIMINATOR_H
+#define FM_DISCRIMINATOR_H
+
+#include <complex>
+#include <cstddef>
+
+// Accuracy tiers of the FM phase discriminator, most to least exact
+enum class DiscriminatorAccuracy {
+    EXACT,          // std::atan2 per sample; the reference
+    POLYNOMIAL,     // branch-free minimax atan2, error below 2e-6 rad
+    QUADRATURE      // atan-free quadrature delay: sin of the step, exact near 0
+};
+
+// Phase step from previous[k] to current[k] in radians, (-pi, pi]:
+//   out[k] = arg(current[k] * conj(previous[k]))
+// POLYNOMIAL and QUADRATURE have no branches or libm calls in the loop, so
+// it compiles to 4 (NEON/SSE) or 8 (AVX) samples per vector iteration.
+// QUADRATURE returns the cross product over |current|^2, which is
+// sin(step) for a constant envelope: 1 % low at 0.25 rad and 6 % low at
+// 0.63 rad, so it suits small steps (narrowband or well-oversampled FM).
+void fmDiscriminate(const std::complex<float>* current, const std::complex<float>* previous,
+                    size_t count, float* out, DiscriminatorAccuracy accuracy);
+
+#endif // FM_DISCRIMINATOR_H
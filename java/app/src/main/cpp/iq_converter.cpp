@@ -0,0 +1,39 @@
+#include "iq_converter.h"
+
+namespace {
+
+// (x - 127.4) / 127.4 == x * SCALE - 1
+constexpr float IQ_ZERO = 127.4f;
+constexpr float SCALE = 1.0f / IQ_ZERO;
+
+// 32768 / 127.4 in 8.8 fixed point is 65845 = 257 * 256 + 53: x * 257
+// exactly, plus the rounded x * 53 / 256
+constexpr int32_t Q15_WHOLE = 257;
+constexpr int32_t Q15_FRACTION = 53;
+
+} // namespace
+
+void convertIQ8(const uint8_t* in, size_t num_samples, std::complex<float>* out) {
+    // A 256-entry table was measured slower here: the lookup is a gather,
+    // while this form vectorizes to widen + convert + FMA
+    float* raw = reinterpret_cast<float*>(out);
+    const size_t count = 2 * num_samples;
+    for (size_t k = 0; k < count; ++k) {
+        raw[k] = static_cast<float>(in[k]) * SCALE - 1.0f;
+    }
+}
+
+void convertIQ8ToQ15(const uint8_t* in, size_t num_samples, std::complex<int16_t>* out) {
+    // (x * 65845 - (32768 << 8) + 128) >> 8, split so every step fits 16
+    // bits and vectorizes eight lanes wide (a 32-bit vector multiply is
+    // missing from SSE2). Only the top code overshoots 32767, and the
+    // subtraction of 32768 wraps, so it is set directly.
+    int16_t* raw = reinterpret_cast<int16_t*>(out);
+    const size_t count = 2 * num_samples;
+    for (size_t k = 0; k < count; ++k) {
+        const uint16_t x = in[k];
+        const uint16_t fraction = static_cast<uint16_t>(x * Q15_FRACTION + 128) >> 8;
+        const uint16_t value = static_cast<uint16_t>(x * Q15_WHOLE + fraction + 32768);
+        raw[k] = x == 255 ? 32767 : static_cast<int16_t>(value);
+    }
+}
@@ -0,0 +1,20 @@
+#ifndef IQ_CONVERTER_H
+#define IQ_CONVERTER_H
+
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+
+// RTL-SDR offset-binary u8 I/Q -> complex float in [-1, 1), centred on 127.4.
+// Works on the interleaved bytes as one flat array (std::complex<float> is
+// layout-compatible with float[2]), so it compiles to a plain widen +
+// convert + multiply-add vector loop with no per-sample branching.
+//
+// Writes num_samples complex values to out; in must hold 2 * num_samples bytes.
+void convertIQ8(const uint8_t* in, size_t num_samples, std::complex<float>* out);
+
+// Same mapping into Q15 (32768 == 1.0) for the fixed-point path, saturating
+// the top code, in integer arithmetic only
+void convertIQ8ToQ15(const uint8_t* in, size_t num_samples, std::complex<int16_t>* out);
+
+#endif // IQ_CONVERTER_H
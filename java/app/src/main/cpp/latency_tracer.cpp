@@ -0,0 +1,170 @@
+#include "latency_tracer.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+LatencyHistogram::LatencyHistogram() {
+    reset();
+}
+
+int LatencyHistogram::bucketOf(uint64_t us) {
+    if (us < 16) {
+        return static_cast<int>(us);
+    }
+    
+    // Exponent of the leading bit, then the next two bits
+    int exponent = 63 - __builtin_clzll(us);
+    int bucket = 16 + (exponent - 4) * 4 + static_cast<int>((us >> (exponent - 2)) & 3);
+    return std::min(bucket, BUCKETS - 1);
+}
+
+double LatencyHistogram::bucketUpperUs(int bucket) {
+    if (bucket < 16) {
+        return bucket + 1;
+    }
+    
+    int exponent = (bucket - 16) / 4 + 4;
+    int quarter = (bucket - 16) % 4;
+    return std::ldexp(1.0 + (quarter + 1) / 4.0, exponent);
+}
+
+void LatencyHistogram::record(int64_t ns) {
+    uint64_t value = ns > 0 ? static_cast<uint64_t>(ns) : 0;
+    
+    buckets_[bucketOf(value / 1000)].fetch_add(1, std::memory_order_relaxed);
+    count_.fetch_add(1, std::memory_order_relaxed);
+    total_ns_.fetch_add(value, std::memory_order_relaxed);
+    
+    uint64_t max = max_ns_.load(std::memory_order_relaxed);
+    while (value > max && !max_ns_.compare_exchange_weak(max, value, std::memory_order_relaxed)) {
+    }
+}
+
+void LatencyHistogram::reset() {
+    for (auto& bucket : buckets_) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+    count_.store(0, std::memory_order_relaxed);
+    total_ns_.store(0, std::memory_order_relaxed);
+    max_ns_.store(0, std::memory_order_relaxed);
+}
+
+LatencySummary LatencyHistogram::summary() const {
+    LatencySummary summary = {};
+    
+    // Buckets are read one by one while others record; the count is taken
+    // from the buckets themselves so the percentiles stay consistent
+    uint64_t counts[BUCKETS];
+    uint64_t total = 0;
+    for (int i = 0; i < BUCKETS; ++i) {
+        counts[i] = buckets_[i].load(std::memory_order_relaxed);
+        total += counts[i];
+    }
+    if (total == 0) {
+        return summary;
+    }
+    
+    summary.count = total;
+    summary.mean_us = total_ns_.load(std::memory_order_relaxed) / 1000.0 /
+                      std::max<uint64_t>(1, count_.load(std::memory_order_relaxed));
+    summary.max_us = max_ns_.load(std::memory_order_relaxed) / 1000.0;
+    
+    const uint64_t p50_rank = total / 2;
+    const uint64_t p99_rank = total - total / 100 - 1;
+    uint64_t seen = 0;
+    bool have_p50 = false;
+    for (int i = 0; i < BUCKETS; ++i) {
+        seen += counts[i];
+        if (!have_p50 && seen > p50_rank) {
+            summary.p50_us = bucketUpperUs(i);
+            have_p50 = true;
+        }
+        if (seen > p99_rank) {
+            summary.p99_us = bucketUpperUs(i);
+            break;
+        }
+    }
+    
+    // A bucket bound can overshoot the largest value actually seen
+    summary.p50_us = std::min(summary.p50_us, summary.max_us);
+    summary.p99_us = std::min(summary.p99_us, summary.max_us);
+    return summary;
+}
+
+int64_t LatencyTracer::now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void LatencyTracer::record(LatencyStage stage, int64_t ns) {
+    histograms_[static_cast<int>(stage)].record(ns);
+}
+
+LatencySummary LatencyTracer::summary(LatencyStage stage) const {
+    return histograms_[static_cast<int>(stage)].summary();
+}
+
+void LatencyTracer::reset() {
+    for (auto& histogram : histograms_) {
+        histogram.reset();
+    }
+}
+
+const char* LatencyTracer::stageName(LatencyStage stage) {
+    switch (stage) {
+        case LatencyStage::QUEUE: return "queue";
+        case LatencyStage::DSP: return "dsp";
+        case LatencyStage::AUDIO_QUEUE: return "audio";
+        case LatencyStage::TOTAL: return "total";
+        default: return "?";
+    }
+}
+
+BlockStampQueue::BlockStampQueue()
+    : write_(0)
+    , read_(0) {
+}
+
+bool BlockStampQueue::push(const BlockStamp& stamp) {
+    const size_t write = write_.load(std::memory_order_relaxed);
+    if (write - read_.load(std::memory_order_acquire) >= CAPACITY) {
+        return false;
+    }
+    
+    stamps_[write % CAPACITY] = stamp;
+    write_.store(write + 1, std::memory_order_release);
+    return true;
+}
+
+bool BlockStampQueue::find(uint64_t index, BlockStamp& stamp) {
+    size_t read = read_.load(std::memory_order_relaxed);
+    const size_t write = write_.load(std::memory_order_acquire);
+    
+    // Skip stamps whose successor also starts at or before index
+    while (write - read >= 2 && stamps_[(read + 1) % CAPACITY].index <= index) {
+        ++read;
+    }
+    read_.store(read, std::memory_order_release);
+    
+    if (read == write || stamps_[read % CAPACITY].index > index) {
+        return false;
+    }
+    stamp = stamps_[read % CAPACITY];
+    return true;
+}
+
+bool BlockStampQueue::popBefore(uint64_t index, BlockStamp& stamp) {
+    const size_t read = read_.load(std::memory_order_relaxed);
+    if (read == write_.load(std::memory_order_acquire) || stamps_[read % CAPACITY].index >= index) {
+        return false;
+    }
+    
+    stamp = stamps_[read % CAPACITY];
+    read_.store(read + 1, std::memory_order_release);
+    return true;
+}
+
+void BlockStampQueue::clear() {
+    write_.store(0);
+    read_.store(0);
+}
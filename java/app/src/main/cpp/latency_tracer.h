@@ -0,0 +1,104 @@
+#ifndef LATENCY_TRACER_H
+#define LATENCY_TRACER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Where a block's time goes between the USB callback and the consumer of
+// its audio (getAudioData() on the app, the sink in sdrradio_cli):
+//   QUEUE        IQ ring, USB callback -> processing loop picks it up
+//   DSP          processing loop -> audio written to AudioProcessor
+//   AUDIO_QUEUE  AudioProcessor buffer -> first sample read out
+//   TOTAL        USB callback -> first sample read out
+enum class LatencyStage {
+    QUEUE = 0,
+    DSP,
+    AUDIO_QUEUE,
+    TOTAL,
+    COUNT
+};
+
+struct LatencySummary {
+    uint64_t count;
+    double mean_us;
+    double p50_us;
+    double p99_us;
+    double max_us;
+};
+
+// Log-linear histogram of microseconds: exact below 16 us, then four
+// buckets per power of two (under 19 % error) up to 2^31 us. Lock-free;
+// any thread may record.
+class LatencyHistogram {
+public:
+    LatencyHistogram();
+    
+    void record(int64_t ns);
+    void reset();
+    LatencySummary summary() const;
+    
+    static const int BUCKETS = 128;
+
+private:
+    static int bucketOf(uint64_t us);
+    static double bucketUpperUs(int bucket);
+    
+    std::atomic<uint64_t> buckets_[BUCKETS];
+    std::atomic<uint64_t> count_;
+    std::atomic<uint64_t> total_ns_;
+    std::atomic<uint64_t> max_ns_;
+};
+
+class LatencyTracer {
+public:
+    // Monotonic clock every stamp is taken on
+    static int64_t now();
+    
+    void record(LatencyStage stage, int64_t ns);
+    LatencySummary summary(LatencyStage stage) const;
+    void reset();
+    
+    static const char* stageName(LatencyStage stage);
+
+private:
+    LatencyHistogram histograms_[static_cast<int>(LatencyStage::COUNT)];
+};
+
+// Ingest time of the samples from index on, plus the time of the last
+// stage that touched them
+struct BlockStamp {
+    uint64_t index;
+    int64_t ingest_ns;
+    int64_t stage_ns;
+};
+
+// Single-producer/single-consumer queue of block stamps that rides next to
+// a sample ring. The producer pushes a stamp before committing the samples
+// it describes, so the consumer never sees a sample before its stamp; a
+// full queue skips the stamp and those samples go untraced.
+class BlockStampQueue {
+public:
+    BlockStampQueue();
+    
+    // Producer
+    bool push(const BlockStamp& stamp);
+    
+    // Consumer: the newest stamp at or before index, dropping the ones it
+    // supersedes. False if no stamp covers index.
+    bool find(uint64_t index, BlockStamp& stamp);
+    
+    // Consumer: takes the oldest stamp if it starts before index
+    bool popBefore(uint64_t index, BlockStamp& stamp);
+    
+    // Only while neither side is running
+    void clear();
+
+private:
+    static const size_t CAPACITY = 256;
+    BlockStamp stamps_[CAPACITY];
+    alignas(64) std::atomic<size_t> write_;
+    alignas(64) std::atomic<size_t> read_;
+};
+
+#endif // LATENCY_TRACER_H
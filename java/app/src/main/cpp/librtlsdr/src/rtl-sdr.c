@@ -10,14 +10,17 @@
 #include <unistd.h>
 #include <errno.h>
 #include <fcntl.h>
+#include <poll.h>
+#include <sys/eventfd.h>
 #include <sys/ioctl.h>
 #include <linux/usbdevice_fs.h>
 #include <android/log.h>
+#include "async_logger.h"
 
 #define LOG_TAG "RTL_SDR"
-#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
-#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
-#define LOGD(...) __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, __VA_ARGS__)
+#define LOGI(...) ASYNC_LOG(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+#define LOGE(...) ASYNC_LOG(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+#define LOGD(...) ASYNC_LOG(ANDROID_LOG_DEBUG, LOG_TAG, __VA_ARGS__)
 
 // RTL2832 USB vendor/product IDs
 #define RTL_VID 0x0bda
@@ -48,6 +51,7 @@ struct rtlsdr_dev {
     rtlsdr_read_async_cb_t cb;
     void *cb_ctx;
     int async_cancel;
+    int cancel_fd;      // eventfd that wakes the async read loop on cancel
 };
 
 static struct rtlsdr_dev *dev = NULL;
@@ -129,6 +133,7 @@ int rtlsdr_open_fd(rtlsdr_dev_t **out_dev, int fd) {
     new_dev->auto_gain = 1;
     new_dev->tuner_type = RTLSDR_TUNER_R820T;
     new_dev->async_cancel = 0;
+    new_dev->cancel_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
     
     *out_dev = new_dev;
     dev = new_dev;
@@ -155,6 +160,9 @@ int rtlsdr_close(rtlsdr_dev_t *dev) {
             close(dev->fd);
         }
     }
+    if (dev->cancel_fd >= 0) {
+        close(dev->cancel_fd);
+    }
     
     free(dev);
     
@@ -297,21 +305,48 @@ int rtlsdr_read_async(rtlsdr_dev_t *dev, rtlsdr_read_async_cb_t cb, void *ctx, u
         return -1;
     }
     
+    // Drop a cancel left over from a previous run
+    uint64_t pending;
+    if (dev->cancel_fd >= 0) {
+        while (read(dev->cancel_fd, &pending, sizeof(pending)) > 0) {
+        }
+    }
+    
+    struct pollfd fds[2];
+    fds[0].fd = dev->fd;
+    fds[0].events = POLLIN;
+    fds[1].fd = dev->cancel_fd;
+    fds[1].events = POLLIN;
+    const nfds_t nfds = dev->cancel_fd >= 0 ? 2 : 1;
+    
     LOGI("Starting async read loop");
     
     while (!dev->async_cancel) {
+        // Sleep until the device has data or rtlsdr_cancel_async() signals
+        if (poll(fds, nfds, -1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            LOGE("Async poll failed: %s", strerror(errno));
+            break;
+        }
+        if (nfds > 1 && (fds[1].revents & POLLIN)) {
+            break;
+        }
+        if (!(fds[0].revents & (POLLIN | POLLERR | POLLHUP))) {
+            continue;
+        }
+        
         int bytes_read = read(dev->fd, buffer, buf_len);
         if (bytes_read > 0) {
             cb(buffer, bytes_read, ctx);
-        } else if (bytes_read < 0) {
-            if (errno != EAGAIN && errno != EINTR) {
-                LOGE("Async read failed: %s", strerror(errno));
-                break;
-            }
+        } else if (bytes_read == 0) {
+            LOGE("Async read: device closed");
+            break;
+        } else if (errno != EAGAIN && errno != EINTR) {
+            LOGE("Async read failed: %s", strerror(errno));
+            break;
         }
-        
-        // Small delay to prevent excessive CPU usage
-        usleep(1000);
     }
     
     free(buffer);
@@ -326,6 +361,12 @@ int rtlsdr_cancel_async(rtlsdr_dev_t *dev) {
     }
     
     dev->async_cancel = 1;
+    if (dev->cancel_fd >= 0) {
+        uint64_t one = 1;
+        if (write(dev->cancel_fd, &one, sizeof(one)) < 0) {
+            LOGE("Async cancel signal failed: %s", strerror(errno));
+        }
+    }
     
     LOGD("Async read cancelled");
     return 0;
@@ -0,0 +1,700 @@
+#include "async_logger.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <condition_variable>
+#include <cstdarg>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <thread>
+
+namespace {
+
+// What each argument of a format is read and stored as
+enum ArgType : uint8_t {
+    ARG_NONE = 0,
+    ARG_INT,
+    ARG_UINT,
+    ARG_LONG,
+    ARG_ULONG,
+    ARG_LLONG,
+    ARG_ULLONG,
+    ARG_SSIZE,
+    ARG_SIZE,
+    ARG_INTMAX,
+    ARG_UINTMAX,
+    ARG_DOUBLE,
+    ARG_STRING,
+    ARG_POINTER
+};
+
+enum ParseState : uint8_t {
+    PARSE_NONE = 0,
+    PARSE_READY,
+    PARSE_UNSUPPORTED
+};
+
+const size_t RECORD_SIZE = 256;
+const size_t RING_RECORDS = 256;     // 64 KB per logging thread
+const int MAX_RINGS = 16;            // threads past this log synchronously
+const size_t MESSAGE_SIZE = 512;
+const size_t MAX_SPEC = 32;
+const int64_t RATE_WINDOW_NS = 1000000000;
+
+struct LogRecord {
+    const async_log_site* site;
+    const char* fmt;
+    int64_t time_ns;
+    uint32_t suppressed;
+    uint16_t string_bytes;
+    uint8_t arg_count;
+    uint64_t args[ASYNC_LOG_MAX_ARGS];    // integers, double bits, string offsets
+    char strings[RECORD_SIZE - 32 - 8 * ASYNC_LOG_MAX_ARGS];
+};
+
+static_assert(sizeof(LogRecord) == RECORD_SIZE, "log records are one fixed size");
+
+// Single producer (the owning thread), single consumer (the drainer)
+struct Ring {
+    LogRecord records[RING_RECORDS];
+    alignas(64) std::atomic<size_t> write_index{0};
+    alignas(64) std::atomic<size_t> read_index{0};
+    std::atomic<bool> owned{false};
+    std::atomic<uint64_t> dropped{0};
+};
+
+struct Spec {
+    const char* end;    // one past the conversion character
+    int stars;          // '*' width / precision, each an int argument
+    uint8_t type;       // ARG_NONE: not something a record can hold
+};
+
+int64_t nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// p points at the '%' of a conversion other than "%%"
+Spec parseSpec(const char* p) {
+    Spec spec = {p + 1, 0, ARG_NONE};
+    const char* s = p + 1;
+    
+    while (*s && std::strchr("-+ #0'", *s)) {
+        ++s;
+    }
+    if (*s == '*') {
+        ++spec.stars;
+        ++s;
+    } else {
+        while (std::isdigit(static_cast<unsigned char>(*s))) {
+            ++s;
+        }
+        if (*s == '$') {
+            // Positional arguments
+            spec.end = s + 1;
+            return spec;
+        }
+    }
+    if (*s == '.') {
+        ++s;
+        if (*s == '*') {
+            ++spec.stars;
+            ++s;
+        } else {
+            while (std::isdigit(static_cast<unsigned char>(*s))) {
+                ++s;
+            }
+        }
+    }
+    
+    enum { LEN_NONE, LEN_H, LEN_L, LEN_LL, LEN_Z, LEN_J, LEN_T, LEN_BIG_L } length = LEN_NONE;
+    if (*s == 'h') {
+        length = LEN_H;
+        s += (s[1] == 'h') ? 2 : 1;
+    } else if (*s == 'l') {
+        length = (s[1] == 'l') ? LEN_LL : LEN_L;
+        s += (s[1] == 'l') ? 2 : 1;
+    } else if (*s == 'z') {
+        length = LEN_Z;
+        ++s;
+    } else if (*s == 'j') {
+        length = LEN_J;
+        ++s;
+    } else if (*s == 't') {
+        length = LEN_T;
+        ++s;
+    } else if (*s == 'L') {
+        length = LEN_BIG_L;
+        ++s;
+    }
+    
+    const char conversion = *s;
+    spec.end = conversion ? s + 1 : s;
+    if (static_cast<size_t>(spec.end - p) >= MAX_SPEC) {
+        return spec;
+    }
+    
+    switch (conversion) {
+        case 'd':
+        case 'i':
+        case 'c':
+            if (conversion == 'c' && length != LEN_NONE) {
+                break;
+            }
+            switch (length) {
+                case LEN_NONE: case LEN_H: spec.type = ARG_INT; break;
+                case LEN_L: spec.type = ARG_LONG; break;
+                case LEN_LL: spec.type = ARG_LLONG; break;
+                case LEN_Z: case LEN_T: spec.type = ARG_SSIZE; break;
+                case LEN_J: spec.type = ARG_INTMAX; break;
+                default: break;
+            }
+            break;
+        case 'u':
+        case 'x':
+        case 'X':
+        case 'o':
+            switch (length) {
+                case LEN_NONE: case LEN_H: spec.type = ARG_UINT; break;
+                case LEN_L: spec.type = ARG_ULONG; break;
+                case LEN_LL: spec.type = ARG_ULLONG; break;
+                case LEN_Z: case LEN_T: spec.type = ARG_SIZE; break;
+                case LEN_J: spec.type = ARG_UINTMAX; break;
+                default: break;
+            }
+            break;
+        case 'f': case 'F': case 'e': case 'E':
+        case 'g': case 'G': case 'a': case 'A':
+            if (length == LEN_NONE || length == LEN_L) {
+                spec.type = ARG_DOUBLE;
+            }
+            break;
+        case 's':
+            if (length == LEN_NONE) {
+                spec.type = ARG_STRING;
+            }
+            break;
+        case 'p':
+            spec.type = ARG_POINTER;
+            break;
+        default:
+            break;
+    }
+    return spec;
+}
+
+// Argument types of fmt in order; false if a record cannot hold them
+bool parseFormat(const char* fmt, uint8_t* types, uint8_t& count) {
+    count = 0;
+    for (const char* p = fmt; *p; ) {
+        if (*p != '%') {
+            ++p;
+            continue;
+        }
+        if (p[1] == '%') {
+            p += 2;
+            continue;
+        }
+        
+        Spec spec = parseSpec(p);
+        if (spec.type == ARG_NONE || count + spec.stars + 1 > ASYNC_LOG_MAX_ARGS) {
+            return false;
+        }
+        for (int i = 0; i < spec.stars; ++i) {
+            types[count++] = ARG_INT;
+        }
+        types[count++] = spec.type;
+        p = spec.end;
+    }
+    return true;
+}
+
+template <typename T>
+int formatValue(char* out, size_t size, const char* spec, const int* stars, int star_count, T value) {
+    switch (star_count) {
+        case 0: return std::snprintf(out, size, spec, value);
+        case 1: return std::snprintf(out, size, spec, stars[0], value);
+        default: return std::snprintf(out, size, spec, stars[0], stars[1], value);
+    }
+}
+
+int formatArg(char* out, size_t size, const char* spec, const int* stars, int star_count,
+              uint8_t type, uint64_t arg, const LogRecord& record) {
+    switch (type) {
+        case ARG_INT: return formatValue(out, size, spec, stars, star_count, static_cast<int>(arg));
+        case ARG_UINT: return formatValue(out, size, spec, stars, star_count, static_cast<unsigned int>(arg));
+        case ARG_LONG: return formatValue(out, size, spec, stars, star_count, static_cast<long>(arg));
+        case ARG_ULONG: return formatValue(out, size, spec, stars, star_count, static_cast<unsigned long>(arg));
+        case ARG_LLONG: return formatValue(out, size, spec, stars, star_count, static_cast<long long>(arg));
+        case ARG_ULLONG: return formatValue(out, size, spec, stars, star_count, static_cast<unsigned long long>(arg));
+        case ARG_SSIZE: return formatValue(out, size, spec, stars, star_count, static_cast<ptrdiff_t>(arg));
+        case ARG_SIZE: return formatValue(out, size, spec, stars, star_count, static_cast<size_t>(arg));
+        case ARG_INTMAX: return formatValue(out, size, spec, stars, star_count, static_cast<intmax_t>(arg));
+        case ARG_UINTMAX: return formatValue(out, size, spec, stars, star_count, static_cast<uintmax_t>(arg));
+        case ARG_DOUBLE: {
+            double value;
+            std::memcpy(&value, &arg, sizeof(value));
+            return formatValue(out, size, spec, stars, star_count, value);
+        }
+        case ARG_STRING:
+            return formatValue(out, size, spec, stars, star_count, record.strings + arg);
+        case ARG_POINTER:
+            return formatValue(out, size, spec, stars, star_count,
+                               reinterpret_cast<const void*>(static_cast<uintptr_t>(arg)));
+        default:
+            return 0;
+    }
+}
+
+// The record's format with its stored arguments, like vsnprintf would
+void formatRecord(const LogRecord& record, char* out, size_t size) {
+    size_t used = 0;
+    int arg = 0;
+    
+    for (const char* p = record.fmt; *p && used + 1 < size; ) {
+        if (*p != '%') {
+            out[used++] = *p++;
+            continue;
+        }
+        if (p[1] == '%') {
+            out[used++] = '%';
+            p += 2;
+            continue;
+        }
+        
+        Spec spec = parseSpec(p);
+        char spec_text[MAX_SPEC];
+        const size_t spec_length = static_cast<size_t>(spec.end - p);
+        std::memcpy(spec_text, p, spec_length);
+        spec_text[spec_length] = '\0';
+        
+        int stars[2] = {0, 0};
+        for (int i = 0; i < spec.stars; ++i) {
+            stars[i] = static_cast<int>(record.args[arg++]);
+        }
+        int written = formatArg(out + used, size - used, spec_text, stars, spec.stars,
+                                record.site->arg_types[arg], record.args[arg], record);
+        ++arg;
+        if (written > 0) {
+            used += std::min(static_cast<size_t>(written), size - used - 1);
+        }
+        p = spec.end;
+    }
+    out[used] = '\0';
+    
+    if (record.suppressed > 0 && used + 1 < size) {
+        std::snprintf(out + used, size - used, " [+%u suppressed]", record.suppressed);
+    }
+}
+
+void logcatHandler(int level, const char* tag, const char* message, void*) {
+    __android_log_write(level, tag, message);
+}
+
+class Logger {
+public:
+    static Logger& instance() {
+        // Never destroyed: thread-exit handlers and late loggers may still
+        // reach it while statics are torn down
+        static Logger* logger = new Logger();
+        return *logger;
+    }
+    
+    Ring* claimRing();
+    void ensureDrainer();
+    void flush();
+    
+    // Producer, after publishing a record into a ring that was empty
+    void wakeDrainer();
+    
+    void setHandler(async_log_handler handler, void* context) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        handler_ = handler ? handler : logcatHandler;
+        context_ = handler ? context : nullptr;
+    }
+    
+    void writeNow(int level, const char* tag, const char* message) {
+        async_log_handler handler;
+        void* context;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            handler = handler_;
+            context = context_;
+        }
+        handler(level, tag, message, context);
+    }
+    
+    std::atomic<uint64_t> written{0};
+    std::atomic<uint64_t> suppressed{0};
+    std::atomic<uint64_t> synchronous{0};
+    std::atomic<uint64_t> wakeups{0};
+    
+    uint64_t droppedTotal() const;
+
+private:
+    Logger()
+        : handler_(logcatHandler)
+        , context_(nullptr)
+        , started_(false)
+        , asleep_(false)
+        , wake_requested_(false)
+        , flush_requested_(0)
+        , flush_done_(0) {
+        for (auto& ring : rings_) {
+            ring.store(nullptr);
+        }
+    }
+    
+    void drainLoop();
+    void drainAll(async_log_handler handler, void* context);
+    bool anyPending() const;
+    
+    std::atomic<Ring*> rings_[MAX_RINGS];
+    
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::condition_variable flushed_;
+    async_log_handler handler_;
+    void* context_;
+    
+    std::atomic<bool> started_;
+    std::once_flag start_once_;
+    
+    // Set while the drainer waits with no timeout; the producer that takes
+    // it back wakes the drainer, so at most one signal per sleep
+    std::atomic<bool> asleep_;
+    bool wake_requested_;       // under mutex_
+    uint64_t flush_requested_;
+    uint64_t flush_done_;
+    uint64_t dropped_reported_ = 0;
+};
+
+Ring* Logger::claimRing() {
+    // A ring left by a thread that exited is reused as is; whatever it
+    // still holds drains in order ahead of the new owner's records
+    for (auto& slot : rings_) {
+        Ring* ring = slot.load(std::memory_order_acquire);
+        bool expected = false;
+        if (ring && ring->owned.compare_exchange_strong(expected, true, std::memory_order_acq_rel)) {
+            return ring;
+        }
+    }
+    
+    Ring* ring = new Ring();
+    ring->owned.store(true);
+    for (auto& slot : rings_) {
+        Ring* expected = nullptr;
+        if (slot.compare_exchange_strong(expected, ring, std::memory_order_acq_rel)) {
+            return ring;
+        }
+    }
+    delete ring;
+    return nullptr;
+}
+
+uint64_t Logger::droppedTotal() const {
+    uint64_t total = 0;
+    for (const auto& slot : rings_) {
+        Ring* ring = slot.load(std::memory_order_acquire);
+        if (ring) {
+            total += ring->dropped.load(std::memory_order_relaxed);
+        }
+    }
+    return total;
+}
+
+void Logger::ensureDrainer() {
+    if (started_.load(std::memory_order_acquire)) {
+        return;
+    }
+    std::call_once(start_once_, [this] {
+        std::thread(&Logger::drainLoop, this).detach();
+        started_.store(true, std::memory_order_release);
+    });
+}
+
+void Logger::flush() {
+    ensureDrainer();
+    
+    std::unique_lock<std::mutex> lock(mutex_);
+    const uint64_t ticket = ++flush_requested_;
+    wake_.notify_one();
+    flushed_.wait(lock, [&] { return flush_done_ >= ticket; });
+}
+
+void Logger::drainLoop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+        const uint64_t requested = flush_requested_;
+        async_log_handler handler = handler_;
+        void* context = context_;
+        lock.unlock();
+        
+        drainAll(handler, context);
+        
+        lock.lock();
+        flush_done_ = requested;
+        flushed_.notify_all();
+        if (flush_requested_ != requested) {
+            continue;
+        }
+        
+        // Announce the sleep, then look once more: a record published
+        // before the producer could see the flag is caught here, one
+        // published after it makes its producer signal. Idle, the drainer
+        // never wakes.
+        wake_requested_ = false;
+        asleep_.store(true, std::memory_order_seq_cst);
+        if (!anyPending()) {
+            wake_.wait(lock, [&] { return wake_requested_ || flush_requested_ != requested; });
+            wakeups.fetch_add(1, std::memory_order_relaxed);
+        }
+        asleep_.store(false, std::memory_order_relaxed);
+    }
+}
+
+void Logger::wakeDrainer() {
+    if (!asleep_.load(std::memory_order_seq_cst) || !asleep_.exchange(false, std::memory_order_seq_cst)) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    wake_requested_ = true;
+    wake_.notify_one();
+}
+
+bool Logger::anyPending() const {
+    for (const auto& slot : rings_) {
+        Ring* ring = slot.load(std::memory_order_acquire);
+        if (ring && ring->read_index.load(std::memory_order_relaxed) !=
+                    ring->write_index.load(std::memory_order_seq_cst)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void Logger::drainAll(async_log_handler handler, void* context) {
+    char message[MESSAGE_SIZE];
+    
+    // Oldest record first across all threads' rings
+    for (;;) {
+        Ring* oldest = nullptr;
+        const LogRecord* oldest_record = nullptr;
+        for (auto& slot : rings_) {
+            Ring* ring = slot.load(std::memory_order_acquire);
+            if (!ring) {
+                continue;
+            }
+            const size_t read = ring->read_index.load(std::memory_order_relaxed);
+            if (read == ring->write_index.load(std::memory_order_acquire)) {
+                continue;
+            }
+            const LogRecord* record = &ring->records[read % RING_RECORDS];
+            if (!oldest_record || record->time_ns < oldest_record->time_ns) {
+                oldest = ring;
+                oldest_record = record;
+            }
+        }
+        if (!oldest) {
+            break;
+        }
+        
+        formatRecord(*oldest_record, message, sizeof(message));
+        handler(oldest_record->site->level, oldest_record->site->tag, message, context);
+        written.fetch_add(1, std::memory_order_relaxed);
+        oldest->read_index.fetch_add(1, std::memory_order_release);
+    }
+    
+    const uint64_t dropped = droppedTotal();
+    if (dropped > dropped_reported_) {
+        std::snprintf(message, sizeof(message), "%llu log records dropped, ring full",
+                      static_cast<unsigned long long>(dropped - dropped_reported_));
+        handler(ANDROID_LOG_WARN, "AsyncLogger", message, context);
+        dropped_reported_ = dropped;
+    }
+}
+
+struct ThreadRing {
+    Ring* ring = nullptr;
+    bool claimed = false;
+    
+    ~ThreadRing() {
+        if (ring) {
+            ring->owned.store(false, std::memory_order_release);
+        }
+    }
+};
+
+thread_local ThreadRing thread_ring;
+
+Ring* currentRing() {
+    if (!thread_ring.claimed) {
+        thread_ring.claimed = true;
+        thread_ring.ring = Logger::instance().claimRing();
+    }
+    return thread_ring.ring;
+}
+
+// At most per_second records per one-second window and site; the record
+// that gets through collects the count held back before it
+bool admit(async_log_site* site, int64_t now, uint32_t& suppressed) {
+    suppressed = 0;
+    if (site->per_second == 0) {
+        return true;
+    }
+    
+    uint64_t start = __atomic_load_n(&site->window_start_ns, __ATOMIC_RELAXED);
+    if (static_cast<int64_t>(static_cast<uint64_t>(now) - start) >= RATE_WINDOW_NS &&
+        __atomic_compare_exchange_n(&site->window_start_ns, &start, static_cast<uint64_t>(now), false,
+                                    __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+        __atomic_store_n(&site->window_count, 0, __ATOMIC_RELAXED);
+    }
+    
+    if (__atomic_fetch_add(&site->window_count, 1, __ATOMIC_RELAXED) >= site->per_second) {
+        __atomic_fetch_add(&site->suppressed, 1, __ATOMIC_RELAXED);
+        Logger::instance().suppressed.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    suppressed = __atomic_exchange_n(&site->suppressed, 0, __ATOMIC_RELAXED);
+    return true;
+}
+
+// Argument types, parsed from the format on the site's first use
+uint8_t siteFormat(async_log_site* site, const char* fmt) {
+    uint8_t state = __atomic_load_n(&site->parse_state, __ATOMIC_ACQUIRE);
+    if (state != PARSE_NONE) {
+        return state;
+    }
+    
+    // Racing first calls parse the same format to the same values
+    uint8_t types[ASYNC_LOG_MAX_ARGS] = {};
+    uint8_t count = 0;
+    state = parseFormat(fmt, types, count) ? PARSE_READY : PARSE_UNSUPPORTED;
+    for (int i = 0; i < ASYNC_LOG_MAX_ARGS; ++i) {
+        __atomic_store_n(&site->arg_types[i], types[i], __ATOMIC_RELAXED);
+    }
+    __atomic_store_n(&site->arg_count, count, __ATOMIC_RELAXED);
+    __atomic_store_n(&site->parse_state, state, __ATOMIC_RELEASE);
+    return state;
+}
+
+uint64_t copyString(LogRecord& record, const char* text) {
+    // The last byte always holds an empty string for when space runs out
+    const size_t last = sizeof(record.strings) - 1;
+    const size_t used = record.string_bytes;
+    if (used >= last) {
+        return last;
+    }
+    
+    if (!text) {
+        text = "(null)";
+    }
+    const size_t length = strnlen(text, last - used);
+    std::memcpy(record.strings + used, text, length);
+    record.strings[used + length] = '\0';
+    record.string_bytes = static_cast<uint16_t>(used + length + 1);
+    return used;
+}
+
+void writeSynchronous(async_log_site* site, uint32_t suppressed, const char* fmt, va_list args) {
+    char message[MESSAGE_SIZE];
+    int length = std::vsnprintf(message, sizeof(message), fmt, args);
+    if (suppressed > 0 && length >= 0 && static_cast<size_t>(length) + 1 < sizeof(message)) {
+        std::snprintf(message + length, sizeof(message) - length, " [+%u suppressed]", suppressed);
+    }
+    Logger::instance().synchronous.fetch_add(1, std::memory_order_relaxed);
+    Logger::instance().writeNow(site->level, site->tag, message);
+}
+
+} // namespace
+
+extern "C" void async_log_write(async_log_site* site, const char* fmt, ...) {
+    const int64_t now = nowNs();
+    uint32_t suppressed = 0;
+    if (!admit(site, now, suppressed)) {
+        return;
+    }
+    
+    va_list args;
+    va_start(args, fmt);
+    
+    Ring* ring = siteFormat(site, fmt) == PARSE_READY ? currentRing() : nullptr;
+    if (!ring) {
+        writeSynchronous(site, suppressed, fmt, args);
+        va_end(args);
+        return;
+    }
+    
+    Logger::instance().ensureDrainer();
+    
+    const size_t write = ring->write_index.load(std::memory_order_relaxed);
+    const size_t read = ring->read_index.load(std::memory_order_acquire);
+    if (write - read >= RING_RECORDS) {
+        ring->dropped.fetch_add(1, std::memory_order_relaxed);
+        va_end(args);
+        return;
+    }
+    
+    LogRecord& record = ring->records[write % RING_RECORDS];
+    record.site = site;
+    record.fmt = fmt;
+    record.time_ns = now;
+    record.suppressed = suppressed;
+    record.string_bytes = 0;
+    record.arg_count = site->arg_count;
+    record.strings[sizeof(record.strings) - 1] = '\0';
+    
+    for (uint8_t i = 0; i < record.arg_count; ++i) {
+        uint64_t& slot = record.args[i];
+        switch (site->arg_types[i]) {
+            case ARG_INT: slot = static_cast<uint64_t>(va_arg(args, int)); break;
+            case ARG_UINT: slot = va_arg(args, unsigned int); break;
+            case ARG_LONG: slot = static_cast<uint64_t>(va_arg(args, long)); break;
+            case ARG_ULONG: slot = va_arg(args, unsigned long); break;
+            case ARG_LLONG: slot = static_cast<uint64_t>(va_arg(args, long long)); break;
+            case ARG_ULLONG: slot = va_arg(args, unsigned long long); break;
+            case ARG_SSIZE: slot = static_cast<uint64_t>(va_arg(args, ptrdiff_t)); break;
+            case ARG_SIZE: slot = va_arg(args, size_t); break;
+            case ARG_INTMAX: slot = static_cast<uint64_t>(va_arg(args, intmax_t)); break;
+            case ARG_UINTMAX: slot = va_arg(args, uintmax_t); break;
+            case ARG_DOUBLE: {
+                double value = va_arg(args, double);
+                std::memcpy(&slot, &value, sizeof(slot));
+                break;
+            }
+            case ARG_STRING: slot = copyString(record, va_arg(args, const char*)); break;
+            case ARG_POINTER: slot = reinterpret_cast<uintptr_t>(va_arg(args, void*)); break;
+            default: slot = 0; break;
+        }
+    }
+    va_end(args);
+    
+    ring->write_index.store(write + 1, std::memory_order_seq_cst);
+    
+    // Only the first record after the drainer caught up can find it
+    // asleep; the rest of a burst costs no syscall
+    if (write == read) {
+        Logger::instance().wakeDrainer();
+    }
+}
+
+extern "C" void async_log_set_handler(async_log_handler handler, void* context) {
+    Logger::instance().setHandler(handler, context);
+}
+
+extern "C" void async_log_flush(void) {
+    Logger::instance().flush();
+}
+
+extern "C" void async_log_get_stats(async_log_stats* stats) {
+    Logger& logger = Logger::instance();
+    stats->written = logger.written.load(std::memory_order_relaxed);
+    stats->dropped = logger.droppedTotal();
+    stats->suppressed = logger.suppressed.load(std::memory_order_relaxed);
+    stats->synchronous = logger.synchronous.load(std::memory_order_relaxed);
+    stats->drainer_wakeups = logger.wakeups.load(std::memory_order_relaxed);
+}
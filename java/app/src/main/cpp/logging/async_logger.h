@@ -0,0 +1,96 @@
+#ifndef ASYNC_LOGGER_H
+#define ASYNC_LOGGER_H
+
+#include <android/log.h>
+#include <stdint.h>
+
+// Logging off the hot path. A call site copies its arguments into a
+// fixed-size binary record (the site identifies the format) in a lock-free
+// ring owned by the calling thread; a background drainer formats the
+// records and hands them to logcat (or another handler). The drainer
+// sleeps without a timeout once the rings are empty and is woken by the
+// record that finds its ring empty, so an idle process sees no wakeups and
+// a burst costs one signal. Plain C so librtlsdr can use it as well.
+//
+//   #define LOGI(...) ASYNC_LOG(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+//
+// Levels below ASYNC_LOG_MIN_LEVEL compile to nothing: by default debug
+// logs only exist without NDEBUG. Each site lets through at most
+// ASYNC_LOG_DEFAULT_RATE records per second (ASYNC_LOG_RATE for its own
+// limit, 0 for none); the next record that gets through reports how many
+// were suppressed.
+//
+// Arguments follow printf; up to ASYNC_LOG_MAX_ARGS of them, strings are
+// copied (truncated to the record's space). Formats the record cannot
+// hold (more arguments, %n, long double, wide strings) are formatted and
+// written synchronously instead, as they would have been before.
+
+#ifndef ASYNC_LOG_MIN_LEVEL
+#ifdef NDEBUG
+#define ASYNC_LOG_MIN_LEVEL ANDROID_LOG_INFO
+#else
+#define ASYNC_LOG_MIN_LEVEL ANDROID_LOG_DEBUG
+#endif
+#endif
+
+#define ASYNC_LOG_DEFAULT_RATE 20
+#define ASYNC_LOG_MAX_ARGS 8
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// One per call site, static. The fields after tag are runtime state the
+// logger updates with atomic builtins; leave them zero.
+typedef struct async_log_site {
+    int level;
+    uint32_t per_second;
+    const char* tag;
+    uint64_t window_start_ns;
+    uint32_t window_count;
+    uint32_t suppressed;
+    uint8_t arg_types[ASYNC_LOG_MAX_ARGS];
+    uint8_t arg_count;
+    uint8_t parse_state;
+} async_log_site;
+
+#define ASYNC_LOG_SITE_INIT(level, per_second, tag) \
+    { (level), (per_second), (tag), 0, 0, 0, {0, 0, 0, 0, 0, 0, 0, 0}, 0, 0 }
+
+void async_log_write(async_log_site* site, const char* fmt, ...)
+    __attribute__((format(printf, 2, 3)));
+
+#define ASYNC_LOG_RATE(level, per_second, tag, ...)                                        \
+    do {                                                                                   \
+        if ((level) >= ASYNC_LOG_MIN_LEVEL) {                                              \
+            static async_log_site async_log_site_ = ASYNC_LOG_SITE_INIT(level, per_second, tag); \
+            async_log_write(&async_log_site_, __VA_ARGS__);                                \
+        }                                                                                  \
+    } while (0)
+
+#define ASYNC_LOG(level, tag, ...) ASYNC_LOG_RATE(level, ASYNC_LOG_DEFAULT_RATE, tag, __VA_ARGS__)
+
+// Where the drainer sends formatted messages; NULL restores logcat
+// (__android_log_write). Called on the drainer thread, and on the caller's
+// thread for records written synchronously.
+typedef void (*async_log_handler)(int level, const char* tag, const char* message, void* context);
+void async_log_set_handler(async_log_handler handler, void* context);
+
+// Blocks until every record written before the call has been handled
+void async_log_flush(void);
+
+typedef struct async_log_stats {
+    uint64_t written;       // records handled by the drainer
+    uint64_t dropped;       // lost to a full ring
+    uint64_t suppressed;    // held back by a site's rate limit
+    uint64_t synchronous;   // formatted on the caller's thread
+    uint64_t drainer_wakeups;   // times the drainer slept and was woken
+} async_log_stats;
+
+void async_log_get_stats(async_log_stats* stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // ASYNC_LOGGER_H
@@ -0,0 +1,98 @@
+#include "nco.h"
+#include <algorithm>
+#include <cmath>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+Nco::Nco()
+    : frequency_(0.0)
+    , phase_(0.0)
+    , step_re_(1.0f)
+    , step_im_(0.0f)
+    , phasor_(1.0f, 0.0f)
+    , scalar_step_(1.0f, 0.0f)
+    , scalar_left_(0) {
+}
+
+void Nco::setFrequency(double frequency) {
+    // phase_ is already the next sample's; only the steps change
+    frequency_ = frequency;
+    const double lanes_angle = 2.0 * M_PI * frequency * LANES;
+    step_re_ = static_cast<float>(std::cos(lanes_angle));
+    step_im_ = static_cast<float>(std::sin(lanes_angle));
+    scalar_step_ = std::complex<float>(static_cast<float>(std::cos(2.0 * M_PI * frequency)),
+                                       static_cast<float>(std::sin(2.0 * M_PI * frequency)));
+    scalar_left_ = 0;
+}
+
+void Nco::reset(double phase) {
+    phase_ = std::remainder(phase, 2.0 * M_PI);
+    scalar_left_ = 0;
+}
+
+void Nco::loadLanes(double phase, float* lane_re, float* lane_im) const {
+    const double step = 2.0 * M_PI * frequency_;
+    for (int lane = 0; lane < LANES; ++lane) {
+        lane_re[lane] = static_cast<float>(std::cos(phase + step * lane));
+        lane_im[lane] = static_cast<float>(std::sin(phase + step * lane));
+    }
+}
+
+void Nco::mix(const std::complex<float>* input, size_t count, std::complex<float>* output) {
+    const double step = 2.0 * M_PI * frequency_;
+    
+    // One interval at a time: the phasors first, into split arrays that
+    // stay in L1, then a flat multiply the vectorizer de-interleaves as in
+    // the FM discriminator. Each phasor is the one LANES samples back
+    // times the step, a recurrence LANES apart, so up to LANES of them
+    // come out of one vector iteration.
+    float phasor_re[RESYNC_INTERVAL];
+    float phasor_im[RESYNC_INTERVAL];
+    const float step_re = step_re_;
+    const float step_im = step_im_;
+    
+    size_t done = 0;
+    while (done < count) {
+        const size_t span = std::min(count - done, static_cast<size_t>(RESYNC_INTERVAL));
+        
+        // First lanes from the exact phase: the renormalization
+        loadLanes(phase_ + step * static_cast<double>(done), phasor_re, phasor_im);
+        for (size_t k = LANES; k < span; ++k) {
+            phasor_re[k] = phasor_re[k - LANES] * step_re - phasor_im[k - LANES] * step_im;
+            phasor_im[k] = phasor_re[k - LANES] * step_im + phasor_im[k - LANES] * step_re;
+        }
+        
+        // Flat float views; output may be input, each sample is read first
+        const float* in = reinterpret_cast<const float*>(input + done);
+        float* out = reinterpret_cast<float*>(output + done);
+        for (size_t k = 0; k < span; ++k) {
+            const float re = in[2 * k];
+            const float im = in[2 * k + 1];
+            out[2 * k] = re * phasor_re[k] - im * phasor_im[k];
+            out[2 * k + 1] = re * phasor_im[k] + im * phasor_re[k];
+        }
+        done += span;
+    }
+    
+    phase_ = std::remainder(phase_ + step * static_cast<double>(count), 2.0 * M_PI);
+    scalar_left_ = 0;
+}
+
+std::complex<float> Nco::next() {
+    if (scalar_left_ == 0) {
+        phasor_ = std::complex<float>(static_cast<float>(std::cos(phase_)),
+                                      static_cast<float>(std::sin(phase_)));
+        scalar_left_ = RESYNC_INTERVAL;
+    }
+    --scalar_left_;
+    
+    const std::complex<float> current = phasor_;
+    phasor_ *= scalar_step_;
+    phase_ += 2.0 * M_PI * frequency_;
+    if (phase_ > M_PI || phase_ < -M_PI) {
+        phase_ = std::remainder(phase_, 2.0 * M_PI);
+    }
+    return current;
+}
@@ -0,0 +1,141 @@
+#include "overlap_save_filter.h"
+#include <algorithm>
+#include <cmath>
+
+OverlapSaveFilter::OverlapSaveFilter()
+    : num_taps_(0)
+    , decimation_(1)
+    , phase_(0)
+    , block_fill_(0) {
+}
+
+bool OverlapSaveFilter::configure(const std::vector<float>& taps, int decimation) {
+    if (taps.empty() || decimation < 1) {
+        return false;
+    }
+    
+    int fft_size = chooseFFTSize(taps.size());
+    if (fft_size == 0 || !fft_plan_.setSize(fft_size)) {
+        return false;
+    }
+    
+    num_taps_ = taps.size();
+    decimation_ = decimation;
+    
+    // H = FFT(taps zero-padded), with the inverse's 1 / N folded in
+    filter_spectrum_.assign(fft_size, std::complex<float>(0, 0));
+    const float scale = 1.0f / fft_size;
+    for (size_t i = 0; i < taps.size(); ++i) {
+        filter_spectrum_[i] = std::complex<float>(taps[i] * scale, 0.0f);
+    }
+    fft_plan_.forward(filter_spectrum_.data());
+    
+    block_.resize(fft_size);
+    work_.resize(fft_size);
+    reset();
+    return true;
+}
+
+void OverlapSaveFilter::reset() {
+    std::fill(block_.begin(), block_.end(), std::complex<float>(0, 0));
+    block_fill_ = num_taps_ > 0 ? num_taps_ - 1 : 0;
+    phase_ = 0;
+}
+
+size_t OverlapSaveFilter::process(const std::complex<float>* input, size_t count,
+                                  std::complex<float>* output) {
+    if (num_taps_ == 0) {
+        return 0;
+    }
+    
+    size_t produced = 0;
+    const size_t block_size = block_.size();
+    while (count > 0) {
+        size_t chunk = std::min(count, block_size - block_fill_);
+        std::copy(input, input + chunk, block_.begin() + block_fill_);
+        block_fill_ += chunk;
+        input += chunk;
+        count -= chunk;
+        
+        if (block_fill_ == block_size) {
+            produced += processBlock(output + produced);
+        }
+    }
+    
+    return produced;
+}
+
+size_t OverlapSaveFilter::processBlock(std::complex<float>* output) {
+    const size_t block_size = block_.size();
+    const size_t history = num_taps_ - 1;
+    
+    std::copy(block_.begin(), block_.end(), work_.begin());
+    fft_plan_.forward(work_.data());
+    
+    // Pointwise complex multiply on the interleaved floats
+    float* w = reinterpret_cast<float*>(work_.data());
+    const float* h = reinterpret_cast<const float*>(filter_spectrum_.data());
+    for (size_t k = 0; k < 2 * block_size; k += 2) {
+        float re = w[k] * h[k] - w[k + 1] * h[k + 1];
+        float im = w[k] * h[k + 1] + w[k + 1] * h[k];
+        w[k] = re;
+        w[k + 1] = im;
+    }
+    
+    fft_plan_.inverse(work_.data());
+    
+    // The first `history` outputs are circularly aliased; the rest are the
+    // linear convolution for the new samples of this block
+    size_t produced = 0;
+    for (size_t j = history; j < block_size; ++j) {
+        if (++phase_ >= decimation_) {
+            phase_ = 0;
+            output[produced++] = work_[j];
+        }
+    }
+    
+    // Keep the last taps - 1 inputs as the next block's history
+    std::copy(block_.end() - history, block_.end(), block_.begin());
+    block_fill_ = history;
+    return produced;
+}
+
+float OverlapSaveFilter::fastConvolutionCost(size_t num_taps) {
+    int fft_size = chooseFFTSize(num_taps);
+    if (fft_size == 0) {
+        return INFINITY;
+    }
+    
+    return FFT_COST_WEIGHT * blockCostPerSample(fft_size, num_taps);
+}
+
+float OverlapSaveFilter::directCost(size_t num_taps, int decimation) {
+    // One real tap against re and im for every kept output
+    return 2.0f * num_taps / std::max(1, decimation);
+}
+
+int OverlapSaveFilter::chooseFFTSize(size_t num_taps) {
+    // Smallest power of two holding two filter lengths, then grow while the
+    // per-sample cost still falls (typically settles around 4-8x the taps)
+    int size = 16;
+    while (size < MAX_FFT_SIZE && static_cast<size_t>(size) < 2 * num_taps) {
+        size *= 2;
+    }
+    if (static_cast<size_t>(size) < 2 * num_taps) {
+        return 0;
+    }
+    
+    while (size < MAX_FFT_SIZE &&
+           blockCostPerSample(size * 2, num_taps) < blockCostPerSample(size, num_taps)) {
+        size *= 2;
+    }
+    return size;
+}
+
+float OverlapSaveFilter::blockCostPerSample(int fft_size, size_t num_taps) {
+    // Two transforms of ~2 N log2 N multiply-adds plus the pointwise
+    // product, spread over the fft_size - taps + 1 new samples per block
+    float n = static_cast<float>(fft_size);
+    float per_block = 2.0f * (2.0f * n * std::log2(n)) + 4.0f * n;
+    return per_block / (n - num_taps + 1);
+}
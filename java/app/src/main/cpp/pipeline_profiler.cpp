@@ -0,0 +1,146 @@
+#include "pipeline_profiler.h"
+#include <algorithm>
+#include <chrono>
+
+PipelineProfiler::PipelineProfiler() {
+    reset();
+}
+
+int64_t PipelineProfiler::now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+namespace {
+
+// Bit n set while a live thread owns slot n. Pipeline threads come and go
+// with every start/stop, so a slot goes back when its thread exits;
+// handing out ever-increasing slots would pile them all onto the last one.
+std::atomic<uint32_t> used_slots{0};
+
+static_assert(PipelineProfiler::MAX_THREADS <= 32, "slot mask is 32 bits");
+
+struct SlotHolder {
+    int slot;
+    bool owned;
+    
+    SlotHolder()
+        : slot(PipelineProfiler::MAX_THREADS - 1)
+        , owned(false) {
+        uint32_t used = used_slots.load(std::memory_order_relaxed);
+        for (;;) {
+            int free_slot = 0;
+            while (free_slot < PipelineProfiler::MAX_THREADS && (used & (1u << free_slot))) {
+                ++free_slot;
+            }
+            if (free_slot == PipelineProfiler::MAX_THREADS) {
+                return;     // all taken: share the last one
+            }
+            if (used_slots.compare_exchange_weak(used, used | (1u << free_slot), std::memory_order_relaxed)) {
+                slot = free_slot;
+                owned = true;
+                return;
+            }
+        }
+    }
+    
+    ~SlotHolder() {
+        if (owned) {
+            used_slots.fetch_and(~(1u << slot), std::memory_order_relaxed);
+        }
+    }
+};
+
+} // namespace
+
+int PipelineProfiler::threadSlot() {
+    thread_local SlotHolder holder;
+    return holder.slot;
+}
+
+void PipelineProfiler::record(PipelineStage stage, size_t samples, int64_t ns) {
+    Counter& counter = counters_[threadSlot()][static_cast<int>(stage)];
+    counter.calls.fetch_add(1, std::memory_order_relaxed);
+    counter.samples.fetch_add(samples, std::memory_order_relaxed);
+    counter.total_ns.fetch_add(ns > 0 ? static_cast<uint64_t>(ns) : 0, std::memory_order_relaxed);
+}
+
+void PipelineProfiler::recordBlock(size_t samples, int sample_rate, int64_t ns) {
+    if (samples == 0 || sample_rate <= 0) {
+        return;
+    }
+    
+    const uint64_t busy = ns > 0 ? static_cast<uint64_t>(ns) : 0;
+    const uint64_t budget = static_cast<uint64_t>(samples) * 1000000000ull / static_cast<uint64_t>(sample_rate);
+    
+    blocks_.fetch_add(1, std::memory_order_relaxed);
+    budget_ns_.fetch_add(budget, std::memory_order_relaxed);
+    busy_ns_.fetch_add(busy, std::memory_order_relaxed);
+    if (busy > budget) {
+        deadline_misses_.fetch_add(1, std::memory_order_relaxed);
+    }
+    
+    const uint64_t ppm = budget > 0 ? busy * 1000000ull / budget : 0;
+    uint64_t worst = worst_block_ppm_.load(std::memory_order_relaxed);
+    while (ppm > worst && !worst_block_ppm_.compare_exchange_weak(worst, ppm, std::memory_order_relaxed)) {
+    }
+}
+
+PipelineStats PipelineProfiler::snapshot() const {
+    PipelineStats stats = {};
+    
+    stats.blocks = blocks_.load(std::memory_order_relaxed);
+    stats.deadline_misses = deadline_misses_.load(std::memory_order_relaxed);
+    const uint64_t budget_ns = budget_ns_.load(std::memory_order_relaxed);
+    stats.budget_seconds = budget_ns / 1e9;
+    stats.worst_block_percent = worst_block_ppm_.load(std::memory_order_relaxed) / 1e4;
+    if (budget_ns > 0) {
+        stats.busy_percent = 100.0 * busy_ns_.load(std::memory_order_relaxed) / budget_ns;
+    }
+    
+    for (int stage = 0; stage < static_cast<int>(PipelineStage::COUNT); ++stage) {
+        StageStats& out = stats.stages[stage];
+        for (int slot = 0; slot < MAX_THREADS; ++slot) {
+            const Counter& counter = counters_[slot][stage];
+            out.calls += counter.calls.load(std::memory_order_relaxed);
+            out.samples += counter.samples.load(std::memory_order_relaxed);
+            out.total_ns += counter.total_ns.load(std::memory_order_relaxed);
+        }
+        if (out.samples > 0) {
+            out.ns_per_sample = static_cast<double>(out.total_ns) / out.samples;
+        }
+        if (budget_ns > 0) {
+            out.budget_percent = 100.0 * out.total_ns / budget_ns;
+        }
+    }
+    return stats;
+}
+
+void PipelineProfiler::reset() {
+    for (auto& slot : counters_) {
+        for (auto& counter : slot) {
+            counter.calls.store(0, std::memory_order_relaxed);
+            counter.samples.store(0, std::memory_order_relaxed);
+            counter.total_ns.store(0, std::memory_order_relaxed);
+        }
+    }
+    blocks_.store(0, std::memory_order_relaxed);
+    deadline_misses_.store(0, std::memory_order_relaxed);
+    budget_ns_.store(0, std::memory_order_relaxed);
+    busy_ns_.store(0, std::memory_order_relaxed);
+    worst_block_ppm_.store(0, std::memory_order_relaxed);
+}
+
+const char* PipelineProfiler::stageName(PipelineStage stage) {
+    switch (stage) {
+        case PipelineStage::INGEST: return "ingest";
+        case PipelineStage::CHANNEL_FILTER: return "channel";
+        case PipelineStage::DEMOD: return "demod";
+        case PipelineStage::AGC: return "agc";
+        case PipelineStage::SQUELCH: return "squelch";
+        case PipelineStage::RESAMPLE: return "resample";
+        case PipelineStage::SPECTRUM_FFT: return "fft";
+        case PipelineStage::AUDIO_CONVERSION: return "audio";
+        default: return "?";
+    }
+}
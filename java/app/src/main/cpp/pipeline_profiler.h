@@ -0,0 +1,113 @@
+#ifndef PIPELINE_PROFILER_H
+#define PIPELINE_PROFILER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Hot-path stages timed per call. INGEST runs on the USB callback thread,
+// the rest on the processing loop.
+enum class PipelineStage {
+    INGEST = 0,         // u8 IQ -> complex float into the sample ring
+    CHANNEL_FILTER,
+    DEMOD,
+    AGC,
+    SQUELCH,
+    RESAMPLE,           // demodulator rate -> audio rate
+    SPECTRUM_FFT,
+    AUDIO_CONVERSION,   // AudioProcessor: drift resampler, float -> int16
+    COUNT
+};
+
+struct StageStats {
+    uint64_t calls;
+    uint64_t samples;       // input samples
+    uint64_t total_ns;
+    double ns_per_sample;
+    double budget_percent;  // share of the signal time processed
+};
+
+// Snapshot of every stage against the real-time budget: the signal
+// duration of the blocks processed so far
+struct PipelineStats {
+    StageStats stages[static_cast<int>(PipelineStage::COUNT)];
+    uint64_t blocks;
+    uint64_t deadline_misses;   // blocks processed slower than real time
+    double budget_seconds;
+    double busy_percent;        // whole-block time over the budget
+    double worst_block_percent;
+};
+
+// Always-on counters: two clock reads per stage per block, a few relaxed
+// adds into counters owned by the calling thread (one cache line per
+// stage per thread, so the USB and processing threads never share one).
+// A thread's slot is returned when it exits. Any thread may record or
+// take a snapshot.
+class PipelineProfiler {
+public:
+    PipelineProfiler();
+    
+    static int64_t now();
+    
+    void record(PipelineStage stage, size_t samples, int64_t ns);
+    
+    // One block through the whole chain: took ns for samples at
+    // sample_rate; a miss when that is longer than the block lasts
+    void recordBlock(size_t samples, int sample_rate, int64_t ns);
+    
+    PipelineStats snapshot() const;
+    void reset();
+    
+    static const char* stageName(PipelineStage stage);
+    
+    // Threads past this many alive at once share the last slot
+    static const int MAX_THREADS = 8;
+
+private:
+    struct alignas(64) Counter {
+        std::atomic<uint64_t> calls;
+        std::atomic<uint64_t> samples;
+        std::atomic<uint64_t> total_ns;
+    };
+    
+    static int threadSlot();
+    
+    Counter counters_[MAX_THREADS][static_cast<int>(PipelineStage::COUNT)];
+    
+    alignas(64) std::atomic<uint64_t> blocks_;
+    std::atomic<uint64_t> deadline_misses_;
+    std::atomic<uint64_t> budget_ns_;
+    std::atomic<uint64_t> busy_ns_;
+    std::atomic<uint64_t> worst_block_ppm_;
+};
+
+// Splits a run of consecutive stages: each lap() charges the time since
+// the previous lap (or construction) to one stage. Does nothing, not even
+// read the clock, without a profiler.
+class StageTimer {
+public:
+    explicit StageTimer(PipelineProfiler* profiler)
+        : profiler_(profiler)
+        , start_(profiler ? PipelineProfiler::now() : 0) {
+    }
+    
+    // First lap counted from start_ns instead
+    StageTimer(PipelineProfiler* profiler, int64_t start_ns)
+        : profiler_(profiler)
+        , start_(start_ns) {
+    }
+    
+    void lap(PipelineStage stage, size_t samples) {
+        if (profiler_) {
+            const int64_t now = PipelineProfiler::now();
+            profiler_->record(stage, samples, now - start_);
+            start_ = now;
+        }
+    }
+
+private:
+    PipelineProfiler* profiler_;
+    int64_t start_;
+};
+
+#endif // PIPELINE_PROFILER_H
@@ -0,0 +1,183 @@
+#include "polyphase_channelizer.h"
+#include <algorithm>
+#include <cmath>
+
+PolyphaseChannelizer::PolyphaseChannelizer()
+    : channels_(0)
+    , decimation_(1)
+    , log2_channels_(0)
+    , write_pos_(0)
+    , phase_(0)
+    , input_phase_(0)
+    , output_capacity_(0) {
+}
+
+bool PolyphaseChannelizer::configure(int channels, bool oversampled, int taps_per_branch) {
+    if (channels < 2 || !FFTPlan::isPowerOfTwo(channels) || taps_per_branch < 1) {
+        return false;
+    }
+    
+    channels_ = channels;
+    decimation_ = oversampled ? channels / 2 : channels;
+    log2_channels_ = 0;
+    while ((1 << log2_channels_) < channels) {
+        ++log2_channels_;
+    }
+    
+    // Hamming windowed sinc, cutoff at the channel edge (half a channel
+    // spacing), normalized to unity gain at DC
+    const size_t num_taps = static_cast<size_t>(channels) * taps_per_branch;
+    const double cutoff = 0.5 / channels;
+    taps_.resize(num_taps);
+    double sum = 0.0;
+    for (size_t i = 0; i < num_taps; ++i) {
+        const double n = i - (num_taps - 1) / 2.0;
+        const double hamming = 0.54 - 0.46 * std::cos(2.0 * M_PI * i / (num_taps - 1));
+        const double sinc = n == 0.0 ? 2.0 * cutoff : std::sin(2.0 * M_PI * cutoff * n) / (M_PI * n);
+        taps_[i] = static_cast<float>(sinc * hamming);
+        sum += taps_[i];
+    }
+    for (auto& tap : taps_) {
+        tap = static_cast<float>(tap / sum);
+    }
+    reversed_taps_.assign(taps_.rbegin(), taps_.rend());
+    
+    twiddles_.resize(channels);
+    for (int i = 0; i < channels; ++i) {
+        const double angle = 2.0 * M_PI * i / channels;
+        twiddles_[i] = std::complex<float>(static_cast<float>(std::cos(angle)),
+                                           static_cast<float>(std::sin(angle)));
+    }
+    fft_.setSize(channels);
+    folded_.assign(channels, std::complex<float>(0.0f, 0.0f));
+    spectrum_.assign(channels, std::complex<float>(0.0f, 0.0f));
+    
+    delay_.assign(2 * num_taps, std::complex<float>(0.0f, 0.0f));
+    active_.assign(channels, 0);
+    active_list_.clear();
+    outputs_.assign(channels, std::vector<std::complex<float>>());
+    output_capacity_ = 0;
+    reset();
+    return true;
+}
+
+void PolyphaseChannelizer::reset() {
+    std::fill(delay_.begin(), delay_.end(), std::complex<float>(0.0f, 0.0f));
+    write_pos_ = 0;
+    phase_ = 0;
+    input_phase_ = 0;
+}
+
+double PolyphaseChannelizer::channelOffset(int channel, double sample_rate) const {
+    const int signed_channel = channel > channels_ / 2 ? channel - channels_ : channel;
+    return signed_channel * sample_rate / channels_;
+}
+
+int PolyphaseChannelizer::channelForOffset(double offset_hz, double sample_rate) const {
+    const long nearest = std::lround(offset_hz * channels_ / sample_rate);
+    return static_cast<int>(((nearest % channels_) + channels_) % channels_);
+}
+
+void PolyphaseChannelizer::setActive(int channel, bool active) {
+    if (channel < 0 || channel >= channels_ || (active_[channel] != 0) == active) {
+        return;
+    }
+    active_[channel] = active ? 1 : 0;
+    if (active) {
+        active_list_.push_back(channel);
+        std::sort(active_list_.begin(), active_list_.end());
+    } else {
+        active_list_.erase(std::find(active_list_.begin(), active_list_.end(), channel));
+    }
+}
+
+void PolyphaseChannelizer::ensureOutputCapacity(size_t frames) {
+    if (frames <= output_capacity_) {
+        return;
+    }
+    for (auto& output : outputs_) {
+        output.resize(frames);
+    }
+    output_capacity_ = frames;
+}
+
+size_t PolyphaseChannelizer::process(const std::complex<float>* input, size_t count) {
+    const size_t num_taps = taps_.size();
+    if (num_taps == 0) {
+        return 0;
+    }
+    ensureOutputCapacity(maxFrames(count));
+    
+    size_t frames = 0;
+    for (size_t i = 0; i < count; ++i) {
+        // Write each sample to both halves so the window never wraps
+        delay_[write_pos_] = delay_[write_pos_ + num_taps] = input[i];
+        if (++write_pos_ == num_taps) {
+            write_pos_ = 0;
+        }
+        const size_t newest_phase = input_phase_;
+        if (++input_phase_ == static_cast<size_t>(channels_)) {
+            input_phase_ = 0;
+        }
+        
+        if (++phase_ < decimation_) {
+            continue;
+        }
+        phase_ = 0;
+        
+        // The frame's mixer phase is that of its newest sample
+        computeFrame(frames++, newest_phase);
+    }
+    return frames;
+}
+
+void PolyphaseChannelizer::computeFrame(size_t frame, size_t shift) {
+    const size_t channels = static_cast<size_t>(channels_);
+    const size_t branches = taps_.size() / channels;
+    
+    // write_pos_ indexes the oldest sample of the window. Weight it by the
+    // prototype and fold the branches: window index p * M + r is n =
+    // L - 1 - p * M - r samples back, so it lands in bin M - 1 - r.
+    const std::complex<float>* window = delay_.data() + write_pos_;
+    const float* taps = reversed_taps_.data();
+    std::complex<float>* folded = folded_.data();
+    std::fill(folded_.begin(), folded_.end(), std::complex<float>(0.0f, 0.0f));
+    for (size_t p = 0; p < branches; ++p) {
+        const std::complex<float>* branch_window = window + p * channels;
+        const float* branch_taps = taps + p * channels;
+        for (size_t r = 0; r < channels; ++r) {
+            folded[r] += branch_taps[r] * branch_window[r];
+        }
+    }
+    
+    // Bin q of the shifted sum is v[(q + s) mod M] = folded[M - 1 - ((q + s) mod M)]
+    std::complex<float>* shifted = spectrum_.data();
+    for (size_t q = 0; q < channels; ++q) {
+        size_t bin = q + shift;
+        if (bin >= channels) {
+            bin -= channels;
+        }
+        shifted[q] = folded[channels - 1 - bin];
+    }
+    
+    // An M-point inverse FFT is about M log2(M) / 2 complex multiplies; a
+    // direct DFT costs M per active channel
+    const size_t active = active_list_.size();
+    if (active * 2 <= static_cast<size_t>(log2_channels_)) {
+        for (int channel : active_list_) {
+            std::complex<float> sum(0.0f, 0.0f);
+            size_t index = 0;
+            for (size_t q = 0; q < channels; ++q) {
+                sum += shifted[q] * twiddles_[index];
+                index = (index + channel) & (channels - 1);
+            }
+            outputs_[channel][frame] = sum;
+        }
+        return;
+    }
+    
+    fft_.inverse(shifted);
+    for (int channel : active_list_) {
+        outputs_[channel][frame] = shifted[channel];
+    }
+}
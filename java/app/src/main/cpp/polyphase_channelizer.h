@@ -0,0 +1,98 @@
+#ifndef POLYPHASE_CHANNELIZER_H
+#define POLYPHASE_CHANNELIZER_H
+
+#include <vector>
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+
+#include "fft.h"
+
+// Splits the capture into `channels` (M) uniform channels with one
+// polyphase filter bank: channel k is centred on k * fs / M (channels
+// above M / 2 are the negative frequencies) and comes out at fs / D.
+// D = M is critically sampled; D = M / 2 (oversampled) keeps each
+// channel's transition band from aliasing into its passband.
+//
+// Per output frame the cost is one pass over the prototype filter
+// (M * taps_per_branch multiply-adds, the length of a single channel
+// filter) plus one M-point FFT, shared by all M channels, against
+// M * taps_per_branch / D multiply-adds per input sample for every
+// separate mixer and decimating filter. With few channels active the FFT
+// gives way to a direct DFT of just those bins.
+//
+// Output k, frame m, is exactly the input mixed by e^-j2pi k n / M (n the
+// absolute input index), filtered by the prototype and taken at the
+// frame's newest input sample.
+class PolyphaseChannelizer {
+public:
+    PolyphaseChannelizer();
+    
+    // channels must be a power of two, at least 2. Designs a Hamming
+    // windowed-sinc prototype with cutoff at the channel edges and unity
+    // gain, and clears the state; every channel starts inactive.
+    bool configure(int channels, bool oversampled, int taps_per_branch = DEFAULT_TAPS_PER_BRANCH);
+    void reset();
+    
+    int getChannels() const { return channels_; }
+    int getDecimation() const { return decimation_; }
+    size_t getNumTaps() const { return taps_.size(); }
+    const std::vector<float>& getTaps() const { return taps_; }
+    
+    // Centre of a channel relative to the tuned frequency, and the channel
+    // whose passband holds an offset
+    double channelOffset(int channel, double sample_rate) const;
+    int channelForOffset(double offset_hz, double sample_rate) const;
+    
+    // Only active channels are written; idle ones cost nothing past the
+    // shared filter and FFT
+    void setActive(int channel, bool active);
+    bool isActive(int channel) const { return active_[channel] != 0; }
+    int activeCount() const { return static_cast<int>(active_list_.size()); }
+    
+    // Takes count input samples and returns the frames completed, at most
+    // maxFrames(count). Frame f of an active channel is output(channel)[f],
+    // valid until the next call. Phase is carried across calls.
+    size_t process(const std::complex<float>* input, size_t count);
+    size_t maxFrames(size_t count) const { return (phase_ + count) / decimation_; }
+    const std::complex<float>* output(int channel) const { return outputs_[channel].data(); }
+    
+    static const int DEFAULT_TAPS_PER_BRANCH = 12;
+
+private:
+    // shift: absolute index of the frame's newest input sample, mod M
+    void computeFrame(size_t frame, size_t shift);
+    void ensureOutputCapacity(size_t frames);
+    
+    int channels_;
+    int decimation_;
+    int log2_channels_;
+    
+    // Prototype reversed, so it lines up with the delay line oldest first
+    std::vector<float> taps_;
+    std::vector<float> reversed_taps_;
+    
+    // Delay line stored twice back to back, newest taps_.size() samples
+    // always contiguous (as in DecimatingFIR)
+    std::vector<std::complex<float>> delay_;
+    size_t write_pos_;
+    int phase_;
+    
+    // Absolute index of the next input sample, mod M: a frame's mixer
+    // phase, applied as a circular shift before the FFT
+    size_t input_phase_;
+    
+    std::vector<std::complex<float>> folded_;
+    std::vector<std::complex<float>> spectrum_;
+    std::vector<std::complex<float>> twiddles_;    // e^+j2pi i / M
+    FFTPlan fft_;
+    
+    std::vector<uint8_t> active_;
+    std::vector<int> active_list_;
+    
+    // Per channel, grown to the most frames one call has produced
+    std::vector<std::vector<std::complex<float>>> outputs_;
+    size_t output_capacity_;
+};
+
+#endif // POLYPHASE_CHANNELIZER_H
@@ -5,11 +5,20 @@
 #include <thread>
 #include <atomic>
 #include <memory>
+#include <optional>
+#include <algorithm>
 
+#include "allocation_counter.h"
 #include "sdr_controller.h"
 #include "signal_processor.h"
 #include "audio_processor.h"
+#include "latency_tracer.h"
+#include "pipeline_profiler.h"
 #include "spectrum_analyzer.h"
+#include "staged_pipeline.h"
+#include "thread_placement.h"
+#include "vfo_bank.h"
+#include "wakeup_meter.h"
 
 #define LOG_TAG "RadioSDR_JNI"
 #define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
@@ -22,43 +31,206 @@ static std::unique_ptr<SignalProcessor> signalProcessor;
 static std::unique_ptr<AudioProcessor> audioProcessor;
 static std::unique_ptr<SpectrumAnalyzer> spectrumAnalyzer;
 
+// Extra receivers inside the capture, fed the same blocks as signalProcessor
+static std::unique_ptr<VfoBank> vfoBank;
+
+// Block latency from the USB callback to getAudioData(), per stage
+static LatencyTracer latencyTracer;
+
+// Per-stage time against the real-time budget, always on
+static PipelineProfiler pipelineProfiler;
+
 static std::atomic<bool> isRunning{false};
 static std::thread processingThread;
 
+// Wakeups of the processing loop, one per block while data flows
+static WakeupMeter processingWakeups;
+
+// Inline or staged processing, and the cores and priority of each
+// pipeline thread; read when the processing loop starts
+static PipelineMode pipelineMode = PipelineMode::INLINE;
+static ThreadPlacement threadPlacements[static_cast<int>(PipelineThread::COUNT)];
+
+// Block sizes the loop takes from the ring and blocks run before the
+// steady state
+static const size_t PROCESSING_MIN_SAMPLES = 8192;
+static const size_t PROCESSING_BLOCK_SAMPLES = 16384;
+static const uint64_t WARMUP_BLOCKS = 8;
+
 // Processing loop function
 void processingLoop() {
     LOGI("Processing loop started");
+    applyThreadPlacement(threadPlacements[static_cast<int>(PipelineThread::DEMOD)]);
+    
+    // Loop-lifetime output buffer; IQ is processed in place in the ring
+    std::vector<float> audioSamples(PROCESSING_BLOCK_SAMPLES);
+    
+    // A Q15 ring (fixed-point processing) goes to the Q15 chain as it is;
+    // only the VFOs, which run in float, get a widened copy
+    const bool q15 = sdrController && sdrController->getSampleFormat() == SampleFormat::Q15;
+    std::vector<std::complex<float>> vfoSamples(q15 ? PROCESSING_BLOCK_SAMPLES : 0);
+    uint64_t blocks = 0;
+    uint64_t vfoGeneration = vfoBank ? vfoBank->generation() : 0;
+    
+    // Staged: this thread filters and demodulates, spectrum and audio
+    // output go to their own threads. Falls back to inline if they
+    // cannot start.
+    std::unique_ptr<StagedPipeline> staged;
+    if (pipelineMode == PipelineMode::STAGED) {
+        staged = std::make_unique<StagedPipeline>(spectrumAnalyzer.get(), audioProcessor.get());
+        staged->setLatencyTracer(&latencyTracer);
+        staged->setPlacement(PipelineThread::SPECTRUM, threadPlacements[static_cast<int>(PipelineThread::SPECTRUM)]);
+        staged->setPlacement(PipelineThread::OUTPUT, threadPlacements[static_cast<int>(PipelineThread::OUTPUT)]);
+        if (!staged->start(PROCESSING_BLOCK_SAMPLES)) {
+            LOGE("Staged pipeline failed to start, processing inline");
+            staged.reset();
+        }
+    }
     
     while (isRunning.load()) {
         if (sdrController && sdrController->isDeviceOpen()) {
-            // Read IQ samples from RTL-SDR
-            std::vector<std::complex<float>> samples;
-            if (sdrController->readSamples(samples)) {
+            // Sleep until the USB callback has written a block's worth of
+            // IQ, or stopProcessing() wakes us; no timeout, so an idle
+            // device costs no wakeups
+            size_t count = 0;
+            const std::complex<float>* samples = nullptr;
+            const std::complex<int16_t>* samplesQ15 = nullptr;
+            if (q15) {
+                samplesQ15 = sdrController->acquireSamplesQ15(
+                    PROCESSING_MIN_SAMPLES, PROCESSING_BLOCK_SAMPLES, SampleRing::WAIT_FOREVER, count);
+            } else {
+                samples = sdrController->acquireSamples(
+                    PROCESSING_MIN_SAMPLES, PROCESSING_BLOCK_SAMPLES, SampleRing::WAIT_FOREVER, count);
+            }
+            processingWakeups.tick();
+            if (samples || samplesQ15) {
+                // The USB callback stamped this span's first sample on the way in
+                const int64_t dequeued = LatencyTracer::now();
+                const int64_t blockStart = PipelineProfiler::now();
+                int64_t ingest = 0;
+                const bool stamped = sdrController->getIngestTime(ingest);
+                if (stamped) {
+                    latencyTracer.record(LatencyStage::QUEUE, dequeued - ingest);
+                }
+                
+                // Past warm-up every buffer is at full size; a debug build
+                // asserts the block never touches the heap on this thread
+                // (the UI and worker threads may allocate meanwhile). A
+                // changed VFO set sizes its buffers again first.
+                if (vfoBank && vfoBank->generation() != vfoGeneration) {
+                    vfoGeneration = vfoBank->generation();
+                    blocks = 0;
+                }
+                std::optional<NoAllocationScope> noAllocation;
+                if (blocks++ >= WARMUP_BLOCKS && allocationCountingEnabled()) {
+                    noAllocation.emplace();
+                }
+                
                 // Process samples through signal processor
                 if (signalProcessor) {
-                    signalProcessor->processSamples(samples);
+                    if (samplesQ15) {
+                        signalProcessor->processSamplesQ15(samplesQ15, count);
+                    } else {
+                        signalProcessor->processSamples(samples, count);
+                    }
                     
                     // Update spectrum analyzer
                     if (spectrumAnalyzer) {
-                        spectrumAnalyzer->updateSpectrum(samples);
+                        if (staged) {
+                            if (samplesQ15) {
+                                staged->pushSpectrumQ15(samplesQ15, count);
+                            } else {
+                                staged->pushSpectrum(samples, count);
+                            }
+                        } else if (samplesQ15) {
+                            spectrumAnalyzer->updateSpectrumQ15(samplesQ15, count);
+                        } else {
+                            spectrumAnalyzer->updateSpectrum(samples, count);
+                        }
                     }
                     
                     // Demodulate and send to audio processor
                     if (audioProcessor) {
-                        std::vector<float> audioSamples = signalProcessor->getAudioSamples();
-                        audioProcessor->processAudio(audioSamples);
+                        size_t audioCount = signalProcessor->readAudioSamples(audioSamples.data(),
+                                                                              audioSamples.size());
+                        if (staged) {
+                            // The output thread stamps and records DSP
+                            staged->pushAudio(audioSamples.data(), audioCount, stamped, ingest, dequeued);
+                        } else {
+                            if (stamped && audioCount > 0) {
+                                audioProcessor->stampNextBlock(ingest);
+                            }
+                            audioProcessor->processAudio(audioSamples.data(), audioCount);
+                            if (stamped) {
+                                latencyTracer.record(LatencyStage::DSP, LatencyTracer::now() - dequeued);
+                            }
+                        }
+                    }
+                }
+                
+                // Every VFO on the same block
+                if (vfoBank && samplesQ15) {
+                    if (vfoBank->size() > 0) {
+                        const int16_t* in = reinterpret_cast<const int16_t*>(samplesQ15);
+                        float* out = reinterpret_cast<float*>(vfoSamples.data());
+                        for (size_t k = 0; k < 2 * count; ++k) {
+                            out[k] = in[k] * (1.0f / 32768.0f);
+                        }
+                        vfoBank->process(vfoSamples.data(), count);
                     }
+                } else if (vfoBank) {
+                    vfoBank->process(samples, count);
                 }
+                
+                // The whole block against its own duration at the SDR rate
+                pipelineProfiler.recordBlock(count, static_cast<int>(sdrController->getCurrentSampleRate()),
+                                             PipelineProfiler::now() - blockStart);
+                
+                sdrController->releaseSamples(count);
             }
+        } else {
+            // Nothing can fill the ring
+            break;
         }
-        
-        // Small delay to prevent excessive CPU usage
-        std::this_thread::sleep_for(std::chrono::milliseconds(1));
     }
     
+    if (staged) {
+        staged->stop();
+    }
     LOGI("Processing loop ended");
 }
 
+static void startProcessing() {
+    isRunning.store(true);
+    processingThread = std::thread(processingLoop);
+}
+
+// Ends processingLoop() and waits for it
+static void stopProcessing() {
+    isRunning.store(false);
+    if (sdrController) {
+        sdrController->wakeConsumer();
+    }
+    if (processingThread.joinable()) {
+        processingThread.join();
+    }
+}
+
+// Runs change with processingLoop() stopped and restarts the loop after,
+// for changes that rebuild filters or buffers it uses mid-block; the USB
+// reader keeps filling the ring meanwhile
+template <typename Change>
+static void whileProcessingStopped(Change change) {
+    const bool running = isRunning.load();
+    if (running) {
+        stopProcessing();
+    }
+    change();
+    if (running) {
+        startProcessing();
+    }
+}
+
 extern "C" JNIEXPORT jboolean JNICALL
 Java_com_radioSDR_app_MainActivity_initRTLSDR(JNIEnv *env, jobject thiz, jint fd) {
     LOGI("Initializing RTL-SDR with file descriptor: %d", fd);
@@ -67,7 +239,15 @@ Java_com_radioSDR_app_MainActivity_initRTLSDR(JNIEnv *env, jobject thiz, jint fd
         sdrController = std::make_unique<SDRController>();
         signalProcessor = std::make_unique<SignalProcessor>();
         audioProcessor = std::make_unique<AudioProcessor>();
+        audioProcessor->setLatencyTracer(&latencyTracer);
         spectrumAnalyzer = std::make_unique<SpectrumAnalyzer>();
+        vfoBank = std::make_unique<VfoBank>();
+        
+        sdrController->setProfiler(&pipelineProfiler);
+        sdrController->setReaderPlacement(threadPlacements[static_cast<int>(PipelineThread::INGEST)]);
+        signalProcessor->setProfiler(&pipelineProfiler);
+        audioProcessor->setProfiler(&pipelineProfiler);
+        spectrumAnalyzer->setProfiler(&pipelineProfiler);
         
         if (sdrController->initDevice(fd)) {
             LOGI("RTL-SDR device initialized successfully");
@@ -88,10 +268,7 @@ Java_com_radioSDR_app_MainActivity_closeRTLSDR(JNIEnv *env, jobject thiz) {
     
     // Stop processing if running
     if (isRunning.load()) {
-        isRunning.store(false);
-        if (processingThread.joinable()) {
-            processingThread.join();
-        }
+        stopProcessing();
     }
     
     // Clean up objects
@@ -99,6 +276,7 @@ Java_com_radioSDR_app_MainActivity_closeRTLSDR(JNIEnv *env, jobject thiz) {
     signalProcessor.reset();
     audioProcessor.reset();
     spectrumAnalyzer.reset();
+    vfoBank.reset();
     
     LOGI("RTL-SDR closed");
 }
@@ -114,6 +292,19 @@ Java_com_radioSDR_app_MainActivity_setFrequency(JNIEnv *env, jobject thiz, jdoub
     return JNI_FALSE;
 }
 
+// Moves the main receiver inside the capture without retuning the tuner,
+// for instance off the LO spike at the centre; phase-continuous. Only
+// hands the offset over: processingLoop takes it up at its next block.
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_radioSDR_app_MainActivity_setTuningOffset(JNIEnv *env, jobject thiz, jint offsetHz) {
+    if (signalProcessor) {
+        bool result = signalProcessor->setFrequencyOffset(offsetHz);
+        LOGI("Set tuning offset to %+d Hz: %s", offsetHz, result ? "success" : "failed");
+        return result ? JNI_TRUE : JNI_FALSE;
+    }
+    return JNI_FALSE;
+}
+
 extern "C" JNIEXPORT jboolean JNICALL
 Java_com_radioSDR_app_MainActivity_setGain(JNIEnv *env, jobject thiz, jint gain) {
     if (sdrController) {
@@ -137,19 +328,48 @@ Java_com_radioSDR_app_MainActivity_setAutoGain(JNIEnv *env, jobject thiz, jboole
 extern "C" JNIEXPORT jboolean JNICALL
 Java_com_radioSDR_app_MainActivity_setSampleRate(JNIEnv *env, jobject thiz, jint rate) {
     if (sdrController) {
-        bool result = sdrController->setSampleRate(rate);
+        // The filters and resampler are redesigned for the new rate
+        bool result = false;
+        whileProcessingStopped([&]() {
+            result = sdrController->setSampleRate(rate);
+            if (result && signalProcessor) {
+                signalProcessor->setSampleRate(rate);
+            }
+            if (result && vfoBank) {
+                vfoBank->setSampleRate(rate);
+            }
+        });
         LOGI("Set sample rate to %d Hz: %s", rate, result ? "success" : "failed");
         return result ? JNI_TRUE : JNI_FALSE;
     }
     return JNI_FALSE;
 }
 
+// Must match the rate the AudioTrack was created with
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_radioSDR_app_MainActivity_setAudioSampleRate(JNIEnv *env, jobject thiz, jint rate) {
+    if (signalProcessor) {
+        bool result = false;
+        whileProcessingStopped([&]() {
+            result = signalProcessor->setAudioSampleRate(rate);
+            if (vfoBank) {
+                vfoBank->setAudioSampleRate(rate);
+            }
+        });
+        LOGI("Set audio sample rate to %d Hz: %s", rate, result ? "success" : "failed");
+        return result ? JNI_TRUE : JNI_FALSE;
+    }
+    return JNI_FALSE;
+}
+
 extern "C" JNIEXPORT jboolean JNICALL
 Java_com_radioSDR_app_MainActivity_startReading(JNIEnv *env, jobject thiz) {
     if (sdrController && !isRunning.load()) {
         if (sdrController->startReading()) {
-            isRunning.store(true);
-            processingThread = std::thread(processingLoop);
+            latencyTracer.reset();
+            pipelineProfiler.reset();
+            processingWakeups.reset();
+            startProcessing();
             LOGI("Started SDR reading and processing");
             return JNI_TRUE;
         } else {
@@ -163,10 +383,7 @@ Java_com_radioSDR_app_MainActivity_startReading(JNIEnv *env, jobject thiz) {
 extern "C" JNIEXPORT void JNICALL
 Java_com_radioSDR_app_MainActivity_stopReading(JNIEnv *env, jobject thiz) {
     if (isRunning.load()) {
-        isRunning.store(false);
-        if (processingThread.joinable()) {
-            processingThread.join();
-        }
+        stopProcessing();
         
         if (sdrController) {
             sdrController->stopReading();
@@ -202,23 +419,232 @@ Java_com_radioSDR_app_MainActivity_getAudioData(JNIEnv *env, jobject thiz) {
     return nullptr;
 }
 
+static VfoSettings vfoSettings(jint offsetHz, jint bandwidthHz, jint mode, jint squelchDb) {
+    VfoSettings settings;
+    settings.offset_hz = offsetHz;
+    settings.bandwidth_hz = bandwidthHz;
+    settings.mode = mode == 1 ? DemodulationType::AM
+                  : mode == 2 ? DemodulationType::USB
+                  : mode == 3 ? DemodulationType::LSB
+                  : DemodulationType::FM;
+    settings.squelch_db = squelchDb;
+    return settings;
+}
+
+// VFOs may come and go while streaming. mode: 0 FM, 1 AM, 2 USB, 3 LSB.
+// Returns the VFO's id, or -1 if it does not fit the capture or all are
+// in use.
+extern "C" JNIEXPORT jint JNICALL
+Java_com_radioSDR_app_MainActivity_addVfo(JNIEnv *env, jobject thiz, jint offsetHz, jint bandwidthHz,
+                                          jint mode, jint squelchDb) {
+    if (!vfoBank) {
+        return -1;
+    }
+    return vfoBank->addVfo(vfoSettings(offsetHz, bandwidthHz, mode, squelchDb));
+}
+
+// An offset-only change retunes without a click
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_radioSDR_app_MainActivity_updateVfo(JNIEnv *env, jobject thiz, jint id, jint offsetHz,
+                                             jint bandwidthHz, jint mode, jint squelchDb) {
+    if (vfoBank && vfoBank->updateVfo(id, vfoSettings(offsetHz, bandwidthHz, mode, squelchDb))) {
+        return JNI_TRUE;
+    }
+    return JNI_FALSE;
+}
+
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_radioSDR_app_MainActivity_removeVfo(JNIEnv *env, jobject thiz, jint id) {
+    return vfoBank && vfoBank->removeVfo(id) ? JNI_TRUE : JNI_FALSE;
+}
+
+// The VFO's audio since the previous call, 16-bit at the audio sample
+// rate, for its own AudioTrack or recorder
+extern "C" JNIEXPORT jshortArray JNICALL
+Java_com_radioSDR_app_MainActivity_getVfoAudio(JNIEnv *env, jobject thiz, jint id) {
+    if (!vfoBank) {
+        return nullptr;
+    }
+    
+    static thread_local std::vector<float> audio(PROCESSING_BLOCK_SAMPLES);
+    static thread_local std::vector<int16_t> pcm(PROCESSING_BLOCK_SAMPLES);
+    const size_t count = vfoBank->readAudio(id, audio.data(), audio.size());
+    if (count == 0) {
+        return nullptr;
+    }
+    for (size_t i = 0; i < count; ++i) {
+        pcm[i] = static_cast<int16_t>(std::max(-1.0f, std::min(1.0f, audio[i])) * 32767.0f);
+    }
+    
+    jshortArray result = env->NewShortArray(count);
+    env->SetShortArrayRegion(result, 0, count, pcm.data());
+    return result;
+}
+
+// One VFO's cost since it was added: blocks, busy % of the real-time
+// budget, worst block %, then the budget % of its channel filter,
+// demodulator, resampler, AGC and squelch
+extern "C" JNIEXPORT jfloatArray JNICALL
+Java_com_radioSDR_app_MainActivity_getVfoStats(JNIEnv *env, jobject thiz, jint id) {
+    PipelineStats stats;
+    if (!vfoBank || !vfoBank->getStats(id, stats)) {
+        return nullptr;
+    }
+    
+    const PipelineStage stages[] = {PipelineStage::CHANNEL_FILTER, PipelineStage::DEMOD, PipelineStage::RESAMPLE,
+                                    PipelineStage::AGC, PipelineStage::SQUELCH};
+    const int size = 3 + 5;
+    jfloat values[size];
+    values[0] = static_cast<jfloat>(stats.blocks);
+    values[1] = static_cast<jfloat>(stats.busy_percent);
+    values[2] = static_cast<jfloat>(stats.worst_block_percent);
+    for (int i = 0; i < 5; ++i) {
+        values[3 + i] = static_cast<jfloat>(stats.stages[static_cast<int>(stages[i])].budget_percent);
+    }
+    
+    jfloatArray result = env->NewFloatArray(size);
+    env->SetFloatArrayRegion(result, 0, size, values);
+    return result;
+}
+
+// Clock-drift loop state: drift ppm, correction ppm, smoothed fill,
+// target fill, resyncs, locked (1/0)
+extern "C" JNIEXPORT jfloatArray JNICALL
+Java_com_radioSDR_app_MainActivity_getAudioClockStats(JNIEnv *env, jobject thiz) {
+    if (!audioProcessor) {
+        return nullptr;
+    }
+    
+    ClockDriftStats stats = audioProcessor->getClockDriftStats();
+    jfloat values[6] = {
+        stats.drift_ppm,
+        stats.correction_ppm,
+        stats.average_fill,
+        static_cast<jfloat>(stats.target_fill),
+        static_cast<jfloat>(stats.resyncs),
+        stats.locked ? 1.0f : 0.0f
+    };
+    
+    jfloatArray result = env->NewFloatArray(6);
+    env->SetFloatArrayRegion(result, 0, 6, values);
+    return result;
+}
+
+// Per-stage block latency since startReading(), in microseconds: for
+// queue, dsp, audio and total in turn, count, mean, p50, p99 and max
+extern "C" JNIEXPORT jfloatArray JNICALL
+Java_com_radioSDR_app_MainActivity_getLatencyStats(JNIEnv *env, jobject thiz) {
+    const int stages = static_cast<int>(LatencyStage::COUNT);
+    jfloat values[stages * 5];
+    
+    for (int i = 0; i < stages; ++i) {
+        LatencySummary summary = latencyTracer.summary(static_cast<LatencyStage>(i));
+        values[i * 5 + 0] = static_cast<jfloat>(summary.count);
+        values[i * 5 + 1] = static_cast<jfloat>(summary.mean_us);
+        values[i * 5 + 2] = static_cast<jfloat>(summary.p50_us);
+        values[i * 5 + 3] = static_cast<jfloat>(summary.p99_us);
+        values[i * 5 + 4] = static_cast<jfloat>(summary.max_us);
+    }
+    
+    jfloatArray result = env->NewFloatArray(stages * 5);
+    env->SetFloatArrayRegion(result, 0, stages * 5, values);
+    return result;
+}
+
+// Hot-path cost since startReading(): blocks, deadline misses, busy % of
+// the real-time budget and worst block %, then for each PipelineStage in
+// turn calls, samples, ns per sample and % of the budget
+extern "C" JNIEXPORT jfloatArray JNICALL
+Java_com_radioSDR_app_MainActivity_getPipelineStats(JNIEnv *env, jobject thiz) {
+    const int stages = static_cast<int>(PipelineStage::COUNT);
+    const int size = 4 + stages * 4;
+    jfloat values[size];
+    
+    PipelineStats stats = pipelineProfiler.snapshot();
+    values[0] = static_cast<jfloat>(stats.blocks);
+    values[1] = static_cast<jfloat>(stats.deadline_misses);
+    values[2] = static_cast<jfloat>(stats.busy_percent);
+    values[3] = static_cast<jfloat>(stats.worst_block_percent);
+    for (int i = 0; i < stages; ++i) {
+        const StageStats& stage = stats.stages[i];
+        values[4 + i * 4 + 0] = static_cast<jfloat>(stage.calls);
+        values[4 + i * 4 + 1] = static_cast<jfloat>(stage.samples);
+        values[4 + i * 4 + 2] = static_cast<jfloat>(stage.ns_per_sample);
+        values[4 + i * 4 + 3] = static_cast<jfloat>(stage.budget_percent);
+    }
+    
+    jfloatArray result = env->NewFloatArray(size);
+    env->SetFloatArrayRegion(result, 0, size, values);
+    return result;
+}
+
+// Wakeups per second since the previous call: the processing loop, then
+// the USB reader. Both drop to 0 while no data flows.
+extern "C" JNIEXPORT jfloatArray JNICALL
+Java_com_radioSDR_app_MainActivity_getWakeupRates(JNIEnv *env, jobject thiz) {
+    jfloat values[2] = {
+        static_cast<jfloat>(processingWakeups.ratePerSecond()),
+        sdrController ? static_cast<jfloat>(sdrController->readerWakeups().ratePerSecond()) : 0.0f
+    };
+    
+    jfloatArray result = env->NewFloatArray(2);
+    env->SetFloatArrayRegion(result, 0, 2, values);
+    return result;
+}
+
 // SpectrumActivity native methods
 extern "C" JNIEXPORT jfloatArray JNICALL
 Java_com_radioSDR_app_SpectrumActivity_getSpectrumData(JNIEnv *env, jobject thiz) {
     return Java_com_radioSDR_app_MainActivity_getSpectrumData(env, thiz);
 }
 
-extern "C" JNIEXPORT jfloatArray JNICALL
-Java_com_radioSDR_app_SpectrumActivity_getWaterfallData(JNIEnv *env, jobject thiz) {
+// Returns the quantized rows added since sinceSequence (oldest first) and
+// stores the next sequence in stateOut[0] and the row width in bytes, taken
+// together with the rows, in stateOut[1]
+extern "C" JNIEXPORT jbyteArray JNICALL
+Java_com_radioSDR_app_SpectrumActivity_getWaterfallRows(JNIEnv *env, jobject thiz, jlong sinceSequence,
+                                                       jlongArray stateOut) {
+    if (!spectrumAnalyzer) {
+        return nullptr;
+    }
+    
+    static thread_local std::vector<uint8_t> rows;
+    int width = 0;
+    jlong state[2];
+    state[0] = static_cast<jlong>(
+        spectrumAnalyzer->getWaterfallRows(static_cast<uint64_t>(sinceSequence), rows, width));
+    state[1] = width;
+    
+    if (stateOut && env->GetArrayLength(stateOut) >= 2) {
+        env->SetLongArrayRegion(stateOut, 0, 2, state);
+    }
+    
+    if (rows.empty()) {
+        return nullptr;
+    }
+    
+    jbyteArray result = env->NewByteArray(rows.size());
+    env->SetByteArrayRegion(result, 0, rows.size(), reinterpret_cast<const jbyte*>(rows.data()));
+    return result;
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_radioSDR_app_SpectrumActivity_setWaterfallHeight(JNIEnv *env, jobject thiz, jint rows) {
     if (spectrumAnalyzer) {
-        std::vector<float> waterfall = spectrumAnalyzer->getWaterfall();
-        if (!waterfall.empty()) {
-            jfloatArray result = env->NewFloatArray(waterfall.size());
-            env->SetFloatArrayRegion(result, 0, waterfall.size(), waterfall.data());
-            return result;
-        }
+        spectrumAnalyzer->setWaterfallHeight(rows);
     }
-    return nullptr;
+}
+
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_radioSDR_app_SpectrumActivity_setWelchAveraging(JNIEnv *env, jobject thiz, jboolean enable,
+                                                        jint overlapPercent, jint segments) {
+    if (spectrumAnalyzer) {
+        bool result = spectrumAnalyzer->setWelchAveraging(enable == JNI_TRUE, overlapPercent, segments);
+        LOGI("Set Welch averaging %s (overlap %d%%, %d segments): %s", enable ? "on" : "off",
+             overlapPercent, segments, result ? "success" : "failed");
+        return result ? JNI_TRUE : JNI_FALSE;
+    }
+    return JNI_FALSE;
 }
 
 // SettingsActivity native methods
@@ -247,6 +673,46 @@ Java_com_radioSDR_app_SettingsActivity_setBandwidth(JNIEnv *env, jobject thiz, j
     return JNI_FALSE;
 }
 
+extern "C" JNIEXPORT void JNICALL
+Java_com_radioSDR_app_SettingsActivity_setFixedPointProcessing(JNIEnv *env, jobject thiz, jboolean enable) {
+    // Switching rebuilds the channel filters processingLoop() runs on, so
+    // the loop stops first. Fixed point also takes Q15 straight from the
+    // USB callback: when the ring changes format the reader stops too.
+    const SampleFormat format = enable ? SampleFormat::Q15 : SampleFormat::FLOAT;
+    const bool reformat = sdrController && sdrController->getSampleFormat() != format;
+    const bool running = isRunning.load();
+    if (running) {
+        stopProcessing();
+        if (reformat) {
+            sdrController->stopReading();
+        }
+    }
+    
+    if (signalProcessor) {
+        signalProcessor->setProcessingMode(enable ? ProcessingMode::FIXED_POINT : ProcessingMode::FLOAT);
+        LOGI("Set %s processing", enable ? "fixed-point" : "float");
+    }
+    if (reformat) {
+        sdrController->setSampleFormat(format);
+    }
+    
+    if (running) {
+        if (reformat && !sdrController->startReading()) {
+            LOGE("Failed to restart SDR reading");
+            return;
+        }
+        startProcessing();
+    }
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_radioSDR_app_SettingsActivity_setDriftCompensation(JNIEnv *env, jobject thiz, jboolean enable) {
+    if (audioProcessor) {
+        audioProcessor->setDriftCompensation(enable == JNI_TRUE);
+        LOGI("Clock-drift compensation %s", enable ? "on" : "off");
+    }
+}
+
 extern "C" JNIEXPORT jboolean JNICALL
 Java_com_radioSDR_app_SettingsActivity_setSquelch(JNIEnv *env, jobject thiz, jint squelch) {
     if (signalProcessor) {
@@ -256,3 +722,46 @@ Java_com_radioSDR_app_SettingsActivity_setSquelch(JNIEnv *env, jobject thiz, jin
     }
     return JNI_FALSE;
 }
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_radioSDR_app_SettingsActivity_setPipelineMode(JNIEnv *env, jobject thiz, jint mode) {
+    const PipelineMode next = mode == 1 ? PipelineMode::STAGED : PipelineMode::INLINE;
+    if (next != pipelineMode) {
+        // A running loop restarts to pick it up
+        whileProcessingStopped([&]() { pipelineMode = next; });
+    }
+    LOGI("Pipeline mode %s", pipelineMode == PipelineMode::STAGED ? "staged" : "inline");
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_radioSDR_app_SettingsActivity_setThreadPlacement(JNIEnv *env, jobject thiz, jint thread, jint cores,
+                                                          jint nice) {
+    if (thread < 0 || thread >= static_cast<jint>(PipelineThread::COUNT)) {
+        LOGE("Unknown pipeline thread %d", thread);
+        return;
+    }
+    
+    ThreadPlacement placement;
+    placement.cores = cores == 1 ? CoreClass::LITTLE : cores == 2 ? CoreClass::BIG : CoreClass::ANY;
+    placement.nice = std::max(-20, std::min(19, static_cast<int>(nice)));
+    
+    const PipelineThread which = static_cast<PipelineThread>(thread);
+    if (which == PipelineThread::INGEST) {
+        // The USB reader picks it up on its next start
+        threadPlacements[thread] = placement;
+        if (sdrController) {
+            sdrController->setReaderPlacement(placement);
+        }
+    } else {
+        const bool running = isRunning.load();
+        if (running) {
+            stopProcessing();
+        }
+        threadPlacements[thread] = placement;
+        if (running) {
+            startProcessing();
+        }
+    }
+    LOGI("%s thread on %s cores (%d), nice %d", pipelineThreadName(which), coreClassName(placement.cores),
+         coreCount(placement.cores), placement.nice);
+}
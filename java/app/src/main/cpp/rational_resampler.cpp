@@ -0,0 +1,157 @@
+#include "rational_resampler.h"
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+namespace {
+
+// Zeroth-order modified Bessel function, for the Kaiser window
+double besselI0(double x) {
+    double sum = 1.0;
+    double term = 1.0;
+    for (int k = 1; k < 32; ++k) {
+        term *= (x / (2.0 * k)) * (x / (2.0 * k));
+        sum += term;
+        if (term < sum * 1e-12) {
+            break;
+        }
+    }
+    return sum;
+}
+
+} // namespace
+
+RationalResampler::RationalResampler()
+    : interpolation_(1)
+    , decimation_(1)
+    , taps_per_phase_(0)
+    , write_pos_(0)
+    , phase_(0) {
+}
+
+bool RationalResampler::plan(long input_rate, long output_rate, int& l, int& m, int& taps_per_phase) {
+    const long g = std::gcd(input_rate, output_rate);
+    if (output_rate / g > MAX_INTERPOLATION || input_rate / g > MAX_BANK_SIZE) {
+        return false;
+    }
+    l = static_cast<int>(output_rate / g);
+    m = static_cast<int>(input_rate / g);
+    
+    taps_per_phase = BASE_TAPS_PER_PHASE;
+    if (m > l) {
+        taps_per_phase = static_cast<int>((static_cast<long>(BASE_TAPS_PER_PHASE) * m + l - 1) / l);
+    }
+    return static_cast<long>(l) * taps_per_phase <= MAX_BANK_SIZE;
+}
+
+int RationalResampler::choosePreDecimation(int input_rate, int output_rate, int min_oversampling) {
+    if (input_rate <= 0 || output_rate <= 0 || min_oversampling < 1) {
+        return 1;
+    }
+    
+    // Largest first: every step of decimation taken ahead is work the
+    // stages after it no longer do
+    int l, m, taps_per_phase;
+    for (long d = input_rate / (static_cast<long>(min_oversampling) * output_rate); d > 1; --d) {
+        if (plan(input_rate, output_rate * d, l, m, taps_per_phase)) {
+            return static_cast<int>(d);
+        }
+    }
+    return 1;
+}
+
+std::vector<float> RationalResampler::designLowPass(int length, double cutoff, double gain) {
+    const double centre = (length - 1) / 2.0;
+    const double window_norm = besselI0(KAISER_BETA);
+    
+    std::vector<double> prototype(length);
+    double sum = 0.0;
+    for (int i = 0; i < length; ++i) {
+        double n = i - centre;
+        double sinc = (n == 0.0) ? 2.0 * cutoff : std::sin(2.0 * M_PI * cutoff * n) / (M_PI * n);
+        double r = n / (centre > 0.0 ? centre : 1.0);
+        double window = besselI0(KAISER_BETA * std::sqrt(std::max(0.0, 1.0 - r * r))) / window_norm;
+        prototype[i] = sinc * window;
+        sum += prototype[i];
+    }
+    
+    std::vector<float> taps(length);
+    const double scale = gain / sum;
+    for (int i = 0; i < length; ++i) {
+        taps[i] = static_cast<float>(prototype[i] * scale);
+    }
+    return taps;
+}
+
+bool RationalResampler::configure(int input_rate, int output_rate) {
+    int l, m, taps_per_phase;
+    if (input_rate <= 0 || output_rate <= 0 || !plan(input_rate, output_rate, l, m, taps_per_phase)) {
+        return false;
+    }
+    
+    interpolation_ = l;
+    decimation_ = m;
+    taps_per_phase_ = taps_per_phase;
+    
+    // Prototype low-pass at the upsampled rate L * input_rate, cut just
+    // below the lower of the two Nyquist frequencies, with gain L to make
+    // up for the zero-stuffing
+    const int length = l * taps_per_phase;
+    const std::vector<float> prototype = designLowPass(length, 0.45 / std::max(l, m), l);
+    
+    // Phase p holds taps p, p + L, p + 2L, ...; tap j applies to x[n - j],
+    // so storing it at (taps_per_phase - 1 - j) makes the row oldest-first
+    phase_bank_.assign(length, 0.0f);
+    for (int p = 0; p < l; ++p) {
+        float* row = &phase_bank_[static_cast<size_t>(p) * taps_per_phase];
+        for (int j = 0; j < taps_per_phase; ++j) {
+            row[taps_per_phase - 1 - j] = prototype[p + j * l];
+        }
+    }
+    
+    delay_line_.assign(2 * taps_per_phase, 0.0f);
+    reset();
+    return true;
+}
+
+void RationalResampler::reset() {
+    std::fill(delay_line_.begin(), delay_line_.end(), 0.0f);
+    write_pos_ = 0;
+    phase_ = 0;
+}
+
+size_t RationalResampler::process(const float* input, size_t count, float* output) {
+    const size_t taps = taps_per_phase_;
+    if (taps == 0) {
+        return 0;
+    }
+    
+    size_t produced = 0;
+    
+    float* delay = delay_line_.data();
+    for (size_t i = 0; i < count; ++i) {
+        delay[write_pos_] = delay[write_pos_ + taps] = input[i];
+        if (++write_pos_ == taps) {
+            write_pos_ = 0;
+        }
+        
+        // Every output whose upsampled time falls before the next input
+        const float* window = delay + write_pos_;
+        while (phase_ < interpolation_) {
+            const float* row = &phase_bank_[static_cast<size_t>(phase_) * taps];
+            float acc = 0.0f;
+            for (size_t k = 0; k < taps; ++k) {
+                acc += row[k] * window[k];
+            }
+            output[produced++] = acc;
+            phase_ += decimation_;
+        }
+        phase_ -= interpolation_;
+    }
+    
+    return produced;
+}
@@ -0,0 +1,69 @@
+#ifndef RATIONAL_RESAMPLER_H
+#define RATIONAL_RESAMPLER_H
+
+#include <vector>
+#include <cstddef>
+
+// Polyphase rational resampler for real (audio) samples. The rate ratio is
+// reduced to output/input = L/M and one windowed-sinc prototype of L phases
+// is precomputed per ratio, so the output rate is exact - no drift against
+// the sink over any run length. Each output costs one dot product of
+// taps_per_phase, whatever L and M are.
+class RationalResampler {
+public:
+    RationalResampler();
+    
+    // Designs the filter bank for input_rate -> output_rate and clears state.
+    // Only the ratio matters, so both rates may carry a common factor (for
+    // a fractional input rate, pass input * k and output * k).
+    bool configure(int input_rate, int output_rate);
+    void reset();
+    
+    // Writes every output sample that becomes available from count inputs;
+    // output must hold maxOutput(count). Returns the number written.
+    size_t process(const float* input, size_t count, float* output);
+    size_t maxOutput(size_t count) const { return (count * interpolation_) / decimation_ + 1; }
+    
+    int getInterpolation() const { return interpolation_; }
+    int getDecimation() const { return decimation_; }
+    int getTapsPerPhase() const { return taps_per_phase_; }
+    
+    // Largest integer decimation D for the stages ahead of a resampler
+    // from input_rate / D to output_rate that configure() accepts, keeping
+    // input_rate / D at least min_oversampling times output_rate; 1 when
+    // no larger D does. 2048000 -> 44100 has no bank of its own, but D = 40
+    // leaves 441/512 (D = 20 and 441/1024 at an oversampling of 2).
+    static int choosePreDecimation(int input_rate, int output_rate, int min_oversampling);
+    
+    // Kaiser-windowed sinc low-pass, cutoff in cycles per sample, with a
+    // DC gain of gain; shared with the pre-decimation filters
+    static std::vector<float> designLowPass(int length, double cutoff, double gain);
+
+private:
+    // L/M and taps per phase for the ratio; false past the bank limits
+    static bool plan(long input_rate, long output_rate, int& l, int& m, int& taps_per_phase);
+    
+    int interpolation_;     // L
+    int decimation_;        // M
+    int taps_per_phase_;
+    
+    // L rows of taps_per_phase coefficients, each row reversed so the
+    // oldest delay line sample pairs with element 0
+    std::vector<float> phase_bank_;
+    
+    // Double-length circular delay line (see DecimatingFIR)
+    std::vector<float> delay_line_;
+    size_t write_pos_;
+    
+    // Position of the next output between the last two inputs, in 1/L steps
+    int phase_;
+    
+    // Taps per phase at unity ratio; scaled up when decimating so the
+    // anti-alias cutoff keeps the same transition in input samples
+    static const int BASE_TAPS_PER_PHASE = 24;
+    static constexpr double KAISER_BETA = 7.0;  // ~70 dB stopband
+    static const int MAX_INTERPOLATION = 1024;
+    static const int MAX_BANK_SIZE = 1 << 18;
+};
+
+#endif // RATIONAL_RESAMPLER_H
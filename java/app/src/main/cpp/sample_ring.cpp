@@ -0,0 +1,258 @@
+#include "sample_ring.h"
+#include <android/log.h>
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <ctime>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#define LOG_TAG "Sample_Ring"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+#define LOGD(...) __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, __VA_ARGS__)
+
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t) &&
+              std::atomic<uint32_t>::is_always_lock_free,
+              "futex word must be a plain 32-bit integer");
+
+namespace {
+
+uint32_t* futexWord(std::atomic<uint32_t>& word) {
+    return reinterpret_cast<uint32_t*>(&word);
+}
+
+// A negative timeout waits until woken
+void futexWait(std::atomic<uint32_t>& word, uint32_t expected, int timeout_ms) {
+    struct timespec timeout;
+    timeout.tv_sec = timeout_ms / 1000;
+    timeout.tv_nsec = static_cast<long>(timeout_ms % 1000) * 1000000L;
+    syscall(SYS_futex, futexWord(word), FUTEX_WAIT_PRIVATE, expected,
+            timeout_ms >= 0 ? &timeout : nullptr, nullptr, 0);
+}
+
+void futexWake(std::atomic<uint32_t>& word) {
+    syscall(SYS_futex, futexWord(word), FUTEX_WAKE_PRIVATE, INT_MAX, nullptr, nullptr, 0);
+}
+
+// Two adjacent views of one memfd; nullptr if the kernel or libc cannot
+void* mapMirrored(size_t bytes) {
+#ifdef __NR_memfd_create
+    int fd = static_cast<int>(syscall(__NR_memfd_create, "sample_ring", 0));
+    if (fd < 0) {
+        return nullptr;
+    }
+    
+    void* result = nullptr;
+    if (ftruncate(fd, static_cast<off_t>(bytes)) == 0) {
+        // Reserve both halves first so nothing else can land in between
+        void* base = mmap(nullptr, 2 * bytes, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (base != MAP_FAILED) {
+            unsigned char* first = static_cast<unsigned char*>(base);
+            if (mmap(first, bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) != MAP_FAILED &&
+                mmap(first + bytes, bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) != MAP_FAILED) {
+                result = base;
+            } else {
+                munmap(base, 2 * bytes);
+            }
+        }
+    }
+    
+    close(fd);
+    return result;
+#else
+    (void)bytes;
+    return nullptr;
+#endif
+}
+
+} // namespace
+
+SampleRing::SampleRing()
+    : data_(nullptr)
+    , format_(SampleFormat::FLOAT)
+    , capacity_(0)
+    , mask_(0)
+    , mirrored_(false)
+    , mapping_(nullptr)
+    , mapping_bytes_(0)
+    , write_index_(0)
+    , read_index_(0)
+    , write_sequence_(0)
+    , consumer_waiting_(false)
+    , consumer_target_(0)
+    , woken_(false)
+    , dropped_(0) {
+}
+
+SampleRing::~SampleRing() {
+    release();
+}
+
+bool SampleRing::allocate(size_t min_capacity, SampleFormat format) {
+    release();
+    
+    // Power of two for masking, and whole pages for the double mapping
+    const size_t sample_bytes = format == SampleFormat::Q15 ? sizeof(std::complex<int16_t>)
+                                                            : sizeof(std::complex<float>);
+    const size_t page_samples = std::max<size_t>(1, sysconf(_SC_PAGESIZE) / sample_bytes);
+    size_t capacity = 1;
+    while (capacity < min_capacity || capacity < page_samples) {
+        capacity <<= 1;
+    }
+    
+    const size_t bytes = capacity * sample_bytes;
+    mapping_ = mapMirrored(bytes);
+    if (mapping_) {
+        mapping_bytes_ = 2 * bytes;
+        data_ = static_cast<unsigned char*>(mapping_);
+        mirrored_ = true;
+    } else {
+        LOGE("Mirrored mapping unavailable, ring spans stop at the wrap");
+        fallback_.reset(new unsigned char[bytes]);
+        data_ = fallback_.get();
+        mirrored_ = false;
+    }
+    
+    format_ = format;
+    capacity_ = capacity;
+    mask_ = capacity - 1;
+    reset();
+    
+    LOGD("Sample ring: %zu %s samples, %s", capacity_, format_ == SampleFormat::Q15 ? "Q15" : "float",
+         mirrored_ ? "mirrored" : "split");
+    return true;
+}
+
+void SampleRing::reset() {
+    write_index_.store(0);
+    read_index_.store(0);
+    woken_.store(false);
+    dropped_.store(0);
+    stamps_.clear();
+}
+
+void SampleRing::release() {
+    if (mapping_) {
+        munmap(mapping_, mapping_bytes_);
+        mapping_ = nullptr;
+        mapping_bytes_ = 0;
+    }
+    fallback_.reset();
+    data_ = nullptr;
+    capacity_ = 0;
+    mask_ = 0;
+    mirrored_ = false;
+}
+
+size_t SampleRing::writeOffset(size_t& count) const {
+    const size_t write = write_index_.load(std::memory_order_relaxed);
+    const size_t read = read_index_.load(std::memory_order_acquire);
+    const size_t offset = write & mask_;
+    
+    count = capacity_ - (write - read);
+    if (!mirrored_) {
+        count = std::min(count, capacity_ - offset);
+    }
+    return offset;
+}
+
+std::complex<float>* SampleRing::writeSpan(size_t& count) {
+    return reinterpret_cast<std::complex<float>*>(data_) + writeOffset(count);
+}
+
+std::complex<int16_t>* SampleRing::writeSpanQ15(size_t& count) {
+    return reinterpret_cast<std::complex<int16_t>*>(data_) + writeOffset(count);
+}
+
+void SampleRing::commitWrite(size_t count) {
+    // seq_cst pairs with the consumer's flag store in waitForSamples()
+    write_index_.fetch_add(count, std::memory_order_seq_cst);
+    notifyConsumer();
+}
+
+void SampleRing::stampWrite(int64_t time_ns) {
+    BlockStamp stamp = {write_index_.load(std::memory_order_relaxed), time_ns, time_ns};
+    stamps_.push(stamp);
+}
+
+bool SampleRing::readStamp(int64_t& time_ns) {
+    BlockStamp stamp;
+    if (!stamps_.find(read_index_.load(std::memory_order_relaxed), stamp)) {
+        return false;
+    }
+    time_ns = stamp.ingest_ns;
+    return true;
+}
+
+size_t SampleRing::readOffset(size_t& count) const {
+    const size_t read = read_index_.load(std::memory_order_relaxed);
+    const size_t write = write_index_.load(std::memory_order_acquire);
+    const size_t offset = read & mask_;
+    
+    count = write - read;
+    if (!mirrored_) {
+        count = std::min(count, capacity_ - offset);
+    }
+    return offset;
+}
+
+const std::complex<float>* SampleRing::readSpan(size_t& count) {
+    return reinterpret_cast<const std::complex<float>*>(data_) + readOffset(count);
+}
+
+const std::complex<int16_t>* SampleRing::readSpanQ15(size_t& count) {
+    return reinterpret_cast<const std::complex<int16_t>*>(data_) + readOffset(count);
+}
+
+void SampleRing::commitRead(size_t count) {
+    read_index_.fetch_add(count, std::memory_order_release);
+}
+
+size_t SampleRing::available() const {
+    return write_index_.load(std::memory_order_acquire) - read_index_.load(std::memory_order_relaxed);
+}
+
+size_t SampleRing::waitForSamples(size_t min_count, int timeout_ms) {
+    min_count = std::min(min_count, capacity_);
+    const bool forever = timeout_ms < 0;
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(forever ? 0 : timeout_ms);
+    
+    for (;;) {
+        // Announce the wait and its target, then check: either the producer
+        // sees the flag and wakes us once the target is written, or we see
+        // its data, or the futex word has moved on
+        const uint32_t sequence = write_sequence_.load(std::memory_order_seq_cst);
+        consumer_target_.store(read_index_.load(std::memory_order_relaxed) + min_count,
+                               std::memory_order_relaxed);
+        consumer_waiting_.store(true, std::memory_order_seq_cst);
+        const size_t ready = available();
+        
+        const auto now = std::chrono::steady_clock::now();
+        if (ready >= min_count || woken_.exchange(false) || (!forever && now >= deadline)) {
+            consumer_waiting_.store(false, std::memory_order_relaxed);
+            return ready;
+        }
+        
+        int remaining_ms = forever ? WAIT_FOREVER : std::max(1, static_cast<int>(
+            std::chrono::duration_cast<std::chrono::milliseconds>(deadline - now).count()));
+        futexWait(write_sequence_, sequence, remaining_ms);
+        consumer_waiting_.store(false, std::memory_order_relaxed);
+    }
+}
+
+void SampleRing::wake() {
+    woken_.store(true);
+    write_sequence_.fetch_add(1, std::memory_order_seq_cst);
+    futexWake(write_sequence_);
+}
+
+void SampleRing::notifyConsumer() {
+    write_sequence_.fetch_add(1, std::memory_order_seq_cst);
+    if (consumer_waiting_.load(std::memory_order_seq_cst) &&
+        write_index_.load(std::memory_order_relaxed) >= consumer_target_.load(std::memory_order_relaxed)) {
+        futexWake(write_sequence_);
+    }
+}
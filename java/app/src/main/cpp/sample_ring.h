@@ -0,0 +1,118 @@
+#ifndef SAMPLE_RING_H
+#define SAMPLE_RING_H
+
+#include <atomic>
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "latency_tracer.h"
+
+// What a ring slot holds: complex float, or Q15 (32768 == 1.0) for the
+// fixed-point chain, which then never sees float at the input rate
+enum class SampleFormat {
+    FLOAT,
+    Q15
+};
+
+// Lock-free single-producer/single-consumer ring of IQ samples.
+//
+// The storage is mapped twice back to back in virtual memory, so the
+// region just past the end aliases the start: any run of free or filled
+// samples is one contiguous span, and neither side ever copies or splits
+// at the wrap. Where the double mapping is unavailable the ring still
+// works, but spans stop at the physical end.
+//
+// The producer (USB callback) never blocks: when the ring is full the new
+// samples are dropped and counted. The consumer can block in
+// waitForSamples() for a minimum fill, with or without a timeout; the
+// producer only issues a futex wake once a waiting consumer's fill is
+// there, so the consumer wakes once per block and never while idle.
+class SampleRing {
+public:
+    SampleRing();
+    ~SampleRing();
+    
+    SampleRing(const SampleRing&) = delete;
+    SampleRing& operator=(const SampleRing&) = delete;
+    
+    static constexpr int WAIT_FOREVER = -1;
+    
+    // Capacity is rounded up to a power of two that fills whole pages.
+    // Not safe while either side is running.
+    bool allocate(size_t min_capacity, SampleFormat format = SampleFormat::FLOAT);
+    
+    // Empties the ring; only while neither side is running
+    void reset();
+    
+    size_t capacity() const { return capacity_; }
+    bool isMirrored() const { return mirrored_; }
+    SampleFormat format() const { return format_; }
+    
+    // Producer: contiguous free space, then publish count samples of it
+    // (the span accessor matching format())
+    std::complex<float>* writeSpan(size_t& count);
+    std::complex<int16_t>* writeSpanQ15(size_t& count);
+    void commitWrite(size_t count);
+    void recordDropped(size_t count) { dropped_.fetch_add(count, std::memory_order_relaxed); }
+    
+    // Producer: ingest time of the samples from the write position on;
+    // call before committing them
+    void stampWrite(int64_t time_ns);
+    
+    // Consumer: contiguous readable samples, then release count of them
+    const std::complex<float>* readSpan(size_t& count);
+    const std::complex<int16_t>* readSpanQ15(size_t& count);
+    void commitRead(size_t count);
+    
+    // Consumer: ingest time of the first readable sample; false if no
+    // stamp covers it
+    bool readStamp(int64_t& time_ns);
+    
+    // Blocks until min_count samples are readable or timeout_ms passes
+    // (never with WAIT_FOREVER); returns the readable count, below
+    // min_count on timeout or wake()
+    size_t waitForSamples(size_t min_count, int timeout_ms);
+    
+    // Releases a consumer blocked in waitForSamples(), e.g. on stop
+    void wake();
+    
+    size_t available() const;
+    uint64_t droppedSamples() const { return dropped_.load(std::memory_order_relaxed); }
+
+private:
+    void release();
+    void notifyConsumer();
+    
+    // Slot index of the span and its length, for either format
+    size_t writeOffset(size_t& count) const;
+    size_t readOffset(size_t& count) const;
+    
+    unsigned char* data_;
+    SampleFormat format_;
+    size_t capacity_;
+    size_t mask_;
+    bool mirrored_;
+    void* mapping_;
+    size_t mapping_bytes_;
+    std::unique_ptr<unsigned char[]> fallback_;
+    
+    // Producer and consumer indices on their own cache lines; both count
+    // up forever and are masked on use
+    alignas(64) std::atomic<size_t> write_index_;
+    alignas(64) std::atomic<size_t> read_index_;
+    
+    // Futex word bumped on every publish, whether anyone sleeps on it and
+    // the write index that sleeper needs
+    alignas(64) std::atomic<uint32_t> write_sequence_;
+    std::atomic<bool> consumer_waiting_;
+    std::atomic<size_t> consumer_target_;
+    std::atomic<bool> woken_;
+    std::atomic<uint64_t> dropped_;
+    
+    // Ingest stamps for latency tracing, indexed like write_index_
+    BlockStampQueue stamps_;
+};
+
+#endif // SAMPLE_RING_H
@@ -1,12 +1,14 @@
 #include "sdr_controller.h"
+#include "iq_converter.h"
 #include <android/log.h>
+#include "async_logger.h"
 #include <algorithm>
 #include <cstring>
 
 #define LOG_TAG "SDR_Controller"
-#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
-#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
-#define LOGD(...) __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, __VA_ARGS__)
+#define LOGI(...) ASYNC_LOG(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+#define LOGE(...) ASYNC_LOG(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+#define LOGD(...) ASYNC_LOG(ANDROID_LOG_DEBUG, LOG_TAG, __VA_ARGS__)
 
 SDRController::SDRController()
     : device_(nullptr)
@@ -16,10 +18,9 @@ SDRController::SDRController()
     , current_sample_rate_(2048000) // 2.048 MHz
     , current_gain_(248)            // 24.8 dB
     , auto_gain_(true)
-    , buffer_read_pos_(0)
-    , buffer_write_pos_(0) {
+    , profiler_(nullptr) {
     
-    sample_buffer_.resize(BUFFER_SIZE);
+    sample_ring_.allocate(RING_SAMPLES);
 }
 
 SDRController::~SDRController() {
@@ -187,25 +188,30 @@ bool SDRController::startReading() {
         return true;
     }
     
+    // Reap a reader that ended on its own (device error)
+    if (read_thread_.joinable()) {
+        read_thread_.join();
+    }
+    
     // Reset buffer
     rtlsdr_reset_buffer(device_);
     
     // Clear our internal buffer
-    {
-        std::lock_guard<std::mutex> lock(buffer_mutex_);
-        buffer_read_pos_ = 0;
-        buffer_write_pos_ = 0;
-    }
+    sample_ring_.reset();
+    reader_wakeups_.reset();
     
     reading_active_.store(true);
     
-    // Start async reading
-    int result = rtlsdr_read_async(device_, asyncCallback, this, 0, 16384);
-    if (result != 0) {
-        LOGE("Failed to start async reading: %d", result);
+    // Start async reading; rtlsdr_read_async only returns once cancelled
+    read_thread_ = std::thread([this]() {
+        applyThreadPlacement(reader_placement_);
+        int result = rtlsdr_read_async(device_, asyncCallback, this, 0, 16384);
+        if (result != 0) {
+            LOGE("Async reading ended with error: %d", result);
+        }
         reading_active_.store(false);
-        return false;
-    }
+        sample_ring_.wake();
+    });
     
     LOGI("Started reading from RTL-SDR");
     return true;
@@ -215,18 +221,20 @@ void SDRController::stopReading() {
     if (reading_active_.load()) {
         reading_active_.store(false);
         rtlsdr_cancel_async(device_);
-        
-        if (read_thread_.joinable()) {
-            read_thread_.join();
-        }
+        sample_ring_.wake();
         
         LOGI("Stopped reading from RTL-SDR");
     }
+    
+    if (read_thread_.joinable()) {
+        read_thread_.join();
+    }
 }
 
 void SDRController::asyncCallback(unsigned char *buf, uint32_t len, void *ctx) {
     SDRController* controller = static_cast<SDRController*>(ctx);
     if (controller && controller->reading_active_.load()) {
+        controller->reader_wakeups_.tick();
         controller->processBuffer(buf, len);
     }
 }
@@ -238,59 +246,93 @@ void SDRController::processBuffer(unsigned char *buf, uint32_t len) {
     }
     
     size_t num_samples = len / 2;
-    std::vector<std::complex<float>> new_samples(num_samples);
+    StageTimer timer(profiler_);
     
-    // Convert unsigned 8-bit IQ to complex float
-    for (size_t i = 0; i < num_samples; ++i) {
-        float i_val = (buf[2*i] - 127.4f) / 127.4f;      // I component
-        float q_val = (buf[2*i + 1] - 127.4f) / 127.4f;  // Q component
-        new_samples[i] = std::complex<float>(i_val, q_val);
-    }
+    // Stamp the block as it arrives, ahead of the samples it describes
+    sample_ring_.stampWrite(LatencyTracer::now());
     
-    // Add to circular buffer
-    {
-        std::lock_guard<std::mutex> lock(buffer_mutex_);
-        
-        for (const auto& sample : new_samples) {
-            sample_buffer_[buffer_write_pos_] = sample;
-            buffer_write_pos_ = (buffer_write_pos_ + 1) % BUFFER_SIZE;
-            
-            // If buffer is full, advance read position
-            if (buffer_write_pos_ == buffer_read_pos_) {
-                buffer_read_pos_ = (buffer_read_pos_ + 1) % BUFFER_SIZE;
-            }
+    // Convert straight into ring storage; with the mirrored mapping the
+    // free space is one span. A full ring drops the rest of this block:
+    // the consumer owns the read side, so there is nothing to overwrite.
+    const bool q15 = sample_ring_.format() == SampleFormat::Q15;
+    while (num_samples > 0) {
+        size_t space = 0;
+        size_t count = 0;
+        if (q15) {
+            std::complex<int16_t>* span = sample_ring_.writeSpanQ15(space);
+            count = std::min(space, num_samples);
+            convertIQ8ToQ15(buf, count, span);
+        } else {
+            std::complex<float>* span = sample_ring_.writeSpan(space);
+            count = std::min(space, num_samples);
+            convertIQ8(buf, count, span);
         }
+        if (count == 0) {
+            sample_ring_.recordDropped(num_samples);
+            break;
+        }
+        sample_ring_.commitWrite(count);
+        
+        buf += 2 * count;
+        num_samples -= count;
+    }
+    timer.lap(PipelineStage::INGEST, len / 2);
+}
+
+const std::complex<float>* SDRController::acquireSamples(size_t min_count, size_t max_count, int timeout_ms,
+                                                         size_t& count) {
+    count = 0;
+    if (sample_ring_.waitForSamples(min_count, timeout_ms) == 0) {
+        return nullptr;
     }
     
-    buffer_cv_.notify_one();
+    const std::complex<float>* span = sample_ring_.readSpan(count);
+    count = std::min(count, max_count);
+    return count > 0 ? span : nullptr;
 }
 
-bool SDRController::readSamples(std::vector<std::complex<float>>& samples) {
-    std::unique_lock<std::mutex> lock(buffer_mutex_);
+const std::complex<int16_t>* SDRController::acquireSamplesQ15(size_t min_count, size_t max_count, int timeout_ms,
+                                                              size_t& count) {
+    count = 0;
+    if (sample_ring_.waitForSamples(min_count, timeout_ms) == 0) {
+        return nullptr;
+    }
     
-    // Wait for data or timeout
-    if (buffer_cv_.wait_for(lock, std::chrono::milliseconds(100), 
-                           [this] { return buffer_read_pos_ != buffer_write_pos_ || !reading_active_.load(); })) {
-        
-        size_t available = 0;
-        if (buffer_write_pos_ >= buffer_read_pos_) {
-            available = buffer_write_pos_ - buffer_read_pos_;
-        } else {
-            available = BUFFER_SIZE - buffer_read_pos_ + buffer_write_pos_;
-        }
-        
-        if (available > 0) {
-            size_t to_read = std::min(available, samples.capacity());
-            samples.resize(to_read);
-            
-            for (size_t i = 0; i < to_read; ++i) {
-                samples[i] = sample_buffer_[buffer_read_pos_];
-                buffer_read_pos_ = (buffer_read_pos_ + 1) % BUFFER_SIZE;
-            }
-            
-            return true;
-        }
+    const std::complex<int16_t>* span = sample_ring_.readSpanQ15(count);
+    count = std::min(count, max_count);
+    return count > 0 ? span : nullptr;
+}
+
+void SDRController::releaseSamples(size_t count) {
+    sample_ring_.commitRead(count);
+}
+
+bool SDRController::setSampleFormat(SampleFormat format) {
+    if (format == sample_ring_.format()) {
+        return true;
+    }
+    if (reading_active_.load() || read_thread_.joinable()) {
+        LOGE("Sample format can only change while not reading");
+        return false;
     }
     
-    return false;
+    sample_ring_.allocate(RING_SAMPLES, format);
+    LOGI("USB samples converted to %s", format == SampleFormat::Q15 ? "Q15" : "float");
+    return true;
+}
+
+bool SDRController::readSamples(std::vector<std::complex<float>>& samples) {
+    if (sample_ring_.format() != SampleFormat::FLOAT) {
+        return false;
+    }
+    size_t max_count = samples.capacity() > 0 ? samples.capacity() : sample_ring_.capacity();
+    size_t count = 0;
+    const std::complex<float>* span = acquireSamples(1, max_count, 100, count);
+    if (!span) {
+        return false;
+    }
+    
+    samples.assign(span, span + count);
+    releaseSamples(count);
+    return true;
 }
@@ -7,8 +7,11 @@
 #include <memory>
 #include <atomic>
 #include <thread>
-#include <mutex>
-#include <condition_variable>
+
+#include "pipeline_profiler.h"
+#include "sample_ring.h"
+#include "thread_placement.h"
+#include "wakeup_meter.h"
 
 extern "C" {
 #include "rtl-sdr.h"
@@ -31,8 +34,52 @@ public:
     
     bool startReading();
     void stopReading();
+    
+    // Zero-copy consumer side of the IQ ring. Waits up to timeout_ms
+    // (SampleRing::WAIT_FOREVER: until data or wakeConsumer()) for at
+    // least min_count samples and returns one contiguous span of up to
+    // max_count of them (count set to its length; nullptr if nothing
+    // arrived). The span stays valid until releaseSamples(count).
+    const std::complex<float>* acquireSamples(size_t min_count, size_t max_count, int timeout_ms,
+                                              size_t& count);
+    void releaseSamples(size_t count);
+    
+    // The same for a Q15 ring
+    const std::complex<int16_t>* acquireSamplesQ15(size_t min_count, size_t max_count, int timeout_ms,
+                                                   size_t& count);
+    
+    // What the USB callback converts to: FLOAT, or Q15 straight from the
+    // u8 samples for the fixed-point chain. Reallocates the ring, so only
+    // while not reading; false otherwise.
+    bool setSampleFormat(SampleFormat format);
+    SampleFormat getSampleFormat() const { return sample_ring_.format(); }
+    
+    // Releases a consumer blocked in acquireSamples(), e.g. on stop
+    void wakeConsumer() { sample_ring_.wake(); }
+    
+    // Time the USB callback delivered the first sample of the next
+    // acquired span (LatencyTracer::now()); false if it was not stamped
+    bool getIngestTime(int64_t& time_ns) { return sample_ring_.readStamp(time_ns); }
+    
+    // Copying form: fills samples up to its capacity (whatever is buffered
+    // if the capacity is 0), waiting up to 100 ms for the first sample;
+    // FLOAT ring only
     bool readSamples(std::vector<std::complex<float>>& samples);
     
+    // Samples dropped because the consumer fell a whole ring behind
+    uint64_t getDroppedSamples() const { return sample_ring_.droppedSamples(); }
+    
+    // One tick per block the USB reader thread wakes up for
+    WakeupMeter& readerWakeups() { return reader_wakeups_; }
+    
+    // Times the USB callback's conversion as INGEST; set before
+    // startReading(), nullptr turns it off
+    void setProfiler(PipelineProfiler* profiler) { profiler_ = profiler; }
+    
+    // Cores and priority of the USB reader thread, the ingest stage;
+    // takes effect on the next startReading()
+    void setReaderPlacement(const ThreadPlacement& placement) { reader_placement_ = placement; }
+    
     uint32_t getCurrentFrequency() const { return current_frequency_; }
     uint32_t getCurrentSampleRate() const { return current_sample_rate_; }
     int getCurrentGain() const { return current_gain_; }
@@ -50,14 +97,15 @@ private:
     int current_gain_;
     bool auto_gain_;
     
-    // Buffer management
-    std::vector<std::complex<float>> sample_buffer_;
-    std::mutex buffer_mutex_;
-    std::condition_variable buffer_cv_;
-    size_t buffer_read_pos_;
-    size_t buffer_write_pos_;
-    static const size_t BUFFER_SIZE = 16384;
+    // USB callback -> processing thread; the callback never blocks
+    SampleRing sample_ring_;
+    static const size_t RING_SAMPLES = 1 << 18;    // 128 ms at 2.048 MHz
+    
+    PipelineProfiler* profiler_;
+    WakeupMeter reader_wakeups_;
+    ThreadPlacement reader_placement_;
     
+    // rtlsdr_read_async blocks until cancelled, so it gets its own thread
     std::thread read_thread_;
 };
 
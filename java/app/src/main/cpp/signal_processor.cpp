@@ -1,7 +1,9 @@
 #include "signal_processor.h"
+#include "fixed_point.h"
 #include <android/log.h>
 #include <algorithm>
 #include <cmath>
+#include <cstdlib>
 #include <numeric>
 
 #define LOG_TAG "Signal_Processor"
@@ -15,9 +17,21 @@
 
 SignalProcessor::SignalProcessor()
     : demod_type_(DemodulationType::FM)
+    , input_sample_rate_(2048000)     // 2.048 MHz default
+    , output_sample_rate_(48000)      // AudioTrack rate
     , bandwidth_hz_(200000)  // 200 kHz default
     , squelch_db_(-50)       // -50 dB default
     , squelch_threshold_(0.001f)
+    , channel_filter_mode_(ChannelFilterMode::AUTO)
+    , use_fast_convolution_(false)
+    , frequency_offset_hz_(0)
+    , pending_offset_hz_(0)
+    , offset_engaged_(false)
+    , use_translating_filter_(false)
+    , processing_mode_(ProcessingMode::FLOAT)
+    , audio_decimation_(1)
+    , resampler_active_(false)
+    , profiler_(nullptr)
     , audio_read_pos_(0)
     , audio_write_pos_(0)
     , agc_gain_(1.0f)
@@ -32,7 +46,9 @@ SignalProcessor::SignalProcessor()
     // Initialize audio buffer
     audio_buffer_.resize(AUDIO_BUFFER_SIZE, 0.0f);
     
-    // Initialize filter
+    // Initialize resampler and filter; the resampler picks the decimation
+    // the filter and demodulator share
+    configureResampler();
     setBandwidth(bandwidth_hz_);
     
     LOGI("Signal processor initialized");
@@ -42,30 +58,130 @@ SignalProcessor::~SignalProcessor() {
     LOGI("Signal processor destroyed");
 }
 
-void SignalProcessor::processSamples(const std::vector<std::complex<float>>& samples) {
-    if (samples.empty()) {
+void SignalProcessor::processSamples(const std::complex<float>* samples, size_t count) {
+    if (count == 0) {
         return;
     }
     
-    // Make a copy for processing
-    std::vector<std::complex<float>> processed_samples = samples;
+    // Everything below is scratch for this block only
+    arena_.reset();
+    applyPendingOffset();
+    processFloatInput(samples, count, profiler_ ? PipelineProfiler::now() : 0);
+}
+
+void SignalProcessor::processFloatInput(const std::complex<float>* samples, size_t count, int64_t start_ns) {
+    // Off centre, and no translating filter to bring it down: mixed first
+    if (offset_engaged_ && !use_translating_filter_) {
+        std::complex<float>* mixed = arena_.allocate<std::complex<float>>(count);
+        offset_mixer_.mix(samples, count, mixed);
+        samples = mixed;
+    }
     
-    // Apply bandpass filter
-    applyBandpassFilter(processed_samples);
+    if (processing_mode_ == ProcessingMode::FIXED_POINT) {
+        std::complex<int16_t>* input_q15 = arena_.allocate<std::complex<int16_t>>(count);
+        convertToQ15(samples, count, input_q15);
+        processBlockQ15(input_q15, count, start_ns);
+        return;
+    }
+    processBlock(samples, count, start_ns);
+}
+
+void SignalProcessor::processBlock(const std::complex<float>* samples, size_t count, int64_t start_ns) {
+    // Low-pass and decimate to the channel rate in one pass. Every buffer
+    // is sized from the bound for count, not from what the previous stage
+    // produced, so bursty stages (overlap-save) do not regrow the arena.
+    // The offset mixer, if any, is part of the channel stage.
+    StageTimer timer(profiler_, start_ns);
+    std::complex<float>* channel_samples;
+    size_t channel_bound;
+    size_t channel_count;
+    if (use_translating_filter_) {
+        channel_bound = translating_filter_.maxOutput(count);
+        channel_samples = arena_.allocate<std::complex<float>>(channel_bound);
+        channel_count = translating_filter_.process(samples, count, channel_samples);
+    } else if (use_fast_convolution_) {
+        channel_bound = fast_channel_filter_.maxOutput(count);
+        channel_samples = arena_.allocate<std::complex<float>>(channel_bound);
+        channel_count = fast_channel_filter_.process(samples, count, channel_samples);
+    } else {
+        channel_bound = channel_filter_.maxOutput(count);
+        channel_samples = arena_.allocate<std::complex<float>>(channel_bound);
+        channel_count = channel_filter_.process(samples, count, channel_samples);
+    }
+    timer.lap(PipelineStage::CHANNEL_FILTER, count);
     
     // Demodulate to audio
-    std::vector<float> audio = demodulator_->demodulate(processed_samples);
+    size_t audio_bound = demodulator_->maxOutput(channel_bound);
+    float* audio = arena_.allocate<float>(audio_bound);
+    size_t audio_count = demodulator_->demodulate(channel_samples, channel_count, audio);
+    timer.lap(PipelineStage::DEMOD, channel_count);
+    processAudio(audio, audio_count, audio_bound);
+}
+
+void SignalProcessor::processSamplesQ15(const std::complex<int16_t>* samples, size_t count) {
+    if (count == 0) {
+        return;
+    }
     
-    if (audio.empty()) {
+    arena_.reset();
+    applyPendingOffset();
+    const int64_t start_ns = profiler_ ? PipelineProfiler::now() : 0;
+    if (offset_engaged_) {
+        // The offset mixer and translating filter run in float
+        std::complex<float>* input = arena_.allocate<std::complex<float>>(count);
+        for (size_t i = 0; i < count; ++i) {
+            input[i] = std::complex<float>(samples[i].real() * (1.0f / 32768.0f),
+                                           samples[i].imag() * (1.0f / 32768.0f));
+        }
+        processFloatInput(input, count, start_ns);
+        return;
+    }
+    processBlockQ15(samples, count, start_ns);
+}
+
+void SignalProcessor::processBlockQ15(const std::complex<int16_t>* samples, size_t count, int64_t start_ns) {
+    // The Q15 conversion of float input, if any, is part of the channel stage
+    StageTimer timer(profiler_, start_ns);
+    size_t channel_bound = channel_filter_q15_.maxOutput(count);
+    std::complex<int16_t>* channel_samples = arena_.allocate<std::complex<int16_t>>(channel_bound);
+    size_t channel_count = channel_filter_q15_.process(samples, count, channel_samples);
+    timer.lap(PipelineStage::CHANNEL_FILTER, count);
+    
+    size_t audio_bound = demodulator_->maxOutput(channel_bound);
+    int16_t* audio_q15 = arena_.allocate<int16_t>(audio_bound);
+    size_t audio_count = demodulator_->demodulateQ15(channel_samples, channel_count, audio_q15);
+    
+    // Back to float at the audio rate for the shared tail
+    float* audio = arena_.allocate<float>(audio_bound);
+    for (size_t i = 0; i < audio_count; ++i) {
+        audio[i] = audio_q15[i] * (1.0f / 32768.0f);
+    }
+    timer.lap(PipelineStage::DEMOD, channel_count);
+    processAudio(audio, audio_count, audio_bound);
+}
+
+void SignalProcessor::processAudio(float* audio, size_t count, size_t bound) {
+    StageTimer timer(profiler_);
+    
+    // Resample to the exact output rate
+    if (resampler_active_) {
+        float* resampled = arena_.allocate<float>(audio_resampler_.maxOutput(bound));
+        size_t input_count = count;
+        count = audio_resampler_.process(audio, count, resampled);
+        audio = resampled;
+        timer.lap(PipelineStage::RESAMPLE, input_count);
+    }
+    
+    if (count == 0) {
         return;
     }
     
     // Apply AGC
     float power = 0.0f;
-    for (float sample : audio) {
-        power += sample * sample;
+    for (size_t i = 0; i < count; ++i) {
+        power += audio[i] * audio[i];
     }
-    power = std::sqrt(power / audio.size());
+    power = std::sqrt(power / count);
     
     if (power > 0.0f) {
         float target_gain = agc_target_ / power;
@@ -78,18 +194,20 @@ void SignalProcessor::processSamples(const std::vector<std::complex<float>>& sam
         // Limit gain
         agc_gain_ = std::max(0.1f, std::min(10.0f, agc_gain_));
         
-        for (float& sample : audio) {
-            sample *= agc_gain_;
+        for (size_t i = 0; i < count; ++i) {
+            audio[i] *= agc_gain_;
         }
     }
+    timer.lap(PipelineStage::AGC, count);
     
     // Apply squelch
-    applySquelch(audio);
+    applySquelch(audio, count);
+    timer.lap(PipelineStage::SQUELCH, count);
     
     // Add to audio buffer
     size_t write_pos = audio_write_pos_.load();
-    for (float sample : audio) {
-        audio_buffer_[write_pos] = sample;
+    for (size_t i = 0; i < count; ++i) {
+        audio_buffer_[write_pos] = audio[i];
         write_pos = (write_pos + 1) % AUDIO_BUFFER_SIZE;
     }
     audio_write_pos_.store(write_pos);
@@ -105,38 +223,71 @@ void SignalProcessor::processSamples(const std::vector<std::complex<float>>& sam
     }
 }
 
-std::vector<float> SignalProcessor::getAudioSamples() {
+size_t SignalProcessor::readAudioSamples(float* output, size_t max_count) {
     size_t read_pos = audio_read_pos_.load();
     size_t write_pos = audio_write_pos_.load();
     
     size_t available = (write_pos >= read_pos) ? 
         (write_pos - read_pos) : (AUDIO_BUFFER_SIZE - read_pos + write_pos);
+    size_t count = std::min(available, max_count);
     
-    if (available == 0) {
-        return {};
-    }
-    
-    std::vector<float> result;
-    result.reserve(available);
-    
-    for (size_t i = 0; i < available; ++i) {
-        result.push_back(audio_buffer_[read_pos]);
+    for (size_t i = 0; i < count; ++i) {
+        output[i] = audio_buffer_[read_pos];
         read_pos = (read_pos + 1) % AUDIO_BUFFER_SIZE;
     }
     
     audio_read_pos_.store(read_pos);
+    return count;
+}
+
+std::vector<float> SignalProcessor::getAudioSamples() {
+    std::vector<float> result(AUDIO_BUFFER_SIZE);
+    result.resize(readAudioSamples(result.data(), result.size()));
     return result;
 }
 
+bool SignalProcessor::setSampleRate(int sample_rate_hz) {
+    if (sample_rate_hz <= 0) {
+        LOGE("Invalid sample rate %d Hz", sample_rate_hz);
+        return false;
+    }
+    
+    input_sample_rate_ = sample_rate_hz;
+    configureResampler();
+    setBandwidth(bandwidth_hz_);
+    
+    LOGD("Sample rate set to %d Hz", sample_rate_hz);
+    return true;
+}
+
+bool SignalProcessor::setAudioSampleRate(int sample_rate_hz) {
+    if (sample_rate_hz <= 0) {
+        LOGE("Invalid audio sample rate %d Hz", sample_rate_hz);
+        return false;
+    }
+    
+    output_sample_rate_ = sample_rate_hz;
+    configureResampler();
+    configureChannelFilter();
+    
+    LOGD("Audio sample rate set to %d Hz", sample_rate_hz);
+    return true;
+}
+
 bool SignalProcessor::setBandwidth(int bandwidth_hz) {
+    if (bandwidth_hz <= 0) {
+        LOGE("Invalid bandwidth %d Hz", bandwidth_hz);
+        return false;
+    }
+    
     bandwidth_hz_ = bandwidth_hz;
     
-    // Design a simple low-pass filter
-    int filter_length = 64;
-    float cutoff = static_cast<float>(bandwidth_hz) / 2048000.0f; // Assuming 2.048 MHz sample rate
+    // Design a windowed-sinc low-pass filter passing +/- bandwidth / 2, which
+    // the decimated channel rate (>= bandwidth) can represent without aliasing
+    int filter_length = chooseChannelTaps(bandwidth_hz);
+    float cutoff = 0.5f * bandwidth_hz / input_sample_rate_;
     
-    filter_taps_.clear();
-    filter_taps_.resize(filter_length);
+    channel_taps_.assign(filter_length, 0.0f);
     
     // Hamming window with sinc function
     for (int i = 0; i < filter_length; ++i) {
@@ -144,26 +295,61 @@ bool SignalProcessor::setBandwidth(int bandwidth_hz) {
         float hamming = 0.54f - 0.46f * std::cos(2.0f * M_PI * i / (filter_length - 1));
         
         if (n == 0) {
-            filter_taps_[i] = 2.0f * cutoff * hamming;
+            channel_taps_[i] = 2.0f * cutoff * hamming;
         } else {
-            filter_taps_[i] = std::sin(2.0f * M_PI * cutoff * n) / (M_PI * n) * hamming;
+            channel_taps_[i] = std::sin(2.0f * M_PI * cutoff * n) / (M_PI * n) * hamming;
         }
     }
     
     // Normalize
-    float sum = std::accumulate(filter_taps_.begin(), filter_taps_.end(), 0.0f);
-    for (float& tap : filter_taps_) {
+    float sum = std::accumulate(channel_taps_.begin(), channel_taps_.end(), 0.0f);
+    for (float& tap : channel_taps_) {
         tap /= sum;
     }
     
-    // Initialize delay line
-    filter_delay_line_.clear();
-    filter_delay_line_.resize(filter_length, std::complex<float>(0, 0));
+    configureChannelFilter();
+    return true;
+}
+
+bool SignalProcessor::setFrequencyOffset(int offset_hz) {
+    if (2 * static_cast<int64_t>(std::abs(offset_hz)) >= input_sample_rate_) {
+        LOGE("Offset %d Hz outside the %d Hz capture", offset_hz, input_sample_rate_);
+        return false;
+    }
     
-    LOGD("Bandwidth set to %d Hz", bandwidth_hz);
+    pending_offset_hz_.store(offset_hz, std::memory_order_release);
+    LOGD("Frequency offset set to %d Hz", offset_hz);
     return true;
 }
 
+void SignalProcessor::applyPendingOffset() {
+    const int offset_hz = pending_offset_hz_.load(std::memory_order_acquire);
+    if (offset_hz == frequency_offset_hz_ ||
+        2 * static_cast<int64_t>(std::abs(offset_hz)) >= input_sample_rate_) {
+        // Nothing new, or left behind by a narrower capture since
+        return;
+    }
+    
+    // Nothing here allocates: the translating filter was sized by
+    // configureChannelFilter() and only has its taps turned
+    frequency_offset_hz_ = offset_hz;
+    const double offset = static_cast<double>(offset_hz) / input_sample_rate_;
+    if (!offset_engaged_) {
+        // Moving off centre keeps the running filter: the mixer starts at
+        // zero phase, which is what no mixer was
+        offset_engaged_ = true;
+        use_translating_filter_ = translatingFilterCheaper();
+        if (use_translating_filter_) {
+            translating_filter_.takeOver(channel_filter_);
+        }
+        offset_mixer_.reset();
+    }
+    if (use_translating_filter_) {
+        translating_filter_.setOffset(offset);
+    }
+    offset_mixer_.setFrequency(-offset);
+}
+
 bool SignalProcessor::setSquelch(int squelch_db) {
     squelch_db_ = squelch_db;
     squelch_threshold_ = std::pow(10.0f, squelch_db / 20.0f);
@@ -172,6 +358,17 @@ bool SignalProcessor::setSquelch(int squelch_db) {
     return true;
 }
 
+void SignalProcessor::setProcessingMode(ProcessingMode mode) {
+    processing_mode_ = mode;
+    configureChannelFilter();
+    LOGD("Processing mode set to %s", mode == ProcessingMode::FIXED_POINT ? "fixed-point" : "float");
+}
+
+void SignalProcessor::setChannelFilterMode(ChannelFilterMode mode) {
+    channel_filter_mode_ = mode;
+    configureChannelFilter();
+}
+
 void SignalProcessor::setDemodulationType(DemodulationType type) {
     demod_type_ = type;
     if (demodulator_) {
@@ -180,37 +377,115 @@ void SignalProcessor::setDemodulationType(DemodulationType type) {
     LOGD("Demodulation type set to %d", static_cast<int>(type));
 }
 
-void SignalProcessor::applyBandpassFilter(std::vector<std::complex<float>>& samples) {
-    if (filter_taps_.empty()) {
-        return;
+void SignalProcessor::setDiscriminatorAccuracy(DiscriminatorAccuracy accuracy) {
+    if (demodulator_) {
+        demodulator_->setDiscriminatorAccuracy(accuracy);
     }
-    
-    for (size_t i = 0; i < samples.size(); ++i) {
-        // Shift delay line
-        for (int j = filter_delay_line_.size() - 1; j > 0; --j) {
-            filter_delay_line_[j] = filter_delay_line_[j - 1];
-        }
-        filter_delay_line_[0] = samples[i];
-        
-        // Apply filter
-        std::complex<float> output(0, 0);
-        for (size_t j = 0; j < filter_taps_.size() && j < filter_delay_line_.size(); ++j) {
-            output += filter_delay_line_[j] * filter_taps_[j];
+    LOGD("FM discriminator accuracy set to %d", static_cast<int>(accuracy));
+}
+
+int SignalProcessor::chooseChannelDecimation(int bandwidth_hz) const {
+    // Largest divisor of audio_decimation_ whose output rate still covers
+    // the channel bandwidth, so the demodulator sees the whole signal
+    for (int d = audio_decimation_; d > 1; --d) {
+        if (audio_decimation_ % d == 0 && input_sample_rate_ / d >= bandwidth_hz) {
+            return d;
         }
-        
-        samples[i] = output;
     }
+    return 1;
+}
+
+void SignalProcessor::configureResampler() {
+    // Decimate as far as the channel filter and demodulator can in whole
+    // steps, then resample the rest. The demodulator runs at input /
+    // audio_decimation_, which is rarely a whole number of Hz; scale both
+    // sides by audio_decimation_ instead.
+    audio_decimation_ = RationalResampler::choosePreDecimation(input_sample_rate_, output_sample_rate_, 1);
+    resampler_active_ = audio_resampler_.configure(input_sample_rate_,
+                                                   output_sample_rate_ * audio_decimation_);
+    
+    if (resampler_active_) {
+        LOGD("Audio decimation %d, resampler %d/%d, %d taps per phase", audio_decimation_,
+             audio_resampler_.getInterpolation(), audio_resampler_.getDecimation(),
+             audio_resampler_.getTapsPerPhase());
+    } else {
+        LOGE("No exact resampler for %d Hz -> %d Hz, audio left at %d Hz", input_sample_rate_,
+             output_sample_rate_, input_sample_rate_ / audio_decimation_);
+    }
+}
+
+int SignalProcessor::chooseChannelTaps(int bandwidth_hz) const {
+    // Hamming transition width is about 3.3 * fs / taps; aim for a
+    // transition of half the channel bandwidth
+    float taps = 3.3f * input_sample_rate_ / (0.5f * bandwidth_hz);
+    return std::max(MIN_CHANNEL_TAPS, std::min(MAX_CHANNEL_TAPS, static_cast<int>(std::ceil(taps))));
+}
+
+void SignalProcessor::configureChannelFilter() {
+    // Split the decimation between the channel filter and the demodulator
+    int channel_decimation = chooseChannelDecimation(bandwidth_hz_);
+    demodulator_->setDecimation(audio_decimation_ / channel_decimation);
+    
+    // FM reaches full scale at half the channel bandwidth, the widest
+    // deviation the filter passes, at the rate the demodulator runs at
+    demodulator_->setFmDeviation(input_sample_rate_ / channel_decimation, bandwidth_hz_ / 2);
+    
+    channel_filter_.configure(channel_taps_, channel_decimation);
+    channel_filter_q15_.configure(channel_taps_, channel_decimation);
+    
+    switch (channel_filter_mode_) {
+        case ChannelFilterMode::DIRECT:
+            use_fast_convolution_ = false;
+            break;
+        case ChannelFilterMode::FAST_CONVOLUTION:
+            use_fast_convolution_ = true;
+            break;
+        default:
+            use_fast_convolution_ =
+                OverlapSaveFilter::fastConvolutionCost(channel_taps_.size()) <
+                OverlapSaveFilter::directCost(channel_taps_.size(), channel_decimation);
+            break;
+    }
+    
+    if (use_fast_convolution_ && !fast_channel_filter_.configure(channel_taps_, channel_decimation)) {
+        use_fast_convolution_ = false;
+    }
+    
+    // The filters restarted anyway: the offset path only stays for an offset
+    const double offset = static_cast<double>(frequency_offset_hz_) / input_sample_rate_;
+    offset_engaged_ = frequency_offset_hz_ != 0;
+    use_translating_filter_ = offset_engaged_ && translatingFilterCheaper();
+    if (translatingFilterCheaper()) {
+        // Sized now even on centre, so moving off it later allocates nothing
+        translating_filter_.configure(channel_taps_, channel_decimation, offset);
+    }
+    offset_mixer_.reset();
+    offset_mixer_.setFrequency(-offset);
+    
+    LOGD("Bandwidth %d Hz: %zu taps, channel decimation %d, %s%s", bandwidth_hz_,
+         channel_taps_.size(), channel_decimation,
+         use_translating_filter_ ? "translating" : use_fast_convolution_ ? "overlap-save" : "direct",
+         offset_engaged_ && !use_translating_filter_ ? " after the NCO" : "");
+}
+
+bool SignalProcessor::translatingFilterCheaper() const {
+    // Rotated complex taps against the NCO in front of the real ones; only
+    // the direct float filter has a translating twin
+    const size_t taps = channel_taps_.size();
+    const int decimation = channel_filter_.getDecimation();
+    return !use_fast_convolution_ && processing_mode_ == ProcessingMode::FLOAT &&
+           TranslatingFIR::cost(taps, decimation) < OverlapSaveFilter::directCost(taps, decimation) + Nco::MIX_COST;
 }
 
-void SignalProcessor::applySquelch(std::vector<float>& audio) {
+void SignalProcessor::applySquelch(float* audio, size_t count) {
     float power = 0.0f;
-    for (float sample : audio) {
-        power += sample * sample;
+    for (size_t i = 0; i < count; ++i) {
+        power += audio[i] * audio[i];
     }
-    power = std::sqrt(power / audio.size());
+    power = std::sqrt(power / count);
     
     if (power < squelch_threshold_) {
-        std::fill(audio.begin(), audio.end(), 0.0f);
+        std::fill(audio, audio + count, 0.0f);
     }
 }
 
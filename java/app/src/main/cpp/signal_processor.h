@@ -5,40 +5,167 @@
 #include <complex>
 #include <memory>
 #include <atomic>
+#include <cstdint>
 
+#include "block_arena.h"
 #include "demodulator.h"
+#include "decimating_fir.h"
+#include "overlap_save_filter.h"
+#include "pipeline_profiler.h"
+#include "rational_resampler.h"
+#include "translating_fir.h"
+#include "nco.h"
+
+// How the channel filter is evaluated. AUTO picks whichever of the direct
+// polyphase form and overlap-save fast convolution is cheaper for the
+// current tap count and decimation.
+enum class ChannelFilterMode {
+    AUTO,
+    DIRECT,
+    FAST_CONVOLUTION
+};
+
+// Arithmetic for the sample-rate part of the chain (channel filter and
+// demodulator). FIXED_POINT runs them on Q15 int16 for FPU-poor devices;
+// FLOAT is the reference. The audio-rate tail is float in both.
+enum class ProcessingMode {
+    FLOAT,
+    FIXED_POINT
+};
 
 class SignalProcessor {
 public:
     SignalProcessor();
     ~SignalProcessor();
     
-    void processSamples(const std::vector<std::complex<float>>& samples);
+    // One block through the chain. Stage buffers come from a per-block
+    // arena, so once the largest block size has been seen nothing here
+    // touches the heap.
+    void processSamples(const std::complex<float>* samples, size_t count);
+    void processSamples(const std::vector<std::complex<float>>& samples) {
+        processSamples(samples.data(), samples.size());
+    }
+    
+    // Q15 input for callers converting raw IQ with convertIQ8ToQ15; always
+    // takes the fixed-point path
+    void processSamplesQ15(const std::complex<int16_t>* samples, size_t count);
+    void processSamplesQ15(const std::vector<std::complex<int16_t>>& samples) {
+        processSamplesQ15(samples.data(), samples.size());
+    }
+    
+    // Copies up to max_count buffered audio samples to output; returns the
+    // number copied. getAudioSamples() is the allocating convenience form.
+    size_t readAudioSamples(float* output, size_t max_count);
     std::vector<float> getAudioSamples();
     
+    // SDR sample rate in and audio rate out; audio is resampled to exactly
+    // the output rate the audio sink was opened with. Both redesign the
+    // filters: not while processSamples() runs.
+    bool setSampleRate(int sample_rate_hz);
+    bool setAudioSampleRate(int sample_rate_hz);
+    
     bool setBandwidth(int bandwidth_hz);
+    
+    // Receives offset_hz away from the tuned frequency instead of at it,
+    // without retuning the hardware: an NCO mixes the input down ahead of
+    // the channel filter, or for a direct float filter short enough for it
+    // to cost less, the filter becomes a frequency-translating one.
+    // Safe from any thread: the offset is checked here and handed over to
+    // the processing thread, which takes it up at the start of its next
+    // block. Every offset change is phase-continuous and keeps the filter
+    // state, back to zero included; the next reconfiguration (bandwidth,
+    // mode, rate) at zero drops the offset path again.
+    bool setFrequencyOffset(int offset_hz);
     bool setSquelch(int squelch_db);
     void setDemodulationType(DemodulationType type);
+    void setDiscriminatorAccuracy(DiscriminatorAccuracy accuracy);
+    // Both rebuild the channel filters: not while processSamples() runs
+    void setChannelFilterMode(ChannelFilterMode mode);
+    void setProcessingMode(ProcessingMode mode);
+    
+    // Times channel filter, demod, resample, AGC and squelch per block;
+    // nullptr (the default) turns it off
+    void setProfiler(PipelineProfiler* profiler) { profiler_ = profiler; }
     
+    int getSampleRate() const { return input_sample_rate_; }
+    int getAudioSampleRate() const { return output_sample_rate_; }
     int getBandwidth() const { return bandwidth_hz_; }
+    // The latest offset asked for, taken up or not
+    int getFrequencyOffset() const { return pending_offset_hz_.load(std::memory_order_relaxed); }
+    int getChannelDecimation() const { return channel_filter_.getDecimation(); }
+    size_t getChannelFilterTaps() const { return channel_filter_.getNumTaps(); }
+    bool isFastConvolutionActive() const { return use_fast_convolution_; }
+    bool isTranslatingFilterActive() const { return use_translating_filter_; }
+    ProcessingMode getProcessingMode() const { return processing_mode_; }
     int getSquelch() const { return squelch_db_; }
     DemodulationType getDemodulationType() const { return demod_type_; }
     
 private:
-    void applyBandpassFilter(std::vector<std::complex<float>>& samples);
-    void applySquelch(std::vector<float>& audio);
+    int chooseChannelDecimation(int bandwidth_hz) const;
+    int chooseChannelTaps(int bandwidth_hz) const;
+    void configureChannelFilter();
+    bool translatingFilterCheaper() const;
+    // Processing thread: takes up an offset setFrequencyOffset() left
+    void applyPendingOffset();
+    void configureResampler();
+    // Offset mixer and the float or Q15 chain for float input
+    void processFloatInput(const std::complex<float>* samples, size_t count, int64_t start_ns);
+    // Float channel filter, demodulator and audio tail on one block
+    void processBlock(const std::complex<float>* samples, size_t count, int64_t start_ns);
+    // start_ns: when the block's timing started, for the channel stage
+    void processBlockQ15(const std::complex<int16_t>* samples, size_t count, int64_t start_ns);
+    // bound: the most audio this block could have produced, for sizing
+    void processAudio(float* audio, size_t count, size_t bound);
+    void applySquelch(float* audio, size_t count);
     float calculatePower(const std::vector<std::complex<float>>& samples);
     
     std::unique_ptr<Demodulator> demodulator_;
     DemodulationType demod_type_;
     
+    int input_sample_rate_;
+    int output_sample_rate_;
     int bandwidth_hz_;
     int squelch_db_;
     float squelch_threshold_;
     
-    // Filter coefficients and state
-    std::vector<float> filter_taps_;
-    std::vector<std::complex<float>> filter_delay_line_;
+    // Channel filter: low-pass and first decimation stage in one pass.
+    // The demodulator decimates the remaining audio_decimation_ / channel
+    // decimation, leaving audio at input_sample_rate_ / audio_decimation_.
+    // Long filters (narrow channels) may run as overlap-save instead.
+    std::vector<float> channel_taps_;
+    DecimatingFIR channel_filter_;
+    OverlapSaveFilter fast_channel_filter_;
+    ChannelFilterMode channel_filter_mode_;
+    bool use_fast_convolution_;
+    
+    // Off-centre channel: the NCO mixing the input down ahead of the
+    // filter, or the same taps as a band-pass at the offset where that is
+    // cheaper. Engaged by the first non-zero offset. frequency_offset_hz_
+    // is the one the filters run at, pending_offset_hz_ the one asked for.
+    int frequency_offset_hz_;
+    std::atomic<int> pending_offset_hz_;
+    bool offset_engaged_;
+    bool use_translating_filter_;
+    TranslatingFIR translating_filter_;
+    Nco offset_mixer_;
+    
+    // Fixed-point path state
+    ProcessingMode processing_mode_;
+    DecimatingFIRQ15 channel_filter_q15_;
+    static const int MIN_CHANNEL_TAPS = 64;
+    static const int MAX_CHANNEL_TAPS = 4095;
+    
+    // Demodulator rate -> output_sample_rate_. audio_decimation_ is the
+    // largest whole decimation that still leaves the resampler a filter
+    // bank: 42 for 2048000 -> 48000, 40 for 44100.
+    int audio_decimation_;
+    RationalResampler audio_resampler_;
+    bool resampler_active_;
+    
+    // Per-block stage buffers, released by the next processSamples()
+    BlockArena arena_;
+    
+    PipelineProfiler* profiler_;
     
     // Audio buffer
     std::vector<float> audio_buffer_;
@@ -13,9 +13,32 @@
 #define M_PI 3.14159265358979323846
 #endif
 
+namespace {
+
+void loadSamples(const std::complex<float>* in, size_t count, std::complex<float>* out) {
+    std::copy(in, in + count, out);
+}
+
+void loadSamples(const std::complex<int16_t>* in, size_t count, std::complex<float>* out) {
+    const int16_t* raw = reinterpret_cast<const int16_t*>(in);
+    float* flat = reinterpret_cast<float*>(out);
+    for (size_t k = 0; k < 2 * count; ++k) {
+        flat[k] = raw[k] * (1.0f / 32768.0f);
+    }
+}
+
+} // namespace
+
 SpectrumAnalyzer::SpectrumAnalyzer()
     : fft_size_(1024)
-    , averaging_factor_(0.1f) {
+    , averaging_factor_(0.1f)
+    , welch_enabled_(false)
+    , overlap_percent_(50)
+    , segments_per_frame_(8)
+    , segment_fill_(0)
+    , segments_accumulated_(0)
+    , waterfall_height_(100)
+    , profiler_(nullptr) {
     
     setFFTSize(fft_size_);
     
@@ -27,9 +50,15 @@ SpectrumAnalyzer::~SpectrumAnalyzer() {
 }
 
 void SpectrumAnalyzer::setFFTSize(int size) {
+    std::lock_guard<std::mutex> lock(spectrum_mutex_);
+    
     // Ensure power of 2
+    size = std::max(MIN_FFT_SIZE, std::min(MAX_FFT_SIZE, size));
     fft_size_ = next_power_of_two(size);
     
+    // Precompute bit-reversal and twiddle tables for this size
+    fft_plan_.setSize(fft_size_);
+    
     // Initialize window (Hamming)
     window_.clear();
     window_.resize(fft_size_);
@@ -42,19 +71,69 @@ void SpectrumAnalyzer::setFFTSize(int size) {
     fft_output_.resize(fft_size_);
     averaged_spectrum_.resize(fft_size_ / 2, -100.0f); // Initialize with low values
     
+    segment_buffer_.resize(fft_size_);
+    resetWelchState();
+    
+    waterfall_.configure(fft_size_ / 2, waterfall_height_);
+    
     LOGD("FFT size set to %d", fft_size_);
 }
 
-void SpectrumAnalyzer::updateSpectrum(const std::vector<std::complex<float>>& samples) {
-    if (samples.size() < static_cast<size_t>(fft_size_)) {
-        return;
+bool SpectrumAnalyzer::setWelchAveraging(bool enabled, int overlap_percent, int segments_per_frame) {
+    if (overlap_percent != 0 && overlap_percent != 50 && overlap_percent != 75) {
+        LOGE("Unsupported Welch overlap: %d%%", overlap_percent);
+        return false;
+    }
+    
+    if (segments_per_frame < 1 || segments_per_frame > MAX_SEGMENTS_PER_FRAME) {
+        LOGE("Invalid Welch segment count: %d", segments_per_frame);
+        return false;
     }
     
     std::lock_guard<std::mutex> lock(spectrum_mutex_);
     
+    welch_enabled_ = enabled;
+    overlap_percent_ = overlap_percent;
+    segments_per_frame_ = segments_per_frame;
+    resetWelchState();
+    
+    LOGD("Welch averaging %s: overlap %d%%, %d segments per frame",
+         enabled ? "enabled" : "disabled", overlap_percent, segments_per_frame);
+    return true;
+}
+
+void SpectrumAnalyzer::resetWelchState() {
+    segment_fill_ = 0;
+    segments_accumulated_ = 0;
+    power_sum_.assign(fft_size_ / 2, 0.0f);
+}
+
+void SpectrumAnalyzer::updateSpectrum(const std::complex<float>* samples, size_t count) {
+    update(samples, count);
+}
+
+void SpectrumAnalyzer::updateSpectrumQ15(const std::complex<int16_t>* samples, size_t count) {
+    update(samples, count);
+}
+
+template <typename Sample>
+void SpectrumAnalyzer::update(const Sample* samples, size_t count) {
+    std::lock_guard<std::mutex> lock(spectrum_mutex_);
+    StageTimer timer(profiler_);
+    
+    if (welch_enabled_) {
+        updateWelch(samples, count);
+        timer.lap(PipelineStage::SPECTRUM_FFT, count);
+        return;
+    }
+    
+    if (count < static_cast<size_t>(fft_size_)) {
+        return;
+    }
+    
     // Take the last fft_size_ samples
-    size_t start_idx = samples.size() - fft_size_;
-    std::copy(samples.begin() + start_idx, samples.end(), fft_input_.begin());
+    size_t start_idx = count - fft_size_;
+    loadSamples(samples + start_idx, fft_size_, fft_input_.data());
     
     // Apply window
     applyWindow(fft_input_);
@@ -63,16 +142,73 @@ void SpectrumAnalyzer::updateSpectrum(const std::vector<std::complex<float>>& sa
     performFFT(fft_input_, fft_output_);
     
     // Calculate magnitudes in dB
-    std::vector<float> magnitudes = calculateMagnitudes(fft_output_);
+    calculateMagnitudes(fft_output_, magnitudes_);
     
+    publishFrame(magnitudes_);
+    timer.lap(PipelineStage::SPECTRUM_FFT, fft_size_);
+}
+
+template <typename Sample>
+void SpectrumAnalyzer::updateWelch(const Sample* samples, size_t count) {
+    const size_t segment_size = static_cast<size_t>(fft_size_);
+    const size_t hop = segment_size * (100 - overlap_percent_) / 100;
+    
+    size_t pos = 0;
+    while (pos < count) {
+        size_t chunk = std::min(segment_size - segment_fill_, count - pos);
+        loadSamples(samples + pos, chunk, segment_buffer_.data() + segment_fill_);
+        segment_fill_ += chunk;
+        pos += chunk;
+        
+        if (segment_fill_ < segment_size) {
+            break;
+        }
+        
+        accumulateSegment();
+        
+        // The overlapping tail starts the next segment
+        std::copy(segment_buffer_.begin() + hop, segment_buffer_.end(), segment_buffer_.begin());
+        segment_fill_ = segment_size - hop;
+        
+        if (segments_accumulated_ >= segments_per_frame_) {
+            // One log conversion per bin for the whole frame
+            magnitudes_.resize(power_sum_.size());
+            const float scale = 1.0f / segments_accumulated_;
+            for (size_t i = 0; i < power_sum_.size(); ++i) {
+                magnitudes_[i] = 10.0f * std::log10(std::max(power_sum_[i] * scale, 1e-20f));
+            }
+            
+            std::fill(power_sum_.begin(), power_sum_.end(), 0.0f);
+            segments_accumulated_ = 0;
+            
+            publishFrame(magnitudes_);
+        }
+    }
+}
+
+void SpectrumAnalyzer::accumulateSegment() {
+    // Window straight into the FFT buffer and transform in place
+    for (int i = 0; i < fft_size_; ++i) {
+        fft_output_[i] = segment_buffer_[i] * window_[i];
+    }
+    
+    fft_plan_.forward(fft_output_.data());
+    
+    for (size_t i = 0; i < power_sum_.size(); ++i) {
+        power_sum_[i] += std::norm(fft_output_[i]);
+    }
+    
+    ++segments_accumulated_;
+}
+
+void SpectrumAnalyzer::publishFrame(std::vector<float>& magnitudes) {
     // Apply averaging
     applyAveraging(magnitudes);
     
     // Add to waterfall history
-    if (waterfall_history_.size() >= WATERFALL_HEIGHT) {
-        waterfall_history_.pop_back();
+    if (magnitudes.size() == static_cast<size_t>(waterfall_.getWidth())) {
+        waterfall_.push(magnitudes.data());
     }
-    waterfall_history_.push_front(magnitudes);
 }
 
 std::vector<float> SpectrumAnalyzer::getSpectrum() {
@@ -84,18 +220,33 @@ std::vector<float> SpectrumAnalyzer::getWaterfall() {
     std::lock_guard<std::mutex> lock(spectrum_mutex_);
     
     std::vector<float> waterfall_data;
-    waterfall_data.reserve(waterfall_history_.size() * (fft_size_ / 2));
+    waterfall_.copyAllDb(waterfall_data);
+    return waterfall_data;
+}
+
+uint64_t SpectrumAnalyzer::getWaterfallRows(uint64_t since_sequence, std::vector<uint8_t>& rows, int& width) {
+    std::lock_guard<std::mutex> lock(spectrum_mutex_);
+    width = waterfall_.getWidth();
+    return waterfall_.copyRowsSince(since_sequence, rows);
+}
+
+void SpectrumAnalyzer::setWaterfallHeight(int rows) {
+    std::lock_guard<std::mutex> lock(spectrum_mutex_);
     
-    for (const auto& line : waterfall_history_) {
-        waterfall_data.insert(waterfall_data.end(), line.begin(), line.end());
-    }
+    waterfall_height_ = std::max(1, std::min(MAX_WATERFALL_HEIGHT, rows));
+    waterfall_.configure(fft_size_ / 2, waterfall_height_);
     
-    return waterfall_data;
+    LOGD("Waterfall height set to %d rows", waterfall_height_);
+}
+
+void SpectrumAnalyzer::setWaterfallRange(float min_db, float max_db) {
+    std::lock_guard<std::mutex> lock(spectrum_mutex_);
+    waterfall_.setRange(min_db, max_db);
 }
 
 void SpectrumAnalyzer::performFFT(const std::vector<std::complex<float>>& input, std::vector<std::complex<float>>& output) {
     output = input;
-    fft_recursive(output);
+    fft_plan_.forward(output.data());
 }
 
 void SpectrumAnalyzer::applyWindow(std::vector<std::complex<float>>& samples) {
@@ -104,21 +255,17 @@ void SpectrumAnalyzer::applyWindow(std::vector<std::complex<float>>& samples) {
     }
 }
 
-std::vector<float> SpectrumAnalyzer::calculateMagnitudes(const std::vector<std::complex<float>>& fft_result) {
-    std::vector<float> magnitudes;
-    magnitudes.reserve(fft_result.size() / 2);
+void SpectrumAnalyzer::calculateMagnitudes(const std::vector<std::complex<float>>& fft_result,
+                                           std::vector<float>& magnitudes) {
+    magnitudes.resize(fft_result.size() / 2);
     
     // Only take the first half (positive frequencies)
     for (size_t i = 0; i < fft_result.size() / 2; ++i) {
         float magnitude = std::abs(fft_result[i]);
         
         // Convert to dB, with protection against log(0)
-        float db = 20.0f * std::log10(std::max(magnitude, 1e-10f));
-        
-        magnitudes.push_back(db);
+        magnitudes[i] = 20.0f * std::log10(std::max(magnitude, 1e-10f));
     }
-    
-    return magnitudes;
 }
 
 void SpectrumAnalyzer::applyAveraging(std::vector<float>& magnitudes) {
@@ -133,39 +280,8 @@ void SpectrumAnalyzer::applyAveraging(std::vector<float>& magnitudes) {
     }
 }
 
-// Simple recursive FFT implementation
-void SpectrumAnalyzer::fft_recursive(std::vector<std::complex<float>>& x) {
-    int n = x.size();
-    
-    if (n <= 1) return;
-    
-    // Divide
-    std::vector<std::complex<float>> even(n / 2);
-    std::vector<std::complex<float>> odd(n / 2);
-    
-    for (int i = 0; i < n / 2; ++i) {
-        even[i] = x[2 * i];
-        odd[i] = x[2 * i + 1];
-    }
-    
-    // Conquer
-    fft_recursive(even);
-    fft_recursive(odd);
-    
-    // Combine
-    for (int k = 0; k < n / 2; ++k) {
-        std::complex<float> t = std::polar(1.0f, -2.0f * static_cast<float>(M_PI) * k / n) * odd[k];
-        x[k] = even[k] + t;
-        x[k + n / 2] = even[k] - t;
-    }
-}
-
-bool SpectrumAnalyzer::is_power_of_two(int n) {
-    return n > 0 && (n & (n - 1)) == 0;
-}
-
 int SpectrumAnalyzer::next_power_of_two(int n) {
-    if (is_power_of_two(n)) {
+    if (FFTPlan::isPowerOfTwo(n)) {
         return n;
     }
     
@@ -4,44 +4,95 @@
 #include <vector>
 #include <complex>
 #include <mutex>
-#include <deque>
+#include <cstdint>
+
+#include "fft.h"
+#include "pipeline_profiler.h"
+#include "waterfall_buffer.h"
 
 class SpectrumAnalyzer {
 public:
     SpectrumAnalyzer();
     ~SpectrumAnalyzer();
     
-    void updateSpectrum(const std::vector<std::complex<float>>& samples);
+    void updateSpectrum(const std::complex<float>* samples, size_t count);
+    void updateSpectrum(const std::vector<std::complex<float>>& samples) {
+        updateSpectrum(samples.data(), samples.size());
+    }
+    
+    // Q15 input from the fixed-point path; only the samples a frame uses
+    // are converted to float
+    void updateSpectrumQ15(const std::complex<int16_t>* samples, size_t count);
     std::vector<float> getSpectrum();
+    
+    // Full waterfall in dB, newest row first (dequantized copy)
     std::vector<float> getWaterfall();
     
+    // Quantized rows (0..255 over the waterfall dB range) added since
+    // since_sequence, oldest first. Returns the next sequence to ask for;
+    // width is the row length, read under the same lock as the rows since
+    // setFFTSize() can change it between two calls.
+    uint64_t getWaterfallRows(uint64_t since_sequence, std::vector<uint8_t>& rows, int& width);
+    
+    void setWaterfallHeight(int rows);
+    void setWaterfallRange(float min_db, float max_db);
+    
     void setFFTSize(int size);
     int getFFTSize() const { return fft_size_; }
     
+    // Welch averaging: every input sample goes into overlapping windowed
+    // segments whose power spectra are averaged (linear domain) before a
+    // single dB conversion per output frame. overlap_percent: 0, 50 or 75.
+    bool setWelchAveraging(bool enabled, int overlap_percent, int segments_per_frame);
+    bool isWelchEnabled() const { return welch_enabled_; }
+    
+    // Times each updateSpectrum() as SPECTRUM_FFT; nullptr turns it off
+    void setProfiler(PipelineProfiler* profiler) { profiler_ = profiler; }
+    
 private:
+    template <typename Sample>
+    void update(const Sample* samples, size_t count);
+    template <typename Sample>
+    void updateWelch(const Sample* samples, size_t count);
+    void accumulateSegment();
+    void resetWelchState();
+    void publishFrame(std::vector<float>& magnitudes);
     void performFFT(const std::vector<std::complex<float>>& input, std::vector<std::complex<float>>& output);
     void applyWindow(std::vector<std::complex<float>>& samples);
-    std::vector<float> calculateMagnitudes(const std::vector<std::complex<float>>& fft_result);
+    void calculateMagnitudes(const std::vector<std::complex<float>>& fft_result, std::vector<float>& magnitudes);
     void applyAveraging(std::vector<float>& magnitudes);
     
     int fft_size_;
+    static const int MIN_FFT_SIZE = 16;
+    static const int MAX_FFT_SIZE = 65536;
+    FFTPlan fft_plan_;
     std::vector<float> window_;
     std::vector<std::complex<float>> fft_input_;
     std::vector<std::complex<float>> fft_output_;
+    std::vector<float> magnitudes_;    // dB frame being published
     
     // Spectrum averaging
     std::vector<float> averaged_spectrum_;
     float averaging_factor_;
     
+    // Welch state: partially filled segment and linear power accumulator
+    bool welch_enabled_;
+    int overlap_percent_;
+    int segments_per_frame_;
+    std::vector<std::complex<float>> segment_buffer_;
+    size_t segment_fill_;
+    std::vector<float> power_sum_;
+    int segments_accumulated_;
+    static const int MAX_SEGMENTS_PER_FRAME = 1024;
+    
     // Waterfall display
-    std::deque<std::vector<float>> waterfall_history_;
-    static const size_t WATERFALL_HEIGHT = 100;
+    WaterfallBuffer waterfall_;
+    int waterfall_height_;
+    static const int MAX_WATERFALL_HEIGHT = 4096;
     
-    std::mutex spectrum_mutex_;
+    mutable std::mutex spectrum_mutex_;
+    PipelineProfiler* profiler_;
     
-    // Simple FFT implementation (for small sizes)
-    void fft_recursive(std::vector<std::complex<float>>& x);
-    bool is_power_of_two(int n);
     int next_power_of_two(int n);
 };
 
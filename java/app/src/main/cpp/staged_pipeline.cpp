@@ -0,0 +1,262 @@
+#include "staged_pipeline.h"
+#include <android/log.h>
+#include "async_logger.h"
+#include <algorithm>
+
+#include "audio_processor.h"
+#include "spectrum_analyzer.h"
+
+#define LOG_TAG "Staged_Pipeline"
+#define LOGI(...) ASYNC_LOG(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+#define LOGE(...) ASYNC_LOG(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+#define LOGD(...) ASYNC_LOG(ANDROID_LOG_DEBUG, LOG_TAG, __VA_ARGS__)
+
+const char* pipelineThreadName(PipelineThread thread) {
+    switch (thread) {
+        case PipelineThread::INGEST: return "ingest";
+        case PipelineThread::DEMOD: return "demod";
+        case PipelineThread::SPECTRUM: return "spectrum";
+        case PipelineThread::OUTPUT: return "output";
+        default: return "?";
+    }
+}
+
+StagedPipeline::StagedPipeline(SpectrumAnalyzer* spectrum, AudioProcessor* audio)
+    : spectrum_(spectrum)
+    , audio_(audio)
+    , tracer_(nullptr)
+    , running_(false)
+    , spectrum_min_(0)
+    , spectrum_max_(0)
+    , slot_capacity_(0)
+    , audio_write_(0)
+    , audio_read_(0)
+    , producer_waiting_(false)
+    , consumer_waiting_(false) {
+}
+
+StagedPipeline::~StagedPipeline() {
+    stop();
+}
+
+void StagedPipeline::setPlacement(PipelineThread thread, const ThreadPlacement& placement) {
+    placements_[static_cast<int>(thread)] = placement;
+}
+
+bool StagedPipeline::start(size_t block_samples) {
+    if (running_.load() || block_samples == 0) {
+        return running_.load();
+    }
+    
+    if (spectrum_) {
+        // A frame needs a whole FFT even when it is longer than a block
+        const size_t fft_size = static_cast<size_t>(std::max(spectrum_->getFFTSize(), 1));
+        spectrum_min_ = std::max(block_samples / 2, fft_size);
+        spectrum_max_ = std::max(block_samples, fft_size);
+        if (spectrum_ring_.capacity() < 4 * spectrum_max_ && !spectrum_ring_.allocate(4 * spectrum_max_)) {
+            LOGE("Cannot allocate the spectrum ring");
+            return false;
+        }
+        spectrum_ring_.reset();
+    }
+    
+    slot_capacity_ = block_samples;
+    for (auto& slot : slots_) {
+        slot.samples.resize(block_samples);
+        slot.count = 0;
+        slot.stamped = false;
+    }
+    audio_write_.store(0);
+    audio_read_.store(0);
+    spectrum_wakeups_.reset();
+    output_wakeups_.reset();
+    
+    running_.store(true);
+    if (spectrum_) {
+        spectrum_thread_ = std::thread(&StagedPipeline::spectrumLoop, this);
+    }
+    if (audio_) {
+        output_thread_ = std::thread(&StagedPipeline::outputLoop, this);
+    }
+    
+    LOGI("Staged pipeline started, %zu-sample blocks", block_samples);
+    return true;
+}
+
+void StagedPipeline::stop() {
+    running_.store(false);
+    spectrum_ring_.wake();
+    {
+        // Under the mutex so a side between its check and its wait still
+        // sees the flag
+        std::lock_guard<std::mutex> lock(mutex_);
+        producer_cv_.notify_all();
+        consumer_cv_.notify_all();
+    }
+    
+    if (spectrum_thread_.joinable()) {
+        spectrum_thread_.join();
+    }
+    if (output_thread_.joinable()) {
+        output_thread_.join();
+        LOGI("Staged pipeline stopped");
+    }
+}
+
+void StagedPipeline::pushSpectrum(const std::complex<float>* samples, size_t count) {
+    if (!spectrum_ || !running_.load(std::memory_order_relaxed)) {
+        return;
+    }
+    
+    // Two spans at most where the ring is not mirrored
+    while (count > 0) {
+        size_t space = 0;
+        std::complex<float>* span = spectrum_ring_.writeSpan(space);
+        if (space == 0) {
+            spectrum_ring_.recordDropped(count);
+            return;
+        }
+        const size_t written = std::min(space, count);
+        std::copy(samples, samples + written, span);
+        spectrum_ring_.commitWrite(written);
+        samples += written;
+        count -= written;
+    }
+}
+
+void StagedPipeline::pushSpectrumQ15(const std::complex<int16_t>* samples, size_t count) {
+    if (!spectrum_ || !running_.load(std::memory_order_relaxed)) {
+        return;
+    }
+    
+    // The copy pushSpectrum() makes anyway, widening on the way
+    while (count > 0) {
+        size_t space = 0;
+        std::complex<float>* span = spectrum_ring_.writeSpan(space);
+        if (space == 0) {
+            spectrum_ring_.recordDropped(count);
+            return;
+        }
+        const size_t written = std::min(space, count);
+        const int16_t* in = reinterpret_cast<const int16_t*>(samples);
+        float* out = reinterpret_cast<float*>(span);
+        for (size_t k = 0; k < 2 * written; ++k) {
+            out[k] = in[k] * (1.0f / 32768.0f);
+        }
+        spectrum_ring_.commitWrite(written);
+        samples += written;
+        count -= written;
+    }
+}
+
+void StagedPipeline::pushAudio(const float* audio, size_t count, bool stamped, int64_t ingest_ns,
+                               int64_t dequeued_ns) {
+    if (!audio_) {
+        return;
+    }
+    
+    while (count > 0) {
+        if (!waitForSlots(AUDIO_SLOTS - 1)) {
+            return;
+        }
+        
+        const size_t write = audio_write_.load(std::memory_order_relaxed);
+        AudioSlot& slot = slots_[write % AUDIO_SLOTS];
+        slot.count = std::min(count, slot_capacity_);
+        std::copy(audio, audio + slot.count, slot.samples.begin());
+        slot.stamped = stamped;
+        slot.ingest_ns = ingest_ns;
+        slot.dequeued_ns = dequeued_ns;
+        
+        // seq_cst pairs with the consumer's flag store in outputLoop()
+        audio_write_.store(write + 1, std::memory_order_seq_cst);
+        if (consumer_waiting_.load(std::memory_order_seq_cst)) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            consumer_cv_.notify_one();
+        }
+        
+        // Only the first piece of a block starts where its stamp points
+        audio += slot.count;
+        count -= slot.count;
+        stamped = false;
+    }
+}
+
+void StagedPipeline::drain() {
+    waitForSlots(0);
+}
+
+bool StagedPipeline::waitForSlots(size_t pending) {
+    auto busy = [this, pending]() {
+        return audio_write_.load(std::memory_order_relaxed) -
+               audio_read_.load(std::memory_order_seq_cst) > pending;
+    };
+    if (!busy()) {
+        return true;
+    }
+    
+    std::unique_lock<std::mutex> lock(mutex_);
+    producer_waiting_.store(true, std::memory_order_seq_cst);
+    producer_cv_.wait(lock, [this, &busy]() { return !running_.load() || !busy(); });
+    producer_waiting_.store(false, std::memory_order_relaxed);
+    return !busy();
+}
+
+void StagedPipeline::spectrumLoop() {
+    applyThreadPlacement(placements_[static_cast<int>(PipelineThread::SPECTRUM)]);
+    
+    while (running_.load()) {
+        const size_t ready = spectrum_ring_.waitForSamples(spectrum_min_, SampleRing::WAIT_FOREVER);
+        spectrum_wakeups_.tick();
+        if (!running_.load() || ready < spectrum_min_) {
+            continue;
+        }
+        
+        // Behind by more than a frame: the display wants the newest IQ
+        if (ready > spectrum_max_) {
+            spectrum_ring_.commitRead(ready - spectrum_max_);
+        }
+        
+        size_t count = 0;
+        const std::complex<float>* samples = spectrum_ring_.readSpan(count);
+        count = std::min(count, spectrum_max_);
+        spectrum_->updateSpectrum(samples, count);
+        spectrum_ring_.commitRead(count);
+    }
+}
+
+void StagedPipeline::outputLoop() {
+    applyThreadPlacement(placements_[static_cast<int>(PipelineThread::OUTPUT)]);
+    
+    for (;;) {
+        const size_t read = audio_read_.load(std::memory_order_relaxed);
+        if (audio_write_.load(std::memory_order_seq_cst) == read) {
+            std::unique_lock<std::mutex> lock(mutex_);
+            consumer_waiting_.store(true, std::memory_order_seq_cst);
+            consumer_cv_.wait(lock, [this, read]() {
+                return !running_.load() || audio_write_.load(std::memory_order_seq_cst) != read;
+            });
+            consumer_waiting_.store(false, std::memory_order_relaxed);
+            output_wakeups_.tick();
+        }
+        if (!running_.load()) {
+            break;
+        }
+        
+        AudioSlot& slot = slots_[read % AUDIO_SLOTS];
+        if (slot.stamped) {
+            audio_->stampNextBlock(slot.ingest_ns);
+        }
+        audio_->processAudio(slot.samples.data(), slot.count);
+        if (slot.stamped && tracer_) {
+            tracer_->record(LatencyStage::DSP, LatencyTracer::now() - slot.dequeued_ns);
+        }
+        
+        // Release only now: drain() takes a free slot to mean done
+        audio_read_.store(read + 1, std::memory_order_seq_cst);
+        if (producer_waiting_.load(std::memory_order_seq_cst)) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            producer_cv_.notify_one();
+        }
+    }
+}
@@ -0,0 +1,135 @@
+#ifndef STAGED_PIPELINE_H
+#define STAGED_PIPELINE_H
+
+#include <atomic>
+#include <complex>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "latency_tracer.h"
+#include "sample_ring.h"
+#include "thread_placement.h"
+#include "wakeup_meter.h"
+
+class AudioProcessor;
+class SpectrumAnalyzer;
+
+// How the processing loop runs the stages after the IQ ring:
+//   INLINE  one thread does channel filter, demod, spectrum and audio in
+//           turn, as before; least overhead, for low-end devices
+//   STAGED  the loop only filters and demodulates and hands spectrum and
+//           audio to a thread each, so a slow FFT frame never delays audio
+enum class PipelineMode {
+    INLINE = 0,
+    STAGED
+};
+
+// The pipeline's threads, for placement. INGEST is SDRController's USB
+// reader and DEMOD the processing loop; both exist in either mode.
+enum class PipelineThread {
+    INGEST = 0,
+    DEMOD,
+    SPECTRUM,
+    OUTPUT,
+    COUNT
+};
+
+const char* pipelineThreadName(PipelineThread thread);
+
+// The spectrum and output threads of STAGED mode. The demod thread is the
+// only producer: pushSpectrum() copies IQ into a SampleRing and never
+// blocks (a spectrum thread that falls a ring behind loses samples),
+// pushAudio() copies demodulated audio into a fixed set of slots and
+// blocks while all of them are full, so audio is never dropped here.
+// Buffers are sized in start(); pushing allocates nothing.
+class StagedPipeline {
+public:
+    StagedPipeline(SpectrumAnalyzer* spectrum, AudioProcessor* audio);
+    ~StagedPipeline();
+    
+    StagedPipeline(const StagedPipeline&) = delete;
+    StagedPipeline& operator=(const StagedPipeline&) = delete;
+    
+    // Before start(); SPECTRUM and OUTPUT are applied on their threads
+    void setPlacement(PipelineThread thread, const ThreadPlacement& placement);
+    
+    // Records DSP latency once a block's audio reaches the AudioProcessor
+    void setLatencyTracer(LatencyTracer* tracer) { tracer_ = tracer; }
+    
+    // block_samples: the most IQ (and audio) one push carries
+    bool start(size_t block_samples);
+    void stop();
+    bool isRunning() const { return running_.load(); }
+    
+    // Demod thread
+    void pushSpectrum(const std::complex<float>* samples, size_t count);
+    // Q15 from the fixed-point path, converted on the way into the ring
+    void pushSpectrumQ15(const std::complex<int16_t>* samples, size_t count);
+    
+    // stamped: ingest_ns is the USB time of the block this audio came
+    // from, dequeued_ns when the demod thread took it from the IQ ring
+    void pushAudio(const float* audio, size_t count, bool stamped, int64_t ingest_ns, int64_t dequeued_ns);
+    
+    // Blocks until everything pushed so far has reached the AudioProcessor
+    void drain();
+    
+    uint64_t droppedSpectrumSamples() const { return spectrum_ring_.droppedSamples(); }
+    WakeupMeter& spectrumWakeups() { return spectrum_wakeups_; }
+    WakeupMeter& outputWakeups() { return output_wakeups_; }
+
+private:
+    struct AudioSlot {
+        std::vector<float> samples;
+        size_t count;
+        bool stamped;
+        int64_t ingest_ns;
+        int64_t dequeued_ns;
+    };
+    
+    void spectrumLoop();
+    void outputLoop();
+    
+    // Producer: waits until at most pending slots are in flight
+    bool waitForSlots(size_t pending);
+    
+    SpectrumAnalyzer* spectrum_;
+    AudioProcessor* audio_;
+    LatencyTracer* tracer_;
+    ThreadPlacement placements_[static_cast<int>(PipelineThread::COUNT)];
+    
+    std::atomic<bool> running_;
+    std::thread spectrum_thread_;
+    std::thread output_thread_;
+    
+    // Demod -> spectrum. The spectrum thread takes at least spectrum_min_
+    // samples per frame and skips whatever backlog exceeds spectrum_max_.
+    SampleRing spectrum_ring_;
+    size_t spectrum_min_;
+    size_t spectrum_max_;
+    
+    // Demod -> output. Indices count up forever; a slot belongs to the
+    // producer until published and to the consumer until released, which
+    // it does only after processAudio() returns, so released == done.
+    static const size_t AUDIO_SLOTS = 8;
+    AudioSlot slots_[AUDIO_SLOTS];
+    size_t slot_capacity_;
+    alignas(64) std::atomic<size_t> audio_write_;
+    alignas(64) std::atomic<size_t> audio_read_;
+    
+    // Sleeping only: each side sleeps on its own condition and the other
+    // takes the mutex to notify only if the flag says someone sleeps
+    std::mutex mutex_;
+    std::condition_variable producer_cv_;
+    std::condition_variable consumer_cv_;
+    std::atomic<bool> producer_waiting_;
+    std::atomic<bool> consumer_waiting_;
+    
+    WakeupMeter spectrum_wakeups_;
+    WakeupMeter output_wakeups_;
+};
+
+#endif // STAGED_PIPELINE_H
@@ -0,0 +1,133 @@
+#include "thread_placement.h"
+#include <android/log.h>
+#include "async_logger.h"
+#include <cerrno>
+#include <climits>
+#include <cstdio>
+#include <cstring>
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#define LOG_TAG "Thread_Placement"
+#define LOGI(...) ASYNC_LOG(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+#define LOGE(...) ASYNC_LOG(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+#define LOGD(...) ASYNC_LOG(ANDROID_LOG_DEBUG, LOG_TAG, __VA_ARGS__)
+
+namespace {
+
+// Cores per class, read once from sysfs
+struct CoreTopology {
+    cpu_set_t any;
+    cpu_set_t little;
+    cpu_set_t big;
+    
+    CoreTopology() {
+        CPU_ZERO(&any);
+        CPU_ZERO(&little);
+        CPU_ZERO(&big);
+        
+        long cores = sysconf(_SC_NPROCESSORS_CONF);
+        if (cores < 1) {
+            cores = 1;
+        }
+        if (cores > CPU_SETSIZE) {
+            cores = CPU_SETSIZE;
+        }
+        
+        long max_khz[CPU_SETSIZE];
+        long slowest = LONG_MAX;
+        long fastest = 0;
+        for (long cpu = 0; cpu < cores; ++cpu) {
+            CPU_SET(cpu, &any);
+            max_khz[cpu] = readMaxFrequency(static_cast<int>(cpu));
+            if (max_khz[cpu] > 0) {
+                slowest = max_khz[cpu] < slowest ? max_khz[cpu] : slowest;
+                fastest = max_khz[cpu] > fastest ? max_khz[cpu] : fastest;
+            }
+        }
+        
+        // Uniform (or unreadable) clocks: no clusters to choose between
+        if (fastest == 0 || slowest == fastest) {
+            little = any;
+            big = any;
+            return;
+        }
+        for (long cpu = 0; cpu < cores; ++cpu) {
+            // A core without cpufreq counts as little, the safe side
+            if (max_khz[cpu] > slowest) {
+                CPU_SET(cpu, &big);
+            } else {
+                CPU_SET(cpu, &little);
+            }
+        }
+    }
+    
+    static long readMaxFrequency(int cpu) {
+        char path[96];
+        std::snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/cpufreq/cpuinfo_max_freq", cpu);
+        FILE* file = std::fopen(path, "r");
+        if (!file) {
+            return 0;
+        }
+        long khz = 0;
+        if (std::fscanf(file, "%ld", &khz) != 1) {
+            khz = 0;
+        }
+        std::fclose(file);
+        return khz;
+    }
+    
+    const cpu_set_t& set(CoreClass cores) const {
+        switch (cores) {
+            case CoreClass::LITTLE: return little;
+            case CoreClass::BIG: return big;
+            default: return any;
+        }
+    }
+};
+
+const CoreTopology& topology() {
+    static const CoreTopology instance;
+    return instance;
+}
+
+} // namespace
+
+bool applyThreadPlacement(const ThreadPlacement& placement) {
+    bool applied = true;
+    const pid_t tid = static_cast<pid_t>(syscall(SYS_gettid));
+    
+    const cpu_set_t& cores = topology().set(placement.cores);
+    if (sched_setaffinity(tid, sizeof(cores), &cores) != 0) {
+        LOGE("Cannot pin thread %d to %s cores: %s", tid, coreClassName(placement.cores), std::strerror(errno));
+        applied = false;
+    }
+    
+    // Per thread on Linux: setpriority() with a tid only touches that thread
+    if (setpriority(PRIO_PROCESS, static_cast<id_t>(tid), placement.nice) != 0) {
+        LOGE("Cannot set thread %d to nice %d: %s", tid, placement.nice, std::strerror(errno));
+        applied = false;
+    }
+    
+    if (applied) {
+        LOGD("Thread %d on %d %s cores, nice %d", tid, coreCount(placement.cores),
+             coreClassName(placement.cores), placement.nice);
+    }
+    return applied;
+}
+
+int coreCount(CoreClass cores) {
+    const cpu_set_t& set = topology().set(cores);
+    return CPU_COUNT(&set);
+}
+
+const char* coreClassName(CoreClass cores) {
+    switch (cores) {
+        case CoreClass::ANY: return "any";
+        case CoreClass::LITTLE: return "little";
+        case CoreClass::BIG: return "big";
+        default: return "?";
+    }
+}
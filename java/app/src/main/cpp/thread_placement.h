@@ -0,0 +1,29 @@
+#ifndef THREAD_PLACEMENT_H
+#define THREAD_PLACEMENT_H
+
+// Which cores a pipeline thread may run on and at what priority. On
+// big.LITTLE parts the clusters are told apart by their maximum clock
+// (cpufreq); where every core looks the same, BIG and LITTLE both mean
+// every core.
+enum class CoreClass {
+    ANY = 0,
+    LITTLE,     // the slowest cluster
+    BIG         // every core faster than the slowest cluster
+};
+
+struct ThreadPlacement {
+    CoreClass cores = CoreClass::ANY;
+    int nice = 0;   // -20 (highest) .. 19; below 0 may need privileges
+};
+
+// Pins the calling thread and sets its nice value. Either part failing
+// (no permission, cores offline) is logged and leaves that part as it
+// was; returns true only if both took effect.
+bool applyThreadPlacement(const ThreadPlacement& placement);
+
+// Cores in the class, as the placement would use them
+int coreCount(CoreClass cores);
+
+const char* coreClassName(CoreClass cores);
+
+#endif // THREAD_PLACEMENT_H
@@ -0,0 +1,129 @@
+#include "translating_fir.h"
+#include <algorithm>
+#include <cmath>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+TranslatingFIR::TranslatingFIR()
+    : write_pos_(0)
+    , decimation_(1)
+    , phase_(0)
+    , offset_(0.0) {
+}
+
+bool TranslatingFIR::configure(const std::vector<float>& taps, int decimation, double offset) {
+    if (taps.empty() || decimation < 1) {
+        return false;
+    }
+    
+    reversed_taps_.assign(taps.rbegin(), taps.rend());
+    taps_re_.resize(taps.size());
+    taps_im_.resize(taps.size());
+    decimation_ = decimation;
+    offset_ = offset;
+    rotateTaps();
+    
+    delay_re_.assign(2 * taps.size(), 0.0f);
+    delay_im_.assign(2 * taps.size(), 0.0f);
+    reset();
+    return true;
+}
+
+void TranslatingFIR::reset() {
+    std::fill(delay_re_.begin(), delay_re_.end(), 0.0f);
+    std::fill(delay_im_.begin(), delay_im_.end(), 0.0f);
+    write_pos_ = 0;
+    phase_ = 0;
+    
+    // The first output's centre sample is input decimation - 1 - centre
+    const double centre = (static_cast<double>(reversed_taps_.size()) - 1.0) / 2.0;
+    mixer_.setFrequency(-offset_ * decimation_);
+    mixer_.reset(-2.0 * M_PI * offset_ * (decimation_ - 1 - centre));
+}
+
+void TranslatingFIR::setOffset(double offset) {
+    // The mixer phase of the next output stays as it is; a symmetric
+    // low-pass turned about its centre leaves the samples already in the
+    // window at the same phase, so the output carries on without a step
+    offset_ = offset;
+    rotateTaps();
+    mixer_.setFrequency(-offset * decimation_);
+}
+
+bool TranslatingFIR::takeOver(const DecimatingFIR& filter) {
+    if (filter.reversed_taps_ != reversed_taps_ || filter.decimation_ != decimation_) {
+        return false;
+    }
+    
+    // Both filter the raw input, so the window means the same here. Same
+    // taps, same delay line length: copied in place, no allocation.
+    std::copy(filter.delay_re_.begin(), filter.delay_re_.end(), delay_re_.begin());
+    std::copy(filter.delay_im_.begin(), filter.delay_im_.end(), delay_im_.begin());
+    write_pos_ = filter.write_pos_;
+    phase_ = filter.phase_;
+    mixer_.reset(0.0);
+    return true;
+}
+
+float TranslatingFIR::cost(size_t num_taps, int decimation) {
+    // Four products per complex tap for every kept output; the rotation is
+    // spread over the decimation
+    return (4.0f * num_taps + 4.0f) / std::max(1, decimation);
+}
+
+void TranslatingFIR::rotateTaps() {
+    // Reversed index k holds h[i] with i = taps - 1 - k samples back;
+    // rotated about the centre tap, whose sample the mixer phase is for
+    const size_t num_taps = reversed_taps_.size();
+    const double centre = (static_cast<double>(num_taps) - 1.0) / 2.0;
+    for (size_t k = 0; k < num_taps; ++k) {
+        const double angle = 2.0 * M_PI * offset_ * (static_cast<double>(num_taps - 1 - k) - centre);
+        taps_re_[k] = static_cast<float>(reversed_taps_[k] * std::cos(angle));
+        taps_im_[k] = static_cast<float>(reversed_taps_[k] * std::sin(angle));
+    }
+}
+
+size_t TranslatingFIR::process(const std::complex<float>* input, size_t count, std::complex<float>* output) {
+    const size_t num_taps = reversed_taps_.size();
+    if (num_taps == 0) {
+        return 0;
+    }
+    
+    size_t produced = 0;
+    
+    const float* taps_re = taps_re_.data();
+    const float* taps_im = taps_im_.data();
+    float* delay_re = delay_re_.data();
+    float* delay_im = delay_im_.data();
+    
+    for (size_t i = 0; i < count; ++i) {
+        // Write each sample to both halves so the window never wraps
+        delay_re[write_pos_] = delay_re[write_pos_ + num_taps] = input[i].real();
+        delay_im[write_pos_] = delay_im[write_pos_ + num_taps] = input[i].imag();
+        if (++write_pos_ == num_taps) {
+            write_pos_ = 0;
+        }
+        
+        if (++phase_ < decimation_) {
+            continue;
+        }
+        phase_ = 0;
+        
+        // Complex taps against complex samples: four real products per tap
+        const float* window_re = delay_re + write_pos_;
+        const float* window_im = delay_im + write_pos_;
+        float acc_re = 0.0f;
+        float acc_im = 0.0f;
+        for (size_t k = 0; k < num_taps; ++k) {
+            acc_re += taps_re[k] * window_re[k] - taps_im[k] * window_im[k];
+            acc_im += taps_re[k] * window_im[k] + taps_im[k] * window_re[k];
+        }
+        
+        // Band-pass output back down to DC
+        output[produced++] = std::complex<float>(acc_re, acc_im) * mixer_.next();
+    }
+    
+    return produced;
+}
@@ -0,0 +1,75 @@
+#ifndef TRANSLATING_FIR_H
+#define TRANSLATING_FIR_H
+
+#include <vector>
+#include <complex>
+#include <cstddef>
+
+#include "decimating_fir.h"
+#include "nco.h"
+
+// Frequency-translating decimating FIR: brings the signal at `offset`
+// (cycles per input sample, -0.5 to 0.5) down to DC, low-pass filters and
+// decimates it in one pass. The low-pass taps are turned into a band-pass
+// centred on the offset, h[i] e^(j2pi offset (i - centre)), and only every
+// decimation-th output is evaluated and then rotated down to DC, so the
+// input is never mixed sample by sample: taps / decimation complex
+// multiply-adds per input sample, plus one rotation per output; the
+// rotations come from an Nco stepping once per output.
+//
+// setOffset() retunes without resetting: the mixer phase carries on from
+// where it was, so the output stays continuous.
+class TranslatingFIR {
+public:
+    TranslatingFIR();
+    
+    // Replaces the low-pass taps, decimation and offset and clears the
+    // filter state
+    bool configure(const std::vector<float>& taps, int decimation, double offset);
+    void reset();
+    
+    // Phase-continuous retune; no allocation
+    void setOffset(double offset);
+    double getOffset() const { return offset_; }
+    
+    // Carries on from a DecimatingFIR with the same taps and decimation:
+    // its delay line and phase, with the mixer at zero on the next
+    // output, so a channel moving off centre does not restart its filter.
+    // No allocation, for the processing thread.
+    bool takeOver(const DecimatingFIR& filter);
+    
+    // As DecimatingFIR::process(), output at DC
+    size_t process(const std::complex<float>* input, size_t count, std::complex<float>* output);
+    size_t maxOutput(size_t count) const { return (phase_ + count) / decimation_; }
+    
+    int getDecimation() const { return decimation_; }
+    size_t getNumTaps() const { return reversed_taps_.size(); }
+    
+    // Approximate real multiply-adds per input sample, to set against an
+    // Nco::mix() in front of the real taps (OverlapSaveFilter::directCost)
+    static float cost(size_t num_taps, int decimation);
+
+private:
+    void rotateTaps();
+    
+    // Low-pass taps reversed, and the band-pass split re/im in the same order
+    std::vector<float> reversed_taps_;
+    std::vector<float> taps_re_;
+    std::vector<float> taps_im_;
+    
+    // Split re/im delay lines, each 2 * taps long (as in DecimatingFIR)
+    std::vector<float> delay_re_;
+    std::vector<float> delay_im_;
+    size_t write_pos_;
+    
+    int decimation_;
+    int phase_;
+    
+    double offset_;
+    
+    // Rotates each output down by the mixer phase at its centre tap's
+    // sample: -offset * decimation cycles per output
+    Nco mixer_;
+};
+
+#endif // TRANSLATING_FIR_H
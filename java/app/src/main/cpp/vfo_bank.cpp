@@ -0,0 +1,313 @@
+#include "vfo_bank.h"
+#include <android/log.h>
+#include "async_logger.h"
+#include <algorithm>
+#include <cstdlib>
+
+#define LOG_TAG "VFO_Bank"
+#define LOGI(...) ASYNC_LOG(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+#define LOGE(...) ASYNC_LOG(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+#define LOGD(...) ASYNC_LOG(ANDROID_LOG_DEBUG, LOG_TAG, __VA_ARGS__)
+
+// Audio moved from a VFO's processor to its buffer per lock, after each block
+static const size_t DRAIN_SAMPLES = 1024;
+
+VfoBank::VfoBank()
+    : next_id_(0)
+    , sample_rate_(2048000)
+    , audio_sample_rate_(48000)
+    , generation_(0)
+    , executor_(nullptr)
+    , graph_dirty_(false)
+    , block_samples_(nullptr)
+    , block_count_(0) {
+    audio_.reserve(MAX_VFOS);
+}
+
+VfoBank::~VfoBank() = default;
+
+bool VfoBank::setSampleRate(int sample_rate_hz) {
+    if (sample_rate_hz <= 0) {
+        return false;
+    }
+    
+    std::lock_guard<std::mutex> lock(mutex_);
+    sample_rate_ = sample_rate_hz;
+    for (auto& vfo : vfos_) {
+        changeSampleRate(*vfo, sample_rate_hz);
+    }
+    generation_.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+bool VfoBank::setAudioSampleRate(int sample_rate_hz) {
+    if (sample_rate_hz <= 0) {
+        return false;
+    }
+    
+    std::lock_guard<std::mutex> lock(mutex_);
+    audio_sample_rate_ = sample_rate_hz;
+    for (auto& vfo : vfos_) {
+        vfo->processor.setAudioSampleRate(sample_rate_hz);
+    }
+    generation_.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+void VfoBank::setExecutor(DspExecutor* executor) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    executor_ = executor;
+    graph_dirty_ = true;
+}
+
+int VfoBank::addVfo(const VfoSettings& settings) {
+    // Built outside the lock: designing the filter takes a while and the
+    // processing thread should not wait for it
+    std::unique_ptr<Vfo> vfo = std::make_unique<Vfo>();
+    int sample_rate;
+    int audio_sample_rate;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        sample_rate = sample_rate_;
+        audio_sample_rate = audio_sample_rate_;
+    }
+    vfo->processor.setSampleRate(sample_rate);
+    vfo->processor.setAudioSampleRate(audio_sample_rate);
+    vfo->processor.setProfiler(&vfo->profiler);
+    vfo->audio = std::make_shared<AudioBuffer>();
+    vfo->audio->samples.resize(AUDIO_BUFFER_SAMPLES);
+    vfo->drain.resize(DRAIN_SAMPLES);
+    if (!applySettings(*vfo, settings)) {
+        return -1;
+    }
+    
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (static_cast<int>(vfos_.size()) >= MAX_VFOS) {
+        LOGE("All %d VFOs in use", MAX_VFOS);
+        return -1;
+    }
+    if (vfo->processor.getSampleRate() != sample_rate_) {
+        // The rate changed meanwhile
+        changeSampleRate(*vfo, sample_rate_);
+    }
+    vfo->id = next_id_++;
+    const int id = vfo->id;
+    {
+        std::lock_guard<std::mutex> audio_lock(audio_mutex_);
+        audio_.emplace_back(id, vfo->audio);
+    }
+    vfos_.push_back(std::move(vfo));
+    graph_dirty_ = true;
+    generation_.fetch_add(1, std::memory_order_relaxed);
+    
+    LOGI("VFO %d at %+d Hz, %d Hz wide, mode %d, squelch %d dB", id, settings.offset_hz,
+         settings.bandwidth_hz, static_cast<int>(settings.mode), settings.squelch_db);
+    return id;
+}
+
+bool VfoBank::updateVfo(int id, const VfoSettings& settings) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Vfo* vfo = find(id);
+    if (!vfo || !applySettings(*vfo, settings)) {
+        return false;
+    }
+    generation_.fetch_add(1, std::memory_order_relaxed);
+    LOGD("VFO %d now at %+d Hz, %d Hz wide, mode %d, squelch %d dB", id, settings.offset_hz,
+         settings.bandwidth_hz, static_cast<int>(settings.mode), settings.squelch_db);
+    return true;
+}
+
+bool VfoBank::removeVfo(int id) {
+    std::unique_ptr<Vfo> removed;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = std::find_if(vfos_.begin(), vfos_.end(),
+                               [id](const std::unique_ptr<Vfo>& vfo) { return vfo->id == id; });
+        if (it == vfos_.end()) {
+            return false;
+        }
+        removed = std::move(*it);
+        vfos_.erase(it);
+        {
+            std::lock_guard<std::mutex> audio_lock(audio_mutex_);
+            audio_.erase(std::find_if(audio_.begin(), audio_.end(),
+                                      [id](const std::pair<int, std::shared_ptr<AudioBuffer>>& entry) {
+                                          return entry.first == id;
+                                      }));
+        }
+        graph_dirty_ = true;
+        generation_.fetch_add(1, std::memory_order_relaxed);
+    }
+    
+    // Freed outside the lock
+    removed.reset();
+    LOGI("VFO %d removed", id);
+    return true;
+}
+
+bool VfoBank::getSettings(int id, VfoSettings& settings) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const Vfo* vfo = find(id);
+    if (!vfo) {
+        return false;
+    }
+    settings = vfo->settings;
+    return true;
+}
+
+std::vector<int> VfoBank::getIds() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<int> ids;
+    for (const auto& vfo : vfos_) {
+        ids.push_back(vfo->id);
+    }
+    return ids;
+}
+
+size_t VfoBank::size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return vfos_.size();
+}
+
+void VfoBank::process(const std::complex<float>* samples, size_t count) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (vfos_.empty() || count == 0) {
+        return;
+    }
+    
+    block_samples_ = samples;
+    block_count_ = count;
+    if (!executor_) {
+        for (auto& vfo : vfos_) {
+            runVfo(*vfo);
+        }
+        return;
+    }
+    
+    if (graph_dirty_) {
+        rebuildGraph();
+    }
+    executor_->run(graph_);
+}
+
+size_t VfoBank::readAudio(int id, float* output, size_t max_count) {
+    // Only this VFO's buffer lock: process() may be a whole block of DSP
+    // into mutex_
+    std::shared_ptr<AudioBuffer> audio = findAudio(id);
+    return audio ? audio->read(output, max_count) : 0;
+}
+
+bool VfoBank::getStats(int id, PipelineStats& stats) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const Vfo* vfo = find(id);
+    if (!vfo) {
+        return false;
+    }
+    stats = vfo->profiler.snapshot();
+    return true;
+}
+
+bool VfoBank::resetStats(int id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Vfo* vfo = find(id);
+    if (!vfo) {
+        return false;
+    }
+    vfo->profiler.reset();
+    return true;
+}
+
+bool VfoBank::applySettings(Vfo& vfo, const VfoSettings& settings) {
+    // The whole channel has to sit inside the capture
+    const int sample_rate = vfo.processor.getSampleRate();
+    if (settings.bandwidth_hz <= 0 ||
+        2 * static_cast<int64_t>(std::abs(settings.offset_hz)) + settings.bandwidth_hz > sample_rate) {
+        LOGE("VFO at %+d Hz, %d Hz wide, does not fit a %d Hz capture", settings.offset_hz,
+             settings.bandwidth_hz, sample_rate);
+        return false;
+    }
+    
+    // Bandwidth first: it restarts the filter, after which the offset
+    // only retunes it
+    if (settings.bandwidth_hz != vfo.processor.getBandwidth()) {
+        vfo.processor.setBandwidth(settings.bandwidth_hz);
+    }
+    vfo.processor.setFrequencyOffset(settings.offset_hz);
+    vfo.processor.setDemodulationType(settings.mode);
+    vfo.processor.setSquelch(settings.squelch_db);
+    vfo.settings = settings;
+    return true;
+}
+
+void VfoBank::changeSampleRate(Vfo& vfo, int sample_rate_hz) {
+    vfo.processor.setSampleRate(sample_rate_hz);
+    if (!vfo.processor.setFrequencyOffset(vfo.settings.offset_hz)) {
+        // Outside the narrower capture: parked at the centre
+        vfo.settings.offset_hz = 0;
+        vfo.processor.setFrequencyOffset(0);
+    }
+}
+
+void VfoBank::runVfo(Vfo& vfo) {
+    const int64_t start = PipelineProfiler::now();
+    vfo.processor.processSamples(block_samples_, block_count_);
+    
+    // The processor's own buffer is only ever read here, on the thread
+    // that writes it; readers get the block from vfo.audio
+    size_t count;
+    while ((count = vfo.processor.readAudioSamples(vfo.drain.data(), vfo.drain.size())) > 0) {
+        vfo.audio->write(vfo.drain.data(), count);
+    }
+    vfo.profiler.recordBlock(block_count_, sample_rate_, PipelineProfiler::now() - start);
+}
+
+VfoBank::Vfo* VfoBank::find(int id) const {
+    for (const auto& vfo : vfos_) {
+        if (vfo->id == id) {
+            return vfo.get();
+        }
+    }
+    return nullptr;
+}
+
+std::shared_ptr<VfoBank::AudioBuffer> VfoBank::findAudio(int id) const {
+    std::lock_guard<std::mutex> lock(audio_mutex_);
+    for (const auto& entry : audio_) {
+        if (entry.first == id) {
+            return entry.second;
+        }
+    }
+    return nullptr;
+}
+
+void VfoBank::AudioBuffer::write(const float* input, size_t count) {
+    std::lock_guard<std::mutex> lock(mutex);
+    const size_t capacity = samples.size();
+    for (size_t i = 0; i < count; ++i) {
+        samples[(write_count + i) % capacity] = input[i];
+    }
+    write_count += count;
+    if (write_count - read_count > capacity) {
+        read_count = write_count - capacity;
+    }
+}
+
+size_t VfoBank::AudioBuffer::read(float* output, size_t max_count) {
+    std::lock_guard<std::mutex> lock(mutex);
+    const size_t capacity = samples.size();
+    const size_t count = static_cast<size_t>(std::min<uint64_t>(write_count - read_count, max_count));
+    for (size_t i = 0; i < count; ++i) {
+        output[i] = samples[(read_count + i) % capacity];
+    }
+    read_count += count;
+    return count;
+}
+
+void VfoBank::rebuildGraph() {
+    graph_.clear();
+    for (auto& vfo : vfos_) {
+        Vfo* target = vfo.get();
+        graph_.addTask("vfo", [this, target]() { runVfo(*target); });
+    }
+    graph_dirty_ = false;
+}
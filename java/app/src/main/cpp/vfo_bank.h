@@ -0,0 +1,132 @@
+#ifndef VFO_BANK_H
+#define VFO_BANK_H
+
+#include <vector>
+#include <complex>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <cstdint>
+#include <utility>
+
+#include "demodulator.h"
+#include "dsp_executor.h"
+#include "pipeline_profiler.h"
+#include "signal_processor.h"
+
+// One virtual receiver inside the capture
+struct VfoSettings {
+    int offset_hz = 0;              // from the tuned frequency
+    int bandwidth_hz = 12500;
+    DemodulationType mode = DemodulationType::FM;
+    int squelch_db = -50;
+};
+
+// Several receivers on the same IQ blocks, each a SignalProcessor on its
+// own offset with its own bandwidth, mode, squelch and audio buffer. Each
+// brings its channel down to DC with an NCO ahead of its filter, or with
+// translating taps where those cost less, with no tuner retune.
+//
+// VFOs can be added, changed and removed from any thread while process()
+// runs on the processing thread; a change waits for the block in flight.
+// An offset change on its own is phase-continuous. Every VFO times its
+// blocks and stages into a PipelineProfiler of its own.
+//
+// Each VFO's audio leaves process() through a buffer with its own lock,
+// held only to copy samples in or out, so readAudio() never waits for the
+// bank's DSP.
+class VfoBank {
+public:
+    VfoBank();
+    ~VfoBank();
+    
+    // Applied to every VFO, present and future
+    bool setSampleRate(int sample_rate_hz);
+    bool setAudioSampleRate(int sample_rate_hz);
+    
+    // VFOs run as tasks on executor, or one after another on the caller
+    // without one (the default)
+    void setExecutor(DspExecutor* executor);
+    
+    // Returns the new VFO's id, or -1 when MAX_VFOS are running or the
+    // settings do not fit the capture
+    int addVfo(const VfoSettings& settings);
+    bool updateVfo(int id, const VfoSettings& settings);
+    bool removeVfo(int id);
+    bool getSettings(int id, VfoSettings& settings) const;
+    std::vector<int> getIds() const;
+    size_t size() const;
+    
+    // Bumped by every add, update and remove: buffers may grow again in
+    // the blocks after one
+    uint64_t generation() const { return generation_.load(std::memory_order_relaxed); }
+    
+    // Every VFO on one block
+    void process(const std::complex<float>* samples, size_t count);
+    
+    // As SignalProcessor::readAudioSamples() for one VFO; 0 for an unknown
+    // id. Does not take the bank lock.
+    size_t readAudio(int id, float* output, size_t max_count);
+    
+    // The VFO's share of the real-time budget, per stage and whole blocks
+    bool getStats(int id, PipelineStats& stats) const;
+    bool resetStats(int id);
+    
+    static const int MAX_VFOS = 16;
+    
+    // Per VFO, as SignalProcessor's own buffer; the oldest audio goes
+    // first when a reader falls this far behind
+    static const size_t AUDIO_BUFFER_SAMPLES = 8192;
+
+private:
+    // Ring from the VFO's task to its readers; shared so a read in flight
+    // outlives removeVfo()
+    struct AudioBuffer {
+        std::mutex mutex;
+        std::vector<float> samples;
+        uint64_t read_count = 0;
+        uint64_t write_count = 0;
+        
+        void write(const float* input, size_t count);
+        size_t read(float* output, size_t max_count);
+    };
+    
+    struct Vfo {
+        int id;
+        VfoSettings settings;
+        SignalProcessor processor;
+        PipelineProfiler profiler;
+        std::shared_ptr<AudioBuffer> audio;
+        std::vector<float> drain;   // the processor's audio, on its way to audio
+    };
+    
+    bool applySettings(Vfo& vfo, const VfoSettings& settings);
+    void changeSampleRate(Vfo& vfo, int sample_rate_hz);
+    void runVfo(Vfo& vfo);
+    Vfo* find(int id) const;
+    std::shared_ptr<AudioBuffer> findAudio(int id) const;
+    void rebuildGraph();
+    
+    mutable std::mutex mutex_;
+    std::vector<std::unique_ptr<Vfo>> vfos_;
+    int next_id_;
+    int sample_rate_;
+    int audio_sample_rate_;
+    std::atomic<uint64_t> generation_;
+    
+    // Every VFO's audio buffer by id, for readAudio(); changed with mutex_
+    // held as well, taken alone only for the lookup
+    mutable std::mutex audio_mutex_;
+    std::vector<std::pair<int, std::shared_ptr<AudioBuffer>>> audio_;
+    
+    // One task per VFO, rebuilt on the next block after the set changes
+    DspExecutor* executor_;
+    TaskGraph graph_;
+    bool graph_dirty_;
+    
+    // The block process() is running, for the tasks
+    const std::complex<float>* block_samples_;
+    size_t block_count_;
+};
+
+#endif // VFO_BANK_H
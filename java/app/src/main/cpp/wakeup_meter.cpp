@@ -0,0 +1,34 @@
+#include "wakeup_meter.h"
+#include <chrono>
+
+namespace {
+
+int64_t nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+} // namespace
+
+WakeupMeter::WakeupMeter()
+    : count_(0)
+    , last_count_(0)
+    , last_time_ns_(nowNs()) {
+}
+
+double WakeupMeter::ratePerSecond() {
+    const uint64_t count = total();
+    const int64_t now = nowNs();
+    const int64_t elapsed = now - last_time_ns_;
+    const double rate = elapsed > 0 ? (count - last_count_) * 1e9 / elapsed : 0.0;
+    
+    last_count_ = count;
+    last_time_ns_ = now;
+    return rate;
+}
+
+void WakeupMeter::reset() {
+    count_.store(0, std::memory_order_relaxed);
+    last_count_ = 0;
+    last_time_ns_ = nowNs();
+}
@@ -0,0 +1,29 @@
+#ifndef WAKEUP_METER_H
+#define WAKEUP_METER_H
+
+#include <atomic>
+#include <cstdint>
+
+// Counts the times a worker thread wakes up, so a rate can confirm the
+// device idles when no data flows. The thread itself ticks once per
+// wakeup; one reader at a time samples the rate.
+class WakeupMeter {
+public:
+    WakeupMeter();
+    
+    void tick() { count_.fetch_add(1, std::memory_order_relaxed); }
+    
+    uint64_t total() const { return count_.load(std::memory_order_relaxed); }
+    
+    // Wakeups per second since the previous call (or reset())
+    double ratePerSecond();
+    
+    void reset();
+
+private:
+    std::atomic<uint64_t> count_;
+    uint64_t last_count_;
+    int64_t last_time_ns_;
+};
+
+#endif // WAKEUP_METER_H
@@ -0,0 +1,80 @@
+#include "waterfall_buffer.h"
+#include <algorithm>
+#include <cstring>
+
+WaterfallBuffer::WaterfallBuffer()
+    : width_(0)
+    , height_(0)
+    , sequence_(0)
+    , first_(0)
+    , min_db_(-100.0f)
+    , max_db_(60.0f)
+    , scale_(255.0f / 160.0f) {
+}
+
+void WaterfallBuffer::configure(int width, int height) {
+    width_ = std::max(0, width);
+    height_ = std::max(1, height);
+    storage_.assign(static_cast<size_t>(width_) * height_, 0);
+    first_ = sequence_;
+}
+
+void WaterfallBuffer::setRange(float min_db, float max_db) {
+    if (max_db <= min_db) {
+        return;
+    }
+    min_db_ = min_db;
+    max_db_ = max_db;
+    scale_ = 255.0f / (max_db - min_db);
+}
+
+void WaterfallBuffer::push(const float* row_db) {
+    uint8_t* row = &storage_[(sequence_ % height_) * width_];
+    
+    for (int i = 0; i < width_; ++i) {
+        float level = (row_db[i] - min_db_) * scale_ + 0.5f;
+        level = std::max(0.0f, std::min(255.0f, level));
+        row[i] = static_cast<uint8_t>(level);
+    }
+    
+    ++sequence_;
+}
+
+const uint8_t* WaterfallBuffer::rowAt(uint64_t sequence) const {
+    return &storage_[(sequence % height_) * width_];
+}
+
+uint64_t WaterfallBuffer::copyRowsSince(uint64_t since_sequence, std::vector<uint8_t>& out) const {
+    uint64_t oldest = std::max(first_, sequence_ > static_cast<uint64_t>(height_) ? sequence_ - height_ : 0);
+    uint64_t first = std::max(since_sequence, oldest);
+    
+    if (first >= sequence_) {
+        out.clear();
+        return sequence_;
+    }
+    
+    out.resize(static_cast<size_t>(sequence_ - first) * width_);
+    
+    uint8_t* dst = out.data();
+    for (uint64_t seq = first; seq < sequence_; ++seq) {
+        std::memcpy(dst, rowAt(seq), width_);
+        dst += width_;
+    }
+    
+    return sequence_;
+}
+
+void WaterfallBuffer::copyAllDb(std::vector<float>& out) const {
+    uint64_t rows = std::min<uint64_t>(sequence_ - first_, height_);
+    out.resize(static_cast<size_t>(rows) * width_);
+    
+    const float step = 1.0f / scale_;
+    float* dst = out.data();
+    for (uint64_t n = 0; n < rows; ++n) {
+        const uint8_t* row = rowAt(sequence_ - 1 - n);
+        for (int i = 0; i < width_; ++i) {
+            dst[i] = min_db_ + row[i] * step;
+        }
+        dst += width_;
+    }
+}
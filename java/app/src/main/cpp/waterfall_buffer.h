@@ -0,0 +1,51 @@
+#ifndef WATERFALL_BUFFER_H
+#define WATERFALL_BUFFER_H
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+// Fixed-memory circular waterfall. Rows are stored quantized to 8 bits
+// over [min_db, max_db]. Every pushed row gets a sequence number, so
+// readers can fetch just the rows they have not seen yet.
+// Not thread-safe; the owner serializes access.
+class WaterfallBuffer {
+public:
+    WaterfallBuffer();
+    
+    // Reallocates storage and drops all rows; sequence numbers carry on,
+    // so a reader's last sequence never points past the new rows
+    void configure(int width, int height);
+    void setRange(float min_db, float max_db);
+    
+    void push(const float* row_db);
+    
+    // Copies rows with sequence >= since_sequence (oldest first) into out,
+    // which is resized to rows * width. Rows that already fell out of the
+    // ring are skipped. Returns the sequence to pass on the next call.
+    uint64_t copyRowsSince(uint64_t since_sequence, std::vector<uint8_t>& out) const;
+    
+    // Dequantized copy of all rows, newest first
+    void copyAllDb(std::vector<float>& out) const;
+    
+    int getWidth() const { return width_; }
+    int getHeight() const { return height_; }
+    uint64_t getSequence() const { return sequence_; }
+    float getMinDb() const { return min_db_; }
+    float getMaxDb() const { return max_db_; }
+    
+private:
+    const uint8_t* rowAt(uint64_t sequence) const;
+    
+    int width_;
+    int height_;
+    std::vector<uint8_t> storage_;
+    uint64_t sequence_;  // Rows ever pushed
+    uint64_t first_;     // Sequence of the first row since configure()
+    
+    float min_db_;
+    float max_db_;
+    float scale_;        // Quantization steps per dB
+};
+
+#endif // WATERFALL_BUFFER_H
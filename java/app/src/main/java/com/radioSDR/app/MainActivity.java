@@ -100,13 +100,24 @@ public class MainActivity extends AppCompatActivity {
     // public native boolean initRTLSDR(int fd);
     // public native void closeRTLSDR();
     // public native boolean setFrequency(double freq);
+    // public native boolean setTuningOffset(int offsetHz);
     // public native boolean setGain(int gain);
     // public native boolean setAutoGain(boolean enable);
     // public native boolean setSampleRate(int rate);
+    // public native boolean setAudioSampleRate(int rate);
     // public native boolean startReading();
     // public native void stopReading();
     // public native float[] getSpectrumData();
     // public native short[] getAudioData();
+    // public native float[] getAudioClockStats();
+    // public native float[] getLatencyStats();
+    // public native float[] getPipelineStats();
+    // public native float[] getWakeupRates();
+    // public native int addVfo(int offsetHz, int bandwidthHz, int mode, int squelchDb);
+    // public native boolean updateVfo(int id, int offsetHz, int bandwidthHz, int mode, int squelchDb);
+    // public native boolean removeVfo(int id);
+    // public native short[] getVfoAudio(int id);
+    // public native float[] getVfoStats(int id);
     
     // Métodos stub para teste
     public boolean initRTLSDR(int fd) { return true; }
@@ -119,6 +130,10 @@ public class MainActivity extends AppCompatActivity {
     public void stopReading() { }
     public float[] getSpectrumData() { return new float[0]; }
     public short[] getAudioData() { return new short[0]; }
+    public float[] getAudioClockStats() { return new float[0]; }
+    public float[] getLatencyStats() { return new float[0]; }
+    public float[] getPipelineStats() { return new float[0]; }
+    public float[] getWakeupRates() { return new float[0]; }
     
     public enum DemodulationType {
         FM, AM, USB, LSB
@@ -26,6 +26,13 @@ public class SettingsActivity extends AppCompatActivity {
     public native boolean setFrequencyCorrection(int ppm);
     public native boolean setBandwidth(int bandwidth);
     public native boolean setSquelch(int squelch);
+    public native void setFixedPointProcessing(boolean enable);
+    public native void setDriftCompensation(boolean enable);
+    
+    // mode: 0 inline (one thread), 1 staged (demod, spectrum and output threads)
+    public native void setPipelineMode(int mode);
+    // thread: 0 ingest, 1 demod, 2 spectrum, 3 output; cores: 0 any, 1 little, 2 big
+    public native void setThreadPlacement(int thread, int cores, int nice);
     
     @Override
     protected void onCreate(Bundle savedInstanceState) {
@@ -26,9 +26,24 @@ public class SpectrumActivity extends AppCompatActivity {
     private Handler updateHandler;
     private Runnable updateRunnable;
     
+    // Waterfall history kept here and topped up with the rows added since
+    // the last poll, so an update copies only new rows out of native code.
+    // Rows are quantized over WaterfallBuffer's default dB range.
+    private static final int WATERFALL_ROWS = 100;
+    private static final float WATERFALL_MIN_DB = -100f;
+    private static final float WATERFALL_MAX_DB = 60f;
+    private byte[] waterfallRows = new byte[0];
+    private int waterfallWidth = 0;
+    private int waterfallHead = 0;      // slot of the next row
+    private int waterfallCount = 0;
+    private long waterfallSequence = 0;
+    private final long[] waterfallState = new long[2];   // next sequence, row width
+    
     // Native methods (same as MainActivity)
     public native float[] getSpectrumData();
-    public native float[] getWaterfallData();
+    public native byte[] getWaterfallRows(long sinceSequence, long[] stateOut);
+    public native void setWaterfallHeight(int rows);
+    public native boolean setWelchAveraging(boolean enable, int overlapPercent, int segments);
     
     @Override
     protected void onCreate(Bundle savedInstanceState) {
@@ -45,6 +60,7 @@ public class SpectrumActivity extends AppCompatActivity {
         
         initViews();
         setupCharts();
+        setWaterfallHeight(WATERFALL_ROWS);
         startUpdates();
     }
     
@@ -142,11 +158,46 @@ public class SpectrumActivity extends AppCompatActivity {
     }
     
     private void updateWaterfall() {
-        float[] waterfallData = getWaterfallData();
-        if (waterfallData != null && waterfallData.length > 0) {
-            List<Entry> entries = new ArrayList<>();
-            for (int i = 0; i < waterfallData.length; i++) {
-                entries.add(new Entry(i, waterfallData[i]));
+        // Rows and width come from one locked read, so an FFT size change
+        // between polls shows up here even when the byte count still
+        // divides evenly by the old width
+        byte[] rows = getWaterfallRows(waterfallSequence, waterfallState);
+        waterfallSequence = waterfallState[0];
+        int width = (int) waterfallState[1];
+        if (width <= 0) {
+            return;
+        }
+        if (width != waterfallWidth) {
+            // New FFT size: the old rows no longer line up. The native
+            // buffer dropped its rows too, so the ones just returned are
+            // all at the new width.
+            waterfallWidth = width;
+            waterfallRows = new byte[WATERFALL_ROWS * width];
+            waterfallHead = 0;
+            waterfallCount = 0;
+        }
+        if (rows == null) {
+            return;
+        }
+        
+        int newRows = rows.length / width;
+        int first = Math.max(0, newRows - WATERFALL_ROWS);
+        for (int r = first; r < newRows; r++) {
+            System.arraycopy(rows, r * width, waterfallRows, waterfallHead * width, width);
+            waterfallHead = (waterfallHead + 1) % WATERFALL_ROWS;
+        }
+        waterfallCount = Math.min(WATERFALL_ROWS, waterfallCount + newRows - first);
+        
+        if (waterfallCount > 0) {
+            // Newest row first, back in dB
+            float step = (WATERFALL_MAX_DB - WATERFALL_MIN_DB) / 255f;
+            List<Entry> entries = new ArrayList<>(waterfallCount * width);
+            int i = 0;
+            for (int n = 0; n < waterfallCount; n++) {
+                int base = ((waterfallHead - 1 - n + WATERFALL_ROWS) % WATERFALL_ROWS) * width;
+                for (int k = 0; k < width; k++) {
+                    entries.add(new Entry(i++, WATERFALL_MIN_DB + (waterfallRows[base + k] & 0xff) * step));
+                }
             }
             
             LineDataSet dataSet = new LineDataSet(entries, "Waterfall");
@@ -0,0 +1,23 @@
+#ifndef FM_DISCRIMINATOR_H
+#define FM_DISCRIMINATOR_H
+
+#include <cstddef>
+
+// Níveis de precisão do discriminador FM, do mais ao menos exato
+enum class DiscriminatorAccuracy {
+    EXACT = 0,      // atan2f por amostra; referência
+    POLYNOMIAL = 1, // atan2 minimax sem desvios, erro abaixo de 2e-6 rad
+    QUADRATURE = 2  // atraso em quadratura sem atan: seno do passo de fase
+};
+
+// Passo de fase entre amostras consecutivas, em radianos (-pi, pi]:
+//   out[k] = arg(x[k] * conj(x[k-1])), x = i + jq
+// x[-1] vem de prev_i/prev_q, que saem com a última amostra do bloco.
+// Sem diferença de fases, não há laço de normalização para +-pi.
+// POLYNOMIAL e QUADRATURE compilam para 4 (NEON) amostras por iteração;
+// QUADRATURE fica 1% abaixo em 0,25 rad, o que cobre o FM comercial
+// (75 kHz) na taxa cheia de 2048000 Hz.
+void discriminate_fm(const float* i, const float* q, size_t count,
+                     float& prev_i, float& prev_q, float* out, DiscriminatorAccuracy accuracy);
+
+#endif // FM_DISCRIMINATOR_H
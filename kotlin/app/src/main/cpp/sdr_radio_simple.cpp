@@ -1,5 +1,6 @@
 #include <jni.h>
 #include <android/log.h>
+#include "async_logger.h"
 #include <SLES/OpenSLES.h>
 #include <SLES/OpenSLES_Android.h>
 #include <pthread.h>
@@ -12,9 +13,12 @@
 #include <sstream>
 #include <iomanip>
 
+#include "fm_discriminator.h"
+
 #define LOG_TAG "SDRRadio"
-#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
-#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+#define LOGI(...) ASYNC_LOG(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+#define LOGE(...) ASYNC_LOG(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+#define LOGD(...) ASYNC_LOG(ANDROID_LOG_DEBUG, LOG_TAG, __VA_ARGS__)
 
 // Estrutura para dados de áudio
 struct AudioData {
@@ -49,6 +53,16 @@ private:
     std::queue<AudioData> audio_queue;
     std::vector<float> frequency_spectrum;
     
+    // Discriminador FM: precisão, última amostra do bloco anterior e buffers I/Q
+    DiscriminatorAccuracy fm_accuracy;
+    float fm_prev_i;
+    float fm_prev_q;
+    std::vector<float> fm_i;
+    std::vector<float> fm_q;
+    
+    // Áudio demodulado do bloco atual; só cresce, sem alocar por bloco
+    std::vector<float> audio_scratch;
+    
     // Callbacks
     jobject java_callback;
     JavaVM* jvm;
@@ -61,8 +75,8 @@ private:
     void update_frequency_spectrum();
     void save_audio_data(const AudioData& data);
     void process_audio_data(const std::vector<uint8_t>& rf_data);
-    std::vector<float> demodulate_am(const std::vector<uint8_t>& rf_data);
-    std::vector<float> demodulate_fm(const std::vector<uint8_t>& rf_data);
+    size_t demodulate_am(const std::vector<uint8_t>& rf_data, float* audio_samples);
+    size_t demodulate_fm(const std::vector<uint8_t>& rf_data, float* audio_samples);
     
 public:
     SDRRadio();
@@ -79,6 +93,7 @@ public:
     bool set_gain(int gain);
     bool set_auto_gain(bool enabled);
     bool set_ppm_error(int ppm);
+    bool set_fm_accuracy(int accuracy);
     
     // Scanning and recording
     bool start_scanning();
@@ -96,7 +111,9 @@ public:
     void notify_java_callback(const char* event, const char* data);
 };
 
-SDRRadio::SDRRadio() : is_connected(false), is_scanning(false), is_recording(false), java_callback(nullptr), jvm(nullptr) {
+SDRRadio::SDRRadio() : is_connected(false), is_scanning(false), is_recording(false),
+                       fm_accuracy(DiscriminatorAccuracy::POLYNOMIAL), fm_prev_i(0.0f), fm_prev_q(0.0f),
+                       java_callback(nullptr), jvm(nullptr) {
     // Inicializar configuração padrão
     config.sample_rate = 2048000;  // 2.048 MHz
     config.center_freq = 100000000; // 100 MHz
@@ -242,10 +259,13 @@ void* SDRRadio::scan_thread_func(void* arg) {
 void* SDRRadio::audio_thread_func(void* arg) {
     SDRRadio* radio = static_cast<SDRRadio*>(arg);
     
+    // Buffer RF reutilizado entre os blocos
+    std::vector<uint8_t> rf_data;
+    rf_data.reserve(2048);
+    
     while (radio->is_recording) {
         // Simular dados RF recebidos
-        std::vector<uint8_t> rf_data;
-        rf_data.reserve(2048);
+        rf_data.clear();
         
         // Gerar dados RF simulados (I/Q samples)
         for (int i = 0; i < 2048; i += 2) {
@@ -331,21 +351,24 @@ void SDRRadio::save_audio_data(const AudioData& data) {
 void SDRRadio::process_audio_data(const std::vector<uint8_t>& rf_data) {
     if (rf_data.empty()) return;
     
-    // Demodular os dados RF em áudio
-    std::vector<float> audio_samples;
+    // Demodular os dados RF em áudio, no scratch do objeto
+    if (audio_scratch.size() < rf_data.size() / 2) {
+        audio_scratch.resize(rf_data.size() / 2);
+    }
     
     // Tentar demodulação AM primeiro (mais comum para rádio)
-    audio_samples = demodulate_am(rf_data);
+    size_t audio_count = demodulate_am(rf_data, audio_scratch.data());
     
     // Se não houver sinal AM, tentar FM
-    if (audio_samples.empty()) {
-        audio_samples = demodulate_fm(rf_data);
+    if (audio_count == 0) {
+        audio_count = demodulate_fm(rf_data, audio_scratch.data());
     }
     
-    if (!audio_samples.empty()) {
-        // Criar estrutura de dados de áudio
+    if (audio_count > 0) {
+        // Criar estrutura de dados de áudio; a fila de gravação guarda
+        // sua própria cópia
         AudioData audio_data;
-        audio_data.samples = audio_samples;
+        audio_data.samples.assign(audio_scratch.begin(), audio_scratch.begin() + audio_count);
         audio_data.frequency = config.center_freq;
         audio_data.signal_strength = get_signal_strength();
         audio_data.timestamp = time(nullptr);
@@ -355,13 +378,13 @@ void SDRRadio::process_audio_data(const std::vector<uint8_t>& rf_data) {
         audio_queue.push(audio_data);
         pthread_mutex_unlock(&data_mutex);
         
-        LOGI("Processed audio data: %zu samples", audio_samples.size());
+        // Um por bloco: no máximo um registro por segundo, e só em debug
+        ASYNC_LOG_RATE(ANDROID_LOG_DEBUG, 1, LOG_TAG, "Processed audio data: %zu samples", audio_count);
     }
 }
 
-std::vector<float> SDRRadio::demodulate_am(const std::vector<uint8_t>& rf_data) {
-    std::vector<float> audio_samples;
-    audio_samples.reserve(rf_data.size() / 2);
+size_t SDRRadio::demodulate_am(const std::vector<uint8_t>& rf_data, float* audio_samples) {
+    size_t count = 0;
     
     // Demodulação AM simples (envelope detection)
     for (size_t i = 0; i < rf_data.size() - 1; i += 2) {
@@ -381,36 +404,33 @@ std::vector<float> SDRRadio::demodulate_am(const std::vector<uint8_t>& rf_data)
         float audio_sample = (filtered - 0.5f) * 2.0f; // Centralizar em 0
         audio_sample = std::max(-1.0f, std::min(1.0f, audio_sample)); // Clipping
         
-        audio_samples.push_back(audio_sample);
+        audio_samples[count++] = audio_sample;
     }
     
-    return audio_samples;
+    return count;
 }
 
-std::vector<float> SDRRadio::demodulate_fm(const std::vector<uint8_t>& rf_data) {
-    std::vector<float> audio_samples;
-    audio_samples.reserve(rf_data.size() / 2);
+size_t SDRRadio::demodulate_fm(const std::vector<uint8_t>& rf_data, float* audio_samples) {
+    const size_t count = rf_data.size() / 2;
     
-    // Demodulação FM simples (discriminador de frequência)
-    float prev_phase = 0.0f;
+    // Converter bytes para valores I/Q
+    fm_i.resize(count);
+    fm_q.resize(count);
+    for (size_t k = 0; k < count; ++k) {
+        fm_i[k] = (float)((int8_t)rf_data[2 * k]) / 128.0f;
+        fm_q[k] = (float)((int8_t)rf_data[2 * k + 1]) / 128.0f;
+    }
     
-    for (size_t i = 0; i < rf_data.size() - 1; i += 2) {
-        // Converter bytes para valores I/Q
-        float i_val = (float)((int8_t)rf_data[i]) / 128.0f;
-        float q_val = (float)((int8_t)rf_data[i + 1]) / 128.0f;
-        
-        // Calcular fase atual
-        float phase = atan2f(q_val, i_val);
-        
-        // Calcular diferença de fase
-        float phase_diff = phase - prev_phase;
-        
-        // Normalizar diferença de fase
-        while (phase_diff > M_PI) phase_diff -= 2 * M_PI;
-        while (phase_diff < -M_PI) phase_diff += 2 * M_PI;
+    // Demodulação FM (discriminador de frequência): diferença de fase
+    // entre amostras consecutivas, continuando do bloco anterior
+    discriminate_fm(fm_i.data(), fm_q.data(), count, fm_prev_i, fm_prev_q,
+                    audio_samples, fm_accuracy);
+    
+    for (size_t k = 0; k < count; ++k) {
+        float& sample = audio_samples[k];
         
         // Converter diferença de fase em áudio
-        float audio_sample = phase_diff * 0.5f; // Escalar para áudio
+        float audio_sample = sample * 0.5f; // Escalar para áudio
         
         // Aplicar filtro passa-baixa
         static float prev_sample = 0.0f;
@@ -418,13 +438,10 @@ std::vector<float> SDRRadio::demodulate_fm(const std::vector<uint8_t>& rf_data)
         prev_sample = filtered;
         
         // Clipping
-        filtered = std::max(-1.0f, std::min(1.0f, filtered));
-        
-        audio_samples.push_back(filtered);
-        prev_phase = phase;
+        sample = std::max(-1.0f, std::min(1.0f, filtered));
     }
     
-    return audio_samples;
+    return count;
 }
 
 bool SDRRadio::set_sample_rate(uint32_t rate) {
@@ -458,6 +475,13 @@ bool SDRRadio::set_ppm_error(int ppm) {
     return true;
 }
 
+bool SDRRadio::set_fm_accuracy(int accuracy) {
+    if (accuracy < 0 || accuracy > 2) return false;
+    fm_accuracy = static_cast<DiscriminatorAccuracy>(accuracy);
+    LOGI("FM discriminator accuracy set to %d", accuracy);
+    return true;
+}
+
 std::vector<float> SDRRadio::get_frequency_spectrum() {
     pthread_mutex_lock(&data_mutex);
     std::vector<float> spectrum = frequency_spectrum;
@@ -624,6 +648,14 @@ JNIEXPORT jboolean JNICALL Java_com_sdrradio_kt_SDRRadio_nativeSetModulation(JNI
     return JNI_FALSE;
 }
 
+JNIEXPORT jboolean JNICALL Java_com_sdrradio_kt_SDRRadio_nativeSetFmAccuracy(JNIEnv* env, jobject thiz, jlong ptr, jint accuracy) {
+    SDRRadio* radio = reinterpret_cast<SDRRadio*>(ptr);
+    if (radio) {
+        return radio->set_fm_accuracy(accuracy) ? JNI_TRUE : JNI_FALSE;
+    }
+    return JNI_FALSE;
+}
+
 JNIEXPORT jdouble JNICALL Java_com_sdrradio_kt_SDRRadio_nativeGetSignalStrength(JNIEnv* env, jobject thiz, jlong ptr) {
     SDRRadio* radio = reinterpret_cast<SDRRadio*>(ptr);
     if (radio) {
@@ -148,6 +148,11 @@ class SDRRadio {
         return nativeSetModulation(nativePtr, modulation)
     }
     
+    // Discriminador FM: 0 = atan2 exato, 1 = polinomial (padrão), 2 = quadratura sem atan
+    fun setFmAccuracy(accuracy: Int): Boolean {
+        return nativeSetFmAccuracy(nativePtr, accuracy)
+    }
+    
     fun getSignalStrength(): Double {
         return nativeGetSignalStrength(nativePtr)
     }
@@ -221,6 +226,7 @@ class SDRRadio {
     private external fun nativeStopAudioPlayback(ptr: Long)
     private external fun nativeSetAudioVolume(ptr: Long, volume: Float): Boolean
     private external fun nativeSetModulation(ptr: Long, modulation: String): Boolean
+    private external fun nativeSetFmAccuracy(ptr: Long, accuracy: Int): Boolean
     private external fun nativeGetSignalStrength(ptr: Long): Double
     private external fun nativeGetSpectrum(ptr: Long): FloatArray?
     
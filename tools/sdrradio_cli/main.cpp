@@ -0,0 +1,2397 @@
+// sdrradio_cli - headless runner for the native DSP chain.
+//
+// Runs source -> filter -> demod -> audio sink on Linux so the hot paths can
+// be timed and profiled (perf record ./sdrradio_cli ...) off-device.
+
+#include <android/log.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "allocation_counter.h"
+#include "async_logger.h"
+#include "audio_processor.h"
+#include "channel_bank.h"
+#include "decimating_fir.h"
+#include "dsp_executor.h"
+#include "iq_converter.h"
+#include "latency_tracer.h"
+#include "nco.h"
+#include "overlap_save_filter.h"
+#include "pipeline_profiler.h"
+#include "pipelines.h"
+#include "polyphase_channelizer.h"
+#include "rtlsdr_simulated.h"
+#include "sample_ring.h"
+#include "signal_processor.h"
+#include "sinks.h"
+#include "sources.h"
+#include "spectrum_analyzer.h"
+#include "thread_placement.h"
+#include "translating_fir.h"
+#include "vfo_bank.h"
+#include "wakeup_meter.h"
+
+namespace {
+
+struct Options {
+    std::string source;             // empty: sim, or fm for --compare-fixed --demod fm
+    std::string sink = "null";
+    std::string pipeline = "core";
+    PipelineConfig config;
+    double seconds = 10.0;
+    size_t block_bytes = 16384 * 2;
+    bool verbose = false;
+    bool compare_fixed = false;
+    bool compare_staged = false;
+    bool compare_threading = false;
+    bool check_allocations = false;
+    bool check_ring = false;
+    bool check_drift = false;
+    bool check_log = false;
+    bool check_idle = false;
+    bool check_executor = false;
+    int check_channelizer = 0;
+    bool check_vfo = false;
+    bool check_nco = false;
+    bool check_fm = false;
+    int vfos = 4;
+    int channels = 20;
+    int workers = -1;
+    bool latency = false;
+    bool stats = false;
+    double drift_ppm = 0.0;
+    double tolerance_db = -1.0;     // below 0: the comparison's own
+    int tolerance_lsb = -1;
+};
+
+// What a --compare-* run must reach: SNR of the candidate against the
+// reference and, when set, a bound on the 99.9th percentile of the
+// per-sample error, which a few bad samples cannot hide behind
+struct CompareTolerance {
+    double snr_db;
+    int p999_lsb;   // 0: not checked
+};
+
+const CompareTolerance DEFAULT_TOLERANCE = {25.0, 0};
+
+// Q15 against float: AM and SSB on the simulated signal and FM on the fm
+// source measure 70-76 dB with the 99.9th percentile under 20 LSB. FM
+// runs on the fm source because the simulated dongle's I == Q carrier
+// turns by exactly pi at every envelope zero, where the sign of the
+// discriminator output is undefined and the two paths pick either one.
+const CompareTolerance FIXED_TOLERANCE = {55.0, 128};
+
+// Blocks processed before --check-allocations starts counting, enough for
+// every lazily sized buffer to reach its final size
+const uint64_t WARMUP_BLOCKS = 8;
+
+void printUsage(const char* argv0) {
+    std::fprintf(stderr,
+        "usage: %s [options]\n"
+        "  --source sim|fm[:DEV_HZ]|file:PATH  IQ source (u8 interleaved), default sim\n"
+        "                            (fm for --compare-fixed --demod fm); fm is a 1 kHz\n"
+        "                            tone at DEV_HZ deviation, default 75000\n"
+        "  --sink null|wav:PATH|clocked[:BUFFERS[:FRAMES[:MAX_MS]]]\n"
+        "                            audio sink, default null; clocked plays out at\n"
+        "                            wall-clock rate like AudioManager (default\n"
+        "                            3:512:200) and paces the source to the SDR rate\n"
+        "  --pipeline core|cpp-audio DSP chain, default core (java/ native core)\n"
+        "  --demod fm|am|usb|lsb     demodulation, default fm\n"
+        "  --rate HZ                 SDR sample rate, default 2048000\n"
+        "  --bandwidth HZ            channel filter bandwidth, default 200000\n"
+        "  --offset HZ               core: receive HZ from the tuned frequency, default 0\n"
+        "  --channel-filter auto|direct|fft  channel filter form, default auto\n"
+        "  --fm-discriminator exact|poly|quadrature  FM discriminator tier, default poly\n"
+        "  --fixed-point             Q15 channel filter and demodulator\n"
+        "  --compare-fixed           run float and fixed-point side by side and\n"
+        "                            compare their audio (exit 1 below tolerance)\n"
+        "  --staged                  cpp-audio: one full pass per stage instead of fused tiles\n"
+        "  --compare-staged          run cpp-audio staged and fused side by side and\n"
+        "                            compare their audio (exit 1 below tolerance)\n"
+        "  --threading inline|staged core: one thread, or spectrum and audio output on\n"
+        "                            threads of their own (PipelineMode), default inline\n"
+        "  --placement T=CORES[:NICE],...  core, staged: cores (any|little|big) and nice\n"
+        "                            value per thread T (demod, spectrum, output)\n"
+        "  --compare-threading       run core inline and staged side by side and\n"
+        "                            compare their audio (exit 1 below tolerance)\n"
+        "  --check-allocations       count heap allocations per block after warm-up\n"
+        "                            (exit 1 if the steady state allocates)\n"
+        "  --check-ring              stress the IQ ring with a producer thread and\n"
+        "                            verify every sample arrives in order\n"
+        "  --check-drift PPM         simulate an audio clock PPM faster than the SDR\n"
+        "                            clock and check the drift loop holds the fill\n"
+        "  --check-idle              feed the IQ ring, pause, resume, and count the\n"
+        "                            consumer's wakeups (exit 1 if it wakes while idle)\n"
+        "  --check-executor          run --channels receivers per block as a task graph on\n"
+        "                            the work-stealing DspExecutor and check it against a\n"
+        "                            serial run (exit 1 on a broken edge or differing audio)\n"
+        "  --channels N              --check-executor: receivers per block, default 20\n"
+        "  --workers N               --check-executor, --check-vfo: threads besides the caller,\n"
+        "                            default one per core (placement: --placement demod=)\n"
+        "  --check-channelizer M     split the capture into M channels (power of two >= 4)\n"
+        "                            with the polyphase channelizer, check it against a\n"
+        "                            direct mixer+filter and time both (exit 1 on error)\n"
+        "  --check-vfo               --vfos receivers on a synthetic capture, one carrier\n"
+        "                            each, serial and on the DspExecutor, then changed\n"
+        "                            live from another thread (exit 1 on cross-talk,\n"
+        "                            differing audio or a stalled VFO)\n"
+        "  --vfos N                  --check-vfo: VFOs, default 4 (at most 15)\n"
+        "  --check-nco               NCO against a double oscillator across retunes, fused\n"
+        "                            into the channel filter and standing alone, and a\n"
+        "                            receiver moved off centre live on every filter form\n"
+        "                            (exit 1 on phase error or cross-talk)\n"
+        "  --check-fm                a tone at broadcast and narrowband FM deviation through\n"
+        "                            the float and Q15 chains, to 48000 and 44100 Hz audio\n"
+        "                            (exit 1 on distortion or a wrong audio rate)\n"
+        "  --check-log               scan retunes through the async logger and stress it\n"
+        "                            from several threads (exit 1 on loss or reorder)\n"
+        "  --latency                 core: per-stage block latency, ingest to sink\n"
+        "  --stats                   core: per-stage time against the real-time budget\n"
+        "  --tolerance-db DB         minimum SNR for the --compare-* modes, default 25\n"
+        "                            (--compare-fixed: 55)\n"
+        "  --tolerance-lsb N         --compare-* bound on the 99.9th percentile error,\n"
+        "                            default off (--compare-fixed: 128)\n"
+        "  --fft N                   spectrum FFT size, default 1024\n"
+        "  --no-spectrum             skip the SpectrumAnalyzer stage\n"
+        "  --welch OVERLAP[:SEGS]    Welch spectrum, overlap 0/50/75 %%, SEGS per frame\n"
+        "  --seconds S               signal time to process (0 = whole file), default 10\n"
+        "  --block BYTES             USB block size, default 32768\n"
+        "  --verbose                 forward LOGI/LOGD from the native code\n",
+        argv0);
+}
+
+// demod=big:-5,spectrum=little:10,output=any
+bool parsePlacement(const char* spec, PipelineConfig& config) {
+    std::string rest = spec;
+    while (!rest.empty()) {
+        const size_t comma = rest.find(',');
+        const std::string item = rest.substr(0, comma);
+        rest = comma == std::string::npos ? std::string() : rest.substr(comma + 1);
+        
+        const size_t equals = item.find('=');
+        if (equals == std::string::npos) {
+            return false;
+        }
+        const std::string thread = item.substr(0, equals);
+        std::string cores = item.substr(equals + 1);
+        
+        ThreadPlacement placement;
+        const size_t colon = cores.find(':');
+        if (colon != std::string::npos) {
+            placement.nice = std::atoi(cores.c_str() + colon + 1);
+            cores.resize(colon);
+        }
+        if (cores == "little") {
+            placement.cores = CoreClass::LITTLE;
+        } else if (cores == "big") {
+            placement.cores = CoreClass::BIG;
+        } else if (cores != "any") {
+            return false;
+        }
+        
+        if (thread == "demod") {
+            config.demod_placement = placement;
+        } else if (thread == "spectrum") {
+            config.spectrum_placement = placement;
+        } else if (thread == "output") {
+            config.output_placement = placement;
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool parseOptions(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        
+        if (arg == "--no-spectrum") {
+            options.config.spectrum = false;
+            continue;
+        }
+        if (arg == "--verbose") {
+            options.verbose = true;
+            continue;
+        }
+        if (arg == "--fixed-point") {
+            options.config.fixed_point = true;
+            continue;
+        }
+        if (arg == "--compare-fixed") {
+            options.compare_fixed = true;
+            continue;
+        }
+        if (arg == "--staged") {
+            options.config.staged = true;
+            continue;
+        }
+        if (arg == "--compare-staged") {
+            options.compare_staged = true;
+            continue;
+        }
+        if (arg == "--compare-threading") {
+            options.compare_threading = true;
+            continue;
+        }
+        if (arg == "--check-allocations") {
+            options.check_allocations = true;
+            continue;
+        }
+        if (arg == "--stats") {
+            options.stats = true;
+            continue;
+        }
+        if (arg == "--latency") {
+            options.latency = true;
+            continue;
+        }
+        if (arg == "--check-idle") {
+            options.check_idle = true;
+            continue;
+        }
+        if (arg == "--check-executor") {
+            options.check_executor = true;
+            continue;
+        }
+        if (arg == "--check-vfo") {
+            options.check_vfo = true;
+            continue;
+        }
+        if (arg == "--check-fm") {
+            options.check_fm = true;
+            continue;
+        }
+        if (arg == "--check-nco") {
+            options.check_nco = true;
+            continue;
+        }
+        if (arg == "--check-log") {
+            options.check_log = true;
+            continue;
+        }
+        if (arg == "--check-ring") {
+            options.check_ring = true;
+            continue;
+        }
+        if (arg == "--help" || arg == "-h") {
+            return false;
+        }
+        
+        if (i + 1 >= argc) {
+            std::fprintf(stderr, "missing value for %s\n", arg.c_str());
+            return false;
+        }
+        const char* v = argv[++i];
+        
+        if (arg == "--source") {
+            options.source = v;
+        } else if (arg == "--sink") {
+            options.sink = v;
+        } else if (arg == "--pipeline") {
+            options.pipeline = v;
+        } else if (arg == "--demod") {
+            options.config.demod = v;
+        } else if (arg == "--rate") {
+            options.config.sample_rate = static_cast<uint32_t>(std::strtoul(v, nullptr, 10));
+        } else if (arg == "--bandwidth") {
+            options.config.bandwidth_hz = std::atoi(v);
+        } else if (arg == "--offset") {
+            options.config.offset_hz = std::atoi(v);
+        } else if (arg == "--channel-filter") {
+            options.config.channel_filter = v;
+        } else if (arg == "--fft") {
+            options.config.fft_size = std::atoi(v);
+        } else if (arg == "--welch") {
+            char* end = nullptr;
+            options.config.welch_overlap = static_cast<int>(std::strtol(v, &end, 10));
+            if (end && *end == ':') {
+                options.config.welch_segments = std::atoi(end + 1);
+            }
+        } else if (arg == "--threading") {
+            if (std::strcmp(v, "inline") != 0 && std::strcmp(v, "staged") != 0) {
+                std::fprintf(stderr, "unknown threading '%s'\n", v);
+                return false;
+            }
+            options.config.threaded = std::strcmp(v, "staged") == 0;
+        } else if (arg == "--placement") {
+            if (!parsePlacement(v, options.config)) {
+                std::fprintf(stderr, "bad placement '%s'\n", v);
+                return false;
+            }
+        } else if (arg == "--fm-discriminator") {
+            options.config.fm_discriminator = v;
+        } else if (arg == "--channels") {
+            options.channels = std::atoi(v);
+        } else if (arg == "--check-channelizer") {
+            options.check_channelizer = std::atoi(v);
+        } else if (arg == "--vfos") {
+            options.vfos = std::atoi(v);
+        } else if (arg == "--workers") {
+            options.workers = std::atoi(v);
+        } else if (arg == "--check-drift") {
+            options.check_drift = true;
+            options.drift_ppm = std::atof(v);
+        } else if (arg == "--tolerance-db") {
+            options.tolerance_db = std::atof(v);
+        } else if (arg == "--tolerance-lsb") {
+            options.tolerance_lsb = std::atoi(v);
+        } else if (arg == "--seconds") {
+            options.seconds = std::atof(v);
+        } else if (arg == "--block") {
+            options.block_bytes = static_cast<size_t>(std::strtoul(v, nullptr, 10)) & ~static_cast<size_t>(1);
+        } else {
+            std::fprintf(stderr, "unknown option %s\n", arg.c_str());
+            return false;
+        }
+    }
+    
+    // Comparing discriminators takes an FM signal; the simulated dongle's
+    // AM only gives them phase flips of pi to disagree on
+    if (options.source.empty()) {
+        options.source = options.compare_fixed && options.config.demod == "fm" ? "fm" : "sim";
+    }
+    
+    return options.config.sample_rate > 0 && options.block_bytes > 0;
+}
+
+uint64_t byteLimit(const Options& options) {
+    return options.seconds > 0.0
+        ? static_cast<uint64_t>(options.seconds * options.config.sample_rate) * 2
+        : UINT64_MAX;
+}
+
+// Reference and candidate pipelines on the same blocks, each timed on its
+// own. Audio is compared at the sink, so the figure is what a listener
+// gets: SNR of the candidate output against the reference output.
+int runCompare(const Options& options, IQSource& source, Pipeline& reference_pipeline,
+               Pipeline& candidate_pipeline, const char* reference_label, const char* candidate_label,
+               CompareTolerance tolerance) {
+    if (options.tolerance_db >= 0.0) {
+        tolerance.snr_db = options.tolerance_db;
+    }
+    if (options.tolerance_lsb >= 0) {
+        tolerance.p999_lsb = options.tolerance_lsb;
+    }
+    
+    MemorySink reference_sink;
+    MemorySink candidate_sink;
+    
+    const uint64_t byte_limit = byteLimit(options);
+    std::vector<uint8_t> block(options.block_bytes);
+    uint64_t bytes_done = 0;
+    std::chrono::steady_clock::duration reference_time{0};
+    std::chrono::steady_clock::duration candidate_time{0};
+    
+    while (bytes_done < byte_limit) {
+        size_t want = static_cast<size_t>(std::min<uint64_t>(block.size(), byte_limit - bytes_done));
+        size_t got = source.read(block.data(), want);
+        if (got == 0) {
+            break;
+        }
+        
+        auto start = std::chrono::steady_clock::now();
+        reference_pipeline.process(block.data(), got, reference_sink);
+        auto middle = std::chrono::steady_clock::now();
+        candidate_pipeline.process(block.data(), got, candidate_sink);
+        candidate_time += std::chrono::steady_clock::now() - middle;
+        reference_time += middle - start;
+        
+        bytes_done += got;
+    }
+    
+    reference_pipeline.finish(reference_sink);
+    candidate_pipeline.finish(candidate_sink);
+    
+    const std::vector<int16_t>& reference = reference_sink.samples();
+    const std::vector<int16_t>& candidate = candidate_sink.samples();
+    const size_t count = std::min(reference.size(), candidate.size());
+    
+    double signal_power = 0.0;
+    double error_power = 0.0;
+    std::vector<int> errors(count);
+    for (size_t i = 0; i < count; ++i) {
+        int error = candidate[i] - reference[i];
+        signal_power += static_cast<double>(reference[i]) * reference[i];
+        error_power += static_cast<double>(error) * error;
+        errors[i] = std::abs(error);
+    }
+    int max_error = 0;
+    int p999_error = 0;
+    if (count > 0) {
+        const size_t p999 = count - 1 - count / 1000;
+        std::nth_element(errors.begin(), errors.begin() + p999, errors.end());
+        p999_error = errors[p999];
+        max_error = *std::max_element(errors.begin() + p999, errors.end());
+    }
+    
+    const double samples = static_cast<double>(bytes_done / 2);
+    const double reference_seconds = std::chrono::duration<double>(reference_time).count();
+    const double candidate_seconds = std::chrono::duration<double>(candidate_time).count();
+    const double snr_db = error_power > 0.0
+        ? 10.0 * std::log10(signal_power / error_power)
+        : INFINITY;
+    
+    std::printf("source      %s\n", source.name());
+    std::printf("pipeline    %s (%s, %u Hz), %s vs %s\n", reference_pipeline.name(),
+                options.config.demod.c_str(), options.config.sample_rate, reference_label, candidate_label);
+    std::printf("signal      %.3f s (%.0f samples)\n", samples / options.config.sample_rate, samples);
+    if (reference_seconds > 0.0 && candidate_seconds > 0.0) {
+        std::printf("%-11s %.2f Msps\n", reference_label, samples / reference_seconds / 1e6);
+        std::printf("%-11s %.2f Msps (%.2fx)\n", candidate_label, samples / candidate_seconds / 1e6,
+                    reference_seconds / candidate_seconds);
+    }
+    std::printf("audio       %zu / %zu samples\n", reference.size(), candidate.size());
+    std::printf("snr         %.1f dB (tolerance %.1f dB)\n", snr_db, tolerance.snr_db);
+    if (tolerance.p999_lsb > 0) {
+        std::printf("p99.9 error %d LSB (tolerance %d LSB)\n", p999_error, tolerance.p999_lsb);
+    } else {
+        std::printf("p99.9 error %d LSB\n", p999_error);
+    }
+    std::printf("max error   %d LSB\n", max_error);
+    
+    if (reference.size() != candidate.size() || count == 0 || snr_db < tolerance.snr_db ||
+        (tolerance.p999_lsb > 0 && p999_error > tolerance.p999_lsb)) {
+        std::printf("result      FAIL\n");
+        return 1;
+    }
+    std::printf("result      PASS\n");
+    return 0;
+}
+
+// SDRController's threading on SampleRing: a producer thread publishes a
+// numbered sample sequence in uneven blocks at the SDR rate, never waiting
+// on the consumer, while the consumer takes minimum-fill spans and checks
+// that every sample not counted as dropped arrives once, in order.
+int runRingCheck(const Options& options) {
+    const uint64_t total = static_cast<uint64_t>(std::max(options.seconds, 0.1) * options.config.sample_rate);
+    const size_t min_fill = options.block_bytes / 2;
+    
+    SampleRing ring;
+    ring.allocate(min_fill * 4);
+    
+    std::atomic<bool> producing{true};
+    std::thread producer([&]() {
+        const auto start = std::chrono::steady_clock::now();
+        const double rate = options.config.sample_rate;
+        uint64_t next = 0;
+        size_t block = 1;
+        while (next < total) {
+            // Paced like the USB transfers; the sleep stands in for the
+            // hardware, not for any wait on the consumer
+            auto due = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                std::chrono::duration<double>(next / rate));
+            std::this_thread::sleep_until(start + due);
+            
+            size_t count = std::min<uint64_t>(block, total - next);
+            size_t space = 0;
+            std::complex<float>* span = ring.writeSpan(space);
+            size_t written = std::min(space, count);
+            for (size_t i = 0; i < written; ++i) {
+                span[i] = std::complex<float>(static_cast<float>((next + i) & 0xffffff),
+                                              static_cast<float>((next + i) >> 24));
+            }
+            ring.commitWrite(written);
+            ring.recordDropped(count - written);
+            next += count;
+            block = block * 7 % 9973 + 1;    // 1 .. 9973 samples, USB-like jitter
+        }
+        producing.store(false);
+        ring.wake();
+    });
+    
+    uint64_t received = 0;
+    uint64_t expected = 0;
+    uint64_t gaps = 0;
+    uint64_t reorders = 0;
+    uint64_t short_reads = 0;
+    auto start = std::chrono::steady_clock::now();
+    
+    for (;;) {
+        bool done = !producing.load();
+        size_t ready = ring.waitForSamples(min_fill, 100);
+        if (ready == 0 && done) {
+            break;
+        }
+        if (ready < min_fill && !done) {
+            ++short_reads;
+        }
+        
+        size_t count = 0;
+        const std::complex<float>* span = ring.readSpan(count);
+        for (size_t i = 0; i < count; ++i) {
+            uint64_t index = static_cast<uint64_t>(span[i].real()) |
+                             (static_cast<uint64_t>(span[i].imag()) << 24);
+            if (index > expected) {
+                ++gaps;
+            } else if (index < expected) {
+                ++reorders;
+            }
+            expected = index + 1;
+        }
+        ring.commitRead(count);
+        received += count;
+    }
+    producer.join();
+    
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    const uint64_t dropped = ring.droppedSamples();
+    
+    std::printf("ring        %zu samples, %s\n", ring.capacity(), ring.isMirrored() ? "mirrored" : "split");
+    std::printf("samples     %llu sent, %llu received, %llu dropped\n",
+                static_cast<unsigned long long>(total), static_cast<unsigned long long>(received),
+                static_cast<unsigned long long>(dropped));
+    std::printf("order       %llu gaps, %llu out of order\n",
+                static_cast<unsigned long long>(gaps), static_cast<unsigned long long>(reorders));
+    std::printf("short reads %llu (timeout before %zu samples)\n",
+                static_cast<unsigned long long>(short_reads), min_fill);
+    if (seconds > 0.0) {
+        std::printf("throughput  %.2f Msps\n", received / seconds / 1e6);
+    }
+    
+    // Drops only happen with the ring full, so each one is a single gap
+    if (received + dropped != total || reorders > 0 || (dropped == 0 && gaps > 0)) {
+        std::printf("result      FAIL\n");
+        return 1;
+    }
+    std::printf("result      PASS\n");
+    return 0;
+}
+
+// The processing loop of radiosdr_jni.cpp on the IQ ring: it waits with no
+// timeout for a block's worth of samples. The producer delivers USB-sized
+// blocks at the SDR rate, goes silent for as long, then resumes; the
+// consumer should wake once per block while data flows and not at all in
+// between.
+int runIdleCheck(const Options& options) {
+    const size_t block_samples = 8192;      // one 16 KB USB transfer
+    const auto phase = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<double>(std::max(options.seconds, 0.5) / 3.0));
+    const auto block_time = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<double>(static_cast<double>(block_samples) / options.config.sample_rate));
+    
+    SampleRing ring;
+    ring.allocate(1 << 18);
+    WakeupMeter wakeups;
+    
+    std::atomic<bool> running{true};
+    std::thread consumer([&]() {
+        while (running.load()) {
+            ring.waitForSamples(block_samples, SampleRing::WAIT_FOREVER);
+            wakeups.tick();
+            size_t count = 0;
+            ring.readSpan(count);
+            ring.commitRead(count);
+        }
+    });
+    
+    // Paced like the USB transfers
+    auto produce = [&](std::chrono::steady_clock::time_point until) {
+        uint64_t blocks = 0;
+        for (auto due = std::chrono::steady_clock::now(); due < until; due += block_time) {
+            std::this_thread::sleep_until(due);
+            size_t space = 0;
+            std::complex<float>* span = ring.writeSpan(space);
+            const size_t count = std::min(space, block_samples);
+            std::fill(span, span + count, std::complex<float>(0.0f, 0.0f));
+            ring.commitWrite(count);
+            ++blocks;
+        }
+        return blocks;
+    };
+    
+    const char* names[3] = {"streaming", "idle", "streaming"};
+    uint64_t blocks[3] = {};
+    uint64_t counts[3] = {};
+    double rates[3] = {};
+    wakeups.ratePerSecond();
+    for (int i = 0; i < 3; ++i) {
+        const uint64_t before = wakeups.total();
+        const auto until = std::chrono::steady_clock::now() + phase;
+        if (i == 1) {
+            std::this_thread::sleep_until(until);
+        } else {
+            blocks[i] = produce(until);
+        }
+        counts[i] = wakeups.total() - before;
+        rates[i] = wakeups.ratePerSecond();
+    }
+    
+    running.store(false);
+    ring.wake();
+    consumer.join();
+    
+    for (int i = 0; i < 3; ++i) {
+        std::printf("%-11s %llu blocks, %llu wakeups, %.1f wakeups/s\n", names[i],
+                    static_cast<unsigned long long>(blocks[i]), static_cast<unsigned long long>(counts[i]),
+                    rates[i]);
+    }
+    
+    // The last block of a streaming phase may be picked up just after it
+    if (counts[1] > 1 || counts[0] > blocks[0] + 1 || counts[2] > blocks[2] + 1) {
+        std::printf("result      FAIL\n");
+        return 1;
+    }
+    std::printf("result      PASS\n");
+    return 0;
+}
+
+// Retune points of a full scan, as the kotlin/ scanner steps
+const uint32_t SCAN_START_HZ = 24000000;
+const uint32_t SCAN_STOP_HZ = 1766000000;
+const uint32_t SCAN_STEP_HZ = 1000000;
+
+const int LOG_CHECK_THREADS = 4;
+const int LOG_CHECK_RECORDS = 20000;
+// Bursts of 20 k records/s per thread: a burst's first record wakes the
+// drainer and the burst is well under a ring's 256 records, so drops mean
+// the drainer fell behind
+const int LOG_CHECK_BURST = 100;
+const auto LOG_CHECK_PAUSE = std::chrono::milliseconds(5);
+const auto LOG_CHECK_IDLE = std::chrono::milliseconds(500);
+
+// What the drainer hands over during --check-log
+struct LogCheckState {
+    uint64_t received[LOG_CHECK_THREADS] = {};
+    long long last[LOG_CHECK_THREADS] = {-1, -1, -1, -1};
+    uint64_t reorders = 0;
+    uint64_t retunes = 0;
+    uint64_t suppressed_reported = 0;
+};
+
+void countingLogHandler(int, const char*, const char* message, void* context) {
+    LogCheckState& state = *static_cast<LogCheckState*>(context);
+    
+    int thread = 0;
+    long long sequence = 0;
+    if (std::sscanf(message, "producer %d record %lld", &thread, &sequence) == 2 &&
+        thread >= 0 && thread < LOG_CHECK_THREADS) {
+        ++state.received[thread];
+        if (sequence <= state.last[thread]) {
+            ++state.reorders;
+        }
+        state.last[thread] = sequence;
+        return;
+    }
+    if (std::strncmp(message, "Retuned", 7) == 0) {
+        ++state.retunes;
+        unsigned suppressed = 0;
+        const char* note = std::strstr(message, "[+");
+        if (note && std::sscanf(note, "[+%u", &suppressed) == 1) {
+            state.suppressed_reported += suppressed;
+        }
+    }
+}
+
+// An info log on every retune, at the default per-site rate limit
+void logRetune(uint32_t freq) {
+    ASYNC_LOG(ANDROID_LOG_INFO, "check-log", "Retuned to %u Hz", freq);
+}
+
+double nsPerCall(std::chrono::steady_clock::duration elapsed, uint64_t calls) {
+    return calls > 0 ? std::chrono::duration<double, std::nano>(elapsed).count() / calls : 0.0;
+}
+
+// The async logger under the two loads it exists for: a scan retuning
+// the simulated dongle once per step, whose per-step logs are debug (gone
+// from this NDEBUG build) or rate limited, and several threads logging in
+// bursts with no limit, where every record must reach the handler in
+// order per thread or be counted as dropped.
+int runLogCheck() {
+    LogCheckState state;
+    async_log_set_handler(countingLogHandler, &state);
+    
+    rtlsdr_dev* device = nullptr;
+    if (rtlsdr_open(&device, 0) != 0) {
+        std::fprintf(stderr, "cannot open simulated device\n");
+        return 1;
+    }
+    
+    uint64_t steps = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t freq = SCAN_START_HZ; freq <= SCAN_STOP_HZ; freq += SCAN_STEP_HZ) {
+        rtlsdr_set_center_freq(device, freq);
+        logRetune(freq);
+        ++steps;
+    }
+    const auto scan_time = std::chrono::steady_clock::now() - start;
+    rtlsdr_close(device);
+    
+    // The first retune of the next window reports what the limit held back
+    std::this_thread::sleep_for(std::chrono::milliseconds(1100));
+    logRetune(SCAN_STOP_HZ);
+    async_log_flush();
+    
+    // The same messages formatted and written on the calling thread
+    std::FILE* null_file = std::fopen("/dev/null", "w");
+    start = std::chrono::steady_clock::now();
+    for (uint32_t freq = SCAN_START_HZ; null_file && freq <= SCAN_STOP_HZ; freq += SCAN_STEP_HZ) {
+        char message[64];
+        std::snprintf(message, sizeof(message), "Retuned to %u Hz", freq);
+        std::fprintf(null_file, "I/check-log: %s\n", message);
+        std::fflush(null_file);
+    }
+    const auto sync_time = std::chrono::steady_clock::now() - start;
+    if (null_file) {
+        std::fclose(null_file);
+    }
+    
+    async_log_stats before;
+    async_log_get_stats(&before);
+    
+    // Time spent in the log calls only, not in the pauses
+    std::atomic<int64_t> producer_ns{0};
+    std::vector<std::thread> producers;
+    for (int t = 0; t < LOG_CHECK_THREADS; ++t) {
+        producers.emplace_back([t, &producer_ns] {
+            for (int i = 0; i < LOG_CHECK_RECORDS; i += LOG_CHECK_BURST) {
+                auto burst_start = std::chrono::steady_clock::now();
+                for (int j = i; j < std::min(i + LOG_CHECK_BURST, LOG_CHECK_RECORDS); ++j) {
+                    ASYNC_LOG_RATE(ANDROID_LOG_WARN, 0, "check-log", "producer %d record %d", t, j);
+                }
+                producer_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now() - burst_start).count();
+                std::this_thread::sleep_for(LOG_CHECK_PAUSE);
+            }
+        });
+    }
+    for (auto& producer : producers) {
+        producer.join();
+    }
+    const auto producer_time = std::chrono::nanoseconds(producer_ns.load());
+    async_log_flush();
+    async_log_set_handler(nullptr, nullptr);
+    
+    async_log_stats after;
+    async_log_get_stats(&after);
+    
+    // Nothing logged for half a second: the drainer must stay asleep
+    std::this_thread::sleep_for(LOG_CHECK_IDLE);
+    async_log_stats idle;
+    async_log_get_stats(&idle);
+    const uint64_t idle_wakeups = idle.drainer_wakeups - after.drainer_wakeups;
+    
+    const uint64_t produced = static_cast<uint64_t>(LOG_CHECK_THREADS) * LOG_CHECK_RECORDS;
+    uint64_t received = 0;
+    for (int t = 0; t < LOG_CHECK_THREADS; ++t) {
+        received += state.received[t];
+    }
+    const uint64_t dropped = after.dropped - before.dropped;
+    // Debug builds also rate limit the simulated dongle's own retune log
+    const uint64_t suppressed = steps + 1 - state.retunes;
+    
+    std::printf("scan        %llu retunes, %.0f ns per step with logging\n",
+                static_cast<unsigned long long>(steps), nsPerCall(scan_time, steps));
+    std::printf("debug logs  %s\n", ASYNC_LOG_MIN_LEVEL > ANDROID_LOG_DEBUG ? "compiled out" : "enabled");
+    std::printf("rate limit  %llu of %llu retune logs written, %llu suppressed, %llu reported\n",
+                static_cast<unsigned long long>(state.retunes), static_cast<unsigned long long>(steps + 1),
+                static_cast<unsigned long long>(suppressed),
+                static_cast<unsigned long long>(state.suppressed_reported));
+    std::printf("sync write  %.0f ns per message\n", nsPerCall(sync_time, steps));
+    std::printf("producers   %d threads, %llu records, %.0f ns per call\n", LOG_CHECK_THREADS,
+                static_cast<unsigned long long>(produced), nsPerCall(producer_time, produced));
+    std::printf("records     %llu received, %llu dropped, %llu out of order\n",
+                static_cast<unsigned long long>(received), static_cast<unsigned long long>(dropped),
+                static_cast<unsigned long long>(state.reorders));
+    std::printf("drainer     %llu wakeups for the bursts, %llu in %lld ms idle\n",
+                static_cast<unsigned long long>(after.drainer_wakeups - before.drainer_wakeups),
+                static_cast<unsigned long long>(idle_wakeups),
+                static_cast<long long>(LOG_CHECK_IDLE.count()));
+    
+    if (received + dropped != produced || state.reorders > 0 || idle_wakeups > 0 ||
+        state.retunes > ASYNC_LOG_DEFAULT_RATE + 1 || state.suppressed_reported != suppressed) {
+        std::printf("result      FAIL\n");
+        return 1;
+    }
+    std::printf("result      PASS\n");
+    return 0;
+}
+
+// AudioProcessor's clock-drift loop against an audio clock drift_ppm
+// faster than the SDR clock, in simulated time so an hour takes seconds.
+// After each block the consumer takes what a 48 kHz * (1 + ppm) sound card
+// would have played by then, in getAudioData()-sized reads, starting one
+// second in so the acquisition jump is covered too. The second half of the
+// run is the steady state: no resyncs, no underruns, fill near target and
+// a drift estimate close to the simulated one.
+int runDriftCheck(const Options& options, IQSource& source) {
+    PipelineConfig config = options.config;
+    config.drift_compensation = true;
+    CorePipeline pipeline(config);
+    AudioProcessor& audio = pipeline.audioProcessor();
+    
+    const uint64_t byte_limit = byteLimit(options);
+    const double total_seconds = static_cast<double>(byte_limit / 2) / config.sample_rate;
+    const double consumer_rate = pipeline.audioRate() * (1.0 + options.drift_ppm * 1e-6);
+    const double consumer_start = 1.0;
+    const double report_interval = std::max(1.0, total_seconds / 10.0);
+    
+    std::vector<uint8_t> block(options.block_bytes);
+    int16_t pcm[1024];
+    uint64_t bytes_done = 0;
+    double consumed = 0.0;
+    double next_report = consumer_start;
+    uint64_t steady_underruns = 0;
+    uint64_t steady_resyncs_start = 0;
+    double steady_fill_error = 0.0;
+    bool steady = false;
+    
+    std::printf("time        fill   correction   drift\n");
+    while (bytes_done < byte_limit) {
+        size_t want = static_cast<size_t>(std::min<uint64_t>(block.size(), byte_limit - bytes_done));
+        size_t got = source.read(block.data(), want);
+        if (got == 0) {
+            break;
+        }
+        pipeline.feed(block.data(), got);
+        bytes_done += got;
+        
+        const double now = static_cast<double>(bytes_done / 2) / config.sample_rate;
+        if (now < consumer_start) {
+            continue;
+        }
+        
+        // Whole samples the sound card has asked for by now
+        const double due = std::floor((now - consumer_start) * consumer_rate);
+        while (consumed < due) {
+            size_t request = static_cast<size_t>(std::min(due - consumed, 1024.0));
+            size_t read = audio.readAudio(pcm, request);
+            if (read < request && steady) {
+                ++steady_underruns;
+            }
+            consumed += static_cast<double>(request);
+        }
+        
+        ClockDriftStats stats = audio.getClockDriftStats();
+        if (!steady && now >= total_seconds / 2) {
+            steady = true;
+            steady_resyncs_start = stats.resyncs;
+        }
+        if (steady) {
+            steady_fill_error = std::max(steady_fill_error,
+                                         std::fabs(stats.average_fill - static_cast<double>(stats.target_fill)));
+        }
+        if (now >= next_report) {
+            std::printf("%7.0f s  %6.0f  %+8.1f ppm  %+6.1f ppm\n", now, stats.average_fill,
+                        stats.correction_ppm, stats.drift_ppm);
+            next_report += report_interval;
+        }
+    }
+    
+    ClockDriftStats stats = audio.getClockDriftStats();
+    const uint64_t steady_resyncs = stats.resyncs - steady_resyncs_start;
+    const double estimate_error = std::fabs(stats.drift_ppm - options.drift_ppm);
+    
+    std::printf("simulated   %+.1f ppm over %.0f s\n", options.drift_ppm, total_seconds);
+    std::printf("estimate    %+.2f ppm (error %.2f ppm), correction %+.2f ppm\n",
+                stats.drift_ppm, estimate_error, stats.correction_ppm);
+    std::printf("fill        %.0f / %zu samples, worst steady error %.0f\n",
+                stats.average_fill, stats.target_fill, steady_fill_error);
+    std::printf("resyncs     %llu total, %llu steady\n",
+                static_cast<unsigned long long>(stats.resyncs),
+                static_cast<unsigned long long>(steady_resyncs));
+    std::printf("underruns   %llu steady\n", static_cast<unsigned long long>(steady_underruns));
+    
+    if (!stats.locked || steady_resyncs > 0 || steady_underruns > 0 ||
+        steady_fill_error > stats.target_fill / 4.0 || estimate_error > 2.0 + 0.05 * std::fabs(options.drift_ppm)) {
+        std::printf("result      FAIL\n");
+        return 1;
+    }
+    std::printf("result      PASS\n");
+    return 0;
+}
+
+// One receiver channel of --check-executor: its own SignalProcessor and
+// the audio its decoder step collected
+struct ExecutorChannel {
+    std::unique_ptr<SignalProcessor> processor;
+    std::vector<float> block_audio;
+    size_t block_count = 0;
+    std::vector<float> audio;
+};
+
+const DemodulationType EXECUTOR_DEMODS[] = {
+    DemodulationType::FM, DemodulationType::AM, DemodulationType::USB, DemodulationType::LSB
+};
+const int EXECUTOR_BANDWIDTHS[] = {200000, 10000, 3000, 3000};
+
+void setUpExecutorChannel(ExecutorChannel& channel, int index, uint32_t sample_rate, size_t block_samples) {
+    channel.processor = std::make_unique<SignalProcessor>();
+    channel.processor->setSampleRate(static_cast<int>(sample_rate));
+    channel.processor->setAudioSampleRate(48000);
+    channel.processor->setDemodulationType(EXECUTOR_DEMODS[index % 4]);
+    channel.processor->setBandwidth(EXECUTOR_BANDWIDTHS[index % 4]);
+    channel.block_audio.resize(block_samples);
+}
+
+// Filter+demod of one block, then the decoder step that consumes it
+void runExecutorChannel(ExecutorChannel& channel, const std::complex<float>* samples, size_t count) {
+    channel.processor->processSamples(samples, count);
+    channel.block_count = channel.processor->readAudioSamples(channel.block_audio.data(),
+                                                              channel.block_audio.size());
+}
+
+void runExecutorDecoder(ExecutorChannel& channel) {
+    channel.audio.insert(channel.audio.end(), channel.block_audio.begin(),
+                         channel.block_audio.begin() + channel.block_count);
+}
+
+// --channels receivers on the same blocks, once one after another on this
+// thread and once as a TaskGraph on the DspExecutor: per channel a
+// filter+demod task and a decoder task after it, one FFT frame task, and
+// a block task after everything. Every edge must hold and each channel's
+// audio must match the serial run bit for bit.
+int runExecutorCheck(const Options& options, IQSource& source) {
+    const int channels = std::max(options.channels, 1);
+    const size_t block_samples = options.block_bytes / 2;
+    
+    std::vector<ExecutorChannel> serial(channels);
+    std::vector<ExecutorChannel> pooled(channels);
+    for (int i = 0; i < channels; ++i) {
+        setUpExecutorChannel(serial[i], i, options.config.sample_rate, block_samples);
+        setUpExecutorChannel(pooled[i], i, options.config.sample_rate, block_samples);
+    }
+    SpectrumAnalyzer serial_spectrum;
+    SpectrumAnalyzer pooled_spectrum;
+    serial_spectrum.setFFTSize(options.config.fft_size);
+    pooled_spectrum.setFFTSize(options.config.fft_size);
+    
+    std::vector<uint8_t> block(options.block_bytes);
+    std::vector<std::complex<float>> samples(block_samples);
+    size_t sample_count = 0;
+    
+    // Start and end order of every task in the current pass
+    std::atomic<uint64_t> clock{0};
+    std::vector<uint64_t> started;
+    std::vector<uint64_t> finished;
+    std::vector<std::pair<int, int>> edges;
+    uint64_t blocks_joined = 0;
+    
+    TaskGraph graph;
+    auto addTask = [&](const char* name, std::function<void()> work) {
+        const int id = graph.addTask(name, [&, id = static_cast<int>(graph.size()), work]() {
+            started[id] = clock.fetch_add(1);
+            work();
+            finished[id] = clock.fetch_add(1);
+        });
+        started.push_back(0);
+        finished.push_back(0);
+        return id;
+    };
+    auto addEdge = [&](int before, int after) {
+        graph.addEdge(before, after);
+        edges.emplace_back(before, after);
+    };
+    
+    const int fft = addTask("fft", [&]() { pooled_spectrum.updateSpectrum(samples.data(), sample_count); });
+    const int join = addTask("block", [&]() { ++blocks_joined; });
+    addEdge(fft, join);
+    std::vector<int> channel_tasks(channels);
+    for (int i = 0; i < channels; ++i) {
+        channel_tasks[i] = addTask("channel", [&, i]() {
+            runExecutorChannel(pooled[i], samples.data(), sample_count);
+        });
+        const int decoder = addTask("decoder", [&, i]() { runExecutorDecoder(pooled[i]); });
+        addEdge(channel_tasks[i], decoder);
+        addEdge(decoder, join);
+    }
+    
+    DspExecutor executor(options.workers, options.config.demod_placement);
+    
+    const uint64_t byte_limit = byteLimit(options);
+    uint64_t bytes_done = 0;
+    uint64_t blocks = 0;
+    uint64_t broken_edges = 0;
+    std::chrono::steady_clock::duration serial_time{0};
+    std::chrono::steady_clock::duration pooled_time{0};
+    
+    while (bytes_done < byte_limit) {
+        size_t want = static_cast<size_t>(std::min<uint64_t>(block.size(), byte_limit - bytes_done));
+        size_t got = source.read(block.data(), want);
+        if (got == 0) {
+            break;
+        }
+        sample_count = got / 2;
+        convertIQ8(block.data(), sample_count, samples.data());
+        
+        auto start = std::chrono::steady_clock::now();
+        for (auto& channel : serial) {
+            runExecutorChannel(channel, samples.data(), sample_count);
+            runExecutorDecoder(channel);
+        }
+        serial_spectrum.updateSpectrum(samples.data(), sample_count);
+        auto middle = std::chrono::steady_clock::now();
+        executor.run(graph);
+        pooled_time += std::chrono::steady_clock::now() - middle;
+        serial_time += middle - start;
+        
+        for (const auto& edge : edges) {
+            if (finished[edge.first] >= started[edge.second]) {
+                ++broken_edges;
+            }
+        }
+        bytes_done += got;
+        ++blocks;
+    }
+    
+    int mismatched = 0;
+    for (int i = 0; i < channels; ++i) {
+        const std::vector<float>& a = serial[i].audio;
+        const std::vector<float>& b = pooled[i].audio;
+        if (a.size() != b.size() || (!a.empty() && std::memcmp(a.data(), b.data(), a.size() * sizeof(float)) != 0)) {
+            ++mismatched;
+        }
+    }
+    const bool spectrum_matches = serial_spectrum.getSpectrum() == pooled_spectrum.getSpectrum();
+    
+    uint64_t channel_ns = 0;
+    uint64_t decoder_ns = 0;
+    for (int task = 0; task < static_cast<int>(graph.size()); ++task) {
+        if (std::strcmp(graph.taskName(task), "channel") == 0) {
+            channel_ns += graph.taskNs(task);
+        } else if (std::strcmp(graph.taskName(task), "decoder") == 0) {
+            decoder_ns += graph.taskNs(task);
+        }
+    }
+    
+    const ExecutorStats stats = executor.stats();
+    const double serial_seconds = std::chrono::duration<double>(serial_time).count();
+    const double pooled_seconds = std::chrono::duration<double>(pooled_time).count();
+    const double per_block = blocks > 0 ? 1e-3 / blocks : 0.0;
+    
+    std::printf("source      %s\n", source.name());
+    std::printf("graph       %d channels, %zu tasks, %zu edges per block\n", channels, graph.size(), edges.size());
+    std::printf("executor    %d workers + caller on %s cores\n", executor.workerCount(),
+                coreClassName(options.config.demod_placement.cores));
+    std::printf("blocks      %llu x %zu bytes\n", static_cast<unsigned long long>(blocks), options.block_bytes);
+    std::printf("serial      %.3f s\n", serial_seconds);
+    if (pooled_seconds > 0.0) {
+        std::printf("pooled      %.3f s (%.2fx)\n", pooled_seconds, serial_seconds / pooled_seconds);
+    }
+    std::printf("task cost   channel %.1f us, decoder %.1f us, fft %.1f us per block\n",
+                channel_ns * per_block / channels, decoder_ns * per_block / channels,
+                graph.taskNs(fft) * per_block);
+    std::printf("scheduling  %llu tasks, %llu stolen, %llu worker sleeps\n",
+                static_cast<unsigned long long>(stats.tasks), static_cast<unsigned long long>(stats.steals),
+                static_cast<unsigned long long>(stats.sleeps));
+    std::printf("order       %llu broken edges, %llu of %llu blocks joined\n",
+                static_cast<unsigned long long>(broken_edges), static_cast<unsigned long long>(blocks_joined),
+                static_cast<unsigned long long>(blocks));
+    std::printf("audio       %d of %d channels differ from serial, spectrum %s\n", mismatched, channels,
+                spectrum_matches ? "matches" : "differs");
+    
+    if (blocks == 0 || broken_edges > 0 || blocks_joined != blocks || mismatched > 0 || !spectrum_matches) {
+        std::printf("result      FAIL\n");
+        return 1;
+    }
+    std::printf("result      PASS\n");
+    return 0;
+}
+
+// --check-channelizer test input: a tone at each channel + fraction
+// (channel spacings, negative channels above M / 2) of amplitude 0.2 each,
+// over a little uniform noise
+std::vector<std::complex<float>> channelizerTestSignal(int channels, size_t count,
+                                                       const std::vector<double>& tones) {
+    std::vector<std::complex<float>> signal(count);
+    uint32_t noise = 12345;
+    auto nextNoise = [&noise]() {
+        noise = noise * 1664525u + 1013904223u;
+        return (static_cast<float>(noise >> 8) / 16777216.0f - 0.5f) * 2e-3f;
+    };
+    for (size_t n = 0; n < count; ++n) {
+        std::complex<double> sum(0.0, 0.0);
+        for (double tone : tones) {
+            sum += std::polar(0.2, 2.0 * M_PI * tone * n / channels);
+        }
+        const float re = nextNoise();
+        const float im = nextNoise();
+        signal[n] = std::complex<float>(static_cast<float>(sum.real()) + re, static_cast<float>(sum.imag()) + im);
+    }
+    return signal;
+}
+
+// Feeds signal in blocks of uneven size, so frames straddle calls, and
+// gathers each active channel's frames
+std::vector<std::vector<std::complex<float>>> runChannelizer(PolyphaseChannelizer& channelizer,
+                                                             const std::vector<std::complex<float>>& signal) {
+    std::vector<std::vector<std::complex<float>>> outputs(channelizer.getChannels());
+    size_t done = 0;
+    for (size_t block = 0; done < signal.size(); ++block) {
+        const size_t count = std::min<size_t>(1 + (block * 997) % 5000, signal.size() - done);
+        const size_t frames = channelizer.process(signal.data() + done, count);
+        for (int channel = 0; channel < channelizer.getChannels(); ++channel) {
+            if (channelizer.isActive(channel)) {
+                const std::complex<float>* output = channelizer.output(channel);
+                outputs[channel].insert(outputs[channel].end(), output, output + frames);
+            }
+        }
+        done += count;
+    }
+    return outputs;
+}
+
+// Channel k the slow way, in double: signal mixed down by e^-j2pi k n / M,
+// filtered by the prototype and taken at each frame's newest sample.
+// Adds its power and that of output's difference from it.
+void compareWithReference(const PolyphaseChannelizer& channelizer, const std::vector<std::complex<float>>& signal,
+                          int channel, const std::vector<std::complex<float>>& output,
+                          double& signal_power, double& error_power) {
+    const size_t channels = static_cast<size_t>(channelizer.getChannels());
+    const size_t decimation = static_cast<size_t>(channelizer.getDecimation());
+    const std::vector<float>& taps = channelizer.getTaps();
+    std::vector<std::complex<double>> mixer(channels);
+    for (size_t i = 0; i < channels; ++i) {
+        mixer[i] = std::polar(1.0, -2.0 * M_PI * i / channels);
+    }
+    
+    for (size_t frame = 0; frame < output.size(); ++frame) {
+        const size_t newest = (frame + 1) * decimation - 1;
+        std::complex<double> sum(0.0, 0.0);
+        for (size_t i = 0; i < taps.size() && i <= newest; ++i) {
+            const size_t n = newest - i;
+            sum += static_cast<double>(taps[i]) * std::complex<double>(signal[n]) *
+                   mixer[(channel * (n % channels)) % channels];
+        }
+        signal_power += std::norm(sum);
+        error_power += std::norm(std::complex<double>(output[frame]) - sum);
+    }
+}
+
+double powerDb(double signal_power, double error_power) {
+    return error_power > 0.0 ? 10.0 * std::log10(signal_power / error_power) : INFINITY;
+}
+
+// Mean power of a channel's frames once the prototype has filled
+double channelPower(const std::vector<std::complex<float>>& output, size_t settle) {
+    double power = 0.0;
+    for (size_t i = settle; i < output.size(); ++i) {
+        power += std::norm(output[i]);
+    }
+    return output.size() > settle ? power / (output.size() - settle) : 0.0;
+}
+
+// One channel the way SignalProcessor would do it, for the cost figure:
+// mixed to DC, then filtered and decimated with the channelizer's prototype
+struct MixerChain {
+    DecimatingFIR filter;
+    std::complex<float> phasor{1.0f, 0.0f};
+    std::complex<float> step;
+    std::vector<std::complex<float>> mixed;
+    std::vector<std::complex<float>> output;
+};
+
+void runMixerChain(MixerChain& chain, const std::complex<float>* samples, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        chain.mixed[i] = samples[i] * chain.phasor;
+        chain.phasor *= chain.step;
+    }
+    chain.phasor /= std::abs(chain.phasor);
+    chain.filter.process(chain.mixed.data(), count, chain.output.data());
+}
+
+// Per-channel chains timed for at most this many channels and scaled up
+const int TIMED_CHAINS = 16;
+
+// PolyphaseChannelizer of M channels, critically sampled and oversampled:
+// every channel (FFT path) and two (direct DFT path) against a double
+// reference on test tones, rejection of a centred tone in the neighbouring
+// channels, cost per input sample against per-channel mixer+filter chains
+// on the source, and a ChannelBank whose enabled channels must all deliver
+// audio, bit-exact with their own channelizer+Demodulator, while the
+// disabled ones deliver none.
+int runChannelizerCheck(const Options& options, IQSource& source) {
+    const int channels = options.check_channelizer;
+    PolyphaseChannelizer probe;
+    if (channels < 4 || !probe.configure(channels, false)) {
+        std::fprintf(stderr, "--check-channelizer needs a power of two >= 4, not %d\n", channels);
+        return 2;
+    }
+    const double rate = options.config.sample_rate;
+    const size_t signal_length = static_cast<size_t>(channels) * 256;
+    const size_t settle = probe.getNumTaps() / probe.getDecimation() + 1;
+    const int sparse_a = 1;
+    const int sparse_b = channels - 1;
+    
+    std::printf("source      %s\n", source.name());
+    std::printf("channelizer %d channels of %.0f Hz, %zu-tap prototype\n", channels, rate / channels,
+                probe.getNumTaps());
+    
+    bool pass = true;
+    for (int oversampled = 0; oversampled < 2; ++oversampled) {
+        PolyphaseChannelizer all;
+        PolyphaseChannelizer sparse;
+        all.configure(channels, oversampled != 0);
+        sparse.configure(channels, oversampled != 0);
+        for (int channel = 0; channel < channels; ++channel) {
+            all.setActive(channel, true);
+        }
+        sparse.setActive(sparse_a, true);
+        sparse.setActive(sparse_b, true);
+        const char* mode = oversampled ? "oversampled" : "critical";
+        
+        // Tones in a positive channel, off centre, and a negative one
+        const std::vector<double> tones = {static_cast<double>(sparse_a), channels / 2 - 0.3,
+                                           channels - 1 + 0.2};
+        const std::vector<std::complex<float>> signal = channelizerTestSignal(channels, signal_length, tones);
+        const auto all_outputs = runChannelizer(all, signal);
+        const auto sparse_outputs = runChannelizer(sparse, signal);
+        
+        double signal_power = 0.0;
+        double error_power = 0.0;
+        for (int channel = 0; channel < channels; ++channel) {
+            compareWithReference(all, signal, channel, all_outputs[channel], signal_power, error_power);
+        }
+        const double all_snr = powerDb(signal_power, error_power);
+        signal_power = error_power = 0.0;
+        for (int channel : {sparse_a, sparse_b}) {
+            compareWithReference(sparse, signal, channel, sparse_outputs[channel], signal_power, error_power);
+        }
+        const double sparse_snr = powerDb(signal_power, error_power);
+        const size_t expected_frames = signal_length / all.getDecimation();
+        
+        // A tone on one channel's centre, seen by its neighbours
+        const int centre = channels / 4;
+        all.reset();
+        const auto tone_outputs = runChannelizer(all, channelizerTestSignal(channels, signal_length, {centre * 1.0}));
+        const double centre_power = channelPower(tone_outputs[centre], settle);
+        double adjacent = 0.0;
+        double next = 0.0;
+        for (int step : {-1, 1}) {
+            const int neighbour = (centre + step + channels) % channels;
+            const int next_neighbour = (centre + 2 * step + channels) % channels;
+            adjacent = std::max(adjacent, channelPower(tone_outputs[neighbour], settle));
+            next = std::max(next, channelPower(tone_outputs[next_neighbour], settle));
+        }
+        const double adjacent_db = powerDb(centre_power, adjacent);
+        const double next_db = powerDb(centre_power, next);
+        
+        std::printf("%-11s %.0f Hz out, %zu frames: all channels %.1f dB, 2 channels %.1f dB SNR\n", mode,
+                    rate / all.getDecimation(), all_outputs[0].size(), all_snr, sparse_snr);
+        std::printf("            rejection %.1f dB adjacent, %.1f dB next\n", adjacent_db, next_db);
+        if (all_outputs[0].size() != expected_frames || sparse_outputs[sparse_a].size() != expected_frames ||
+            all_snr < 60.0 || sparse_snr < 60.0 || adjacent_db < 40.0 || next_db < 40.0) {
+            pass = false;
+        }
+    }
+    
+    // Cost on the source: channelizer with every channel and with two,
+    // against a mixer and decimating filter per channel
+    PolyphaseChannelizer all;
+    PolyphaseChannelizer sparse;
+    all.configure(channels, false);
+    sparse.configure(channels, false);
+    for (int channel = 0; channel < channels; ++channel) {
+        all.setActive(channel, true);
+    }
+    sparse.setActive(sparse_a, true);
+    sparse.setActive(sparse_b, true);
+    
+    const size_t block_samples = options.block_bytes / 2;
+    const int timed_chains = std::min(channels, TIMED_CHAINS);
+    std::vector<MixerChain> chains(timed_chains);
+    for (int i = 0; i < timed_chains; ++i) {
+        chains[i].filter.configure(all.getTaps(), all.getDecimation());
+        chains[i].step = std::polar(1.0f, static_cast<float>(-2.0 * M_PI * i / channels));
+        chains[i].mixed.resize(block_samples);
+        chains[i].output.resize(block_samples / all.getDecimation() + 1);
+    }
+    
+    std::vector<uint8_t> block(options.block_bytes);
+    std::vector<std::complex<float>> samples(block_samples);
+    const uint64_t byte_limit = byteLimit(options);
+    uint64_t bytes_done = 0;
+    std::chrono::steady_clock::duration all_time{0};
+    std::chrono::steady_clock::duration sparse_time{0};
+    std::chrono::steady_clock::duration chain_time{0};
+    while (bytes_done < byte_limit) {
+        size_t want = static_cast<size_t>(std::min<uint64_t>(block.size(), byte_limit - bytes_done));
+        size_t got = source.read(block.data(), want);
+        if (got == 0) {
+            break;
+        }
+        const size_t count = got / 2;
+        convertIQ8(block.data(), count, samples.data());
+        
+        auto start = std::chrono::steady_clock::now();
+        all.process(samples.data(), count);
+        auto after_all = std::chrono::steady_clock::now();
+        sparse.process(samples.data(), count);
+        auto after_sparse = std::chrono::steady_clock::now();
+        for (auto& chain : chains) {
+            runMixerChain(chain, samples.data(), count);
+        }
+        chain_time += std::chrono::steady_clock::now() - after_sparse;
+        sparse_time += after_sparse - after_all;
+        all_time += after_all - start;
+        bytes_done += got;
+    }
+    
+    const double source_samples = static_cast<double>(bytes_done / 2);
+    if (source_samples > 0.0) {
+        auto nsPerSample = [source_samples](std::chrono::steady_clock::duration time) {
+            return std::chrono::duration<double, std::nano>(time).count() / source_samples;
+        };
+        const double chains_ns = nsPerSample(chain_time) * channels / timed_chains;
+        std::printf("cost        %.1f ns/smp all %d channels, %.1f ns/smp 2 channels\n", nsPerSample(all_time),
+                    channels, nsPerSample(sparse_time));
+        std::printf("            %.1f ns/smp as %d mixer+filter chains (%d timed), %.1fx\n", chains_ns, channels,
+                    timed_chains, nsPerSample(all_time) > 0.0 ? chains_ns / nsPerSample(all_time) : 0.0);
+    }
+    
+    // ChannelBank: three modes on three channels; each must match a
+    // channelizer with the same channels active feeding its own
+    // Demodulator, and the rest stay silent
+    ChannelBank bank;
+    bank.configure(channels, true, static_cast<int>(options.config.sample_rate));
+    PolyphaseChannelizer direct;
+    direct.configure(channels, true);
+    const std::vector<std::pair<int, DemodulationType>> enabled = {
+        {sparse_a, DemodulationType::FM}, {channels / 2, DemodulationType::AM}, {sparse_b, DemodulationType::USB}};
+    std::vector<std::unique_ptr<Demodulator>> demodulators;
+    for (const auto& entry : enabled) {
+        bank.enableChannel(entry.first, entry.second);
+        direct.setActive(entry.first, true);
+        demodulators.push_back(std::make_unique<Demodulator>());
+        demodulators.back()->setType(entry.second);
+        demodulators.back()->setDecimation(1);
+        demodulators.back()->setFmDeviation(static_cast<int>(bank.getChannelRate()),
+                                            static_cast<int>(options.config.sample_rate) / channels / 2);
+    }
+    
+    const std::vector<std::complex<float>> signal = channelizerTestSignal(
+        channels, signal_length, {sparse_a + 0.1, channels / 2 + 0.2, sparse_b - 0.1});
+    std::vector<size_t> audio_counts(channels, 0);
+    std::vector<float> direct_audio;
+    size_t mismatched = 0;
+    size_t done = 0;
+    for (size_t block_index = 0; done < signal.size(); ++block_index) {
+        const size_t count = std::min<size_t>(1 + (block_index * 997) % 5000, signal.size() - done);
+        const size_t frames = bank.process(signal.data() + done, count);
+        for (int channel = 0; channel < channels; ++channel) {
+            audio_counts[channel] += bank.isEnabled(channel) ? bank.audioCount(channel) : 0;
+        }
+        
+        const size_t direct_frames = direct.process(signal.data() + done, count);
+        for (size_t i = 0; i < enabled.size(); ++i) {
+            const int channel = enabled[i].first;
+            direct_audio.resize(demodulators[i]->maxOutput(direct_frames));
+            const size_t produced = demodulators[i]->demodulate(direct.output(channel), direct_frames,
+                                                                direct_audio.data());
+            if (direct_frames != frames || produced != bank.audioCount(channel) ||
+                (produced > 0 && std::memcmp(direct_audio.data(), bank.audio(channel), produced * sizeof(float)) != 0)) {
+                ++mismatched;
+            }
+        }
+        done += count;
+    }
+    
+    int silent_enabled = 0;
+    int noisy_disabled = 0;
+    const size_t bank_frames = signal_length / bank.getChannelizer().getDecimation();
+    for (int channel = 0; channel < channels; ++channel) {
+        if (bank.isEnabled(channel) && audio_counts[channel] != bank_frames) {
+            ++silent_enabled;
+        } else if (!bank.isEnabled(channel) && audio_counts[channel] != 0) {
+            ++noisy_disabled;
+        }
+    }
+    std::printf("bank        %d of %d channels enabled at %.0f Hz: %d short, %d disabled with audio, %zu blocks differ\n",
+                bank.enabledCount(), channels, bank.getChannelRate(), silent_enabled, noisy_disabled, mismatched);
+    
+    if (!pass || bank.enabledCount() != static_cast<int>(enabled.size()) || silent_enabled > 0 ||
+        noisy_disabled > 0 || mismatched > 0) {
+        std::printf("result      FAIL\n");
+        return 1;
+    }
+    std::printf("result      PASS\n");
+    return 0;
+}
+
+// --check-vfo test capture: carrier k sits where VFO k listens, FM or AM
+// modulated by a tone of its own
+struct VfoCarrier {
+    VfoSettings settings;
+    double tone_hz;
+    double carrier_phase = 0.0;
+    double tone_phase = 0.0;
+};
+
+VfoCarrier vfoTestCarrier(int index) {
+    VfoCarrier carrier;
+    const int sign = index % 2 ? -1 : 1;
+    carrier.settings.offset_hz = sign * (index / 2 + 1) * 110000;
+    carrier.settings.bandwidth_hz = index % 2 ? 10000 : 12500;
+    carrier.settings.mode = index % 2 ? DemodulationType::AM : DemodulationType::FM;
+    carrier.tone_hz = 500.0 + 150.0 * index;
+    return carrier;
+}
+
+// FM with 2.5 kHz deviation or AM at 50 %, 0.1 full scale each, over a
+// little noise
+void vfoTestBlock(std::vector<VfoCarrier>& carriers, int sample_rate, std::complex<float>* out, size_t count,
+                  uint32_t& noise) {
+    const double step = 2.0 * M_PI / sample_rate;
+    for (size_t n = 0; n < count; ++n) {
+        std::complex<double> sum(0.0, 0.0);
+        for (auto& carrier : carriers) {
+            const double tone = std::sin(carrier.tone_phase);
+            double amplitude = 0.1;
+            if (carrier.settings.mode == DemodulationType::FM) {
+                carrier.carrier_phase += step * (carrier.settings.offset_hz + 2500.0 * tone);
+            } else {
+                carrier.carrier_phase += step * carrier.settings.offset_hz;
+                amplitude *= 1.0 + 0.5 * tone;
+            }
+            carrier.carrier_phase = std::remainder(carrier.carrier_phase, 2.0 * M_PI);
+            carrier.tone_phase = std::remainder(carrier.tone_phase + step * carrier.tone_hz, 2.0 * M_PI);
+            sum += std::polar(amplitude, carrier.carrier_phase);
+        }
+        noise = noise * 1664525u + 1013904223u;
+        const float re = (static_cast<float>(noise >> 8) / 16777216.0f - 0.5f) * 2e-3f;
+        noise = noise * 1664525u + 1013904223u;
+        const float im = (static_cast<float>(noise >> 8) / 16777216.0f - 0.5f) * 2e-3f;
+        out[n] = std::complex<float>(static_cast<float>(sum.real()) + re, static_cast<float>(sum.imag()) + im);
+    }
+}
+
+// Power of one frequency in audio[start..] (Goertzel)
+double tonePower(const std::vector<float>& audio, size_t start, double frequency, int sample_rate) {
+    const double coefficient = 2.0 * std::cos(2.0 * M_PI * frequency / sample_rate);
+    double s1 = 0.0;
+    double s2 = 0.0;
+    for (size_t i = start; i < audio.size(); ++i) {
+        const double s0 = audio[i] + coefficient * s1 - s2;
+        s2 = s1;
+        s1 = s0;
+    }
+    return s1 * s1 + s2 * s2 - coefficient * s1 * s2;
+}
+
+// Windowed-sinc low-pass, cutoff in cycles per sample
+std::vector<float> lowPassTaps(size_t num_taps, double cutoff) {
+    std::vector<float> taps(num_taps);
+    for (size_t i = 0; i < num_taps; ++i) {
+        const double n = i - (num_taps - 1) / 2.0;
+        const double hamming = 0.54 - 0.46 * std::cos(2.0 * M_PI * i / (num_taps - 1));
+        taps[i] = static_cast<float>((n == 0.0 ? 2.0 * cutoff : std::sin(2.0 * M_PI * cutoff * n) / (M_PI * n)) *
+                                     hamming);
+    }
+    return taps;
+}
+
+// TranslatingFIR against mixing down in double, then filtering: SNR of
+// its output in dB
+double translatingFirSnr() {
+    const int decimation = 21;
+    const double offset = 0.137;
+    const std::vector<float> taps = lowPassTaps(255, 0.02);
+    
+    std::vector<VfoCarrier> carriers = {vfoTestCarrier(0), vfoTestCarrier(1)};
+    carriers[0].settings.offset_hz = static_cast<int>(offset * 2048000) + 3000;
+    std::vector<std::complex<float>> input(decimation * 400);
+    uint32_t noise = 777;
+    vfoTestBlock(carriers, 2048000, input.data(), input.size(), noise);
+    
+    TranslatingFIR filter;
+    filter.configure(taps, decimation, offset);
+    std::vector<std::complex<float>> output(input.size() / decimation + 1);
+    size_t produced = 0;
+    for (size_t done = 0, block = 0; done < input.size(); ++block) {
+        const size_t count = std::min<size_t>(1 + (block * 389) % 700, input.size() - done);
+        produced += filter.process(input.data() + done, count, output.data() + produced);
+        done += count;
+    }
+    
+    double signal_power = 0.0;
+    double error_power = 0.0;
+    for (size_t m = 0; m < produced; ++m) {
+        const size_t newest = (m + 1) * decimation - 1;
+        std::complex<double> sum(0.0, 0.0);
+        for (size_t i = 0; i < taps.size() && i <= newest; ++i) {
+            const size_t n = newest - i;
+            sum += static_cast<double>(taps[i]) * std::complex<double>(input[n]) *
+                   std::polar(1.0, -2.0 * M_PI * std::fmod(offset * n, 1.0));
+        }
+        signal_power += std::norm(sum);
+        error_power += std::norm(std::complex<double>(output[m]) - sum);
+    }
+    return powerDb(signal_power, error_power);
+}
+
+// An unmodulated carrier on the filter's offset comes out as a constant;
+// retuning a little mid-stream must bend it, not step it. Returns the
+// largest step between outputs around the retune, over the output level.
+double translatingFirRetuneStep() {
+    const int decimation = 21;
+    const double offset = -0.2;
+    std::vector<float> taps(255, 1.0f / 255.0f);
+    TranslatingFIR filter;
+    filter.configure(taps, decimation, offset);
+    
+    const size_t block = decimation * 50;
+    std::vector<std::complex<float>> input(block);
+    std::vector<std::complex<float>> output(block / decimation + 1);
+    double phase = 0.0;
+    double level = 0.0;
+    double largest = 0.0;
+    std::complex<float> previous(0.0f, 0.0f);
+    for (int pass = 0; pass < 4; ++pass) {
+        for (auto& sample : input) {
+            sample = std::polar(1.0f, static_cast<float>(phase));
+            phase = std::remainder(phase + 2.0 * M_PI * offset, 2.0 * M_PI);
+        }
+        if (pass == 2) {
+            filter.setOffset(offset + 1e-4);
+        }
+        const size_t produced = filter.process(input.data(), input.size(), output.data());
+        for (size_t i = 0; i < produced; ++i) {
+            // Passes 0 and 1 fill the filter
+            if (pass >= 1) {
+                level = std::max(level, static_cast<double>(std::abs(output[i])));
+                if (pass >= 2 || i > 0) {
+                    largest = std::max(largest, static_cast<double>(std::abs(output[i] - previous)));
+                }
+            }
+            previous = output[i];
+        }
+    }
+    return level > 0.0 ? largest / level : INFINITY;
+}
+
+// Each VFO's audio so far
+void collectVfoAudio(VfoBank& bank, const std::vector<int>& ids, std::vector<std::vector<float>>& audio,
+                     std::vector<float>& scratch) {
+    for (size_t i = 0; i < ids.size(); ++i) {
+        const size_t count = bank.readAudio(ids[i], scratch.data(), scratch.size());
+        audio[i].insert(audio[i].end(), scratch.begin(), scratch.begin() + count);
+    }
+}
+
+// TranslatingFIR against a double reference and across a retune, then
+// --vfos receivers on a capture holding one test carrier per VFO, as one
+// bank run serially and one on the DspExecutor: each VFO must hear its
+// own carrier's tone well above the others' and both banks must agree
+// bit for bit. Last, a control thread adds, retunes and removes a VFO
+// while blocks stream; the rest must keep going.
+int runVfoCheck(const Options& options) {
+    const int vfos = std::max(1, std::min(options.vfos, VfoBank::MAX_VFOS - 1));
+    const int sample_rate = static_cast<int>(options.config.sample_rate);
+    const int audio_rate = 48000;
+    const size_t block_samples = options.block_bytes / 2;
+    const uint64_t total_samples = static_cast<uint64_t>(std::max(options.seconds, 0.5) * sample_rate);
+    
+    const double fir_snr = translatingFirSnr();
+    const double retune_step = translatingFirRetuneStep();
+    
+    std::vector<VfoCarrier> carriers;
+    for (int i = 0; i < vfos; ++i) {
+        carriers.push_back(vfoTestCarrier(i));
+    }
+    
+    DspExecutor executor(options.workers, options.config.demod_placement);
+    VfoBank serial;
+    VfoBank pooled;
+    pooled.setExecutor(&executor);
+    std::vector<int> serial_ids;
+    std::vector<int> pooled_ids;
+    for (VfoBank* bank : {&serial, &pooled}) {
+        bank->setSampleRate(sample_rate);
+        bank->setAudioSampleRate(audio_rate);
+        std::vector<int>& ids = bank == &serial ? serial_ids : pooled_ids;
+        for (const auto& carrier : carriers) {
+            ids.push_back(bank->addVfo(carrier.settings));
+        }
+    }
+    
+    std::vector<std::complex<float>> samples(block_samples);
+    std::vector<float> scratch(8192);
+    std::vector<std::vector<float>> serial_audio(vfos);
+    std::vector<std::vector<float>> pooled_audio(vfos);
+    uint32_t noise = 12345;
+    uint64_t done = 0;
+    std::chrono::steady_clock::duration serial_time{0};
+    std::chrono::steady_clock::duration pooled_time{0};
+    while (done < total_samples) {
+        const size_t count = static_cast<size_t>(std::min<uint64_t>(block_samples, total_samples - done));
+        vfoTestBlock(carriers, sample_rate, samples.data(), count, noise);
+        auto start = std::chrono::steady_clock::now();
+        serial.process(samples.data(), count);
+        auto middle = std::chrono::steady_clock::now();
+        pooled.process(samples.data(), count);
+        pooled_time += std::chrono::steady_clock::now() - middle;
+        serial_time += middle - start;
+        collectVfoAudio(serial, serial_ids, serial_audio, scratch);
+        collectVfoAudio(pooled, pooled_ids, pooled_audio, scratch);
+        done += count;
+    }
+    
+    std::printf("signal      %.3f s at %d Hz, %d VFOs, %zu-sample blocks\n",
+                static_cast<double>(done) / sample_rate, sample_rate, vfos, block_samples);
+    std::printf("filter      translating FIR %.1f dB SNR against a double mixer, retune step %.4f of level\n",
+                fir_snr, retune_step);
+    std::printf("vfo         %-4s %9s %7s %6s %9s %9s %8s %9s\n", "id", "offset", "mode", "bw", "taps/dec",
+                "audio", "isol dB", "budget %");
+    
+    bool pass = fir_snr >= 60.0 && retune_step < 0.02;
+    int mismatched = 0;
+    const size_t settle = audio_rate / 5;
+    for (int i = 0; i < vfos; ++i) {
+        const std::vector<float>& audio = serial_audio[i];
+        const double own = tonePower(audio, settle, carriers[i].tone_hz, audio_rate);
+        double others = 0.0;
+        for (int j = 0; j < vfos; ++j) {
+            if (j != i) {
+                others = std::max(others, tonePower(audio, settle, carriers[j].tone_hz, audio_rate));
+            }
+        }
+        const double isolation = vfos > 1 ? powerDb(own, others) : INFINITY;
+        PipelineStats stats;
+        serial.getStats(serial_ids[i], stats);
+        
+        SignalProcessor probe;
+        probe.setSampleRate(sample_rate);
+        probe.setBandwidth(carriers[i].settings.bandwidth_hz);
+        std::printf("            %-4d %+9d %7s %6d %4zu/%-4d %9zu %8.1f %9.3f\n", serial_ids[i],
+                    carriers[i].settings.offset_hz, carriers[i].settings.mode == DemodulationType::FM ? "fm" : "am",
+                    carriers[i].settings.bandwidth_hz, probe.getChannelFilterTaps(), probe.getChannelDecimation(),
+                    audio.size(), isolation, stats.busy_percent);
+        
+        const std::vector<float>& other = pooled_audio[i];
+        if (audio.size() != other.size() ||
+            (!audio.empty() && std::memcmp(audio.data(), other.data(), audio.size() * sizeof(float)) != 0)) {
+            ++mismatched;
+        }
+        if (audio.size() <= settle || isolation < 20.0) {
+            pass = false;
+        }
+    }
+    
+    const double serial_seconds = std::chrono::duration<double>(serial_time).count();
+    const double pooled_seconds = std::chrono::duration<double>(pooled_time).count();
+    std::printf("serial      %.3f s, %.1f%% of real time\n", serial_seconds,
+                100.0 * serial_seconds * sample_rate / static_cast<double>(done));
+    if (pooled_seconds > 0.0) {
+        std::printf("pooled      %.3f s (%.2fx) on %d workers + caller, %d of %d VFOs differ from serial\n",
+                    pooled_seconds, serial_seconds / pooled_seconds, executor.workerCount(), mismatched, vfos);
+    }
+    
+    // Live changes: the control thread plays the UI, the loop below the
+    // processing thread
+    std::atomic<bool> streaming{true};
+    std::atomic<uint64_t> changes{0};
+    std::atomic<uint64_t> failed_changes{0};
+    std::chrono::steady_clock::duration worst_read{0};   // the control thread's, read after join()
+    std::thread control([&]() {
+        std::vector<float> audio(4096);
+        int round = 0;
+        while (streaming.load()) {
+            VfoSettings settings;
+            settings.offset_hz = -900000 + (round * 37000) % 1800000;
+            settings.bandwidth_hz = round % 3 ? 12500 : 25000;
+            const int id = pooled.addVfo(settings);
+            bool ok = id >= 0;
+            for (int step = 0; ok && step < 5; ++step) {
+                settings.offset_hz += 500;
+                ok = pooled.updateVfo(id, settings);
+                const auto read_start = std::chrono::steady_clock::now();
+                pooled.readAudio(id, audio.data(), audio.size());
+                worst_read = std::max(worst_read, std::chrono::steady_clock::now() - read_start);
+                std::this_thread::sleep_for(std::chrono::milliseconds(2));
+            }
+            settings.mode = DemodulationType::USB;
+            settings.bandwidth_hz = 3000;
+            ok = ok && pooled.updateVfo(id, settings) && pooled.removeVfo(id);
+            (ok ? changes : failed_changes).fetch_add(1);
+            ++round;
+        }
+    });
+    
+    const uint64_t generation = pooled.generation();
+    std::vector<std::vector<float>> live_audio(vfos);
+    const uint64_t live_samples = static_cast<uint64_t>(sample_rate);
+    std::chrono::steady_clock::duration worst_block{0};
+    for (uint64_t live = 0; live < live_samples; live += block_samples) {
+        vfoTestBlock(carriers, sample_rate, samples.data(), block_samples, noise);
+        const auto block_start = std::chrono::steady_clock::now();
+        pooled.process(samples.data(), block_samples);
+        worst_block = std::max(worst_block, std::chrono::steady_clock::now() - block_start);
+        collectVfoAudio(pooled, pooled_ids, live_audio, scratch);
+    }
+    streaming.store(false);
+    control.join();
+    
+    int starved = 0;
+    for (int i = 0; i < vfos; ++i) {
+        // One second of audio, less what a block boundary can hold back
+        if (live_audio[i].size() < static_cast<size_t>(audio_rate * 9 / 10)) {
+            ++starved;
+        }
+    }
+    std::printf("live        %llu add/retune/remove rounds (%llu failed), %llu set changes, %d of %d VFOs starved, %zu left\n",
+                static_cast<unsigned long long>(changes.load()), static_cast<unsigned long long>(failed_changes.load()),
+                static_cast<unsigned long long>(pooled.generation() - generation), starved, vfos, pooled.size());
+    // readAudio() takes only its VFO's buffer lock, so it should not wait
+    // out a block in flight
+    std::printf("reader      worst readAudio %.1f us, worst block %.1f us\n",
+                std::chrono::duration<double, std::micro>(worst_read).count(),
+                std::chrono::duration<double, std::micro>(worst_block).count());
+    
+    if (!pass || mismatched > 0 || failed_changes.load() > 0 || changes.load() == 0 || starved > 0 ||
+        pooled.size() != static_cast<size_t>(vfos)) {
+        std::printf("result      FAIL\n");
+        return 1;
+    }
+    std::printf("result      PASS\n");
+    return 0;
+}
+
+// --check-nco: Nco phasors against a double-precision oscillator retuned
+// at the same samples, every block, so a phase step at a retune shows up
+// as error. mix() and next() are checked on their own.
+struct NcoAccuracy {
+    double mix_snr;
+    double next_snr;
+    double max_phase_error;     // radians, mix()
+    int retunes;
+};
+
+NcoAccuracy ncoAccuracy(size_t total) {
+    const double frequencies[] = {0.1234567, -0.31, 0.0004, 0.4999, -0.05};
+    Nco mixer;
+    Nco scalar;
+    std::vector<std::complex<float>> ones(4096, std::complex<float>(1.0f, 0.0f));
+    std::vector<std::complex<float>> output(ones.size());
+    
+    NcoAccuracy result = {0.0, 0.0, 0.0, 0};
+    double phase = 0.0;
+    double signal_power = 0.0;
+    double mix_error = 0.0;
+    double next_error = 0.0;
+    size_t done = 0;
+    for (size_t block = 0; done < total; ++block, ++result.retunes) {
+        const double frequency = frequencies[block % 5];
+        mixer.setFrequency(frequency);
+        scalar.setFrequency(frequency);
+        const size_t count = std::min<size_t>(1 + (block * 1543) % ones.size(), total - done);
+        mixer.mix(ones.data(), count, output.data());
+        for (size_t i = 0; i < count; ++i) {
+            const std::complex<double> reference = std::polar(1.0, phase);
+            const std::complex<double> mixed(output[i]);
+            signal_power += 1.0;
+            mix_error += std::norm(mixed - reference);
+            next_error += std::norm(std::complex<double>(scalar.next()) - reference);
+            result.max_phase_error = std::max(result.max_phase_error, std::abs(std::arg(mixed * std::conj(reference))));
+            phase = std::remainder(phase + 2.0 * M_PI * frequency, 2.0 * M_PI);
+        }
+        done += count;
+    }
+    result.mix_snr = powerDb(signal_power, mix_error);
+    result.next_snr = powerDb(signal_power, next_error);
+    return result;
+}
+
+// ns per sample mixing block after block: the Nco, and std::polar per
+// sample as the plain alternative
+void ncoThroughput(double& nco_ns, double& polar_ns) {
+    const size_t block = 16384;
+    const int passes = 200;
+    const double frequency = 0.0371;
+    std::vector<std::complex<float>> input(block);
+    std::vector<std::complex<float>> output(block);
+    uint32_t noise = 99;
+    for (auto& sample : input) {
+        noise = noise * 1664525u + 1013904223u;
+        sample = std::polar(0.5f, static_cast<float>(noise >> 8) / 16777216.0f * 6.2831853f);
+    }
+    
+    Nco nco;
+    nco.setFrequency(frequency);
+    auto start = std::chrono::steady_clock::now();
+    for (int pass = 0; pass < passes; ++pass) {
+        nco.mix(input.data(), block, output.data());
+    }
+    auto middle = std::chrono::steady_clock::now();
+    float phase = 0.0f;
+    const float step = static_cast<float>(2.0 * M_PI * frequency);
+    for (int pass = 0; pass < passes; ++pass) {
+        for (size_t i = 0; i < block; ++i) {
+            output[i] = input[i] * std::polar(1.0f, phase);
+            phase += step;
+            if (phase > static_cast<float>(M_PI)) {
+                phase -= static_cast<float>(2.0 * M_PI);
+            }
+        }
+    }
+    auto end = std::chrono::steady_clock::now();
+    const double samples = static_cast<double>(block) * passes;
+    nco_ns = std::chrono::duration<double, std::nano>(middle - start).count() / samples;
+    polar_ns = std::chrono::duration<double, std::nano>(end - middle).count() / samples;
+}
+
+// The NCO fused into the channel filter (TranslatingFIR, one rotation per
+// output) against standing alone in front of it (Nco::mix, then a
+// DecimatingFIR): SNR between the two and ns per input sample of each
+const size_t FUSED_TAPS = 255;
+const int FUSED_DECIMATION = 21;
+
+void ncoFusedAgainstStandalone(double& snr, double& fused_ns, double& standalone_ns) {
+    const int decimation = FUSED_DECIMATION;
+    const double offset = 0.137;
+    const size_t block = 16380;
+    const std::vector<float> taps = lowPassTaps(FUSED_TAPS, 0.02);
+    
+    std::vector<VfoCarrier> carriers = {vfoTestCarrier(0), vfoTestCarrier(1)};
+    carriers[0].settings.offset_hz = static_cast<int>(offset * 2048000) + 3000;
+    std::vector<std::complex<float>> input(block * 40);
+    uint32_t noise = 4242;
+    vfoTestBlock(carriers, 2048000, input.data(), input.size(), noise);
+    
+    TranslatingFIR fused;
+    fused.configure(taps, decimation, offset);
+    Nco mixer;
+    mixer.setFrequency(-offset);
+    DecimatingFIR filter;
+    filter.configure(taps, decimation);
+    std::vector<std::complex<float>> mixed(block);
+    std::vector<std::complex<float>> fused_output(input.size() / decimation + 1);
+    std::vector<std::complex<float>> standalone_output(fused_output.size());
+    
+    size_t fused_count = 0;
+    size_t standalone_count = 0;
+    std::chrono::steady_clock::duration fused_time{0};
+    std::chrono::steady_clock::duration standalone_time{0};
+    for (size_t done = 0; done < input.size(); done += block) {
+        auto start = std::chrono::steady_clock::now();
+        fused_count += fused.process(input.data() + done, block, fused_output.data() + fused_count);
+        auto middle = std::chrono::steady_clock::now();
+        mixer.mix(input.data() + done, block, mixed.data());
+        standalone_count += filter.process(mixed.data(), block, standalone_output.data() + standalone_count);
+        standalone_time += std::chrono::steady_clock::now() - middle;
+        fused_time += middle - start;
+    }
+    
+    double signal_power = 0.0;
+    double error_power = 0.0;
+    for (size_t i = 0; i < std::min(fused_count, standalone_count); ++i) {
+        signal_power += std::norm(std::complex<double>(standalone_output[i]));
+        error_power += std::norm(std::complex<double>(fused_output[i]) - std::complex<double>(standalone_output[i]));
+    }
+    snr = fused_count == standalone_count ? powerDb(signal_power, error_power) : -INFINITY;
+    fused_ns = std::chrono::duration<double, std::nano>(fused_time).count() / input.size();
+    standalone_ns = std::chrono::duration<double, std::nano>(standalone_time).count() / input.size();
+}
+
+// A receiver moved off centre while running, then retuned, without
+// touching the tuner: it must hear carrier 0's tone after the first move
+// and carrier 2's after the second, each over the other. Isolation in dB
+// for both stretches.
+// path: the form the receiver ended up running
+void offsetReceiverRun(ChannelFilterMode mode, bool fixed_point, int sample_rate, double& first_db,
+                       double& second_db, const char*& path) {
+    const int audio_rate = 48000;
+    const size_t block = 16384;
+    std::vector<VfoCarrier> carriers = {vfoTestCarrier(0), vfoTestCarrier(2)};
+    
+    SignalProcessor processor;
+    processor.setSampleRate(sample_rate);
+    processor.setAudioSampleRate(audio_rate);
+    processor.setBandwidth(carriers[0].settings.bandwidth_hz);
+    processor.setChannelFilterMode(mode);
+    if (fixed_point) {
+        processor.setProcessingMode(ProcessingMode::FIXED_POINT);
+    }
+    
+    std::vector<std::complex<float>> samples(block);
+    std::vector<float> scratch(8192);
+    std::vector<float> stretches[3];
+    uint32_t noise = 31337;
+    for (int stretch = 0; stretch < 3; ++stretch) {
+        if (stretch > 0) {
+            processor.setFrequencyOffset(carriers[stretch - 1].settings.offset_hz);
+        }
+        for (size_t done = 0; done < static_cast<size_t>(sample_rate) / 2; done += block) {
+            vfoTestBlock(carriers, sample_rate, samples.data(), block, noise);
+            processor.processSamples(samples.data(), block);
+            const size_t count = processor.readAudioSamples(scratch.data(), scratch.size());
+            stretches[stretch].insert(stretches[stretch].end(), scratch.begin(), scratch.begin() + count);
+        }
+    }
+    
+    path = processor.isTranslatingFilterActive() ? "translating"
+         : fixed_point                           ? "nco+q15"
+         : processor.isFastConvolutionActive()   ? "nco+fft"
+                                                 : "nco+direct";
+    
+    const size_t settle = audio_rate / 10;
+    first_db = powerDb(tonePower(stretches[1], settle, carriers[0].tone_hz, audio_rate),
+                       tonePower(stretches[1], settle, carriers[1].tone_hz, audio_rate));
+    second_db = powerDb(tonePower(stretches[2], settle, carriers[1].tone_hz, audio_rate),
+                        tonePower(stretches[2], settle, carriers[0].tone_hz, audio_rate));
+}
+
+// setFrequencyOffset() from a control thread, as the UI calls it, while
+// the loop below streams blocks: the retunes must land between blocks and
+// the audio keep coming. Returns the retunes made; audio_fraction is the
+// audio produced over what one second should give.
+uint64_t offsetRetuneLive(int sample_rate, double& audio_fraction) {
+    const int audio_rate = 48000;
+    const size_t block = 16384;
+    std::vector<VfoCarrier> carriers = {vfoTestCarrier(0), vfoTestCarrier(2)};
+    SignalProcessor processor;
+    processor.setSampleRate(sample_rate);
+    processor.setAudioSampleRate(audio_rate);
+    processor.setBandwidth(carriers[0].settings.bandwidth_hz);
+    
+    std::atomic<bool> streaming{true};
+    std::atomic<uint64_t> retunes{0};
+    std::thread control([&]() {
+        const int offsets[] = {0, 110000, 110500, 220000, -5000};
+        for (int round = 0; streaming.load(); ++round) {
+            processor.setFrequencyOffset(offsets[round % 5]);
+            retunes.fetch_add(1);
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    });
+    
+    std::vector<std::complex<float>> samples(block);
+    std::vector<float> scratch(8192);
+    size_t audio = 0;
+    uint32_t noise = 2718;
+    for (size_t done = 0; done < static_cast<size_t>(sample_rate); done += block) {
+        vfoTestBlock(carriers, sample_rate, samples.data(), block, noise);
+        processor.processSamples(samples.data(), block);
+        audio += processor.readAudioSamples(scratch.data(), scratch.size());
+    }
+    streaming.store(false);
+    control.join();
+    
+    audio_fraction = static_cast<double>(audio) / audio_rate;
+    return retunes.load();
+}
+
+// The NCO on its own (accuracy over retunes, throughput), fused into the
+// channel filter against in front of it, then SignalProcessor off centre
+// on every channel filter form
+int runNcoCheck(const Options& options) {
+    const int sample_rate = static_cast<int>(options.config.sample_rate);
+    const size_t total = static_cast<size_t>(std::max(options.seconds, 0.1) * sample_rate);
+    
+    const NcoAccuracy accuracy = ncoAccuracy(total);
+    std::printf("nco         %zu samples, %d retunes: mix %.1f dB, next %.1f dB SNR against double, "
+                "max phase error %.2e rad\n",
+                total, accuracy.retunes, accuracy.mix_snr, accuracy.next_snr, accuracy.max_phase_error);
+    
+    double nco_ns = 0.0;
+    double polar_ns = 0.0;
+    ncoThroughput(nco_ns, polar_ns);
+    std::printf("throughput  nco %.2f ns/smp, std::polar per sample %.2f ns/smp (%.1fx)\n", nco_ns, polar_ns,
+                polar_ns / nco_ns);
+    
+    double fused_snr = 0.0;
+    double fused_ns = 0.0;
+    double standalone_ns = 0.0;
+    ncoFusedAgainstStandalone(fused_snr, fused_ns, standalone_ns);
+    std::printf("fused       translating FIR %.2f ns/smp, nco + FIR %.2f ns/smp, %.1f dB SNR between them\n",
+                fused_ns, standalone_ns, fused_snr);
+    std::printf("cost model  %zu taps / %d: translating %.1f, nco + FIR %.1f multiply-adds/smp\n",
+                FUSED_TAPS, FUSED_DECIMATION, TranslatingFIR::cost(FUSED_TAPS, FUSED_DECIMATION),
+                OverlapSaveFilter::directCost(FUSED_TAPS, FUSED_DECIMATION) + Nco::MIX_COST);
+    
+    bool pass = accuracy.mix_snr >= 90.0 && accuracy.next_snr >= 90.0 && fused_snr >= 80.0;
+    
+    struct Form {
+        const char* name;
+        ChannelFilterMode mode;
+        bool fixed_point;
+    };
+    const Form forms[] = {
+        {"direct", ChannelFilterMode::DIRECT, false},
+        {"fft", ChannelFilterMode::FAST_CONVOLUTION, false},
+        {"fixed", ChannelFilterMode::DIRECT, true},
+    };
+    std::printf("receiver    %-8s %-12s %10s %10s\n", "filter", "path", "1st dB", "2nd dB");
+    for (const Form& form : forms) {
+        double first_db = 0.0;
+        double second_db = 0.0;
+        const char* path = "";
+        offsetReceiverRun(form.mode, form.fixed_point, sample_rate, first_db, second_db, path);
+        std::printf("            %-8s %-12s %10.1f %10.1f\n", form.name, path, first_db, second_db);
+        if (first_db < 20.0 || second_db < 20.0) {
+            pass = false;
+        }
+    }
+    
+    double audio_fraction = 0.0;
+    const uint64_t retunes = offsetRetuneLive(sample_rate, audio_fraction);
+    std::printf("live        %llu offset changes from another thread, %.1f%% of the audio delivered\n",
+                static_cast<unsigned long long>(retunes), 100.0 * audio_fraction);
+    if (retunes == 0 || audio_fraction < 0.9) {
+        pass = false;
+    }
+    
+    std::printf("result      %s\n", pass ? "PASS" : "FAIL");
+    return pass ? 0 : 1;
+}
+
+// --check-fm: a tone at a service's nominal FM deviation through
+// SignalProcessor in float and Q15, at both audio rates the apps open. The
+// discriminator gain has to follow the rate the demodulator actually runs
+// at; one tuned for the capture rate clips the tone into a square wave,
+// which SINAD shows. The audio must also come out at the rate asked for:
+// 44100 Hz has no filter bank from the capture rate without decimating
+// to a different rate first.
+struct FmService {
+    const char* name;
+    int bandwidth_hz;
+    double deviation_hz;
+};
+
+const FmService FM_SERVICES[] = {
+    {"broadcast", 200000, 75000.0},
+    {"nbfm-25k", 25000, 5000.0},
+    {"nbfm-12k5", 12500, 2500.0},
+};
+
+const int FM_CHECK_AUDIO_RATES[] = {48000, 44100};
+const double FM_CHECK_TONE_HZ = 1000.0;
+const double FM_CHECK_MIN_SINAD_DB = 30.0;
+const double FM_CHECK_MAX_RATE_ERROR = 0.005;
+
+// Tone against everything else in the audio after settle, in dB, summed
+// over windows of whole tone periods: short enough that the AGC's slow
+// gain changes stay out of the residual
+double fmSinad(const std::vector<float>& audio, size_t settle, int sample_rate) {
+    const size_t window = static_cast<size_t>(std::lround(sample_rate * 100 / FM_CHECK_TONE_HZ));
+    double tone = 0.0;
+    double total = 0.0;
+    for (size_t start = settle; start + window <= audio.size(); start += window) {
+        const std::vector<float> part(audio.begin() + start, audio.begin() + start + window);
+        for (float sample : part) {
+            total += static_cast<double>(sample) * sample;
+        }
+        tone += 2.0 * tonePower(part, 0, FM_CHECK_TONE_HZ, sample_rate) / window;
+    }
+    return tone > 0.0 ? powerDb(tone, std::max(total - tone, 1e-20)) : 0.0;
+}
+
+// rate_ratio: audio samples delivered over what audio_rate promises for
+// the input fed
+double fmServiceSinad(const FmService& service, bool fixed_point, int sample_rate, int audio_rate, size_t total,
+                      double& rate_ratio) {
+    SignalProcessor processor;
+    processor.setSampleRate(sample_rate);
+    processor.setAudioSampleRate(audio_rate);
+    processor.setBandwidth(service.bandwidth_hz);
+    processor.setDemodulationType(DemodulationType::FM);
+    processor.setSquelch(-100);
+    if (fixed_point) {
+        processor.setProcessingMode(ProcessingMode::FIXED_POINT);
+    }
+    
+    const size_t block = 16384;
+    std::vector<std::complex<float>> samples(block);
+    std::vector<float> scratch(8192);
+    std::vector<float> audio;
+    double carrier_phase = 0.0;
+    double tone_phase = 0.0;
+    const double step = 2.0 * M_PI / sample_rate;
+    size_t done = 0;
+    for (; done < total; done += block) {
+        for (size_t n = 0; n < block; ++n) {
+            carrier_phase = std::remainder(carrier_phase + step * service.deviation_hz * std::sin(tone_phase),
+                                           2.0 * M_PI);
+            tone_phase = std::remainder(tone_phase + step * FM_CHECK_TONE_HZ, 2.0 * M_PI);
+            samples[n] = std::polar(0.5f, static_cast<float>(carrier_phase));
+        }
+        processor.processSamples(samples.data(), block);
+        const size_t count = processor.readAudioSamples(scratch.data(), scratch.size());
+        audio.insert(audio.end(), scratch.begin(), scratch.begin() + count);
+    }
+    rate_ratio = audio.size() / (static_cast<double>(done) * audio_rate / sample_rate);
+    return fmSinad(audio, audio_rate / 5, audio_rate);
+}
+
+int runFmCheck(const Options& options) {
+    const int sample_rate = static_cast<int>(options.config.sample_rate);
+    const size_t total = static_cast<size_t>(std::max(options.seconds, 0.5) * sample_rate);
+    
+    std::printf("fm          %.0f Hz tone, SINAD in dB (minimum %.0f), audio delivered in %% of the rate "
+                "(within %.1f%%)\n", FM_CHECK_TONE_HZ, FM_CHECK_MIN_SINAD_DB, 100.0 * FM_CHECK_MAX_RATE_ERROR);
+    std::printf("            %-10s %9s %10s %7s %8s %8s %8s\n", "service", "bw", "deviation", "audio", "float",
+                "fixed", "rate %");
+    bool pass = true;
+    for (int audio_rate : FM_CHECK_AUDIO_RATES) {
+        for (const FmService& service : FM_SERVICES) {
+            double float_ratio = 0.0;
+            double fixed_ratio = 0.0;
+            const double float_sinad = fmServiceSinad(service, false, sample_rate, audio_rate, total, float_ratio);
+            const double fixed_sinad = fmServiceSinad(service, true, sample_rate, audio_rate, total, fixed_ratio);
+            std::printf("            %-10s %9d %10.0f %7d %8.1f %8.1f %8.2f\n", service.name, service.bandwidth_hz,
+                        service.deviation_hz, audio_rate, float_sinad, fixed_sinad, 100.0 * float_ratio);
+            if (float_sinad < FM_CHECK_MIN_SINAD_DB || fixed_sinad < FM_CHECK_MIN_SINAD_DB) {
+                pass = false;
+            }
+            if (std::fabs(float_ratio - 1.0) > FM_CHECK_MAX_RATE_ERROR ||
+                std::fabs(fixed_ratio - 1.0) > FM_CHECK_MAX_RATE_ERROR) {
+                pass = false;
+            }
+        }
+    }
+    
+    std::printf("result      %s\n", pass ? "PASS" : "FAIL");
+    return pass ? 0 : 1;
+}
+
+// One line per LatencyStage
+void printLatency(const LatencyTracer& tracer) {
+    std::printf("latency     %-6s %9s %9s %9s %9s %9s\n", "stage", "blocks", "mean us", "p50 us", "p99 us", "max us");
+    for (int i = 0; i < static_cast<int>(LatencyStage::COUNT); ++i) {
+        LatencyStage stage = static_cast<LatencyStage>(i);
+        LatencySummary summary = tracer.summary(stage);
+        std::printf("            %-6s %9llu %9.1f %9.0f %9.0f %9.0f\n", LatencyTracer::stageName(stage),
+                    static_cast<unsigned long long>(summary.count), summary.mean_us,
+                    summary.p50_us, summary.p99_us, summary.max_us);
+    }
+}
+
+// One line per PipelineStage, then the whole-block budget
+void printPipelineStats(const PipelineProfiler& profiler) {
+    PipelineStats stats = profiler.snapshot();
+    std::printf("stages      %-8s %9s %11s %9s %9s\n", "stage", "calls", "samples", "ns/smp", "budget %");
+    for (int i = 0; i < static_cast<int>(PipelineStage::COUNT); ++i) {
+        const StageStats& stage = stats.stages[i];
+        std::printf("            %-8s %9llu %11llu %9.2f %9.3f\n",
+                    PipelineProfiler::stageName(static_cast<PipelineStage>(i)),
+                    static_cast<unsigned long long>(stage.calls),
+                    static_cast<unsigned long long>(stage.samples),
+                    stage.ns_per_sample, stage.budget_percent);
+    }
+    std::printf("budget      %.3f %% busy, worst block %.2f %%, %llu of %llu blocks missed\n",
+                stats.busy_percent, stats.worst_block_percent,
+                static_cast<unsigned long long>(stats.deadline_misses),
+                static_cast<unsigned long long>(stats.blocks));
+}
+
+// Queue depth, underruns and write-to-playout delay of a clocked run
+void printClockedStats(const ClockedAudioSink& sink) {
+    std::printf("queue       %d x %d frames, limit %zu samples, max %zu queued\n",
+                sink.getBufferCount(), sink.getFramesPerBuffer(),
+                sink.getQueueCapacity(), sink.getMaxQueuedSamples());
+    std::printf("underruns   %llu in %llu buffers\n",
+                static_cast<unsigned long long>(sink.getUnderrunCount()),
+                static_cast<unsigned long long>(sink.getBuffersPlayed()));
+    std::printf("dropped     %llu samples\n", static_cast<unsigned long long>(sink.getDroppedSamples()));
+    std::printf("delay       p50 %.1f ms, p95 %.1f ms, p99 %.1f ms, max %.1f ms (%llu blocks)\n",
+                sink.getDelayPercentileMs(50.0), sink.getDelayPercentileMs(95.0),
+                sink.getDelayPercentileMs(99.0), sink.getMaxDelayMs(),
+                static_cast<unsigned long long>(sink.getDelayCount()));
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        printUsage(argv[0]);
+        return 2;
+    }
+    
+    sdrradio_cli_set_log_level(options.verbose ? ANDROID_LOG_DEBUG : ANDROID_LOG_WARN);
+    
+    std::atexit([] { async_log_flush(); });
+    
+    if (options.check_ring) {
+        return runRingCheck(options);
+    }
+    if (options.check_log) {
+        return runLogCheck();
+    }
+    if (options.check_idle) {
+        return runIdleCheck(options);
+    }
+    if (options.check_vfo) {
+        return runVfoCheck(options);
+    }
+    if (options.check_nco) {
+        return runNcoCheck(options);
+    }
+    if (options.check_fm) {
+        return runFmCheck(options);
+    }
+    
+    std::unique_ptr<IQSource> source = createSource(options.source, options.config.sample_rate);
+    if (!source) {
+        std::fprintf(stderr, "cannot open source '%s'\n", options.source.c_str());
+        return 1;
+    }
+    
+    if (options.check_drift) {
+        return runDriftCheck(options, *source);
+    }
+    if (options.check_executor) {
+        return runExecutorCheck(options, *source);
+    }
+    if (options.check_channelizer != 0) {
+        return runChannelizerCheck(options, *source);
+    }
+    if (options.compare_fixed) {
+        PipelineConfig float_config = options.config;
+        float_config.fixed_point = false;
+        PipelineConfig fixed_config = options.config;
+        fixed_config.fixed_point = true;
+        CorePipeline float_pipeline(float_config);
+        CorePipeline fixed_pipeline(fixed_config);
+        return runCompare(options, *source, float_pipeline, fixed_pipeline, "float", "fixed", FIXED_TOLERANCE);
+    }
+    if (options.compare_staged) {
+        PipelineConfig staged_config = options.config;
+        staged_config.staged = true;
+        PipelineConfig fused_config = options.config;
+        fused_config.staged = false;
+        CppAudioPipeline staged_pipeline(staged_config);
+        CppAudioPipeline fused_pipeline(fused_config);
+        return runCompare(options, *source, staged_pipeline, fused_pipeline, "staged", "fused",
+                          DEFAULT_TOLERANCE);
+    }
+    if (options.compare_threading) {
+        PipelineConfig inline_config = options.config;
+        inline_config.threaded = false;
+        PipelineConfig staged_config = options.config;
+        staged_config.threaded = true;
+        CorePipeline inline_pipeline(inline_config);
+        CorePipeline staged_pipeline(staged_config);
+        return runCompare(options, *source, inline_pipeline, staged_pipeline, "inline", "staged",
+                          DEFAULT_TOLERANCE);
+    }
+    
+    std::unique_ptr<Pipeline> pipeline = createPipeline(options.pipeline, options.config);
+    if (!pipeline) {
+        std::fprintf(stderr, "unknown pipeline '%s'\n", options.pipeline.c_str());
+        return 1;
+    }
+    
+    LatencyTracer latency_tracer;
+    if (options.latency) {
+        pipeline->setLatencyTracer(&latency_tracer);
+    }
+    PipelineProfiler profiler;
+    if (options.stats) {
+        pipeline->setProfiler(&profiler);
+    }
+    
+    std::unique_ptr<AudioSink> sink = createSink(options.sink, pipeline->audioRate());
+    if (!sink) {
+        std::fprintf(stderr, "cannot open sink '%s'\n", options.sink.c_str());
+        return 1;
+    }
+    
+    // A sink that plays out in real time needs the source in real time too,
+    // or the queue only measures how fast the CPU fills it
+    const ClockedAudioSink* clocked = dynamic_cast<const ClockedAudioSink*>(sink.get());
+    const auto source_start = std::chrono::steady_clock::now();
+    
+    const uint64_t byte_limit = byteLimit(options);
+    
+    std::vector<uint8_t> block(options.block_bytes);
+    uint64_t bytes_done = 0;
+    uint64_t blocks = 0;
+    uint64_t steady_allocations = 0;
+    uint64_t steady_thread_allocations = 0;   // what NoAllocationScope sees
+    std::chrono::steady_clock::duration dsp_time{0};
+    
+    while (bytes_done < byte_limit) {
+        size_t want = static_cast<size_t>(std::min<uint64_t>(block.size(), byte_limit - bytes_done));
+        if (clocked) {
+            // Block is due once the dongle would have delivered it
+            auto due = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                std::chrono::duration<double>(static_cast<double>((bytes_done + want) / 2) /
+                                              options.config.sample_rate));
+            std::this_thread::sleep_until(source_start + due);
+        }
+        size_t got = source->read(block.data(), want);
+        if (got == 0) {
+            break;
+        }
+        
+        // Only the DSP chain is timed; the simulated source is not free
+        const uint64_t allocations_before = allocationCount();
+        const uint64_t thread_allocations_before = threadAllocationCount();
+        auto start = std::chrono::steady_clock::now();
+        pipeline->process(block.data(), got, *sink);
+        dsp_time += std::chrono::steady_clock::now() - start;
+        if (blocks >= WARMUP_BLOCKS) {
+            steady_allocations += allocationCount() - allocations_before;
+            steady_thread_allocations += threadAllocationCount() - thread_allocations_before;
+        }
+        
+        bytes_done += got;
+        ++blocks;
+    }
+    
+    // Threaded, the last blocks' audio may still be on its way
+    auto finish_start = std::chrono::steady_clock::now();
+    pipeline->finish(*sink);
+    dsp_time += std::chrono::steady_clock::now() - finish_start;
+    
+    sink->stopAudio();
+    
+    const double samples = static_cast<double>(bytes_done / 2);
+    const double signal_seconds = samples / options.config.sample_rate;
+    const double dsp_seconds = std::chrono::duration<double>(dsp_time).count();
+    
+    std::printf("source      %s\n", source->name());
+    std::printf("pipeline    %s (%s, %u Hz)\n", pipeline->name(),
+                options.config.demod.c_str(), options.config.sample_rate);
+    if (options.config.threaded && options.pipeline == "core") {
+        std::printf("threading   staged (demod %s, spectrum %s, output %s)\n",
+                    coreClassName(options.config.demod_placement.cores),
+                    coreClassName(options.config.spectrum_placement.cores),
+                    coreClassName(options.config.output_placement.cores));
+    }
+    std::printf("sink        %s\n", sink->getName());
+    std::printf("blocks      %llu x %zu bytes\n", static_cast<unsigned long long>(blocks), options.block_bytes);
+    std::printf("signal      %.3f s (%.0f samples)\n", signal_seconds, samples);
+    std::printf("dsp time    %.3f s\n", dsp_seconds);
+    
+    if (dsp_seconds > 0.0 && signal_seconds > 0.0) {
+        std::printf("throughput  %.2f Msps\n", samples / dsp_seconds / 1e6);
+        std::printf("rtf         %.4f (%.1fx real time)\n",
+                    dsp_seconds / signal_seconds, signal_seconds / dsp_seconds);
+    }
+    
+    if (clocked) {
+        printClockedStats(*clocked);
+    }
+    if (options.latency) {
+        printLatency(latency_tracer);
+    }
+    if (options.stats) {
+        printPipelineStats(profiler);
+    }
+    
+    if (options.check_allocations) {
+        const uint64_t steady_blocks = blocks > WARMUP_BLOCKS ? blocks - WARMUP_BLOCKS : 0;
+        std::printf("allocations %llu in %llu steady-state blocks, %llu of them on the processing thread\n",
+                    static_cast<unsigned long long>(steady_allocations),
+                    static_cast<unsigned long long>(steady_blocks),
+                    static_cast<unsigned long long>(steady_thread_allocations));
+        if (!allocationCountingEnabled() || steady_blocks == 0 || steady_allocations > 0) {
+            std::printf("result      FAIL\n");
+            return 1;
+        }
+        std::printf("result      PASS\n");
+    }
+    
+    return 0;
+}
@@ -0,0 +1,256 @@
+#include "pipelines.h"
+
+#include <algorithm>
+#include <cctype>
+
+#include "iq_converter.h"
+#include "latency_tracer.h"
+#include "pipeline_profiler.h"
+#include "sample_ring.h"
+#include "signal_processor.h"
+#include "spectrum_analyzer.h"
+#include "staged_pipeline.h"
+#include "audio_processor.h"
+#include "audio_processor_api.h"
+
+static DemodulationType parseDemod(const std::string& demod) {
+    if (demod == "am") return DemodulationType::AM;
+    if (demod == "usb") return DemodulationType::USB;
+    if (demod == "lsb") return DemodulationType::LSB;
+    return DemodulationType::FM;
+}
+
+CorePipeline::CorePipeline(const PipelineConfig& config)
+    : signal_processor_(std::make_unique<SignalProcessor>())
+    , audio_processor_(std::make_unique<AudioProcessor>())
+    , ring_(std::make_unique<SampleRing>())
+    , demod_placement_(config.demod_placement)
+    , fixed_point_(config.fixed_point)
+    , tracer_(nullptr)
+    , profiler_(nullptr)
+    , sample_rate_(static_cast<int>(config.sample_rate)) {
+    
+    signal_processor_->setSampleRate(static_cast<int>(config.sample_rate));
+    signal_processor_->setAudioSampleRate(audioRate());
+    signal_processor_->setDemodulationType(parseDemod(config.demod));
+    if (config.channel_filter == "direct") {
+        signal_processor_->setChannelFilterMode(ChannelFilterMode::DIRECT);
+    } else if (config.channel_filter == "fft") {
+        signal_processor_->setChannelFilterMode(ChannelFilterMode::FAST_CONVOLUTION);
+    }
+    if (config.fm_discriminator == "exact") {
+        signal_processor_->setDiscriminatorAccuracy(DiscriminatorAccuracy::EXACT);
+    } else if (config.fm_discriminator == "quadrature") {
+        signal_processor_->setDiscriminatorAccuracy(DiscriminatorAccuracy::QUADRATURE);
+    }
+    signal_processor_->setBandwidth(config.bandwidth_hz);
+    audio_processor_->setDriftCompensation(config.drift_compensation);
+    if (fixed_point_) {
+        signal_processor_->setProcessingMode(ProcessingMode::FIXED_POINT);
+    }
+    if (config.offset_hz != 0) {
+        signal_processor_->setFrequencyOffset(config.offset_hz);
+    }
+    
+    if (config.spectrum) {
+        spectrum_analyzer_ = std::make_unique<SpectrumAnalyzer>();
+        spectrum_analyzer_->setFFTSize(config.fft_size);
+        if (config.welch_overlap >= 0) {
+            spectrum_analyzer_->setWelchAveraging(true, config.welch_overlap, config.welch_segments);
+        }
+    }
+    
+    if (config.threaded) {
+        staged_ = std::make_unique<StagedPipeline>(spectrum_analyzer_.get(), audio_processor_.get());
+        staged_->setPlacement(PipelineThread::SPECTRUM, config.spectrum_placement);
+        staged_->setPlacement(PipelineThread::OUTPUT, config.output_placement);
+    }
+}
+
+CorePipeline::~CorePipeline() = default;
+
+void CorePipeline::process(const uint8_t* iq, size_t len, AudioSink& sink) {
+    feed(iq, len);
+    drainAudio(sink);
+}
+
+void CorePipeline::finish(AudioSink& sink) {
+    if (staged_) {
+        staged_->drain();
+    }
+    drainAudio(sink);
+}
+
+void CorePipeline::drainAudio(AudioSink& sink) {
+    // Drain like the Java side polling getAudioData()
+    for (;;) {
+        size_t count = audio_processor_->readAudio(pcm_, PCM_CHUNK);
+        if (count == 0) {
+            break;
+        }
+        sink.writeAudioData(pcm_, count);
+    }
+}
+
+void CorePipeline::setLatencyTracer(LatencyTracer* tracer) {
+    tracer_ = tracer;
+    audio_processor_->setLatencyTracer(tracer);
+    if (staged_) {
+        staged_->setLatencyTracer(tracer);
+    }
+}
+
+void CorePipeline::setProfiler(PipelineProfiler* profiler) {
+    profiler_ = profiler;
+    signal_processor_->setProfiler(profiler);
+    audio_processor_->setProfiler(profiler);
+    if (spectrum_analyzer_) {
+        spectrum_analyzer_->setProfiler(profiler);
+    }
+}
+
+void CorePipeline::feed(const uint8_t* iq, size_t len) {
+    if (staged_ && !staged_->isRunning()) {
+        // This thread is the demod stage from here on
+        applyThreadPlacement(demod_placement_);
+        staged_->start(std::max(len / 2, AUDIO_CHUNK));
+    }
+    
+    const int64_t ingest = tracer_ ? LatencyTracer::now() : 0;
+    int64_t dequeued = ingest;
+    const int64_t block_start = profiler_ ? PipelineProfiler::now() : 0;
+    StageTimer timer(profiler_, block_start);
+    
+    // Same path as SDRController: convert into the ring's free span, then
+    // process the readable span in place. Fixed point converts to Q15 and
+    // never widens the block to float.
+    const SampleFormat format = fixed_point_ ? SampleFormat::Q15 : SampleFormat::FLOAT;
+    if (ring_->capacity() < len / 2 || ring_->format() != format) {
+        ring_->allocate(len / 2, format);
+    }
+    size_t space = 0;
+    size_t count = 0;
+    if (fixed_point_) {
+        std::complex<int16_t>* span = ring_->writeSpanQ15(space);
+        count = std::min(space, len / 2);
+        convertIQ8ToQ15(iq, count, span);
+    } else {
+        std::complex<float>* span = ring_->writeSpan(space);
+        count = std::min(space, len / 2);
+        convertIQ8(iq, count, span);
+    }
+    if (tracer_) {
+        ring_->stampWrite(ingest);
+    }
+    ring_->commitWrite(count);
+    timer.lap(PipelineStage::INGEST, count);
+    
+    int64_t stamped = 0;
+    if (tracer_ && ring_->readStamp(stamped)) {
+        dequeued = LatencyTracer::now();
+        tracer_->record(LatencyStage::QUEUE, dequeued - stamped);
+    }
+    
+    if (fixed_point_) {
+        const std::complex<int16_t>* samples = ring_->readSpanQ15(count);
+        signal_processor_->processSamplesQ15(samples, count);
+        if (staged_) {
+            staged_->pushSpectrumQ15(samples, count);
+        } else if (spectrum_analyzer_) {
+            spectrum_analyzer_->updateSpectrumQ15(samples, count);
+        }
+    } else {
+        const std::complex<float>* samples = ring_->readSpan(count);
+        signal_processor_->processSamples(samples, count);
+        if (staged_) {
+            staged_->pushSpectrum(samples, count);
+        } else if (spectrum_analyzer_) {
+            spectrum_analyzer_->updateSpectrum(samples, count);
+        }
+    }
+    ring_->commitRead(count);
+    
+    // Buffer-passing forms of getAudioSamples() / getAudioBuffer(), as
+    // processingLoop() uses them, so steady-state blocks do not allocate
+    bool first = true;
+    for (;;) {
+        size_t count = signal_processor_->readAudioSamples(audio_, AUDIO_CHUNK);
+        if (count == 0) {
+            break;
+        }
+        if (staged_) {
+            // The output thread stamps the first piece and records DSP
+            staged_->pushAudio(audio_, count, first && tracer_, ingest, dequeued);
+            first = false;
+            continue;
+        }
+        if (first && tracer_) {
+            audio_processor_->stampNextBlock(ingest);
+        }
+        first = false;
+        audio_processor_->processAudio(audio_, count);
+    }
+    
+    if (tracer_ && !staged_) {
+        tracer_->record(LatencyStage::DSP, LatencyTracer::now() - dequeued);
+    }
+    if (profiler_) {
+        profiler_->recordBlock(len / 2, sample_rate_, PipelineProfiler::now() - block_start);
+    }
+}
+
+CppAudioPipeline::CppAudioPipeline(const PipelineConfig& config)
+    : processor_(audio_processor_create())
+    , demod_type_(config.demod)
+    , sample_rate_(static_cast<int>(config.sample_rate))
+    , profiler_(nullptr) {
+    
+    std::transform(demod_type_.begin(), demod_type_.end(), demod_type_.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::toupper(c)); });
+    
+    audio_processor_set_sample_rates(processor_, static_cast<int>(config.sample_rate), audioRate());
+    audio_processor_set_fused(processor_, !config.staged);
+    if (config.fm_discriminator == "exact") {
+        audio_processor_set_fm_accuracy(processor_, 0);
+    } else if (config.fm_discriminator == "quadrature") {
+        audio_processor_set_fm_accuracy(processor_, 2);
+    }
+}
+
+CppAudioPipeline::~CppAudioPipeline() {
+    audio_processor_destroy(processor_);
+}
+
+void CppAudioPipeline::setProfiler(PipelineProfiler* profiler) {
+    profiler_ = profiler;
+    audio_processor_set_profiler(processor_, profiler);
+}
+
+void CppAudioPipeline::process(const uint8_t* iq, size_t len, AudioSink& sink) {
+    const int64_t block_start = profiler_ ? PipelineProfiler::now() : 0;
+    audio_.resize(len / 2);
+    int audio_length = static_cast<int>(audio_.size());
+    
+    audio_processor_process_iq(processor_, iq, static_cast<int>(len),
+                               audio_.data(), &audio_length, demod_type_.c_str());
+    
+    // Float straight to the sink, converted the way SDRRadio's audio is;
+    // the processor lapped its own stages, so time the sink as SDRRadio does
+    StageTimer timer(profiler_);
+    sink.writeAudioData(audio_.data(), static_cast<size_t>(audio_length));
+    timer.lap(PipelineStage::AUDIO_CONVERSION, static_cast<size_t>(audio_length));
+    
+    if (profiler_) {
+        profiler_->recordBlock(len / 2, sample_rate_, PipelineProfiler::now() - block_start);
+    }
+}
+
+std::unique_ptr<Pipeline> createPipeline(const std::string& name, const PipelineConfig& config) {
+    if (name == "core") {
+        return std::make_unique<CorePipeline>(config);
+    }
+    if (name == "cpp-audio") {
+        return std::make_unique<CppAudioPipeline>(config);
+    }
+    return nullptr;
+}
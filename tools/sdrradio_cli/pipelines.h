@@ -0,0 +1,138 @@
+#ifndef SDRRADIO_CLI_PIPELINES_H
+#define SDRRADIO_CLI_PIPELINES_H
+
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "sinks.h"
+#include "thread_placement.h"
+
+class SignalProcessor;
+class SpectrumAnalyzer;
+class AudioProcessor;
+class SampleRing;
+class LatencyTracer;
+class PipelineProfiler;
+class StagedPipeline;
+
+namespace audio {
+class AudioProcessor;
+}
+
+struct PipelineConfig {
+    std::string demod = "fm";
+    uint32_t sample_rate = 2048000;
+    int bandwidth_hz = 200000;
+    int offset_hz = 0;              // core: receive this far from the tuned frequency
+    std::string channel_filter = "auto";  // auto, direct or fft
+    bool fixed_point = false;       // Q15 channel filter and demodulator
+    std::string fm_discriminator = "poly";  // exact, poly or quadrature
+    bool staged = false;            // cpp-audio: full pass per stage, not fused
+    bool drift_compensation = false;  // core: AudioProcessor clock-drift loop
+    bool threaded = false;          // core: spectrum and audio output on their own threads
+    ThreadPlacement demod_placement;    // core, threaded: the calling thread
+    ThreadPlacement spectrum_placement;
+    ThreadPlacement output_placement;
+    int fft_size = 1024;
+    bool spectrum = true;
+    int welch_overlap = -1;         // percent, -1 = last-block spectrum
+    int welch_segments = 8;
+};
+
+// One complete source-to-sink chain. process() takes one USB-sized block
+// of u8 IQ and pushes whatever audio it yields into the sink.
+class Pipeline {
+public:
+    virtual ~Pipeline() = default;
+    
+    virtual void process(const uint8_t* iq, size_t len, AudioSink& sink) = 0;
+    
+    // After the last block: pushes audio still in flight into the sink
+    virtual void finish(AudioSink& sink) { (void)sink; }
+    
+    // Per-stage block latency into tracer, where the chain supports it
+    virtual void setLatencyTracer(LatencyTracer* tracer) { (void)tracer; }
+    
+    // Per-stage hot-path timing into profiler, where the chain supports it
+    virtual void setProfiler(PipelineProfiler* profiler) { (void)profiler; }
+    
+    // Rate the produced audio is labelled with
+    virtual int audioRate() const = 0;
+    virtual const char* name() const = 0;
+};
+
+// java/ native core: SignalProcessor -> SpectrumAnalyzer -> AudioProcessor,
+// driven the same way processingLoop() in radiosdr_jni.cpp drives it.
+class CorePipeline : public Pipeline {
+public:
+    explicit CorePipeline(const PipelineConfig& config);
+    ~CorePipeline() override;
+    
+    void process(const uint8_t* iq, size_t len, AudioSink& sink) override;
+    void finish(AudioSink& sink) override;
+    int audioRate() const override { return 48000; }
+    const char* name() const override { return "core"; }
+    
+    // process() without the drain: audio stays in the AudioProcessor for
+    // a caller that reads it on its own clock. Threaded, the audio of a
+    // block may reach the AudioProcessor after feed() returns.
+    void feed(const uint8_t* iq, size_t len);
+    AudioProcessor& audioProcessor() { return *audio_processor_; }
+    
+    // Stamps each block on entry like SDRController's USB callback and
+    // records QUEUE and DSP; AudioProcessor records the rest on the drain
+    void setLatencyTracer(LatencyTracer* tracer) override;
+    
+    // Hands the profiler to every stage object, times the IQ conversion as
+    // SDRController's INGEST and each whole block against its duration
+    void setProfiler(PipelineProfiler* profiler) override;
+    
+private:
+    void drainAudio(AudioSink& sink);
+    
+    std::unique_ptr<SignalProcessor> signal_processor_;
+    std::unique_ptr<SpectrumAnalyzer> spectrum_analyzer_;
+    std::unique_ptr<AudioProcessor> audio_processor_;
+    std::unique_ptr<SampleRing> ring_;
+    
+    // Threaded mode, as processingLoop() runs it with PipelineMode::STAGED;
+    // started on the first block
+    std::unique_ptr<StagedPipeline> staged_;
+    ThreadPlacement demod_placement_;
+    bool fixed_point_;
+    LatencyTracer* tracer_;
+    PipelineProfiler* profiler_;
+    int sample_rate_;
+    
+    static const size_t AUDIO_CHUNK = 8192;
+    static const size_t PCM_CHUNK = 1024;
+    float audio_[AUDIO_CHUNK];
+    int16_t pcm_[PCM_CHUNK];
+};
+
+// cpp/ tree audio chain (audio/audio_processor.cpp)
+class CppAudioPipeline : public Pipeline {
+public:
+    explicit CppAudioPipeline(const PipelineConfig& config);
+    ~CppAudioPipeline() override;
+    
+    void process(const uint8_t* iq, size_t len, AudioSink& sink) override;
+    int audioRate() const override { return 44100; }
+    const char* name() const override { return "cpp-audio"; }
+    void setProfiler(PipelineProfiler* profiler) override;
+    
+private:
+    audio::AudioProcessor* processor_;
+    std::string demod_type_;
+    int sample_rate_;
+    std::vector<float> audio_;
+    PipelineProfiler* profiler_;
+};
+
+std::unique_ptr<Pipeline> createPipeline(const std::string& name, const PipelineConfig& config);
+
+#endif // SDRRADIO_CLI_PIPELINES_H
@@ -0,0 +1,35 @@
+#ifndef SDRRADIO_CLI_ANDROID_LOG_SHIM_H
+#define SDRRADIO_CLI_ANDROID_LOG_SHIM_H
+
+// Host replacement for the NDK <android/log.h>, so the native DSP sources
+// can be compiled unmodified on Linux. Messages go to stderr.
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum android_LogPriority {
+    ANDROID_LOG_UNKNOWN = 0,
+    ANDROID_LOG_DEFAULT,
+    ANDROID_LOG_VERBOSE,
+    ANDROID_LOG_DEBUG,
+    ANDROID_LOG_INFO,
+    ANDROID_LOG_WARN,
+    ANDROID_LOG_ERROR,
+    ANDROID_LOG_FATAL,
+    ANDROID_LOG_SILENT
+} android_LogPriority;
+
+int __android_log_print(int prio, const char* tag, const char* fmt, ...)
+    __attribute__((format(printf, 3, 4)));
+
+int __android_log_write(int prio, const char* tag, const char* text);
+
+// Messages below this priority are dropped (default: ANDROID_LOG_WARN)
+void sdrradio_cli_set_log_level(int prio);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SDRRADIO_CLI_ANDROID_LOG_SHIM_H
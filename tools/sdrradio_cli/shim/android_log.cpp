@@ -0,0 +1,41 @@
+#include <android/log.h>
+
+#include <atomic>
+#include <cstdarg>
+#include <cstdio>
+
+static std::atomic<int> min_log_level{ANDROID_LOG_WARN};
+
+extern "C" int __android_log_print(int prio, const char* tag, const char* fmt, ...) {
+    if (prio < min_log_level.load(std::memory_order_relaxed)) {
+        return 0;
+    }
+    
+    static const char levels[] = "??VDIWEFS";
+    char level = (prio >= 0 && prio <= ANDROID_LOG_SILENT) ? levels[prio] : '?';
+    
+    std::fprintf(stderr, "%c/%s: ", level, tag ? tag : "");
+    
+    va_list args;
+    va_start(args, fmt);
+    int written = std::vfprintf(stderr, fmt, args);
+    va_end(args);
+    
+    std::fputc('\n', stderr);
+    return written;
+}
+
+extern "C" int __android_log_write(int prio, const char* tag, const char* text) {
+    if (prio < min_log_level.load(std::memory_order_relaxed)) {
+        return 0;
+    }
+    
+    static const char levels[] = "??VDIWEFS";
+    char level = (prio >= 0 && prio <= ANDROID_LOG_SILENT) ? levels[prio] : '?';
+    
+    return std::fprintf(stderr, "%c/%s: %s\n", level, tag ? tag : "", text ? text : "");
+}
+
+extern "C" void sdrradio_cli_set_log_level(int prio) {
+    min_log_level.store(prio, std::memory_order_relaxed);
+}
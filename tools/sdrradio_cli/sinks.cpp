@@ -0,0 +1,42 @@
+#include "sinks.h"
+
+#include <cstdlib>
+
+namespace {
+
+// AudioManager's defaults
+const int CLOCKED_BUFFER_COUNT = 3;
+const int CLOCKED_FRAMES_PER_BUFFER = 512;
+const int CLOCKED_MAX_QUEUED_MS = 200;
+
+std::unique_ptr<AudioSink> createClockedSink(const std::string& params) {
+    int values[3] = {CLOCKED_BUFFER_COUNT, CLOCKED_FRAMES_PER_BUFFER, CLOCKED_MAX_QUEUED_MS};
+    const char* p = params.c_str();
+    for (int i = 0; i < 3 && *p == ':'; ++i) {
+        char* end = nullptr;
+        values[i] = static_cast<int>(std::strtol(p + 1, &end, 10));
+        p = end;
+    }
+    if (*p != '\0') {
+        return nullptr;
+    }
+    return std::make_unique<ClockedAudioSink>(values[0], values[1], values[2]);
+}
+
+} // namespace
+
+std::unique_ptr<AudioSink> createSink(const std::string& spec, int sample_rate) {
+    std::unique_ptr<AudioSink> sink;
+    if (spec == "null") {
+        sink = std::make_unique<NullAudioSink>();
+    } else if (spec.compare(0, 4, "wav:") == 0) {
+        sink = std::make_unique<WavAudioSink>(spec.substr(4));
+    } else if (spec.compare(0, 7, "clocked") == 0) {
+        sink = createClockedSink(spec.substr(7));
+    }
+    
+    if (!sink || !sink->startAudio(sample_rate, 1)) {
+        return nullptr;
+    }
+    return sink;
+}
@@ -0,0 +1,47 @@
+#ifndef SDRRADIO_CLI_SINKS_H
+#define SDRRADIO_CLI_SINKS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "audio_sink.h"
+#include "headless_audio_sink.h"
+
+// Keeps everything in memory, for comparing two runs sample by sample.
+// Accepts audio whether or not it was started.
+class MemorySink : public AudioSink {
+public:
+    bool startAudio(int sample_rate, int channels) override {
+        sample_rate_ = sample_rate;
+        channels_ = channels;
+        return true;
+    }
+    void stopAudio() override {}
+    bool isAudioPlaying() const override { return true; }
+    
+    using AudioSink::writeAudioData;
+    bool writeAudioData(const int16_t* samples, size_t count) override {
+        samples_.insert(samples_.end(), samples, samples + count);
+        return true;
+    }
+    
+    int getSampleRate() const override { return sample_rate_; }
+    int getChannels() const override { return channels_; }
+    const char* getName() const override { return "memory"; }
+    
+    const std::vector<int16_t>& samples() const { return samples_; }
+    
+private:
+    std::vector<int16_t> samples_;
+    int sample_rate_ = 0;
+    int channels_ = 1;
+};
+
+// null, wav:PATH or clocked[:BUFFERS[:FRAMES[:MAX_MS]]], already started
+// at sample_rate mono; nullptr if the spec is unknown or cannot start
+std::unique_ptr<AudioSink> createSink(const std::string& spec, int sample_rate);
+
+#endif // SDRRADIO_CLI_SINKS_H
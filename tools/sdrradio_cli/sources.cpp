@@ -0,0 +1,106 @@
+#include "sources.h"
+#include "rtlsdr_simulated.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+static void noopCallback(unsigned char*, uint32_t, void*) {}
+
+SimulatedSource::SimulatedSource(uint32_t sample_rate)
+    : device_(nullptr) {
+    
+    if (rtlsdr_open(&device_, 0) != 0) {
+        device_ = nullptr;
+        return;
+    }
+    
+    rtlsdr_set_sample_rate(device_, sample_rate);
+    
+    // The simulator only hands out data while "streaming"
+    rtlsdr_read_async(device_, noopCallback, nullptr, 0, 0);
+}
+
+SimulatedSource::~SimulatedSource() {
+    if (device_) {
+        rtlsdr_cancel_async(device_);
+        rtlsdr_close(device_);
+    }
+}
+
+size_t SimulatedSource::read(uint8_t* buf, size_t len) {
+    int n_read = 0;
+    if (rtlsdr_read_sync(device_, buf, static_cast<int>(len), &n_read) != 0) {
+        return 0;
+    }
+    return static_cast<size_t>(n_read);
+}
+
+FileSource::FileSource(const std::string& path)
+    : path_(path)
+    , file_(std::fopen(path.c_str(), "rb")) {
+}
+
+FileSource::~FileSource() {
+    if (file_) {
+        std::fclose(file_);
+    }
+}
+
+size_t FileSource::read(uint8_t* buf, size_t len) {
+    // Keep I/Q pairs aligned
+    return std::fread(buf, 1, len & ~static_cast<size_t>(1), file_);
+}
+
+FmToneSource::FmToneSource(uint32_t sample_rate, double deviation_hz)
+    : sample_rate_(sample_rate)
+    , deviation_hz_(deviation_hz)
+    , carrier_phase_(0.0)
+    , tone_phase_(0.0)
+    , noise_(12345) {
+    
+    char name[64];
+    std::snprintf(name, sizeof(name), "fm tone, %.0f Hz deviation", deviation_hz);
+    name_ = name;
+}
+
+size_t FmToneSource::read(uint8_t* buf, size_t len) {
+    const double step = 2.0 * M_PI / sample_rate_;
+    const size_t pairs = len / 2;
+    for (size_t n = 0; n < pairs; ++n) {
+        carrier_phase_ = std::remainder(carrier_phase_ + step * deviation_hz_ * std::sin(tone_phase_), 2.0 * M_PI);
+        tone_phase_ = std::remainder(tone_phase_ + step * TONE_HZ, 2.0 * M_PI);
+        
+        // About 1 LSB of noise, enough to dither the u8 steps
+        const double value[2] = {0.5 * std::cos(carrier_phase_), 0.5 * std::sin(carrier_phase_)};
+        for (int k = 0; k < 2; ++k) {
+            noise_ = noise_ * 1664525u + 1013904223u;
+            const double noisy = value[k] + (static_cast<double>(noise_ >> 8) / 16777216.0 - 0.5) / 64.0;
+            buf[2 * n + k] = static_cast<uint8_t>(std::max(0.0, std::min(255.0, std::round(127.5 + 127.5 * noisy))));
+        }
+    }
+    return pairs * 2;
+}
+
+std::unique_ptr<IQSource> createSource(const std::string& spec, uint32_t sample_rate) {
+    if (spec == "fm" || spec.compare(0, 3, "fm:") == 0) {
+        const double deviation = spec.size() > 3 ? std::atof(spec.c_str() + 3) : FmToneSource::DEFAULT_DEVIATION_HZ;
+        if (deviation > 0.0) {
+            return std::make_unique<FmToneSource>(sample_rate, deviation);
+        }
+    } else if (spec == "sim") {
+        auto source = std::make_unique<SimulatedSource>(sample_rate);
+        if (source->isOpen()) {
+            return source;
+        }
+    } else if (spec.compare(0, 5, "file:") == 0) {
+        auto source = std::make_unique<FileSource>(spec.substr(5));
+        if (source->isOpen()) {
+            return source;
+        }
+    }
+    return nullptr;
+}
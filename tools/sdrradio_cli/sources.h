@@ -0,0 +1,76 @@
+#ifndef SDRRADIO_CLI_SOURCES_H
+#define SDRRADIO_CLI_SOURCES_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+
+struct rtlsdr_dev;
+
+// Producer of interleaved unsigned 8-bit IQ bytes, as delivered by the
+// RTL-SDR USB callback.
+class IQSource {
+public:
+    virtual ~IQSource() = default;
+    
+    // Fills up to len bytes, returns the number written (0 at end of stream)
+    virtual size_t read(uint8_t* buf, size_t len) = 0;
+    virtual const char* name() const = 0;
+};
+
+// Simulated dongle from cpp/app/src/main/cpp/rtlsdr
+class SimulatedSource : public IQSource {
+public:
+    explicit SimulatedSource(uint32_t sample_rate);
+    ~SimulatedSource() override;
+    
+    bool isOpen() const { return device_ != nullptr; }
+    size_t read(uint8_t* buf, size_t len) override;
+    const char* name() const override { return "simulated rtlsdr_dev"; }
+    
+private:
+    rtlsdr_dev* device_;
+};
+
+// Raw u8 IQ capture, e.g. from `rtl_sdr -s 2048000 capture.iq`
+class FileSource : public IQSource {
+public:
+    explicit FileSource(const std::string& path);
+    ~FileSource() override;
+    
+    bool isOpen() const { return file_ != nullptr; }
+    size_t read(uint8_t* buf, size_t len) override;
+    const char* name() const override { return path_.c_str(); }
+    
+private:
+    std::string path_;
+    FILE* file_;
+};
+
+// Synthetic FM carrier at the tuned frequency: a 1 kHz tone at the given
+// deviation, half full scale, over a little noise. The simulated dongle
+// only sends AM, which an FM discriminator turns into phase flips.
+class FmToneSource : public IQSource {
+public:
+    FmToneSource(uint32_t sample_rate, double deviation_hz);
+    
+    size_t read(uint8_t* buf, size_t len) override;
+    const char* name() const override { return name_.c_str(); }
+    
+    static constexpr double TONE_HZ = 1000.0;
+    static constexpr double DEFAULT_DEVIATION_HZ = 75000.0;
+    
+private:
+    double sample_rate_;
+    double deviation_hz_;
+    double carrier_phase_;
+    double tone_phase_;
+    uint32_t noise_;
+    std::string name_;
+};
+
+std::unique_ptr<IQSource> createSource(const std::string& spec, uint32_t sample_rate);
+
+#endif // SDRRADIO_CLI_SOURCES_H